@@ -187,6 +187,16 @@ extern int	pkginfo __P((struct pkginfo *info, char *pkginst, ...));
 extern int	fpkginfo __P((struct pkginfo *info, char *pkginst));
 extern char	*fpkginst __P((char *pkg, ...));
 
+/*
+ * pkgreg.c
+ */
+extern int	pkgregOpen __P((void));
+extern char	*pkgregInst __P((int a_pos));
+extern int	pkgregInfo __P((struct pkginfo *info, char *pkginst));
+extern int	pkgregParams __P((char *a_inst, char **r_arch,
+				char **r_vers));
+extern void	pkgregFlush __P((void));
+
 /*
  * pkgnmchk.c
  */
@@ -250,6 +250,12 @@ extern int  isUpdate __P((void));
 extern void setPatchUpdate __P((void));
 extern int  isPatchUpdate __P((void));
 
+/* rdepindex.c */
+extern int	rdepOpen __P((char *a_pkgdir, char *a_admdir));
+extern char	*rdepDependent __P((char *a_pkg, int *a_pos));
+extern int	rdepInstalled __P((char *a_spec));
+extern void	rdepClose __P((void));
+
 /* mntinfo.c */
 extern int	get_mntinfo __P((int map_client, char *vfstab_file));
 extern short	fsys __P((char *path));
@@ -299,6 +305,9 @@ extern int	set_cfdir __P((char *cfdir));
 extern int	socfile __P((VFP_T **vfp));
 extern int	relslock __P((void));
 extern int	vcfile __P((void));
+extern int	begin_cfbatch __P((void));
+extern void	set_cfbatch __P((void));
+extern int	end_cfbatch __P((char *a_pkginst));
 
 extern long	nblk __P((long size, unsigned long bsize, unsigned long frsize));
 extern struct	cfent **procmap __P((VFP_T *vfp, int mapflag, char *ir));
@@ -383,7 +392,8 @@ extern boolean_t	setup_temporary_directory(char **r_dirname,
 
 /* unpack_package_from_stream.c */
 extern boolean_t	unpack_package_from_stream(char *a_idsName,
-				char *a_pkginst, char *a_tempDir);
+				char *a_pkginst, char *a_tempDir,
+				boolean_t a_stream);
 
 /* pkgops.c */
 
@@ -94,6 +94,7 @@ extern "C" {
 #define	DBG_CLOSING_STREAM		gettext("closing datastream <%s> at <%s>")
 #define	DBG_CONVERTING_PKG		gettext("converting package <%s/%s> to stream <%s>")
 #define	DBG_COPY_FILE			gettext("copy <%s> to <%s>")
+#define	DBG_COPY_FILE_VIA		gettext("copied <%s> to <%s> via <%s>")
 #define	DBG_CPPATH_ENTRY		gettext("copy path: control <0x%02x> mode <0%04lo> source <%s> destination <%s>")
 #define	DBG_CREATED_ZONE_ADMINFILE	gettext("created temporary zone administration file <%s>")
 #define	DBG_CREATED_ZONE_TEMPDIR	gettext("created temporary zone directory <%s>")
@@ -176,6 +177,7 @@ extern "C" {
 #define	DBG_PKGADD_CKRETURN		gettext("check return code <%d> package <%s> function <add packages>")
 #define	DBG_PKGADD_ENABLING_HOLLOW	gettext("enabling hollow package support")
 #define	DBG_PKGADD_HOLLOW_ENABLED	gettext("hollow package support is enabled")
+#define	DBG_PKGADD_ORDER		gettext("package <%s> is added in layer <%d> of the batch")
 #define	DBG_PKGADD_PKGPATHS		gettext("locations set: pkg <%s> adm <%s>")
 #define	DBG_PKGADD_RESPFILE		gettext("using response file <%s> directory <%s>")
 #define	DBG_PKGADD_TMPDIR		gettext("using temporary directory <%s>")
@@ -490,6 +492,7 @@ extern "C" {
 #define	ERR_ILL_PASSWD			gettext("A password is required to retrieve the public certificate from the keystore.")
 #define	ERR_INCOMP_VERS			gettext("A version of <%s> package \"%s\" (which is incompatible with the package that is being installed) is currently installed and must be removed.")
 #define	ERR_INPUT			gettext("error while reading file <%s>: (%d) %s")
+#define	ERR_INPUT_STREAM		gettext("error while reading file <%s> from datastream: %s")
 #define	ERR_INSTALL_ZONES_SKIPPED	gettext("unable to boot <%d> zones that are not currently running - no packages installed on those zones")
 #define	ERR_INTONLY			gettext("unable to install <%s> without user interaction")
 #define	ERR_INTR			gettext("Interactive request script supplied by package")
@@ -553,6 +556,7 @@ extern "C" {
 #define	ERR_PKGADDCHK_MKPKGDIR		gettext("Unable to make required packaging directory")
 #define	ERR_PKGADDCHK_PRIVFAILED	gettext("Privilege checking failed.")
 #define	ERR_PKGADDCHK_SPCFAILED		gettext("Space checking failed.")
+#define	ERR_PKGADD_INCOMPAT		gettext("<%s> is incompatible with <%s>, which is also being added")
 #define	ERR_PKGASK_AND_IGNORE_SIG	gettext("cannot use the -i option with pkgask")
 #define	ERR_PKGASK_AND_KEYSTORE_FILE	gettext("cannot use the -k option with pkgask")
 #define	ERR_PKGASK_AND_NOINTERACT	gettext("cannot use the -n option with pkgask")
@@ -849,6 +853,8 @@ extern "C" {
 #define	WRN_INSTVOL_NOTDIR		gettext("WARNING: %s may not overwrite a populated directory.")
 #define	WRN_INSTVOL_NOVERIFY		gettext("WARNING: %s <cannot install to or verify on %s>")
 #define	WRN_NOMAIL			gettext("WARNING: unable to send e-mail notification")
+#define	WRN_PKGADD_CYCLE		gettext("WARNING: the prerequisites of <%s> that are being added depend on it in turn; it is added before them")
+#define	WRN_PKGADD_INCOMPAT		gettext("WARNING: <%s> is incompatible with <%s>, which is also being added")
 #define	WRN_PKGREMOVE_PATCHES		gettext("\\nWARNING: The following patch(es) are installed to <%s>. If <%s> is removed, the patches applied to it will be removed as well leaving the patch partially installed. It is recommended that the patch(es) be removed before removing <%s>.\\n\\t%s")
 #define	WRN_RELATIVE			gettext("attempting to rename a relative file <%s>")
 #define	WRN_RSCRIPTALT_BAD		gettext("WARNING: the admin parameter <%s> is set to <%s> which is not recognized; the parameter may only be set to <%s> or <%s>")
@@ -44,6 +44,8 @@ extern "C" {
 #define	PT_DEBUG	0x08
 #define	PT_SILENT	0x10
 #define	PT_ODTSTREAM	0x40
+#define	PT_GZIP		0x80	/* gzip compress datastream parts */
+#define	PT_ZSTD		0x100	/* zstd compress datastream parts */
 
 #ifdef	__cplusplus
 }
@@ -5,7 +5,7 @@
 OBJ = ckdate.o ckgid.o ckint.o ckitem.o ckkeywd.o ckpath.o ckrange.o \
 	ckstr.o cktime.o ckuid.o ckyorn.o \
 	fulldevnm.o getinput.o \
-	pkginfo.o pkgnmchk.o pkgparam.o \
+	pkginfo.o pkgnmchk.o pkgparam.o pkgreg.o \
 	puterror.o puthelp.o putprmpt.o puttext.o \
 	regexp.o space.o \
 	strlcat.o strlcpy.o closefrom.o sigsend.o cftime.o getpass.o \
@@ -72,6 +72,9 @@ pkgnmchk.o: pkgnmchk.c ../hdrs/libadm.h  \
 pkgparam.o: pkgparam.c ../hdrs/pkgstrct.h ../hdrs/pkginfo.h \
   ../hdrs/pkglocs.h ../hdrs/libadm.h  \
   ../hdrs/sys/dklabel.h ../hdrs/valtools.h ../hdrs/install.h
+pkgreg.o: pkgreg.c ../hdrs/pkginfo.h ../hdrs/pkgstrct.h \
+  ../hdrs/libadm.h ../hdrs/sys/dklabel.h ../hdrs/valtools.h \
+  ../hdrs/install.h pkgreg.h
 puterror.o: puterror.c ../hdrs/libadm.h  \
   ../hdrs/sys/dklabel.h ../hdrs/pkgstrct.h ../hdrs/pkginfo.h \
   ../hdrs/valtools.h ../hdrs/install.h
@@ -207,6 +207,10 @@ rdconfig(struct pkginfo *info, char *pkginst, char *ckvers)
 	char	*value, *pt, *copy, **memloc;
 	int	count;
 
+	/* installed instances are looked up in the registry first */
+	if ((count = pkgregInfo(info, pkginst)) <= 0)
+		return (count);
+
 	if ((fp = pkginfopen(pkgdir, pkginst)) == NULL) {
 		errno = EACCES;
 		return (-1);
@@ -298,8 +302,9 @@ fpkginst(char *pkg, ...)
 {
 	static char pkginst[PKGSIZ+1];
 	static DIR *pdirfp;
+	static int regpos = -1;
 	struct dirent *dp;
-	char	*ckarch, *ckvers;
+	char	*ckarch, *ckvers, *inst;
 	va_list	ap;
 
 	va_start(ap, pkg);
@@ -310,6 +315,8 @@ fpkginst(char *pkg, ...)
 			(void) closedir(pdirfp);
 			pdirfp = NULL;
 		}
+		regpos = -1;
+		pkgregFlush();
 		return (NULL);
 	}
 
@@ -320,6 +327,30 @@ fpkginst(char *pkg, ...)
 	if (!pkgdir)
 		pkgdir = get_PKGLOC();
 
+	/* the installed instances are listed by the registry */
+	if (!pdirfp && (regpos < 0) && (pkgregOpen() >= 0))
+		regpos = 0;
+
+	if (regpos >= 0) {
+		while ((inst = pkgregInst(regpos)) != NULL) {
+			regpos++;
+			/* ignore invalid SVR4 package names */
+			if (pkgnmchk(inst, pkg, 0))
+				continue;
+
+			/* ckinfo() may read the entry again, freeing inst */
+			(void) strcpy(pkginst, inst);
+			if (ckinfo(pkginst, ckarch, ckvers))
+				continue;
+
+			return (pkginst);
+		}
+
+		errno = ESRCH;
+		regpos = -1;
+		return (NULL);
+	}
+
 	if (!pdirfp && ((pdirfp = opendir(pkgdir)) == NULL)) {
 		errno = EACCES;
 		return (NULL);
@@ -436,6 +467,15 @@ ckinfo(char *inst, char *arch, char *vers)
 	char	*pt, *copy, *value, *myarch, *myvers;
 	int	errflg;
 
+	/* the registry has the parameters of installed instances */
+	if ((errflg = pkgregParams(inst, &myarch, &myvers)) >= 0) {
+		if (errflg)
+			return (1);
+		if ((arch == NULL) && (vers == NULL))
+			return (0);
+		return (ckinst(inst, myarch, myvers, arch, vers) ? 1 : 0);
+	}
+
 	(void) sprintf(file, "%s/%s/pkginfo", pkgdir, inst);
 	if ((fp = fopen(file, "r")) == NULL)
 		return (1);
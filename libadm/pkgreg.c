@@ -0,0 +1,970 @@
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at src/OPENSOLARIS.LICENSE
+ * or http://www.opensolaris.org/os/licensing.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+/*LINTLIBRARY*/
+
+/*
+ * Module:	pkgreg.c
+ * Synopsis:	Registry of the package instances installed
+ * Description:
+ *
+ * pkginfo() and fpkginst() used to read the package directory and parse
+ * the pkginfo file of each instance for every query. This module keeps a
+ * registry file in the package administration directory (see pkgreg.h)
+ * that holds, for each instance directory, the pkginfo parameters that
+ * pkginfo() returns and whether the instance is partially installed.
+ *
+ * The registry is mapped read-only and indexed by a hash table of the
+ * instance names. Before it is used, the package directory is checked:
+ * if it has changed, it is read again, and the records of the instances
+ * still there are kept. Before a record is used, its instance directory
+ * (which changes when a lock file is created or removed) and its pkginfo
+ * file are checked; a record that has changed is read again from the
+ * pkginfo file. So a query costs a few stat() calls instead of opening
+ * and parsing pkginfo files, and the registry is never trusted beyond
+ * what the file system shows.
+ *
+ * Files changed within REG_RACY seconds of being read may change again
+ * without their times changing; their records are always read again.
+ *
+ * The registry only describes the installed package directory; queries
+ * of a spool directory are not served here. The registry file is written
+ * back by pkgregFlush() if it has changed, replacing the old file by
+ * rename; if it cannot be written, the registry is kept in memory only.
+ *
+ * Public Methods:
+ *
+ *   pkgregFlush - write back the registry if it has changed
+ *   pkgregInfo - return the pkginfo() information of an instance
+ *   pkgregInst - return the instance at a position of the registry
+ *   pkgregOpen - bring the registry up to date with the package directory
+ *   pkgregParams - return the architecture and version of an instance
+ */
+
+#include <stdio.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <pkginfo.h>
+#include <pkgstrct.h>
+#include "libadm.h"
+#include "pkgreg.h"
+
+#define	REG_RACY	2	/* seconds */
+#define	REG_NALLOC	64	/* entries allocated at a time */
+
+/* a package instance of the registry */
+
+struct regent {
+	char		*re_str[RS_NSTR]; /* RS_*, or NULL if not set */
+	uint32_t	re_flags;	/* RF_* */
+	int		re_heap;	/* != 0 if re_str are malloc'd */
+	int		re_next;	/* next entry of hash chain, or -1 */
+	struct regid	re_dir;		/* instance directory */
+	struct regid	re_info;	/* pkginfo file */
+};
+
+/*
+ * the registry currently open
+ */
+
+static struct {
+	int		rg_open;	/* != 0 if the registry is open */
+	int		rg_dirty;	/* != 0 if the file is out of date */
+	char		rg_dir[PATH_MAX]; /* package directory described */
+	char		rg_path[PATH_MAX]; /* path of registry file */
+	void		*rg_map;	/* mapping of registry file */
+	size_t		rg_mapsize;	/* size of the mapping */
+	struct regid	rg_dirid;	/* package directory when read */
+	struct regent	*rg_ent;	/* instances, in directory order */
+	int		rg_nent;	/* number of instances */
+	int		*rg_hash;	/* first entry of each hash chain */
+	int		rg_nhash;	/* number of hash chains, power of 2 */
+} reg = {
+	.rg_open = 0,
+	.rg_dirty = 0,
+	.rg_dir = "",
+	.rg_path = "",
+	.rg_map = MAP_FAILED,
+	.rg_mapsize = 0,
+	.rg_dirid = { 0, 0, 0, 0, 0, 0, 0 },
+	.rg_ent = (struct regent *)NULL,
+	.rg_nent = 0,
+	.rg_hash = (int *)NULL,
+	.rg_nhash = 0
+};
+
+static int	regsync(void);
+static int	readdirectory(void);
+static void	readregistry(void);
+static int	writeregistry(void);
+static int	loadent(struct regent *a_ent);
+static int	checkent(struct regent *a_ent, int a_all);
+static int	lookup(char *a_inst);
+static int	mkhash(void);
+static void	getid(struct regid *r_id, char *a_path);
+static int	isracy(struct regid *a_id, time_t a_now);
+static void	freeent(struct regent *a_ent);
+static void	release(void);
+
+/*
+ * *****************************************************************************
+ * global external (public) functions
+ * *****************************************************************************
+ */
+
+/*
+ * Name:	pkgregOpen
+ * Description:	bring the registry up to date with the package directory
+ *		if that is the installed package directory
+ * Arguments:	none
+ * Returns:	int
+ *			>= 0 - the number of instances in the registry
+ *			< 0 - the registry cannot be used; the package
+ *			  directory must be read instead
+ */
+
+int
+pkgregOpen(void)
+{
+	if (regsync() != 0) {
+		return (-1);
+	}
+
+	return (reg.rg_nent);
+}
+
+/*
+ * Name:	pkgregInst
+ * Description:	return the instance at a position of the registry, in the
+ *		order the package directory was read in
+ * Arguments:	a_pos - (int) - [RO]
+ *			position, from 0 to the number of instances returned
+ *			by pkgregOpen()
+ * Returns:	char *
+ *			== NULL - no instance is at this position
+ *			!= NULL - the name of the instance, valid until the
+ *			  registry is next used
+ */
+
+char *
+pkgregInst(int a_pos)
+{
+	if (!reg.rg_open || (a_pos < 0) || (a_pos >= reg.rg_nent)) {
+		return ((char *)NULL);
+	}
+
+	return (reg.rg_ent[a_pos].re_str[RS_INST]);
+}
+
+/*
+ * Name:	pkgregInfo
+ * Description:	fill in a pkginfo structure for an installed instance, as
+ *		rdconfig() in pkginfo.c does from the pkginfo file
+ * Arguments:	info - (struct pkginfo *) - [RO, *RW]
+ *			structure to fill in; it must have been initialized
+ *		pkginst - (char *) - [RO, *RO]
+ *			package instance
+ * Returns:	int
+ *			== 0 - the structure has been filled in
+ *			< 0 - out of memory; errno is set
+ *			> 0 - the instance is not served by the registry;
+ *			  its pkginfo file must be read instead
+ */
+
+int
+pkgregInfo(struct pkginfo *info, char *pkginst)
+{
+	struct regent	*re;
+	char		**memloc;
+	int		i;
+	int		n;
+
+	if ((regsync() != 0) || ((n = lookup(pkginst)) < 0)) {
+		return (1);
+	}
+
+	re = &reg.rg_ent[n];
+
+	/* pkginfopen() reads the pkginfo file of .save.<pkginst> first */
+
+	if ((re->re_flags & RF_SAVE) || (checkent(re, 1) != 0) ||
+			(re->re_flags & (RF_NOINFO | RF_NOPARAM))) {
+		return (1);
+	}
+
+	for (i = 0; i < RS_NSTR; i++) {
+		switch (i) {
+		case RS_NAME:
+			memloc = &info->name;
+			break;
+		case RS_VERSION:
+			memloc = &info->version;
+			break;
+		case RS_ARCH:
+			memloc = &info->arch;
+			break;
+		case RS_VENDOR:
+			memloc = &info->vendor;
+			break;
+		case RS_BASEDIR:
+			memloc = &info->basedir;
+			break;
+		case RS_CATG:
+			memloc = &info->catg;
+			break;
+		default:
+			continue;
+		}
+
+		if (re->re_str[i] == (char *)NULL) {
+			continue;
+		}
+
+		if ((*memloc = strdup(re->re_str[i])) == (char *)NULL) {
+			errno = ENOMEM;
+			return (-1);
+		}
+	}
+
+	info->status = (re->re_flags & RF_PARTIAL) ? PI_PARTIAL :
+	    PI_INSTALLED;
+	info->pkginst = strdup(pkginst);
+
+	return (0);
+}
+
+/*
+ * Name:	pkgregParams
+ * Description:	return the architecture and version of an installed
+ *		instance, as ckinfo() in pkginfo.c reads them from the
+ *		pkginfo file of the instance directory
+ * Arguments:	a_inst - (char *) - [RO, *RO]
+ *			package instance
+ *		r_arch - (char **) - [RO, *RW]
+ *			set to the architecture, or NULL if not set
+ *		r_vers - (char **) - [RO, *RW]
+ *			set to the version, or NULL if not set
+ * Returns:	int
+ *			== 0 - the instance has a pkginfo file; the values
+ *			  returned are valid until the registry is next used
+ *			> 0 - the instance has no pkginfo file
+ *			< 0 - the instance is not served by the registry;
+ *			  its pkginfo file must be read instead
+ */
+
+int
+pkgregParams(char *a_inst, char **r_arch, char **r_vers)
+{
+	struct regent	*re;
+	int		n;
+
+	if ((regsync() != 0) || ((n = lookup(a_inst)) < 0)) {
+		return (-1);
+	}
+
+	re = &reg.rg_ent[n];
+	if (checkent(re, 0) != 0) {
+		return (-1);
+	}
+
+	if (re->re_flags & RF_NOINFO) {
+		return (1);
+	}
+
+	*r_arch = re->re_str[RS_ARCH];
+	*r_vers = re->re_str[RS_VERSION];
+
+	return (0);
+}
+
+/*
+ * Name:	pkgregFlush
+ * Description:	write back the registry file if the registry has changed
+ *		since it was read; failures are ignored
+ * Arguments:	none
+ * Returns:	void
+ */
+
+void
+pkgregFlush(void)
+{
+	if (reg.rg_open && reg.rg_dirty) {
+		(void) writeregistry();
+		reg.rg_dirty = 0;
+	}
+}
+
+/*
+ * *****************************************************************************
+ * static internal (private) functions
+ * *****************************************************************************
+ */
+
+/*
+ * open the registry of the installed package directory and read the
+ * directory again if it has changed
+ */
+
+static int
+regsync(void)
+{
+	struct regid	id;
+
+	if ((pkgdir == (char *)NULL) || (strcmp(pkgdir, get_PKGLOC()) != 0)) {
+		return (-1);
+	}
+
+	if (!reg.rg_open || (strcmp(reg.rg_dir, pkgdir) != 0)) {
+		release();
+		if ((snprintf(reg.rg_dir, sizeof (reg.rg_dir), "%s",
+				pkgdir) >= sizeof (reg.rg_dir)) ||
+			(snprintf(reg.rg_path, sizeof (reg.rg_path), "%s/%s",
+				get_PKGADM(), PKGREG_FILE) >=
+				sizeof (reg.rg_path))) {
+			reg.rg_dir[0] = '\0';
+			return (-1);
+		}
+		readregistry();
+		reg.rg_open = 1;
+	}
+
+	getid(&id, reg.rg_dir);
+	if (id.ri_ino == 0) {
+		return (-1);
+	}
+
+	if (memcmp(&id, &reg.rg_dirid, sizeof (struct regid)) != 0) {
+		if (readdirectory() != 0) {
+			release();
+			return (-1);
+		}
+	}
+
+	return (0);
+}
+
+/*
+ * read the package directory, keeping the entries of the instances still
+ * there; the entries of new instances are read when first used
+ */
+
+static int
+readdirectory(void)
+{
+	struct dirent	*dp;
+	struct regent	*ent = (struct regent *)NULL;
+	struct regent	*re;
+	struct regid	id;
+	DIR		*dirfp;
+	void		*p;
+	char		**save = (char **)NULL;
+	int		nsave = 0;
+	int		nalloc = 0;
+	int		n = 0;
+	int		i;
+
+	/* the identity is taken first so that later changes are seen */
+
+	getid(&id, reg.rg_dir);
+	if (isracy(&id, time((time_t *)NULL))) {
+		(void) memset(&id, '\0', sizeof (struct regid));
+	}
+
+	if ((dirfp = opendir(reg.rg_dir)) == (DIR *)NULL) {
+		return (-1);
+	}
+
+	while ((dp = readdir(dirfp)) != (struct dirent *)NULL) {
+		if (dp->d_name[0] == '.') {
+			if (strncmp(dp->d_name, ".save.", 6) != 0) {
+				continue;
+			}
+			p = realloc(save, (nsave + 1) * sizeof (char *));
+			if (p == NULL) {
+				goto nomem;
+			}
+			save = (char **)p;
+			if ((save[nsave] = strdup(dp->d_name + 6)) ==
+					(char *)NULL) {
+				goto nomem;
+			}
+			nsave++;
+			continue;
+		}
+
+		if (n >= nalloc) {
+			p = realloc(ent, (nalloc + REG_NALLOC) *
+					sizeof (struct regent));
+			if (p == NULL) {
+				goto nomem;
+			}
+			ent = (struct regent *)p;
+			nalloc += REG_NALLOC;
+		}
+
+		re = &ent[n];
+		if ((i = lookup(dp->d_name)) >= 0) {
+			/* taken over; the old entry no longer owns it */
+			*re = reg.rg_ent[i];
+			reg.rg_ent[i].re_str[RS_INST] = (char *)NULL;
+		} else {
+			(void) memset(re, '\0', sizeof (struct regent));
+			re->re_heap = 1;
+			re->re_flags = RF_RACY;
+			re->re_str[RS_INST] = strdup(dp->d_name);
+			if (re->re_str[RS_INST] == (char *)NULL) {
+				goto nomem;
+			}
+		}
+		re->re_flags &= ~RF_SAVE;
+		n++;
+	}
+	(void) closedir(dirfp);
+
+	for (i = 0; i < reg.rg_nent; i++) {
+		freeent(&reg.rg_ent[i]);
+	}
+	free(reg.rg_ent);
+
+	reg.rg_ent = ent;
+	reg.rg_nent = n;
+	reg.rg_dirid = id;
+	reg.rg_dirty = 1;
+
+	if (mkhash() != 0) {
+		goto nomem2;
+	}
+
+	for (i = 0; i < nsave; i++) {
+		if ((n = lookup(save[i])) >= 0) {
+			reg.rg_ent[n].re_flags |= RF_SAVE;
+		}
+		free(save[i]);
+	}
+	free(save);
+
+	return (0);
+
+nomem:
+	(void) closedir(dirfp);
+	for (i = 0; i < n; i++) {
+		freeent(&ent[i]);
+	}
+	free(ent);
+nomem2:
+	for (i = 0; i < nsave; i++) {
+		free(save[i]);
+	}
+	free(save);
+	errno = ENOMEM;
+	return (-1);
+}
+
+/* map the registry file; a missing or damaged file is treated as empty */
+
+static void
+readregistry(void)
+{
+	struct reghdr	*hdr;
+	struct regrec	*rec;
+	struct regent	*re;
+	struct stat	st;
+	char		*strs;
+	void		*map;
+	int		fd;
+	int		i;
+	int		j;
+
+	if ((fd = open(reg.rg_path, O_RDONLY)) < 0) {
+		return;
+	}
+
+	if ((fstat(fd, &st) != 0) ||
+			(st.st_size < sizeof (struct reghdr))) {
+		(void) close(fd);
+		return;
+	}
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, (off_t)0);
+	(void) close(fd);
+	if (map == MAP_FAILED) {
+		return;
+	}
+
+	hdr = (struct reghdr *)map;
+	rec = (struct regrec *)(hdr+1);
+	strs = (char *)(rec + hdr->rh_nrec);
+
+	if ((memcmp(hdr->rh_magic, PKGREG_MAGIC,
+			sizeof (hdr->rh_magic)) != 0) ||
+		(hdr->rh_version != PKGREG_VERSION) ||
+		(hdr->rh_nrec > INT_MAX / sizeof (struct regrec)) ||
+		(hdr->rh_strsize > st.st_size) ||
+		(st.st_size != sizeof (struct reghdr) +
+			hdr->rh_nrec * sizeof (struct regrec) +
+			hdr->rh_strsize) ||
+		((hdr->rh_strsize > 0) && (strs[hdr->rh_strsize-1] != '\0'))) {
+		(void) munmap(map, st.st_size);
+		return;
+	}
+
+	reg.rg_ent = (struct regent *)calloc(hdr->rh_nrec + 1,
+			sizeof (struct regent));
+	if (reg.rg_ent == (struct regent *)NULL) {
+		(void) munmap(map, st.st_size);
+		return;
+	}
+
+	for (i = 0; i < hdr->rh_nrec; i++) {
+		re = &reg.rg_ent[i];
+		for (j = 0; j < RS_NSTR; j++) {
+			if (rec[i].rr_str[j] == RS_NONE) {
+				continue;
+			}
+			if (rec[i].rr_str[j] >= hdr->rh_strsize) {
+				goto damaged;
+			}
+			re->re_str[j] = strs + rec[i].rr_str[j];
+		}
+		if (re->re_str[RS_INST] == (char *)NULL) {
+			goto damaged;
+		}
+		re->re_flags = rec[i].rr_flags;
+		re->re_dir = rec[i].rr_dir;
+		re->re_info = rec[i].rr_info;
+	}
+
+	reg.rg_nent = hdr->rh_nrec;
+	if (mkhash() != 0) {
+		reg.rg_nent = 0;
+		goto damaged;
+	}
+
+	reg.rg_map = map;
+	reg.rg_mapsize = st.st_size;
+	reg.rg_dirid = hdr->rh_dir;
+	return;
+
+damaged:
+	free(reg.rg_ent);
+	reg.rg_ent = (struct regent *)NULL;
+	(void) munmap(map, st.st_size);
+}
+
+/* replace the registry file by the registry open */
+
+static int
+writeregistry(void)
+{
+	struct reghdr	hdr;
+	struct regrec	rec;
+	struct regent	*re;
+	FILE		*fp;
+	char		tpath[PATH_MAX];
+	uint64_t	off;
+	int		fd;
+	int		i;
+	int		j;
+
+	if (snprintf(tpath, sizeof (tpath), "%s.XXXXXX", reg.rg_path) >=
+			sizeof (tpath)) {
+		return (-1);
+	}
+
+	if ((fd = mkstemp(tpath)) < 0) {
+		return (-1);
+	}
+
+	(void) fchmod(fd, 0644);
+
+	if ((fp = fdopen(fd, "w")) == (FILE *)NULL) {
+		(void) close(fd);
+		(void) unlink(tpath);
+		return (-1);
+	}
+
+	(void) memset(&hdr, '\0', sizeof (hdr));
+	(void) memcpy(hdr.rh_magic, PKGREG_MAGIC, sizeof (hdr.rh_magic));
+	hdr.rh_version = PKGREG_VERSION;
+	hdr.rh_nrec = reg.rg_nent;
+	hdr.rh_dir = reg.rg_dirid;
+	(void) fwrite(&hdr, sizeof (hdr), 1, fp);
+
+	/* the records, with the offsets the strings will have */
+
+	for (off = 0, i = 0; i < reg.rg_nent; i++) {
+		re = &reg.rg_ent[i];
+		(void) memset(&rec, '\0', sizeof (rec));
+		for (j = 0; j < RS_NSTR; j++) {
+			if (re->re_str[j] == (char *)NULL) {
+				rec.rr_str[j] = RS_NONE;
+				continue;
+			}
+			if (off >= RS_NONE) {
+				goto failed;
+			}
+			rec.rr_str[j] = (uint32_t)off;
+			off += strlen(re->re_str[j]) + 1;
+		}
+		rec.rr_flags = re->re_flags;
+		rec.rr_dir = re->re_dir;
+		rec.rr_info = re->re_info;
+		(void) fwrite(&rec, sizeof (rec), 1, fp);
+	}
+
+	for (i = 0; i < reg.rg_nent; i++) {
+		re = &reg.rg_ent[i];
+		for (j = 0; j < RS_NSTR; j++) {
+			if (re->re_str[j] != (char *)NULL) {
+				(void) fwrite(re->re_str[j],
+					strlen(re->re_str[j]) + 1, 1, fp);
+			}
+		}
+	}
+
+	/* the header is written again once the size of the strings is known */
+
+	hdr.rh_strsize = off;
+	if ((fseek(fp, 0L, SEEK_SET) != 0) ||
+		(fwrite(&hdr, sizeof (hdr), 1, fp) != 1)) {
+		goto failed;
+	}
+
+	if ((fflush(fp) != 0) || ferror(fp)) {
+		goto failed;
+	}
+
+	if ((fclose(fp) != 0) || (rename(tpath, reg.rg_path) != 0)) {
+		(void) unlink(tpath);
+		return (-1);
+	}
+
+	return (0);
+
+failed:
+	(void) fclose(fp);
+	(void) unlink(tpath);
+	return (-1);
+}
+
+/*
+ * read the entry of an instance from its pkginfo file; the pkginfo file
+ * is parsed as rdconfig() in pkginfo.c parses it
+ */
+
+static int
+loadent(struct regent *a_ent)
+{
+	struct regent	ent;
+	FILE		*fp;
+	char		path[PATH_MAX];
+	char		temp[256];
+	char		*inst = a_ent->re_str[RS_INST];
+	char		*value;
+	char		*pt;
+	char		*copy;
+	time_t		now;
+	int		count = 0;
+	int		i;
+
+	(void) memset(&ent, '\0', sizeof (ent));
+	ent.re_heap = 1;
+	ent.re_next = a_ent->re_next;
+	ent.re_flags = a_ent->re_flags & RF_SAVE;
+
+	now = time((time_t *)NULL);
+
+	/* freeent() releases an entry only once it has an instance */
+
+	if ((ent.re_str[RS_INST] = strdup(inst)) == (char *)NULL) {
+		return (-1);
+	}
+
+	if (snprintf(path, sizeof (path), "%s/%s", reg.rg_dir, inst) >=
+			sizeof (path)) {
+		freeent(&ent);
+		return (-1);
+	}
+	getid(&ent.re_dir, path);
+
+	if (snprintf(path, sizeof (path), "%s/%s/pkginfo", reg.rg_dir,
+			inst) >= sizeof (path)) {
+		freeent(&ent);
+		return (-1);
+	}
+	getid(&ent.re_info, path);
+
+	if ((fp = fopen(path, "r")) == (FILE *)NULL) {
+		ent.re_flags |= RF_NOINFO;
+	} else {
+		temp[0] = '\0';
+		while ((value = fpkgparam(fp, temp)) != (char *)NULL) {
+			if ((strcmp(temp, "ARCH") == 0) ||
+			    (strcmp(temp, "CATEGORY") == 0)) {
+				/* remove all whitespace from value */
+				pt = copy = value;
+				while (*pt) {
+					if (!isspace((unsigned char)*pt))
+						*copy++ = *pt;
+					pt++;
+				}
+				*copy = '\0';
+			}
+			count++;
+
+			if (strcmp(temp, "PKG") == 0)
+				i = RS_PKG;
+			else if (strcmp(temp, "NAME") == 0)
+				i = RS_NAME;
+			else if (strcmp(temp, "VERSION") == 0)
+				i = RS_VERSION;
+			else if (strcmp(temp, "ARCH") == 0)
+				i = RS_ARCH;
+			else if (strcmp(temp, "VENDOR") == 0)
+				i = RS_VENDOR;
+			else if (strcmp(temp, "BASEDIR") == 0)
+				i = RS_BASEDIR;
+			else if (strcmp(temp, "CATEGORY") == 0)
+				i = RS_CATG;
+			else
+				i = -1;
+
+			temp[0] = '\0';
+			if (i < 0) {
+				free(value);
+				continue;
+			}
+			free(ent.re_str[i]);
+			ent.re_str[i] = value;
+		}
+		(void) fclose(fp);
+
+		if (!count) {
+			ent.re_flags |= RF_NOPARAM;
+		}
+	}
+
+	if (snprintf(path, sizeof (path), "%s/%s/!I-Lock!", reg.rg_dir,
+			inst) >= sizeof (path)) {
+		freeent(&ent);
+		return (-1);
+	}
+	if (access(path, 0) == 0) {
+		ent.re_flags |= RF_PARTIAL;
+	} else {
+		if (snprintf(path, sizeof (path), "%s/%s/!R-Lock!",
+				reg.rg_dir, inst) >= sizeof (path)) {
+			freeent(&ent);
+			return (-1);
+		}
+		if (access(path, 0) == 0) {
+			ent.re_flags |= RF_PARTIAL;
+		}
+	}
+
+	if (isracy(&ent.re_dir, now) || isracy(&ent.re_info, now)) {
+		ent.re_flags |= RF_RACY;
+	}
+
+	freeent(a_ent);
+	*a_ent = ent;
+	reg.rg_dirty = 1;
+
+	return (0);
+}
+
+/*
+ * make sure an entry is up to date, checking its pkginfo file and, if
+ * a_all is set, its instance directory
+ */
+
+static int
+checkent(struct regent *a_ent, int a_all)
+{
+	struct regid	id;
+	char		path[PATH_MAX];
+	char		*inst = a_ent->re_str[RS_INST];
+
+	if (a_ent->re_flags & RF_RACY) {
+		return (loadent(a_ent));
+	}
+
+	if (snprintf(path, sizeof (path), "%s/%s/pkginfo", reg.rg_dir,
+			inst) >= sizeof (path)) {
+		return (-1);
+	}
+	getid(&id, path);
+	if (memcmp(&id, &a_ent->re_info, sizeof (struct regid)) != 0) {
+		return (loadent(a_ent));
+	}
+
+	if (a_all) {
+		if (snprintf(path, sizeof (path), "%s/%s", reg.rg_dir,
+				inst) >= sizeof (path)) {
+			return (-1);
+		}
+		getid(&id, path);
+		if (memcmp(&id, &a_ent->re_dir, sizeof (struct regid)) != 0) {
+			return (loadent(a_ent));
+		}
+	}
+
+	return (0);
+}
+
+/* find the entry of an instance; returns -1 if there is none */
+
+static int
+lookup(char *a_inst)
+{
+	unsigned long	h = 5381;
+	char		*p;
+	int		i;
+
+	if (reg.rg_hash == (int *)NULL) {
+		return (-1);
+	}
+
+	for (p = a_inst; *p != '\0'; p++) {
+		h = ((h << 5) + h) ^ (unsigned char)*p;
+	}
+
+	for (i = reg.rg_hash[h & (reg.rg_nhash - 1)]; i >= 0;
+			i = reg.rg_ent[i].re_next) {
+		if ((reg.rg_ent[i].re_str[RS_INST] != (char *)NULL) &&
+		    (strcmp(reg.rg_ent[i].re_str[RS_INST], a_inst) == 0)) {
+			return (i);
+		}
+	}
+
+	return (-1);
+}
+
+/* index the entries of the registry by instance */
+
+static int
+mkhash(void)
+{
+	unsigned long	h;
+	char		*p;
+	int		i;
+
+	free(reg.rg_hash);
+
+	for (reg.rg_nhash = 64; reg.rg_nhash < 2 * reg.rg_nent; )
+		reg.rg_nhash *= 2;
+
+	reg.rg_hash = (int *)malloc(reg.rg_nhash * sizeof (int));
+	if (reg.rg_hash == (int *)NULL) {
+		return (-1);
+	}
+
+	for (i = 0; i < reg.rg_nhash; i++) {
+		reg.rg_hash[i] = -1;
+	}
+
+	/* chained in reverse so that a chain is in directory order */
+
+	for (i = reg.rg_nent - 1; i >= 0; i--) {
+		h = 5381;
+		for (p = reg.rg_ent[i].re_str[RS_INST]; *p != '\0'; p++) {
+			h = ((h << 5) + h) ^ (unsigned char)*p;
+		}
+		h &= reg.rg_nhash - 1;
+		reg.rg_ent[i].re_next = reg.rg_hash[h];
+		reg.rg_hash[h] = i;
+	}
+
+	return (0);
+}
+
+static void
+getid(struct regid *r_id, char *a_path)
+{
+	struct stat	st;
+
+	(void) memset(r_id, '\0', sizeof (struct regid));
+
+	if (stat(a_path, &st) != 0) {
+		return;
+	}
+
+	r_id->ri_dev = (uint64_t)st.st_dev;
+	r_id->ri_ino = (uint64_t)st.st_ino;
+	r_id->ri_size = (uint64_t)st.st_size;
+	r_id->ri_mtime = (int64_t)st.st_mtim.tv_sec;
+	r_id->ri_mtimens = (uint32_t)st.st_mtim.tv_nsec;
+	r_id->ri_ctime = (int64_t)st.st_ctim.tv_sec;
+	r_id->ri_ctimens = (uint32_t)st.st_ctim.tv_nsec;
+}
+
+static int
+isracy(struct regid *a_id, time_t a_now)
+{
+	return ((a_id->ri_mtime >= a_now - REG_RACY) ||
+		(a_id->ri_ctime >= a_now - REG_RACY));
+}
+
+static void
+freeent(struct regent *a_ent)
+{
+	int	i;
+
+	/* an entry taken over by another has no instance */
+
+	if (!a_ent->re_heap || (a_ent->re_str[RS_INST] == (char *)NULL)) {
+		return;
+	}
+
+	for (i = 0; i < RS_NSTR; i++) {
+		free(a_ent->re_str[i]);
+		a_ent->re_str[i] = (char *)NULL;
+	}
+}
+
+static void
+release(void)
+{
+	int	i;
+
+	for (i = 0; i < reg.rg_nent; i++) {
+		freeent(&reg.rg_ent[i]);
+	}
+	free(reg.rg_ent);
+	free(reg.rg_hash);
+
+	if (reg.rg_map != MAP_FAILED) {
+		(void) munmap(reg.rg_map, reg.rg_mapsize);
+	}
+
+	(void) memset(&reg, '\0', sizeof (reg));
+	reg.rg_map = MAP_FAILED;
+}
@@ -0,0 +1,109 @@
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at src/OPENSOLARIS.LICENSE
+ * or http://www.opensolaris.org/os/licensing.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+#ifndef	_PKGREG_H
+#define	_PKGREG_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <sys/types.h>
+#include <inttypes.h>
+
+/*
+ * On-disk layout of the installed package registry ("pkgregistry").
+ *
+ * The registry consists of a fixed size header, followed by rh_nrec
+ * records in the order the package directory was read in, followed by
+ * rh_strsize bytes of null terminated strings that the records refer to
+ * by offset. A record describes one package instance directory: the
+ * parameters of its pkginfo file that pkginfo() returns, and whether a
+ * lock file marks the instance as partially installed.
+ *
+ * The header holds the identity of the package directory when it was read,
+ * and each record the identity of the instance directory and of its
+ * pkginfo file when they were read; an identity that no longer matches
+ * makes the part of the registry it covers stale.
+ *
+ * All values are stored in native byte order - the registry describes
+ * local files only and is never transported.
+ */
+
+#define	PKGREG_MAGIC	"PKGREGST"
+#define	PKGREG_VERSION	1
+#define	PKGREG_FILE	"pkgregistry"
+
+/* strings of a record */
+
+#define	RS_INST		0	/* package instance */
+#define	RS_PKG		1	/* PKG */
+#define	RS_NAME		2	/* NAME */
+#define	RS_ARCH		3	/* ARCH, without white space */
+#define	RS_VERSION	4	/* VERSION */
+#define	RS_VENDOR	5	/* VENDOR */
+#define	RS_BASEDIR	6	/* BASEDIR */
+#define	RS_CATG		7	/* CATEGORY, without white space */
+#define	RS_NSTR		8
+
+#define	RS_NONE		0xffffffffU	/* parameter not set */
+
+/* flags of a record */
+
+#define	RF_SAVE		0x01	/* a .save.<pkginst> directory exists */
+#define	RF_PARTIAL	0x02	/* !I-Lock! or !R-Lock! exists */
+#define	RF_NOINFO	0x04	/* there is no pkginfo file */
+#define	RF_NOPARAM	0x08	/* the pkginfo file has no parameters */
+#define	RF_RACY		0x10	/* changed too recently to be trusted */
+
+/* identity of a file; all 0 if it does not exist */
+
+struct regid {
+	uint64_t	ri_dev;
+	uint64_t	ri_ino;
+	uint64_t	ri_size;
+	int64_t		ri_mtime;
+	int64_t		ri_ctime;
+	uint32_t	ri_mtimens;
+	uint32_t	ri_ctimens;
+};
+
+struct reghdr {
+	char		rh_magic[8];	/* PKGREG_MAGIC */
+	uint32_t	rh_version;	/* PKGREG_VERSION */
+	uint32_t	rh_nrec;	/* number of records */
+	uint64_t	rh_strsize;	/* size of the strings */
+	struct regid	rh_dir;		/* package directory */
+};
+
+struct regrec {
+	uint32_t	rr_str[RS_NSTR]; /* offsets of strings, or RS_NONE */
+	uint32_t	rr_flags;	/* RF_* */
+	uint32_t	rr_pad;		/* unused, zero */
+	struct regid	rr_dir;		/* instance directory */
+	struct regid	rr_info;	/* pkginfo file */
+};
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _PKGREG_H */
@@ -9,7 +9,7 @@ OBJ = copyf.o cvtpath.o depchk.o dockdeps.o doulimit.o dryrun.o echo.o \
 	is_local_host.o isreloc.o listmgr.o lockinst.o log.o mntinfo.o \
 	nblk.o ocfile.o open_package_datastream.o pathdup.o pkgdbmerg.o \
 	pkgobjmap.o pkgops.o pkgpatch.o procmap.o ptext.o \
-	putparam.o qreason.o qstrdup.o setadmin.o setlist.o \
+	putparam.o qreason.o qstrdup.o rdepindex.o setadmin.o setlist.o \
 	setup_temporary_directory.o sml.o srcpath.o \
 	unpack_package_from_stream.o scriptvfy.o \
 	getvfsent.o resolvepath.o
@@ -167,6 +167,11 @@ qstrdup.o: qstrdup.c ../libpkg/pkglib.h ../hdrs/pkgdev.h \
   ../hdrs/pkgstrct.h ../libpkg/pkgerr.h ../libpkg/keystore.h \
   ../libpkg/cfext.h ../hdrs/libinst.h ../hdrs/pkginfo.h ../libpkg/cfext.h \
   ../hdrs/install.h
+rdepindex.o: rdepindex.c ../hdrs/pkgstrct.h ../hdrs/pkginfo.h \
+  ../libpkg/pkglib.h ../hdrs/pkgdev.h ../libpkg/pkgerr.h \
+  ../libpkg/keystore.h ../libpkg/cfext.h ../hdrs/libinst.h \
+  ../libpkg/cfext.h ../hdrs/install.h ../hdrs/libadm.h  \
+  ../hdrs/sys/dklabel.h ../hdrs/valtools.h ../hdrs/messages.h
 resolvepath.o: resolvepath.c
 scriptvfy.o: scriptvfy.c ../libpkg/pkglib.h
 setadmin.o: setadmin.c ../hdrs/pkglocs.h ../libpkg/pkglib.h \
@@ -51,6 +51,11 @@
 #include <locale.h>
 #include <libintl.h>
 #include <sys/mman.h>
+#ifdef	__linux__
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <linux/fs.h>
+#endif
 
 /*
  * consolidation pkg command library includes
@@ -80,6 +85,11 @@
 #define	MAXMAPSIZE	(1024*1024*8)-(1024*16)	/* map at most 8MB */
 #define	SMALLFILESIZE	(32*1024)	/* dont mmap files less than 32kb */
 
+#ifdef	__linux__
+static int	copyKernel(int a_srcFd, int a_dstFd, off_t a_size,
+			char **r_via);
+#endif
+
 /*
  * Name:	copyF
  * Description:	fast copy of file - use mmap()/write() loop if possible
@@ -195,7 +205,8 @@ copyf(char *a_srcPath, char *a_dstPath, time_t a_mytime)
 
 /*
  * Name:	copyFile
- * Description:	fast copy of file - use mmap()/write() loop if possible
+ * Description:	fast copy of file - let the kernel copy the data if possible,
+ *		otherwise use mmap()/write() loop if possible
  * Arguments:	int srcFd - file descriptor open on source file
  *		int dstFd - file descriptor open on target file
  *		char *srcPath - name of source file (for error messages)
@@ -219,6 +230,27 @@ copyFile(int a_srcFd, int a_dstFd, char *a_srcPath, char *a_dstPath,
 
 	echoDebug(DBG_COPY_FILE, a_srcPath, a_dstPath);
 
+#ifdef	__linux__
+	/*
+	 * if the source is a regular file, try to have the kernel copy the
+	 * data without passing it through this process
+	 */
+
+	if (S_ISREG(a_srcStatbuf->st_mode) && (filesize > 0)) {
+		char	*via;
+
+		switch (copyKernel(a_srcFd, a_dstFd, filesize, &via)) {
+		case 0:
+			echoDebug(DBG_COPY_FILE_VIA, a_srcPath, a_dstPath,
+				via);
+			return (0);
+		case 1:
+			progerr(ERR_WRITE, a_dstPath, errno, strerror(errno));
+			return (1);
+		}
+	}
+#endif
+
 	/*
 	 * if the source is a regular file and is not "too small", then cause
 	 * the file to be mapped into memory
@@ -297,6 +329,8 @@ copyFile(int a_srcFd, int a_dstFd, char *a_srcPath, char *a_dstPath,
 			if (n == 0) {
 				/* end of file - return success */
 				(void) free(buf);
+				echoDebug(DBG_COPY_FILE_VIA, a_srcPath,
+					a_dstPath, "read");
 				return (0);
 			} else if (n < 0) {
 				/* read error - return error */
@@ -416,9 +450,91 @@ copyFile(int a_srcFd, int a_dstFd, char *a_srcPath, char *a_dstPath,
 
 	(void) munmap(cp, munmapsize);
 
+	echoDebug(DBG_COPY_FILE_VIA, a_srcPath, a_dstPath, "mmap");
+
 	return (0);
 }
 
+#ifdef	__linux__
+/*
+ * Name:	copyKernel
+ * Description:	copy a regular file inside the kernel: share the blocks of the
+ *		source with the target if the file system supports it (reflink),
+ *		else copy with copy_file_range(), else with sendfile()
+ * Arguments:	int a_srcFd - file descriptor open on source file
+ *		int a_dstFd - file descriptor open on target file; the data is
+ *			written at its current offset
+ *		off_t a_size - size of source file
+ *		char **r_via - set to the name of the method that was used
+ * Returns:	int
+ *		== 0 - successful
+ *		== 1 - failure after part of the data was copied; errno is set
+ *		== -1 - no data was copied, copy the file in user space
+ */
+
+static int
+copyKernel(int a_srcFd, int a_dstFd, off_t a_size, char **r_via)
+{
+	struct stat	dstStatbuf;
+	loff_t		cfroff = 0;
+	off_t		sfoff = 0;
+	ssize_t		n;
+
+	if ((fstat(a_dstFd, &dstStatbuf) != 0) ||
+	    !S_ISREG(dstStatbuf.st_mode)) {
+		return (-1);
+	}
+
+#ifdef	FICLONE
+	/* a reflink replaces all of the target, so it must be empty */
+
+	if ((dstStatbuf.st_size == 0) &&
+	    (lseek(a_dstFd, (off_t)0, SEEK_CUR) == 0) &&
+	    (ioctl(a_dstFd, FICLONE, a_srcFd) == 0)) {
+		(void) lseek(a_dstFd, a_size, SEEK_SET);
+		*r_via = "reflink";
+		return (0);
+	}
+#endif
+
+	/* both calls may copy less than asked for - loop until done */
+
+	*r_via = "copy_file_range";
+	while ((n = copy_file_range(a_srcFd, &cfroff, a_dstFd, NULL,
+	    (size_t)(a_size - cfroff), 0)) > 0) {
+		if (cfroff >= a_size) {
+			return (0);
+		}
+	}
+
+	/* unsupported between these files (or the source shrunk) */
+
+	if (cfroff > 0) {
+		if (n == 0) {
+			errno = EIO;
+		}
+		return (1);
+	}
+
+	*r_via = "sendfile";
+	while ((n = sendfile(a_dstFd, a_srcFd, &sfoff,
+	    (size_t)(a_size - sfoff))) > 0) {
+		if (sfoff >= a_size) {
+			return (0);
+		}
+	}
+
+	if (sfoff > 0) {
+		if (n == 0) {
+			errno = EIO;
+		}
+		return (1);
+	}
+
+	return (-1);
+}
+#endif	/* __linux__ */
+
 /*
  * Name:	openLocal
  * Description:	open a file and assure that the descriptor returned is open on
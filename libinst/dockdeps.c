@@ -44,7 +44,6 @@
 #include <unistd.h>
 #include <string.h>
 #include <ctype.h>
-#include <dirent.h>
 #include <sys/types.h>
 #include <pkgstrct.h>
 #include <pkginfo.h>
@@ -116,6 +115,12 @@ dockdeps(char *a_depfile, int a_removeFlag, boolean_t a_preinstallCheck)
 	int	i;
 	char	*inst;
 
+	/* installed packages and what they depend on */
+
+	if (!pkgdir)
+		pkgdir = get_PKGLOC();
+	(void) rdepOpen(pkgdir, get_PKGADM());
+
 	if (a_removeFlag) {
 		/* check removal dependencies */
 		rmpkginst = a_depfile;
@@ -162,15 +167,21 @@ dockdeps(char *a_depfile, int a_removeFlag, boolean_t a_preinstallCheck)
 		}
 		(void) snprintf(wabbrev, sizeof (wabbrev), "%s.*", abbrev);
 
-		do {
-			inst = fpkginst(wabbrev, alist[i], vlist[i]);
-			if (inst && (pkginfo(&info, inst, NULL, NULL) == 0)) {
-				pkgexist++;
-				if (info.status == PI_INSTALLED)
-					pkgokay++;
-			}
-		} while (++i < nlist);
-		(void) fpkginst(NULL); 	/* force closing/rewind of files */
+		/* no need to scan the package directory if none is there */
+
+		if (rdepInstalled(wabbrev)) {
+			do {
+				inst = fpkginst(wabbrev, alist[i], vlist[i]);
+				if (inst &&
+				    (pkginfo(&info, inst, NULL, NULL) == 0)) {
+					pkgexist++;
+					if (info.status == PI_INSTALLED)
+						pkgokay++;
+				}
+			} while (++i < nlist);
+			/* force closing/rewind of files */
+			(void) fpkginst(NULL);
+		}
 
 		if (!info.name) {
 			info.name = name;
@@ -195,6 +206,7 @@ done:
 	if (a_removeFlag) {
 		ckrdeps(a_preinstallCheck);
 	}
+	rdepClose();
 
 	return (errflg);
 }
@@ -397,31 +409,29 @@ getline(FILE *fp)
 	return ((found >= 0) ? 1 : 0);
 }
 
+/*
+ * only the depend files of the packages that the index lists as naming
+ * the package removed in a 'P' entry are read
+ */
+
 static void
 ckrdeps(boolean_t a_preinstallCheck)
 {
-	struct dirent *drp;
-	DIR	*dirfp;
 	FILE	*fp;
 	char	depfile[PATH_MAX+1];
+	char	*dname;
+	int	pos = 0;
 
-	if ((dirfp = opendir(pkgdir)) == NULL)
-		return;
-
-	while ((drp = readdir(dirfp)) != NULL) {
-		if (drp->d_name[0] == '.')
-			continue;
-
-		if (strcmp(drp->d_name, rmpkginst) == 0)
+	while ((dname = rdepDependent(rmpkg, &pos)) != NULL) {
+		if (strcmp(dname, rmpkginst) == 0)
 			continue; /* others don't include me */
 		(void) snprintf(depfile, sizeof (depfile),
-				"%s/%s/%s", pkgdir, drp->d_name, DEPEND_FILE);
+				"%s/%s/%s", pkgdir, dname, DEPEND_FILE);
 		if ((fp = fopen(depfile, "r")) == NULL)
 			continue;
 
-		ckpreq(fp, drp->d_name, a_preinstallCheck);
+		ckpreq(fp, dname, a_preinstallCheck);
 	}
-	(void) closedir(dirfp);
 }
 
 static void
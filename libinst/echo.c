@@ -93,13 +93,15 @@ echo(char *fmt, ...)
 	/* output message if echoing is enabled */
 
 	if (echoFlag == B_TRUE) {
+		FILE	*fp = get_msg_stream();
+
 		va_start(ap, fmt);
 
-		(void) vfprintf(stderr, fmt, ap);
+		(void) vfprintf(fp, fmt, ap);
 
 		va_end(ap);
 
-		(void) putc('\n', stderr);
+		(void) putc('\n', fp);
 	}
 }
 
@@ -133,22 +135,23 @@ echoDebug(char *a_fmt, ...)
 
 	if (debugFlag == B_TRUE) {
 		char	*p = get_prog_name();
+		FILE	*fp = get_msg_stream();
 
-		(void) fprintf(stderr, "# [%6d %3d", getpid(), getzoneid());
+		(void) fprintf(fp, "# [%6d %3d", getpid(), getzoneid());
 
 		if ((p != (char *)NULL) && (*p != '\0')) {
-			fprintf(stderr, " %-11s", p);
+			fprintf(fp, " %-11s", p);
 		}
 
-		(void) fprintf(stderr, "] ");
+		(void) fprintf(fp, "] ");
 
 		va_start(ap, a_fmt);
 
-		(void) vfprintf(stderr, a_fmt, ap);
+		(void) vfprintf(fp, a_fmt, ap);
 
 		va_end(ap);
 
-		(void) putc('\n', stderr);
+		(void) putc('\n', fp);
 	}
 }
 
@@ -88,6 +88,8 @@
 #define	ERR_NOSTATV	"statvfs(%s) failed"
 #define	ERR_NOUPD	"unable to update contents file"
 #define	ERR_DRCONTCP	"unable to copy contents file to <%s>"
+#define	ERR_NOJNLOPEN	"unable to read contents file journal of <%s>"
+#define	ERR_NOJNLAPPEND	"WARNING: unable to append to journal of <%s>"
 
 #define	MSG_XWTING	"NOTE: Waiting for exclusive access to the package " \
 				"database."
@@ -109,6 +111,7 @@ static char	*pkgadm_dir;
 
 static int	pkgWlock(int verbose);
 static int	pkgWunlock(void);
+static int	cpjcfile(char *a_srcPath, char *a_dstPath);
 
 /*
  * This VFP is used to cache the last copy of the contents file that was
@@ -135,6 +138,21 @@ static VFP_T	*contentsVfp = {(VFP_T *)NULL};
 
 #define	CONTENTS_DELTA	(32*1024*1024)	/* 32mb */
 
+/*
+ * When a batch of packages is added, the contents file updates of all of
+ * the packages are journaled without regard to the size of the journal,
+ * and the journal is folded into the contents file once at the end of the
+ * batch (see begin_cfbatch()/end_cfbatch()).
+ */
+
+#define	CFBATCH_NONE	0	/* not part of a batch */
+#define	CFBATCH_MEMBER	1	/* update is part of a batch */
+#define	CFBATCH_END	2	/* end of batch: rewrite the contents file */
+
+static int	cfbatch = CFBATCH_NONE;
+static int	cfbatchjnl = 0;	/* journal was created for the batch */
+static int	cfmerged = 0;	/* journaled entries in last contents opened */
+
 /* forward declarations */
 
 int relslock(void);
@@ -205,9 +223,16 @@ set_cfdir(char *cfdir)
 		(void) close(n);
 	} else {
 
-		/* contents file exists, save in pkgadm-dir */
+		/*
+		 * contents file exists, save in pkgadm-dir; if updates to
+		 * the contents file are journaled, save the merged data
+		 */
 
-		status = copyf(realcf, tmpcf, (time_t)0);
+		if (cfjnlEnabled(realcf)) {
+			status = cpjcfile(realcf, tmpcf);
+		} else {
+			status = copyf(realcf, tmpcf, (time_t)0);
+		}
 		if (status != 0) {
 			progerr(gettext(ERR_DRCONTCP), tmpcf);
 			return (99);
@@ -232,7 +257,9 @@ ocfile(VFP_T **r_mapvfp, VFP_T **r_tmpvfp, ulong_t map_blks)
 	VFP_T		*mapvfp = (VFP_T *)NULL;
 	VFP_T		*tmpvfp = (VFP_T *)NULL;
 	char		contents[PATH_MAX];
+	int		jnl;
 	int		n;
+	size_t		cfsize;
 
 	/* reset return VFP/FILE pointers */
 
@@ -282,6 +309,21 @@ ocfile(VFP_T **r_mapvfp, VFP_T **r_tmpvfp, ulong_t map_blks)
 		return (0);
 	}
 
+	/*
+	 * attach any journaled updates; srchcfile() merges them with the
+	 * contents file data and records the entries looked up for
+	 * swapcfile()
+	 */
+
+	if ((jnl = cfjnlOpen(mapvfp, 1)) < 0) {
+		int	lerrno = errno;
+
+		progerr(gettext(ERR_NOJNLOPEN), contents);
+		logerr(gettext(ERR_ERRNO), lerrno, strerror(lerrno));
+		(void) vfpClose(&mapvfp);
+		return (0);
+	}
+
 	/*
 	 * Check and see if there is enough space for the packaging commands
 	 * to back up the contents file, if there is not, then do not allow
@@ -295,6 +337,7 @@ ocfile(VFP_T **r_mapvfp, VFP_T **r_tmpvfp, ulong_t map_blks)
 
 		progerr(gettext(ERR_NOSTAT), contents);
 		logerr(gettext(ERR_ERRNO), lerrno, strerror(lerrno));
+		cfjnlClose();
 		(void) vfpClose(&mapvfp);
 		return (0);
 	}
@@ -306,6 +349,7 @@ ocfile(VFP_T **r_mapvfp, VFP_T **r_tmpvfp, ulong_t map_blks)
 
 		progerr(gettext(ERR_NOSTATV), contents);
 		logerr(gettext(ERR_ERRNO), lerrno, strerror(lerrno));
+		cfjnlClose();
 		(void) vfpClose(&mapvfp);
 		return (0);
 	}
@@ -322,13 +366,18 @@ ocfile(VFP_T **r_mapvfp, VFP_T **r_tmpvfp, ulong_t map_blks)
 	 * Calculate the number of blocks we need to be able to operate on
 	 * the contents file.
 	 */
+	cfmerged = (jnl > 0);
+
+	cfsize = statb.st_size + cfjnlSize(mapvfp);
+
 	need_blocks = map_blks +
-		nblk(statb.st_size, svfsb.f_bsize, svfsb.f_frsize);
+		nblk(cfsize, svfsb.f_bsize, svfsb.f_frsize);
 
 	if ((need_blocks + 10) > free_blocks) {
 		progerr(gettext(ERR_CFBACK), contents);
 		progerr(gettext(ERR_CFBACK1), need_blocks, free_blocks,
 			DEV_BSIZE);
+		cfjnlClose();
 		(void) vfpClose(&mapvfp);
 		return (0);
 	}
@@ -347,6 +396,7 @@ ocfile(VFP_T **r_mapvfp, VFP_T **r_tmpvfp, ulong_t map_blks)
 
 		progerr(gettext(ERR_NOTMPOPEN));
 		logerr(gettext(ERR_ERRNO), lerrno, strerror(lerrno));
+		cfjnlClose();
 		(void) vfpClose(&mapvfp);
 		return (0);
 	}
@@ -356,12 +406,13 @@ ocfile(VFP_T **r_mapvfp, VFP_T **r_tmpvfp, ulong_t map_blks)
 	 * size of the in-memory buffer associated with the open vfp.
 	 */
 
-	if (vfpSetSize(tmpvfp, statb.st_size + CONTENTS_DELTA) != 0) {
+	if (vfpSetSize(tmpvfp, cfsize + CONTENTS_DELTA) != 0) {
 		int	lerrno = errno;
 
 		progerr(gettext(ERR_NOTMPOPEN));
 		logerr(gettext(ERR_ERRNO), lerrno, strerror(lerrno));
 		(void) vfpClose(&tmpvfp);
+		cfjnlClose();
 		(void) vfpClose(&mapvfp);
 		return (0);
 	}
@@ -373,6 +424,18 @@ ocfile(VFP_T **r_mapvfp, VFP_T **r_tmpvfp, ulong_t map_blks)
 
 	(void) vfpSetFlags(mapvfp, VFP_NEEDNOW);
 
+	/*
+	 * use the contents file indexes for path and package lookups if they
+	 * are current
+	 */
+
+	(void) cfidxOpen(mapvfp);
+	if (cfpkxOpen(mapvfp) < 0) {
+		/* rebuild a missing or stale package index under the lock */
+		(void) cfpkxWrite(mapvfp, contents);
+		(void) cfpkxOpen(mapvfp);
+	}
+
 	/* set return ->s to open vfps */
 
 	(*r_mapvfp) = mapvfp;
@@ -432,6 +495,27 @@ socfile(VFP_T **r_mapvfp)
 		return (0);
 	}
 
+	n = cfjnlOpen(mapvfp, 0);
+	if (n < 0) {
+		int lerrno = errno;
+
+		progerr(gettext(ERR_NOJNLOPEN), contents);
+		logerr(gettext(ERR_ERRNO), lerrno, strerror(lerrno));
+		(void) vfpClose(&mapvfp);
+		return (0);
+	}
+
+	cfmerged = (n > 0);
+
+	/*
+	 * use the contents file indexes if they are current; a missing or
+	 * stale package index is not rebuilt here, as the database may not
+	 * be locked - package lookups then scan the contents file
+	 */
+
+	(void) cfidxOpen(mapvfp);
+	(void) cfpkxOpen(mapvfp);
+
 	*r_mapvfp = mapvfp;
 
 	return (1);
@@ -470,6 +554,9 @@ socfile(VFP_T **r_mapvfp)
  * NOTES: If dbchg != 0, the contents file is always updated. If dbchg == 0,
  *		the contents file is updated IF the data is modified indication
  *		is set on the contents file associated with a_cfTmpVfp.
+ *		If updates to the contents file are journaled, the update is
+ *		normally appended to the journal instead of rewriting the
+ *		contents file; no "last modified by" comments are written then.
  */
 
 int
@@ -483,6 +570,9 @@ swapcfile(VFP_T **a_cfVfp, VFP_T **a_cfTmpVfp, char *pkginst, int dbchg)
 	char	sContentsPath[PATH_MAX] = {'\0'};
 	char	tContentsPath[PATH_MAX] = {'\0'};
 	char	timeb[BUFSIZ];
+	int	jnl;
+	int	journaled = 0;
+	int	orphan;
 	int	retval = RESULT_OK;
 	struct tm	*timep;
 	time_t	clock;
@@ -506,6 +596,44 @@ swapcfile(VFP_T **a_cfVfp, VFP_T **a_cfTmpVfp, char *pkginst, int dbchg)
 	(void) snprintf(sContentsPath, sizeof (sContentsPath),
 			"%s/s.contents", pkgadm_dir);
 
+	cfidxClose();
+	cfpkxClose();
+
+	/*
+	 * If updates to the contents file are journaled and changes were made,
+	 * just record the entries that changed in the journal - the contents
+	 * file is rewritten in full (starting the journal anew) when the
+	 * journal has grown too large or cannot be appended to.
+	 */
+
+	jnl = cfjnlEnabled(contentsPath);
+
+	/*
+	 * a journal left behind by a batch of packages that was not finished
+	 * (see begin_cfbatch()) is folded into the contents file and removed
+	 * by the next update
+	 */
+
+	orphan = jnl && cfjnlOrphaned(contentsPath);
+
+	if (jnl && !orphan && (cfbatch != CFBATCH_END) &&
+		((dbchg != 0) || (vfpGetModified(*a_cfTmpVfp) != 0))) {
+		int	n;
+
+		n = cfjnlAppend(*a_cfVfp, *a_cfTmpVfp, contentsPath,
+			(cfbatch == CFBATCH_MEMBER));
+		if (n == 0) {
+			journaled = 1;
+		} else if (n < 0) {
+			int	lerrno = errno;
+
+			logerr(gettext(ERR_NOJNLAPPEND), contentsPath);
+			logerr(gettext(ERR_ERRNO), lerrno, strerror(lerrno));
+		}
+	}
+
+	cfjnlClose();
+
 	/* original contents file no longer needed - close */
 
 	if (vfpClose(a_cfVfp) != 0) {
@@ -516,15 +644,24 @@ swapcfile(VFP_T **a_cfVfp, VFP_T **a_cfTmpVfp, char *pkginst, int dbchg)
 		retval = RESULT_WRN;
 	}
 
+	/* the journal holds the changes - the contents file is unchanged */
+
+	if (journaled) {
+		vfpClose(a_cfTmpVfp);
+		return (relslock() == 0 ? RESULT_ERR : retval);
+	}
+
 	/*
 	 * If no changes were made to the database, checkpoint the temporary
 	 * contents file - if this fails, then just close the file which causes
-	 * the contents file to be reopened and reread if it is needed again
+	 * the contents file to be reopened and reread if it is needed again.
+	 * If the contents file is journaled the temporary contents file is
+	 * not a checkpoint of the contents file alone, so just close it.
 	 */
 
 	if ((dbchg == 0) && (vfpGetModified(*a_cfTmpVfp) == 0)) {
-		if (vfpCheckpointFile(&contentsVfp, a_cfTmpVfp,
-							contentsPath) != 0) {
+		if (jnl || (vfpCheckpointFile(&contentsVfp, a_cfTmpVfp,
+							contentsPath) != 0)) {
 			vfpClose(a_cfTmpVfp);
 		}
 		(void) pkgWunlock();	/* Free the database lock. */
@@ -617,7 +754,24 @@ swapcfile(VFP_T **a_cfVfp, VFP_T **a_cfTmpVfp, char *pkginst, int dbchg)
 		return (RESULT_ERR);
 	}
 
-	if (rename(tContentsPath, contentsPath) != 0) {
+	if (rename(tContentsPath, contentsPath) == 0) {
+		/*
+		 * the new contents file includes all journaled changes;
+		 * a journal that cannot be reset no longer applies to
+		 * the new contents file and is ignored by readers
+		 */
+		(void) cfjnlReset(contentsPath);
+		if (orphan) {
+			(void) cfjnlRemove(contentsPath);
+		}
+
+		/*
+		 * index the new contents file; on failure the indexes are
+		 * removed and lookups fall back to scanning the file
+		 */
+		(void) cfidxWrite(*a_cfTmpVfp, contentsPath);
+		(void) cfpkxWrite(*a_cfTmpVfp, contentsPath);
+	} else {
 		int	lerrno = errno;
 
 		progerr(gettext(ERR_NORENAME_CONTENTS), contentsPath,
@@ -854,3 +1008,173 @@ vcfile(void)
 	logerr(gettext(ERR_ERRNO), lerrno, strerror(lerrno));
 	return (0);	/* failure */
 }
+
+/*
+ * Name:	begin_cfbatch
+ * Description:	prepare the contents file for the addition of a batch of
+ *		packages: the updates of each package of the batch are
+ *		journaled, and end_cfbatch() folds the journal into the
+ *		contents file once all packages have been added. Each package
+ *		of the batch must be added by a process that calls
+ *		set_cfbatch(). The journal records the calling process as the
+ *		owner of the batch: if the process exits without calling
+ *		end_cfbatch(), the next update of the contents file (or the
+ *		next batch) folds the journal and removes it.
+ * Returns:	int
+ *			== 0 - the contents file cannot be journaled; the
+ *				packages must be added one at a time
+ *			!= 0 - contents file updates will be journaled
+ */
+
+int
+begin_cfbatch(void)
+{
+	char	contents[PATH_MAX];
+	int	n;
+
+	if (pkgadm_dir == NULL) {
+		if (set_cfdir(NULL) != 0) {
+			return (0);
+		}
+	}
+
+	(void) snprintf(contents, sizeof (contents), "%s/contents", pkgadm_dir);
+
+	/* enable journaling for the batch unless already enabled */
+
+	n = cfjnlCreate(contents);
+	if (n < 0) {
+		return (0);
+	}
+
+	cfbatchjnl = (n == 0);
+
+	return (1);
+}
+
+/*
+ * Name:	set_cfbatch
+ * Description:	mark the contents file updates of this process as part of
+ *		a batch started by begin_cfbatch() - if the updates are
+ *		journaled, the journal is not folded into the contents file
+ *		however large it grows.
+ * Returns:	void
+ */
+
+void
+set_cfbatch(void)
+{
+	cfbatch = CFBATCH_MEMBER;
+}
+
+/*
+ * Name:	end_cfbatch
+ * Description:	fold the updates journaled during a batch started by
+ *		begin_cfbatch() into the contents file
+ * Arguments:	a_pkginst - (char *) - [RO, *RO]
+ *			name of the last package of the batch; this is used to
+ *			write the "last modified by xxx" comment at the end of
+ *			the contents file.
+ * Returns:	int
+ *			== 0 - the contents file could not be rewritten; the
+ *				updates remain in the journal
+ *			!= 0 - the contents file holds all updates
+ */
+
+int
+end_cfbatch(char *a_pkginst)
+{
+	VFP_T		*mapvfp = (VFP_T *)NULL;
+	VFP_T		*tmpvfp = (VFP_T *)NULL;
+	char		contents[PATH_MAX];
+	int		n;
+	struct cfent	ent;
+
+	if (!ocfile(&mapvfp, &tmpvfp, 0L)) {
+		return (0);
+	}
+
+	/* rewrite the contents file if anything was journaled */
+
+	if (cfmerged) {
+		(void) srchcfile(&ent, (char *)NULL, mapvfp, tmpvfp);
+
+		cfbatch = CFBATCH_END;
+		n = swapcfile(&mapvfp, &tmpvfp, a_pkginst, 1);
+		cfbatch = CFBATCH_NONE;
+	} else {
+		n = swapcfile(&mapvfp, &tmpvfp, a_pkginst, 0);
+	}
+
+	/* disable journaling again if it was enabled for the batch */
+
+	if (cfbatchjnl != 0) {
+		cfbatchjnl = 0;
+		if (pkgWlock(0)) {
+			(void) snprintf(contents, sizeof (contents),
+				"%s/contents", pkgadm_dir);
+			(void) cfjnlRemove(contents);
+			(void) pkgWunlock();
+		}
+	}
+
+	return (n != RESULT_ERR);
+}
+
+/*
+ * Name:	cpjcfile
+ * Description:	copy a journaled contents file, merging the journal into the
+ *		copy so that the copy can be used without the journal
+ * Arguments:	a_srcPath - (char *) - [RO, *RO]
+ *			path of the journaled contents file to copy
+ *		a_dstPath - (char *) - [RO, *RO]
+ *			path of the file to create
+ * Returns:	int
+ *			== 0 - the contents file was copied
+ *			!= 0 - the contents file could not be copied
+ */
+
+static int
+cpjcfile(char *a_srcPath, char *a_dstPath)
+{
+	VFP_T		*tmpvfp = (VFP_T *)NULL;
+	VFP_T		*vfp = (VFP_T *)NULL;
+	int		n;
+	size_t		len;
+	struct cfent	ent;
+
+	if (vfpOpen(&vfp, a_srcPath, "r", VFP_NEEDNOW) != 0) {
+		return (1);
+	}
+
+	if (cfjnlOpen(vfp, 0) < 0) {
+		(void) vfpClose(&vfp);
+		return (1);
+	}
+
+	/* copy the merged entries to an in-memory file */
+
+	len = vfpGetLastCharPtr(vfp) - vfpGetFirstCharPtr(vfp) + 1;
+
+	if ((vfpOpen(&tmpvfp, (char *)NULL, "w", VFP_NONE) != 0) ||
+		(vfpSetSize(tmpvfp, len + cfjnlSize(vfp) + 1) != 0)) {
+		cfjnlClose();
+		(void) vfpClose(&tmpvfp);
+		(void) vfpClose(&vfp);
+		return (1);
+	}
+
+	(void) srchcfile(&ent, (char *)NULL, vfp, tmpvfp);
+
+	cfjnlClose();
+	(void) vfpClose(&vfp);
+
+	n = vfpWriteToFile(tmpvfp, a_dstPath);
+	if (n != 0) {
+		(void) remove(a_dstPath);
+	}
+
+	(void) vfpClose(&tmpvfp);
+
+	return (n != 0);
+}
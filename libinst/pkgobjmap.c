@@ -72,7 +72,9 @@ static int	pkgobjassign(struct cfent *ept, char **server_local,
 		    int nc);
 
 static int	ckdup(struct cfent *ept1, struct cfent *ept2);
-static int	sortentry(int index);
+static int	sortentries(void);
+static void	msortentry(struct cfextra **a_list, struct cfextra **a_tmp,
+		    int a_n);
 static int	dup_merg(struct cfextra *ext1, struct cfextra *ext2);
 
 void
@@ -292,7 +294,6 @@ pkgobjmap(VFP_T *vfp, int mapflag, char *ir)
 {
 	struct	cfextra *ext, **ext_ptr;
 	struct	cfent *ept, map_entry;
-	int	i;
 	int	n;
 	int	nc;
 
@@ -372,116 +373,130 @@ pkgobjmap(VFP_T *vfp, int mapflag, char *ir)
 		return (NULL);
 	}
 
-	(void) sortentry(-1);
-	for (i = 0; i < eptnum; /* void */) {
-		if (!sortentry(i))
-			i++;
+	if (!sortentries()) {
+		progerr(gettext(ERR_MEMORY));
+		return (NULL);
 	}
 
 	return (errflg ? NULL : extlist);
 }
 
 /*
- * This function sorts the final list of cfextra entries. If index = -1, the
- * function is initialized. index = 0 doesn't get us anywhere because this
- * sorts against index-1. Positive natural index values are compared and
- * sorted into the array appropriately. Yes, it does seem we should use a
- * quicksort on the whole array or something. The apparent reason for taking
- * this approach is that there are enough special considerations to be
- * applied to each package object that inserting them one-by-one doesn't cost
- * that much.
+ * This function sorts the final list of cfextra entries on path and removes
+ * the duplicates. The list is merge sorted as a whole; since the merge sort
+ * is stable, entries with the same path stay in the order they were added
+ * and each duplicate is checked against (and, if the array was seeded,
+ * merged into) the first entry with its path, which is the one retained.
+ * The duplicates are then moved behind the retained entries and deleted
+ * from the end of the array, which leaves the rest of the array alone.
+ * Returns 0 if memory could not be allocated, 1 otherwise.
  */
 static int
-sortentry(int index)
+sortentries(void)
 {
-	struct cfextra *ext;
+	struct cfextra **tmp;
 	struct cfent *ept, *ept_i;
-	static int last = 0;
-	int	i, n, j;
-	int	upper, lower;
+	int	i, n, ndup;
 
-	if (index == 0)
-		return (0);
-	else if (index < 0) {
-		last = 0;
-		return (0);
+	/* quick check for pre-sorted arrays without duplicates */
+	for (i = 1; i < eptnum; i++) {
+		if (strcmp(extlist[i]->cf_ent.path,
+		    extlist[i-1]->cf_ent.path) <= 0)
+			break;
 	}
+	if (i >= eptnum)
+		return (1);
+
+	tmp = (struct cfextra **)malloc(eptnum * sizeof (struct cfextra *));
+	if (tmp == NULL)
+		return (0);
+
+	msortentry(extlist, tmp, eptnum);
 
 	/*
-	 * Based on the index, this is the package object we're going to
-	 * review. It may stay where it is or it may be repositioned in the
-	 * array.
+	 * NOTE: This sorts on path. There are lots of other worthy items in
+	 * the array, but path is the key into the package database. Keep the
+	 * first entry of each path in extlist and collect the others in tmp.
 	 */
-	ext = extlist[index];
-	ept = &(ext->cf_ent);
+	for (i = 1, n = 1, ndup = 0; i < eptnum; i++) {
+		ept = &(extlist[i]->cf_ent);
+		ept_i = &(extlist[n-1]->cf_ent);
 
-	/* quick comparison optimization for pre-sorted arrays */
-	if (strcmp(ept->path, extlist[index-1]->cf_ent.path) > 0) {
-		/* do nothing */
-		last = index-1;
-		return (0);
-	}
+		if (strcmp(ept->path, ept_i->path) != 0) {
+			extlist[n++] = extlist[i];
+			continue;
+		}
 
-	lower = 0;		/* lower bound of the unsorted elements */
-	upper = index;		/* upper bound */
-	i = last;
-	do {
-		/*
-		 * NOTE: This does a binary sort on path. There are lots of
-		 * other worthy items in the array, but path is the key into
-		 * the package database.
-		 */
-		ept_i = &(extlist[i]->cf_ent);
-
-		n = strcmp(ept->path, ept_i->path);
-		if (n == 0) {
-			if (!ckdup(ept, ept_i)) {
-				/*
-				 * If the array was seeded then there are
-				 * bound to be occasional duplicates.
-				 * Otherwise, duplicates are definitely a
-				 * sign of major damage.
-				 */
-				if (array_preloaded) {
-					if (!dup_merg(ext, extlist[i])) {
-						progerr(gettext(ERR_DUPPATH),
-						    ept->path);
-						errflg++;
-					}
-				} else {
+		if (!ckdup(ept, ept_i)) {
+			/*
+			 * If the array was seeded then there are bound to be
+			 * occasional duplicates. Otherwise, duplicates are
+			 * definitely a sign of major damage.
+			 */
+			if (array_preloaded) {
+				if (!dup_merg(extlist[i], extlist[n-1])) {
 					progerr(gettext(ERR_DUPPATH),
 					    ept->path);
 					errflg++;
 				}
+			} else {
+				progerr(gettext(ERR_DUPPATH), ept->path);
+				errflg++;
 			}
-			/* remove the entry at index */
-			(void) ar_delete(xspace, index);
-
-			eptnum--;
-			return (1);	/* Use this index again. */
-		} else if (n < 0) {
-			/*
-			 * The path of interest is smaller than the path
-			 * under test. Move down array using the method of
-			 * division
-			 */
-			upper = i;
-			i = lower + (upper-lower)/2;
-		} else {
-			/* Move up array */
-			lower = i+1;
-			i = upper - (upper-lower)/2 - 1;
 		}
-	} while (upper != lower);
-	last = i = upper;
+		tmp[ndup++] = extlist[i];
+	}
+
+	/* remove the duplicates from the end of the array */
+	(void) memcpy(&extlist[n], tmp, ndup * sizeof (struct cfextra *));
+	while (eptnum > n) {
+		(void) ar_delete(xspace, --eptnum);
+	}
 
-	/* expand to insert at i */
-	for (j = index; j > i; j--)
-		extlist[j] = extlist[j-1];
+	free(tmp);
 
-	extlist[i] = ext;
+	return (1);
+}
 
-	return (0);
+/*
+ * Stable merge sort of a_n cfextra entries on path; a_tmp is scratch space
+ * for a_n entries.
+ */
+static void
+msortentry(struct cfextra **a_list, struct cfextra **a_tmp, int a_n)
+{
+	struct cfextra **src, **dst, **swp;
+	int	width, lo, mid, hi;
+	int	i, j, k;
+
+	src = a_list;
+	dst = a_tmp;
+
+	for (width = 1; width < a_n; width *= 2) {
+		for (lo = 0; lo < a_n; lo += 2 * width) {
+			mid = (lo + width < a_n) ? lo + width : a_n;
+			hi = (lo + 2 * width < a_n) ? lo + 2 * width : a_n;
+
+			/* take from the left run unless right is smaller */
+			for (i = lo, j = mid, k = lo; i < mid && j < hi; ) {
+				if (strcmp(src[j]->cf_ent.path,
+				    src[i]->cf_ent.path) < 0)
+					dst[k++] = src[j++];
+				else
+					dst[k++] = src[i++];
+			}
+			while (i < mid)
+				dst[k++] = src[i++];
+			while (j < hi)
+				dst[k++] = src[j++];
+		}
+		swp = src;
+		src = dst;
+		dst = swp;
+	}
+
+	if (src != a_list)
+		(void) memcpy(a_list, src, a_n * sizeof (struct cfextra *));
 }
 
 /* Return the number of blocks required by the package object provided. */
@@ -0,0 +1,579 @@
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at src/OPENSOLARIS.LICENSE
+ * or http://www.opensolaris.org/os/licensing.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+/*LINTLIBRARY*/
+
+/*
+ * Module:	rdepindex.c
+ * Synopsis:	Index of the packages that installed packages depend on
+ * Description:
+ *
+ * Before a package is removed, every installed package that names it in a
+ * prerequisite ('P') entry of its depend file must be found. Reading the
+ * depend file of every installed package for this makes each removal cost
+ * a file open per installed package, plus a scan of the package directory
+ * for each prerequisite entry found. This module keeps an index of the
+ * packages named by the 'P' entries of each installed package instead, so
+ * only the depend files of the packages that really depend on the package
+ * removed need to be read.
+ *
+ * The index is a text file in the package administration directory. Its
+ * first line is "PKGRDEP <version>"; each other line describes a package
+ * instance directory of the package directory:
+ *
+ *	<pkginst> <dev> <ino> <size> <mtime> <mtimens> <ctime> <ctimens>
+ *	    [<pkg> ...]
+ *
+ * where <dev> to <ctimens> identify the depend file of the instance (all 0
+ * if it has none) and <pkg> are the packages named by its 'P' entries.
+ *
+ * rdepOpen() reads the package directory and checks the depend file of
+ * each instance against the index; the entries of instances that have been
+ * added or whose depend file has changed are read from the depend file,
+ * and the index is rewritten if anything changed. The index is replaced
+ * atomically by rename; if it cannot be written, the entries just read
+ * are used for this process only.
+ *
+ * Public Methods:
+ *
+ *   rdepClose - release the index
+ *   rdepDependent - find the next package that depends on a package
+ *   rdepInstalled - determine if an instance of a package is present
+ *   rdepOpen - bring the index up to date with the package directory
+ */
+
+#include <stdio.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <pkgstrct.h>
+#include <pkginfo.h>
+#include <locale.h>
+#include <libintl.h>
+#include <pkglib.h>
+#include "libinst.h"
+#include "libadm.h"
+#include "messages.h"
+
+#define	RDEP_FILE	"rdepindex"
+#define	RDEP_MAGIC	"PKGRDEP"
+#define	RDEP_VERSION	1
+
+/*
+ * depend files are read in pieces of this size, as dockdeps() reads them,
+ * so that the entries found here are the ones dockdeps() finds
+ */
+
+#define	RDEP_LSIZE	256
+
+/* identity of a depend file; all 0 if there is none */
+
+struct rdepid {
+	unsigned long long	ri_dev;
+	unsigned long long	ri_ino;
+	unsigned long long	ri_size;
+	long long		ri_mtime;
+	long			ri_mtimens;
+	long long		ri_ctime;	/* not kept from the package */
+	long			ri_ctimens;
+};
+
+struct rdepent {
+	char		*re_inst;	/* package instance */
+	struct rdepid	re_id;		/* its depend file */
+	char		**re_prereq;	/* packages named by 'P' entries */
+	int		re_nprereq;
+};
+
+/*
+ * the index currently open, in the order of the package directory
+ */
+
+static struct rdepent	*rdeps = (struct rdepent *)NULL;
+static int		nrdeps = 0;
+static int		rdepopen = 0;
+
+static int	entcmp(const void *a_ent1, const void *a_ent2);
+static void	freeents(struct rdepent *a_ents, int a_n);
+static void	getid(struct rdepid *r_id, char *a_path);
+static struct rdepent	*readindex(char *a_path, int *r_n);
+static void	readdepend(struct rdepent *a_ent, char *a_path);
+static void	addprereq(struct rdepent *a_ent, char *a_pkg);
+static void	writeindex(char *a_path);
+
+/*
+ * *****************************************************************************
+ * global external (public) functions
+ * *****************************************************************************
+ */
+
+/*
+ * Name:	rdepOpen
+ * Description:	open the index of the packages that the installed packages
+ *		depend on, bringing it up to date with a package directory
+ * Arguments:	a_pkgdir - (char *) - [RO, *RO]
+ *			package directory (/var/sadm/pkg)
+ *		a_admdir - (char *) - [RO, *RO]
+ *			directory the index is kept in (/var/sadm/install);
+ *			if NULL, the index is built in memory only
+ * Returns:	int
+ *			== 0 - the index is open
+ *			!= 0 - the package directory cannot be read; the
+ *				index is not open
+ */
+
+int
+rdepOpen(char *a_pkgdir, char *a_admdir)
+{
+	struct dirent	*dp;
+	struct rdepent	*old = (struct rdepent *)NULL;
+	struct rdepent	*oe;
+	struct rdepent	*re;
+	struct rdepent	key;
+	DIR		*dirfp;
+	char		ipath[PATH_MAX];
+	char		path[PATH_MAX];
+	int		changed = 0;
+	int		nalloc = 0;
+	int		nmatch = 0;
+	int		nold = 0;
+
+	rdepClose();
+
+	if ((a_admdir != (char *)NULL) && (snprintf(ipath, sizeof (ipath),
+			"%s/%s", a_admdir, RDEP_FILE) < sizeof (ipath))) {
+		old = readindex(ipath, &nold);
+	} else {
+		ipath[0] = '\0';
+	}
+
+	if (old == (struct rdepent *)NULL) {
+		changed++;
+	}
+
+	if ((dirfp = opendir(a_pkgdir)) == (DIR *)NULL) {
+		freeents(old, nold);
+		return (-1);
+	}
+
+	while ((dp = readdir(dirfp)) != (struct dirent *)NULL) {
+		if ((dp->d_name[0] == '.') ||
+			(strpbrk(dp->d_name, " \t\n") != (char *)NULL)) {
+			continue;
+		}
+
+		if (nrdeps >= nalloc) {
+			nalloc += 64;
+			rdeps = (struct rdepent *)realloc(rdeps,
+					nalloc * sizeof (struct rdepent));
+			if (rdeps == (struct rdepent *)NULL) {
+				progerr(ERR_MEMORY, errno);
+				quit(99);
+			}
+		}
+
+		re = &rdeps[nrdeps++];
+		(void) memset(re, '\0', sizeof (struct rdepent));
+		re->re_inst = qstrdup(dp->d_name);
+
+		(void) snprintf(path, sizeof (path), "%s/%s/%s",
+				a_pkgdir, dp->d_name, DEPEND_FILE);
+		getid(&re->re_id, path);
+
+		/* an entry whose depend file is unchanged is taken over */
+
+		key.re_inst = dp->d_name;
+		oe = (nold == 0) ? (struct rdepent *)NULL :
+			(struct rdepent *)bsearch(&key, old, nold,
+				sizeof (struct rdepent), entcmp);
+
+		if (oe != (struct rdepent *)NULL) {
+			nmatch++;
+			if (memcmp(&oe->re_id, &re->re_id,
+					sizeof (struct rdepid)) == 0) {
+				re->re_prereq = oe->re_prereq;
+				re->re_nprereq = oe->re_nprereq;
+				oe->re_prereq = (char **)NULL;
+				oe->re_nprereq = 0;
+				continue;
+			}
+		}
+
+		changed++;
+		if (re->re_id.ri_ino != 0) {
+			readdepend(re, path);
+		}
+	}
+	(void) closedir(dirfp);
+
+	/* entries of instances that are gone */
+
+	if (nmatch != nold) {
+		changed++;
+	}
+
+	freeents(old, nold);
+	rdepopen = 1;
+
+	if (changed && (ipath[0] != '\0')) {
+		writeindex(ipath);
+	}
+
+	return (0);
+}
+
+/*
+ * Name:	rdepDependent
+ * Description:	find the next package instance that names a package in a
+ *		prerequisite ('P') entry of its depend file
+ * Arguments:	a_pkg - (char *) - [RO, *RO]
+ *			package abbreviation as named in the depend file
+ *		a_pos - (int *) - [RO, *RW]
+ *			position in the index to search from; 0 to search
+ *			from the start, then as updated by the last call
+ * Returns:	char *
+ *			== NULL - no further instance depends on the package
+ *			!= NULL - the name of the instance, valid until the
+ *				index is closed
+ */
+
+char *
+rdepDependent(char *a_pkg, int *a_pos)
+{
+	struct rdepent	*re;
+	int		i;
+
+	for (; *a_pos < nrdeps; (*a_pos)++) {
+		re = &rdeps[*a_pos];
+		for (i = 0; i < re->re_nprereq; i++) {
+			if (strcmp(re->re_prereq[i], a_pkg) == 0) {
+				(*a_pos)++;
+				return (re->re_inst);
+			}
+		}
+	}
+
+	return ((char *)NULL);
+}
+
+/*
+ * Name:	rdepInstalled
+ * Description:	determine if the package directory holds an instance that
+ *		matches a package specification, as fpkginst() does before
+ *		it checks the architecture and version of an instance
+ * Arguments:	a_spec - (char *) - [RO, *RO]
+ *			package specification ("pkg.*")
+ * Returns:	int
+ *			== 0 - no instance matches, or the index is not open
+ *			!= 0 - an instance matches, or the index is not open
+ */
+
+int
+rdepInstalled(char *a_spec)
+{
+	int	i;
+
+	if (!rdepopen) {
+		return (1);
+	}
+
+	for (i = 0; i < nrdeps; i++) {
+		if (pkgnmchk(rdeps[i].re_inst, a_spec, 0) == 0) {
+			return (1);
+		}
+	}
+
+	return (0);
+}
+
+/*
+ * Name:	rdepClose
+ * Description:	release the index opened by rdepOpen()
+ * Arguments:	none
+ * Returns:	void
+ */
+
+void
+rdepClose(void)
+{
+	freeents(rdeps, nrdeps);
+	rdeps = (struct rdepent *)NULL;
+	nrdeps = 0;
+	rdepopen = 0;
+}
+
+/*
+ * *****************************************************************************
+ * static internal (private) functions
+ * *****************************************************************************
+ */
+
+static int
+entcmp(const void *a_ent1, const void *a_ent2)
+{
+	return (strcmp(((const struct rdepent *)a_ent1)->re_inst,
+		((const struct rdepent *)a_ent2)->re_inst));
+}
+
+static void
+freeents(struct rdepent *a_ents, int a_n)
+{
+	int	i;
+	int	j;
+
+	if (a_ents == (struct rdepent *)NULL) {
+		return;
+	}
+
+	for (i = 0; i < a_n; i++) {
+		for (j = 0; j < a_ents[i].re_nprereq; j++) {
+			free(a_ents[i].re_prereq[j]);
+		}
+		free(a_ents[i].re_prereq);
+		free(a_ents[i].re_inst);
+	}
+	free(a_ents);
+}
+
+static void
+getid(struct rdepid *r_id, char *a_path)
+{
+	struct stat	st;
+
+	(void) memset(r_id, '\0', sizeof (struct rdepid));
+
+	if (stat(a_path, &st) != 0) {
+		return;
+	}
+
+	r_id->ri_dev = (unsigned long long)st.st_dev;
+	r_id->ri_ino = (unsigned long long)st.st_ino;
+	r_id->ri_size = (unsigned long long)st.st_size;
+	r_id->ri_mtime = (long long)st.st_mtim.tv_sec;
+	r_id->ri_mtimens = (long)st.st_mtim.tv_nsec;
+	r_id->ri_ctime = (long long)st.st_ctim.tv_sec;
+	r_id->ri_ctimens = (long)st.st_ctim.tv_nsec;
+}
+
+/*
+ * read the index file; returns its entries sorted by instance, or NULL if
+ * the file is missing or damaged
+ */
+
+static struct rdepent *
+readindex(char *a_path, int *r_n)
+{
+	struct rdepent	*ents = (struct rdepent *)NULL;
+	struct rdepent	*re;
+	FILE		*fp;
+	char		line[RDEP_LSIZE];
+	char		inst[RDEP_LSIZE];
+	char		pkg[RDEP_LSIZE];
+	int		version;
+	int		nalloc = 0;
+	int		n = 0;
+	int		c;
+
+	*r_n = 0;
+
+	if ((fp = fopen(a_path, "r")) == (FILE *)NULL) {
+		return ((struct rdepent *)NULL);
+	}
+
+	if ((fgets(line, sizeof (line), fp) == (char *)NULL) ||
+		(sscanf(line, RDEP_MAGIC " %d", &version) != 1) ||
+		(version != RDEP_VERSION)) {
+		(void) fclose(fp);
+		return ((struct rdepent *)NULL);
+	}
+
+	while (fscanf(fp, "%255s", inst) == 1) {
+		if (n >= nalloc) {
+			nalloc += 64;
+			ents = (struct rdepent *)realloc(ents,
+					nalloc * sizeof (struct rdepent));
+			if (ents == (struct rdepent *)NULL) {
+				progerr(ERR_MEMORY, errno);
+				quit(99);
+			}
+		}
+
+		re = &ents[n];
+		(void) memset(re, '\0', sizeof (struct rdepent));
+		if (fscanf(fp, "%llu %llu %llu %lld %ld %lld %ld",
+				&re->re_id.ri_dev, &re->re_id.ri_ino,
+				&re->re_id.ri_size, &re->re_id.ri_mtime,
+				&re->re_id.ri_mtimens, &re->re_id.ri_ctime,
+				&re->re_id.ri_ctimens) != 7) {
+			goto damaged;
+		}
+		re->re_inst = qstrdup(inst);
+		n++;
+
+		/* the packages named, up to the end of the line */
+
+		for (;;) {
+			while (((c = getc(fp)) == ' ') || (c == '\t'))
+				;
+			if (c == '\n') {
+				break;
+			}
+			if (c == EOF) {
+				goto damaged;
+			}
+			(void) ungetc(c, fp);
+			if (fscanf(fp, "%255[^ \t\n]", pkg) != 1) {
+				goto damaged;
+			}
+			addprereq(re, pkg);
+		}
+	}
+
+	if (!feof(fp)) {
+		goto damaged;
+	}
+	(void) fclose(fp);
+
+	if (n > 0) {
+		qsort(ents, n, sizeof (struct rdepent), entcmp);
+	} else if (ents == (struct rdepent *)NULL) {
+		ents = (struct rdepent *)calloc(1, sizeof (struct rdepent));
+		if (ents == (struct rdepent *)NULL) {
+			progerr(ERR_MEMORY, errno);
+			quit(99);
+		}
+	}
+
+	*r_n = n;
+	return (ents);
+
+damaged:
+	(void) fclose(fp);
+	freeents(ents, n);
+	return ((struct rdepent *)NULL);
+}
+
+/*
+ * add the packages named by the 'P' entries of a depend file to an entry;
+ * the file is read the way getline() in dockdeps.c reads it, where a line
+ * that does not start with white space begins a new entry
+ */
+
+static void
+readdepend(struct rdepent *a_ent, char *a_path)
+{
+	FILE	*fp;
+	char	line[RDEP_LSIZE];
+	char	pkg[128+1];
+	char	type;
+
+	if ((fp = fopen(a_path, "r")) == (FILE *)NULL) {
+		return;
+	}
+
+	while (fgets(line, sizeof (line), fp) != (char *)NULL) {
+		if (line[0] != 'P') {
+			continue;
+		}
+		pkg[0] = '\0';
+		if ((sscanf(line, "%c %128s", &type, pkg) == 2) &&
+				(pkg[0] != '\0')) {
+			addprereq(a_ent, pkg);
+		}
+	}
+
+	(void) fclose(fp);
+}
+
+static void
+addprereq(struct rdepent *a_ent, char *a_pkg)
+{
+	int	i;
+
+	for (i = 0; i < a_ent->re_nprereq; i++) {
+		if (strcmp(a_ent->re_prereq[i], a_pkg) == 0) {
+			return;
+		}
+	}
+
+	a_ent->re_prereq = (char **)realloc(a_ent->re_prereq,
+			(a_ent->re_nprereq + 1) * sizeof (char *));
+	if (a_ent->re_prereq == (char **)NULL) {
+		progerr(ERR_MEMORY, errno);
+		quit(99);
+	}
+	a_ent->re_prereq[a_ent->re_nprereq++] = qstrdup(a_pkg);
+}
+
+/* replace the index file by the index open; failures are ignored */
+
+static void
+writeindex(char *a_path)
+{
+	struct rdepent	*re;
+	FILE		*fp;
+	char		tpath[PATH_MAX];
+	int		fd;
+	int		i;
+	int		j;
+
+	if (snprintf(tpath, sizeof (tpath), "%s.XXXXXX", a_path) >=
+			sizeof (tpath)) {
+		return;
+	}
+
+	if ((fd = mkstemp(tpath)) < 0) {
+		return;
+	}
+
+	(void) fchmod(fd, 0644);
+
+	if ((fp = fdopen(fd, "w")) == (FILE *)NULL) {
+		(void) close(fd);
+		(void) unlink(tpath);
+		return;
+	}
+
+	(void) fprintf(fp, "%s %d\n", RDEP_MAGIC, RDEP_VERSION);
+
+	for (i = 0; i < nrdeps; i++) {
+		re = &rdeps[i];
+		(void) fprintf(fp, "%s %llu %llu %llu %lld %ld %lld %ld",
+				re->re_inst, re->re_id.ri_dev,
+				re->re_id.ri_ino, re->re_id.ri_size,
+				re->re_id.ri_mtime, re->re_id.ri_mtimens,
+				re->re_id.ri_ctime, re->re_id.ri_ctimens);
+		for (j = 0; j < re->re_nprereq; j++) {
+			(void) fprintf(fp, " %s", re->re_prereq[j]);
+		}
+		(void) putc('\n', fp);
+	}
+
+	if ((fflush(fp) != 0) || ferror(fp) || (fclose(fp) != 0) ||
+			(rename(tpath, a_path) != 0)) {
+		(void) unlink(tpath);
+	}
+}
@@ -83,14 +83,20 @@
  *			the package to unpack from the specified stream
  *		a_tempDir - pointer to string representing the path to a
  *			directory into which the package will be unpacked
+ *		a_stream - B_TRUE to leave the package objects of a package
+ *			in a single part in the stream, to be installed
+ *			straight from it (see ds_nextstream()); B_FALSE to
+ *			unpack the whole part
  * Returns:	boolean_t
  *			== B_TRUE - package successfully unpacked from stream
  *			== B_FALSE - failed to unpack package from stream
  */
 
 boolean_t
-unpack_package_from_stream(char *a_idsName, char *a_pkginst, char *a_tempDir)
+unpack_package_from_stream(char *a_idsName, char *a_pkginst, char *a_tempDir,
+	boolean_t a_stream)
 {
+	int		n;
 	int		dparts;
 	char		instdir[PATH_MAX];
 
@@ -149,7 +155,12 @@ unpack_package_from_stream(char *a_idsName, char *a_pkginst, char *a_tempDir)
 	}
 
 	dparts--;
-	if (ds_next(a_idsName, instdir)) {
+	if (a_stream == B_TRUE) {
+		n = ds_nextstream(a_idsName, instdir);
+	} else {
+		n = ds_next(a_idsName, instdir);
+	}
+	if (n != 0) {
 		progerr(ERR_UNPACK_DSREAD, dparts+1, a_idsName, instdir,
 			a_pkginst);
 		return (B_FALSE);
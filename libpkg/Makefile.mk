@@ -4,12 +4,12 @@ INC = -I. -I../hdrs -I../libgendb
 	$(CC) -c $(CFLAGS) $(CPPFLAGS) $(INC) $(PATHS) $(WARN) $<
 
 
-OBJ = canonize.o ckparam.o ckvolseq.o cvtpath.o dbsql.o devtype.o \
-	dstream.o fmkdir.o gpkglist.o gpkgmap.o isdir.o keystore.o \
-	logerr.o mappath.o ncgrpw.o nhash.o pkgerr.o \
-	pkgexecl.o pkgexecv.o pkgmount.o pkgstr.o pkgtrans.o \
-	ppkgmap.o progerr.o putcfile.o rrmdir.o runcmd.o \
-	srchcfile.o tputcfent.o verify.o vfpops.o
+OBJ = canonize.o cfindex.o cfjournal.o cfpkgindex.o cfscan.o cksum.o \
+	cksumcache.o ckparam.o ckvolseq.o cpio.o cpiozip.o cvtpath.o \
+	dbsql.o devtype.o dstream.o fmkdir.o gpkglist.o gpkgmap.o isdir.o \
+	keystore.o logerr.o mappath.o ncgrpw.o nhash.o pkgerr.o pkgexecl.o \
+	pkgexecv.o pkgmount.o pkgstr.o pkgtrans.o ppkgmap.o progerr.o \
+	putcfile.o rrmdir.o runcmd.o srchcfile.o tputcfent.o verify.o vfpops.o
 
 all: libpkgu.a
 
@@ -19,16 +19,43 @@ libpkgu.a: $(OBJ)
 
 install: all
 
+cksumtest: cksumtest.c cksum.c ./pkglib.h
+	$(CC) $(CFLAGS) $(CPPFLAGS) $(INC) $(WARN) -o $@ cksumtest.c \
+		$(LDFLAGS) -lpthread
+
+check: cksumtest
+	./cksumtest
+
 clean:
-	rm -f libpkgu.a $(OBJ) core log *~
+	rm -f libpkgu.a $(OBJ) cksumtest core log *~
 
 mrproper: clean
 
 canonize.o: canonize.c
+cfindex.o: cfindex.c ./pkglib.h ../hdrs/pkgdev.h ../hdrs/pkgstrct.h \
+  ./pkgerr.h ./keystore.h ./cfext.h cfindex.h
+cfjournal.o: cfjournal.c ./pkglib.h ../hdrs/pkgdev.h ../hdrs/pkgstrct.h \
+  ./pkgerr.h ./keystore.h ./cfext.h cfjournal.h
+cfpkgindex.o: cfpkgindex.c ./pkglib.h ../hdrs/pkgdev.h ../hdrs/pkgstrct.h \
+  ./pkgerr.h ./keystore.h ./cfext.h ../hdrs/libadm.h ../hdrs/pkginfo.h \
+  ../hdrs/valtools.h cfjournal.h cfpkgindex.h
+cfscan.o: cfscan.c ./pkglib.h ../hdrs/pkgdev.h ../hdrs/pkgstrct.h \
+  ./pkgerr.h ./keystore.h ./cfext.h ../hdrs/libadm.h ../hdrs/pkginfo.h \
+  ../hdrs/valtools.h pkglocale.h pkglibmsgs.h cfjournal.h srchcfile.h
+cksum.o: cksum.c ./pkglib.h ../hdrs/pkgdev.h ../hdrs/pkgstrct.h \
+  ./pkgerr.h ./keystore.h ./cfext.h
+cksumcache.o: cksumcache.c ./pkglib.h ../hdrs/pkgdev.h \
+  ../hdrs/pkgstrct.h ./pkgerr.h ./keystore.h ./cfext.h cksumcache.h
 ckparam.o: ckparam.c ./pkglib.h ../hdrs/pkgdev.h ../hdrs/pkgstrct.h \
   ./pkgerr.h ./keystore.h ./cfext.h ./pkglibmsgs.h pkglocale.h
 ckvolseq.o: ckvolseq.c ../hdrs/pkgstrct.h ./pkglib.h ../hdrs/pkgdev.h \
   ./pkgerr.h ./keystore.h ./cfext.h ./pkglibmsgs.h pkglocale.h
+cpio.o: cpio.c ./pkglib.h ../hdrs/pkgdev.h ../hdrs/pkgstrct.h ./pkgerr.h \
+  ./keystore.h ./cfext.h ../hdrs/archives.h ../hdrs/libadm.h \
+  ../hdrs/pkginfo.h ../hdrs/valtools.h pkglocale.h pkglibmsgs.h \
+  cpiozip.h
+cpiozip.o: cpiozip.c ./pkglib.h ../hdrs/pkgdev.h ../hdrs/pkgstrct.h \
+  ./pkgerr.h ./keystore.h ./cfext.h pkglocale.h pkglibmsgs.h cpiozip.h
 cvtpath.o: cvtpath.c
 dbsql.o: dbsql.c ./pkglib.h ../hdrs/pkgdev.h ../hdrs/pkgstrct.h \
   ./pkgerr.h ./keystore.h ./cfext.h pkglocale.h ../libgendb/genericdb.h \
@@ -47,7 +74,8 @@ gpkgmap.o: gpkgmap.c ../hdrs/pkgstrct.h pkglib.h ../hdrs/pkgdev.h \
 isdir.o: isdir.c ../hdrs/archives.h pkglocale.h pkglibmsgs.h
 keystore.o: keystore.c p12lib.h pkgerr.h keystore.h pkglib.h \
   ../hdrs/pkgdev.h ../hdrs/pkgstrct.h cfext.h pkglibmsgs.h
-logerr.o: logerr.c pkglocale.h
+logerr.o: logerr.c pkglocale.h pkglib.h ../hdrs/pkgdev.h \
+  ../hdrs/pkgstrct.h pkgerr.h keystore.h cfext.h
 mappath.o: mappath.c
 ncgrpw.o: ncgrpw.c ./pkglib.h ../hdrs/pkgdev.h ../hdrs/pkgstrct.h \
   ./pkgerr.h ./keystore.h ./cfext.h pkglocale.h nhash.h
@@ -77,7 +105,8 @@ rrmdir.o: rrmdir.c pkglocale.h pkglib.h ../hdrs/pkgdev.h \
 runcmd.o: runcmd.c ./pkglib.h ../hdrs/pkgdev.h ../hdrs/pkgstrct.h \
   ./pkgerr.h ./keystore.h ./cfext.h pkglocale.h pkglibmsgs.h ../hdrs/libadm.h
 srchcfile.o: srchcfile.c ./pkglib.h ../hdrs/pkgdev.h ../hdrs/pkgstrct.h \
-  ./pkgerr.h ./keystore.h ./cfext.h pkglocale.h pkglibmsgs.h
+  ./pkgerr.h ./keystore.h ./cfext.h pkglocale.h pkglibmsgs.h cfjournal.h \
+  srchcfile.h
 tputcfent.o: tputcfent.c ../hdrs/pkgstrct.h pkglocale.h
 verify.o: verify.c ../hdrs/pkgstrct.h ./pkglib.h ../hdrs/pkgdev.h \
   ./pkgerr.h ./keystore.h ./cfext.h ./pkglibmsgs.h pkglocale.h
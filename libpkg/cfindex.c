@@ -0,0 +1,443 @@
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at src/OPENSOLARIS.LICENSE
+ * or http://www.opensolaris.org/os/licensing.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+/*LINTLIBRARY*/
+
+/*
+ * Module:	cfindex.c
+ * Synopsis:	Maintain and use the contents file line-offset index
+ * Description:
+ *
+ * The contents file is sorted by path, and srchcfile() locates a path by
+ * bisecting the raw bytes of the file, backing up to the start of a line
+ * on every probe. This module maintains an optional sidecar file next to
+ * the contents file that holds a (path hash, byte offset) record for each
+ * line, sorted by hash, so that an exact match can be located with a
+ * binary search over fixed width records instead.
+ *
+ * The index is written by swapcfile() each time the contents file is
+ * replaced, and attached to the contents file VFP by ocfile()/socfile().
+ * It is only trusted if the size, modification time (to the nanosecond),
+ * inode and device recorded in its header match the contents file it is
+ * attached to. The contents file is only ever replaced by renaming a new
+ * file over it, so a rewrite always changes the inode; a missing or stale
+ * index is silently ignored and srchcfile() falls back to scanning.
+ * Every hit is verified against the contents file data before it is
+ * returned, so an index can cause a lookup to miss but never to be wrong.
+ *
+ * Public Methods:
+ *
+ *   cfidxClose - detach the index from the contents file VFP
+ *   cfidxFind - locate the line describing a path in the contents file
+ *   cfidxHash - compute the hash used to index a path
+ *   cfidxOpen - attach the index to an open contents file VFP
+ *   cfidxWrite - write the index for the contents file data in a VFP
+ */
+
+#include <stdio.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <pkglib.h>
+#include "cfindex.h"
+
+/*
+ * the index currently attached to a contents file VFP
+ */
+
+static struct {
+	VFP_T		*ci_vfp;	/* VFP the index is attached to */
+	char		*ci_start;	/* first data byte of that VFP */
+	void		*ci_map;	/* mapping of the index file */
+	size_t		ci_mapsize;	/* size of the mapping */
+	struct cfidxrec	*ci_rec;	/* -> first record in the mapping */
+	uint64_t	ci_nrec;	/* number of records */
+} cfidx = { NULL, NULL, MAP_FAILED, 0, NULL, 0 };
+
+/* true if the character terminates a path in the contents file */
+
+#define	ISPATHEND(C)	(((C) == '=') || ((C) == ' ') || ((C) == '\t') || \
+				((C) == '\n') || ((C) == '\0'))
+
+static int	reccmp(const void *a_r1, const void *a_r2);
+
+/*
+ * Name:	cfidxHash
+ * Description:	compute the hash of a path as stored in the index
+ * Arguments:	a_path - (char *) - [RO, *RO]
+ *			path to hash (need not be null terminated)
+ *		a_len - (size_t) - [RO]
+ *			number of bytes in a_path
+ * Returns:	uint32_t - 32-bit FNV-1a hash of the path
+ */
+
+uint32_t
+cfidxHash(char *a_path, size_t a_len)
+{
+	uint32_t	h = 2166136261U;
+
+	while (a_len-- > 0) {
+		h ^= (unsigned char)*a_path++;
+		h *= 16777619U;
+	}
+
+	return (h);
+}
+
+/*
+ * Name:	cfidxClose
+ * Description:	detach any index attached to a contents file VFP
+ * Returns:	void
+ */
+
+void
+cfidxClose(void)
+{
+	if (cfidx.ci_map != MAP_FAILED) {
+		(void) munmap(cfidx.ci_map, cfidx.ci_mapsize);
+	}
+
+	cfidx.ci_vfp = (VFP_T *)NULL;
+	cfidx.ci_start = (char *)NULL;
+	cfidx.ci_map = MAP_FAILED;
+	cfidx.ci_mapsize = 0;
+	cfidx.ci_rec = (struct cfidxrec *)NULL;
+	cfidx.ci_nrec = 0;
+}
+
+/*
+ * Name:	cfidxOpen
+ * Description:	attach the index for the contents file open on a VFP
+ * Arguments:	a_vfp - (VFP_T *) - [RO, *RO]
+ *			VFP open on the contents file; the index is expected
+ *			next to the file the VFP is associated with.
+ * Returns:	int
+ *			== 0 - a valid index is attached to the VFP
+ *			!= 0 - no index or stale index; nothing attached
+ */
+
+int
+cfidxOpen(VFP_T *a_vfp)
+{
+	char		path[PATH_MAX];
+	int		fd;
+	struct cfidxhdr	*hdr;
+	struct stat	cstat;
+	struct stat	istat;
+	void		*map;
+
+	cfidxClose();
+
+	if ((a_vfp == (VFP_T *)NULL) || (a_vfp->_vfpFile == (FILE *)NULL)) {
+		return (-1);
+	}
+
+	if (fstat(fileno(a_vfp->_vfpFile), &cstat) != 0) {
+		return (-1);
+	}
+
+	if (snprintf(path, sizeof (path), "%s%s", vfpGetPath(a_vfp),
+			CFIDX_SUFFIX) >= sizeof (path)) {
+		return (-1);
+	}
+
+	if ((fd = open(path, O_RDONLY)) < 0) {
+		return (-1);
+	}
+
+	if ((fstat(fd, &istat) != 0) ||
+			(istat.st_size < sizeof (struct cfidxhdr))) {
+		(void) close(fd);
+		return (-1);
+	}
+
+	map = mmap(NULL, istat.st_size, PROT_READ, MAP_SHARED, fd, (off_t)0);
+	(void) close(fd);
+	if (map == MAP_FAILED) {
+		return (-1);
+	}
+
+	/* the index must describe exactly the contents file opened */
+
+	hdr = (struct cfidxhdr *)map;
+	if ((memcmp(hdr->ch_magic, CFIDX_MAGIC, sizeof (hdr->ch_magic)) != 0) ||
+		(hdr->ch_version != CFIDX_VERSION) ||
+		(hdr->ch_size != (uint64_t)cstat.st_size) ||
+		(hdr->ch_mtime != (int64_t)cstat.st_mtim.tv_sec) ||
+		(hdr->ch_mtimens != (uint32_t)cstat.st_mtim.tv_nsec) ||
+		(hdr->ch_ino != (uint64_t)cstat.st_ino) ||
+		(hdr->ch_dev != (uint64_t)cstat.st_dev) ||
+		(istat.st_size != sizeof (struct cfidxhdr) +
+			hdr->ch_nrec * sizeof (struct cfidxrec))) {
+		(void) munmap(map, istat.st_size);
+		return (-1);
+	}
+
+#ifdef	MADV_RANDOM
+	(void) madvise(map, istat.st_size, MADV_RANDOM);
+#endif
+
+	cfidx.ci_vfp = a_vfp;
+	cfidx.ci_start = vfpGetFirstCharPtr(a_vfp);
+	cfidx.ci_map = map;
+	cfidx.ci_mapsize = istat.st_size;
+	cfidx.ci_rec = (struct cfidxrec *)(hdr+1);
+	cfidx.ci_nrec = hdr->ch_nrec;
+
+	return (0);
+}
+
+/*
+ * Name:	cfidxFind
+ * Description:	use the attached index to locate the line describing a path
+ * Arguments:	a_vfp - (VFP_T *) - [RO, *RO]
+ *			VFP open on the contents file being searched
+ *		a_path - (char *) - [RO, *RO]
+ *			absolute path to search for
+ *		a_pathLen - (size_t) - [RO]
+ *			length of a_path
+ * Returns:	char *	- pointer to the first byte of the line for a_path,
+ *			at or after the current position of a_vfp
+ *			== (char *)NULL - no index attached to a_vfp, or the
+ *			path is not indexed; the caller must scan the file.
+ */
+
+char *
+cfidxFind(VFP_T *a_vfp, char *a_path, size_t a_pathLen)
+{
+	char		*curr;
+	char		*p;
+	size_t		hi;
+	size_t		lo;
+	size_t		mid;
+	size_t		limit;
+	uint32_t	h;
+
+	if ((cfidx.ci_vfp == (VFP_T *)NULL) || (cfidx.ci_vfp != a_vfp) ||
+		(cfidx.ci_start != vfpGetFirstCharPtr(a_vfp)) ||
+		(cfidx.ci_nrec == 0) || (a_pathLen == 0)) {
+		return ((char *)NULL);
+	}
+
+	h = cfidxHash(a_path, a_pathLen);
+	curr = vfpGetCurrCharPtr(a_vfp);
+	limit = (ptrdiff_t)vfpGetLastCharPtr(a_vfp) -
+		(ptrdiff_t)vfpGetFirstCharPtr(a_vfp);
+
+	/* find first record with this hash */
+
+	lo = 0;
+	hi = cfidx.ci_nrec;
+	while (lo < hi) {
+		mid = lo + ((hi - lo) >> 1);
+		if (cfidx.ci_rec[mid].cr_hash < h) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	/* verify each candidate against the data actually in the VFP */
+
+	for (; (lo < cfidx.ci_nrec) && (cfidx.ci_rec[lo].cr_hash == h); lo++) {
+		struct cfidxrec	*r = &cfidx.ci_rec[lo];
+
+		if ((r->cr_len != a_pathLen) ||
+				(r->cr_off + a_pathLen > limit)) {
+			continue;
+		}
+
+		p = vfpGetFirstCharPtr(a_vfp) + r->cr_off;
+
+		if ((p < curr) || ((p > vfpGetFirstCharPtr(a_vfp)) &&
+				(p[-1] != '\n'))) {
+			continue;
+		}
+
+		if ((memcmp(p, a_path, a_pathLen) == 0) &&
+				ISPATHEND(p[a_pathLen])) {
+			return (p);
+		}
+	}
+
+	return ((char *)NULL);
+}
+
+/*
+ * Name:	cfidxWrite
+ * Description:	write the index describing the contents file data in a VFP
+ * Arguments:	a_vfp - (VFP_T *) - [RO, *RO]
+ *			VFP holding the data just written to the contents file
+ *		a_contents - (char *) - [RO, *RO]
+ *			path of the contents file the data was written to;
+ *			the index is written to the same path plus CFIDX_SUFFIX
+ * Returns:	int
+ *			== 0 - the index was written
+ *			!= 0 - the index could not be written; any previous
+ *				index has been removed
+ */
+
+int
+cfidxWrite(VFP_T *a_vfp, char *a_contents)
+{
+	char		ipath[PATH_MAX];
+	char		tpath[PATH_MAX];
+	char		*end;
+	char		*p;
+	char		*ps;
+	int		fd;
+	int		lerrno;
+	size_t		len;
+	size_t		nalloc = 0;
+	size_t		nrec = 0;
+	ssize_t		wlen;
+	struct cfidxhdr	hdr;
+	struct cfidxrec	*rec = (struct cfidxrec *)NULL;
+	struct stat	cstat;
+
+	if ((snprintf(ipath, sizeof (ipath), "%s%s", a_contents,
+			CFIDX_SUFFIX) >= sizeof (ipath)) ||
+		(snprintf(tpath, sizeof (tpath), "%s.tmp", ipath) >=
+			sizeof (tpath))) {
+		errno = ENAMETOOLONG;
+		return (-1);
+	}
+
+	if (stat(a_contents, &cstat) != 0) {
+		lerrno = errno;
+		(void) unlink(ipath);
+		errno = lerrno;
+		return (-1);
+	}
+
+	(void) memset(&hdr, '\0', sizeof (hdr));
+	(void) memcpy(hdr.ch_magic, CFIDX_MAGIC, sizeof (hdr.ch_magic));
+	hdr.ch_version = CFIDX_VERSION;
+	hdr.ch_size = (uint64_t)cstat.st_size;
+	hdr.ch_mtime = (int64_t)cstat.st_mtim.tv_sec;
+	hdr.ch_mtimens = (uint32_t)cstat.st_mtim.tv_nsec;
+	hdr.ch_ino = (uint64_t)cstat.st_ino;
+	hdr.ch_dev = (uint64_t)cstat.st_dev;
+
+	/* collect one record for each line starting with an absolute path */
+
+	ps = vfpGetFirstCharPtr(a_vfp);
+	end = ps + vfpGetModifiedLen(a_vfp);
+
+	for (p = ps; p < end; ) {
+		char	*pe;
+
+		if (*p == '/') {
+			for (pe = p; (pe < end) && !ISPATHEND(*pe); pe++)
+				;
+
+			if (nrec >= nalloc) {
+				struct cfidxrec	*nr;
+
+				nalloc = (nalloc == 0) ? 65536 : nalloc * 2;
+				nr = (struct cfidxrec *)realloc(rec,
+					nalloc * sizeof (struct cfidxrec));
+				if (nr == (struct cfidxrec *)NULL) {
+					(void) free(rec);
+					(void) unlink(ipath);
+					errno = ENOMEM;
+					return (-1);
+				}
+				rec = nr;
+			}
+
+			rec[nrec].cr_hash = cfidxHash(p, pe - p);
+			rec[nrec].cr_len = (uint32_t)(pe - p);
+			rec[nrec].cr_off = (uint64_t)(p - ps);
+			nrec++;
+			p = pe;
+		}
+
+		/* advance to the start of the next line */
+
+		p = memchr(p, '\n', end - p);
+		if (p == (char *)NULL) {
+			break;
+		}
+		p++;
+	}
+
+	qsort(rec, nrec, sizeof (struct cfidxrec), reccmp);
+	hdr.ch_nrec = nrec;
+
+	/* write the new index to a temporary file and move it into place */
+
+	fd = open(tpath, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+	if (fd < 0) {
+		lerrno = errno;
+		(void) free(rec);
+		(void) unlink(ipath);
+		errno = lerrno;
+		return (-1);
+	}
+
+	len = nrec * sizeof (struct cfidxrec);
+	wlen = vfpSafeWrite(fd, &hdr, sizeof (hdr));
+	if ((wlen == sizeof (hdr)) && (len > 0) &&
+			(vfpSafeWrite(fd, rec, len) != len)) {
+		wlen = -1;
+	}
+
+	(void) free(rec);
+
+	if ((close(fd) != 0) || (wlen != sizeof (hdr)) ||
+			(rename(tpath, ipath) != 0)) {
+		lerrno = errno;
+		(void) unlink(tpath);
+		(void) unlink(ipath);
+		errno = lerrno;
+		return (-1);
+	}
+
+	return (0);
+}
+
+/*
+ * order index records by hash, then by offset in the contents file
+ */
+
+static int
+reccmp(const void *a_r1, const void *a_r2)
+{
+	const struct cfidxrec	*r1 = (const struct cfidxrec *)a_r1;
+	const struct cfidxrec	*r2 = (const struct cfidxrec *)a_r2;
+
+	if (r1->cr_hash != r2->cr_hash) {
+		return (r1->cr_hash < r2->cr_hash ? -1 : 1);
+	}
+
+	if (r1->cr_off != r2->cr_off) {
+		return (r1->cr_off < r2->cr_off ? -1 : 1);
+	}
+
+	return (0);
+}
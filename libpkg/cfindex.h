@@ -0,0 +1,70 @@
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at src/OPENSOLARIS.LICENSE
+ * or http://www.opensolaris.org/os/licensing.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+#ifndef	_CFINDEX_H
+#define	_CFINDEX_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <sys/types.h>
+#include <inttypes.h>
+
+/*
+ * On-disk layout of the contents file line-offset index ("contents.idx").
+ *
+ * The index consists of a fixed size header followed by ch_nrec records,
+ * one for each line of the contents file that begins with an absolute
+ * path. Records are sorted by path hash and, within one hash value, by
+ * byte offset, so that the line describing a path can be located with a
+ * binary search over fixed width records.
+ *
+ * All values are stored in native byte order - the index is a private
+ * cache of the local contents file and is never transported.
+ */
+
+#define	CFIDX_MAGIC	"PKGCFIDX"
+#define	CFIDX_VERSION	2
+#define	CFIDX_SUFFIX	".idx"
+
+struct cfidxhdr {
+	char		ch_magic[8];	/* CFIDX_MAGIC */
+	uint32_t	ch_version;	/* CFIDX_VERSION */
+	uint32_t	ch_mtimens;	/* nanoseconds of ch_mtime */
+	uint64_t	ch_size;	/* size of indexed contents file */
+	int64_t		ch_mtime;	/* mtime of indexed contents file */
+	uint64_t	ch_ino;		/* inode of indexed contents file */
+	uint64_t	ch_dev;		/* device of indexed contents file */
+	uint64_t	ch_nrec;	/* number of records that follow */
+};
+
+struct cfidxrec {
+	uint32_t	cr_hash;	/* hash of path (see cfidxHash) */
+	uint32_t	cr_len;		/* length of path in bytes */
+	uint64_t	cr_off;		/* byte offset of line in contents */
+};
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _CFINDEX_H */
@@ -0,0 +1,1287 @@
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at src/OPENSOLARIS.LICENSE
+ * or http://www.opensolaris.org/os/licensing.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+/*LINTLIBRARY*/
+
+/*
+ * Module:	cfjournal.c
+ * Synopsis:	Append-only delta journal for the contents file
+ * Description:
+ *
+ * Every package operation ends in swapcfile(), which writes out the whole
+ * contents file even if the package touched only a handful of its paths.
+ * If a journal file exists next to the contents file - journaling is
+ * enabled by creating an empty "contents.jnl" - swapcfile() instead appends
+ * the entries that changed to the journal, so that the cost of an update
+ * is proportional to the size of the package rather than the size of the
+ * database.
+ *
+ * The journal is attached to the contents file VFP as the contents file is
+ * opened by ocfile()/socfile(): the entries of its batches are collected in
+ * a table sorted by path, which srchcfile() consults alongside the mapped
+ * contents file data and its indexes. srchcfile() and pkgdbmerg() thus see
+ * the current state of the database without knowing about the journal, and
+ * without the contents file being copied. For ocfile() srchcfile() also
+ * records each path looked up; as every entry of the new contents file is
+ * written by way of srchcfile(), only those entries can have changed, and
+ * only those are compared between the old and the new image.
+ *
+ * When the journal grows beyond a fraction of the size of the contents
+ * file, swapcfile() rewrites the contents file in full and starts the
+ * journal again with a header describing the new contents file. Batches
+ * are only appended to a journal that has such a header, so the contents
+ * file a journal applies to has been written by swapcfile().
+ *
+ * Public Methods:
+ *
+ *   cfjnlAppend - append the entries changed by an update to the journal
+ *   cfjnlClose - detach the journal from a contents file VFP
+ *   cfjnlCreate - enable journaling of updates to a contents file
+ *   cfjnlEnabled - determine if updates to a contents file are journaled
+ *   cfjnlLocate - locate a path in a table of journaled entries
+ *   cfjnlOpen - attach the journal to a contents file VFP
+ *   cfjnlOrphaned - determine if a batch journal was left behind
+ *   cfjnlRemove - disable journaling of updates to a contents file
+ *   cfjnlReset - discard all batches recorded in the journal
+ *   cfjnlSize - determine the size of the journaled contents file lines
+ *   cfjnlTable - get the journaled entries attached to a VFP
+ *   cfjnlTouch - record a path looked up in a contents file VFP
+ */
+
+#include <stdio.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <pkglib.h>
+#include "cfjournal.h"
+
+/* true if the character terminates a path in the contents file */
+
+#define	ISPATHEND(C)	(((C) == '=') || ((C) == ' ') || ((C) == '\t') || \
+				((C) == '\n') || ((C) == '\0'))
+
+/* size of the header of a version 1 or 2 journal */
+
+#define	OLDHDRSIZE	offsetof(struct cfjnlhdr, jh_owner)
+
+/*
+ * growable buffer a batch is assembled in
+ */
+
+struct dbuf {
+	char	*db_buf;	/* start of allocated buffer */
+	size_t	db_len;		/* number of bytes used */
+	size_t	db_alloc;	/* size of buffer in bytes */
+};
+
+/*
+ * the journal attached to a contents file VFP
+ */
+
+static struct {
+	VFP_T		*cj_vfp;	/* VFP the journal is attached to */
+	char		*cj_start;	/* first data byte of that VFP */
+	int		cj_track;	/* != 0 to record paths looked up */
+	char		*cj_buf;	/* contents of the journal */
+	size_t		cj_valid;	/* bytes up to end of last batch */
+	uint32_t	cj_nbatch;	/* number of complete batches */
+	CFJNLENT_T	*cj_ent;	/* entries, sorted by path */
+	size_t		cj_nent;	/* number of entries */
+	size_t		cj_size;	/* bytes of contents file lines */
+	struct dbuf	cj_touch;	/* paths looked up, null terminated */
+	size_t		cj_last;	/* offset of last path recorded */
+	size_t		cj_ntouch;	/* number of paths recorded */
+} cfjnl = { NULL, NULL, 0, NULL, 0, 0, NULL, 0, 0, { NULL, 0, 0 }, 0, 0 };
+
+static char	*dataend(VFP_T *a_vfp, char *a_last);
+static int	entcmp(const void *a_e1, const void *a_e2);
+static char	*findline(char *a_start, char *a_end, char *a_path,
+			size_t a_len, size_t *r_len);
+static size_t	nextbatch(char *a_buf, size_t a_off, size_t a_len);
+static int	orphaned(int a_fd, struct cfjnlhdr *r_hdr);
+static int	pathcmp(char *a_p1, size_t a_l1, char *a_p2, size_t a_l2);
+static int	putbuf(struct dbuf *a_db, char *a_data, size_t a_len);
+static int	readhdr(int a_fd, struct cfjnlhdr *r_hdr);
+static int	readjnl(char *a_path, struct stat *a_cstat, char **r_buf,
+			size_t *r_first, size_t *r_valid, uint32_t *r_nbatch);
+static int	strpcmp(const void *a_s1, const void *a_s2);
+
+/*
+ * *****************************************************************************
+ * global external (public) functions
+ * *****************************************************************************
+ */
+
+/*
+ * Name:	cfjnlEnabled
+ * Description:	determine if updates to a contents file are journaled
+ * Arguments:	a_contents - (char *) - [RO, *RO]
+ *			path of the contents file
+ * Returns:	int
+ *			== 0 - no journal; the contents file is always
+ *				rewritten in full
+ *			!= 0 - a journal exists next to the contents file
+ */
+
+int
+cfjnlEnabled(char *a_contents)
+{
+	char	jpath[PATH_MAX];
+
+	if (snprintf(jpath, sizeof (jpath), "%s%s", a_contents,
+			CFJNL_SUFFIX) >= sizeof (jpath)) {
+		return (0);
+	}
+
+	return (access(jpath, F_OK) == 0);
+}
+
+/*
+ * Name:	cfjnlCreate
+ * Description:	enable journaling of updates to a contents file for a batch
+ *		of packages owned by the calling process, by creating an
+ *		empty journal that records the process as its owner, unless
+ *		a journal already exists
+ * Arguments:	a_contents - (char *) - [RO, *RO]
+ *			path of the contents file
+ * Returns:	int
+ *			== 0 - an empty journal was created, or the journal of
+ *				a batch whose owner no longer exists was taken
+ *				over; the caller must remove it when the batch
+ *				is done (see cfjnlRemove())
+ *			== 1 - a journal already exists
+ *			< 0 - the journal could not be created, errno contains
+ *				the reason
+ */
+
+int
+cfjnlCreate(char *a_contents)
+{
+	char		jpath[PATH_MAX];
+	int		created = 0;
+	int		fd;
+	int		lerrno;
+	struct cfjnlhdr	hdr;
+
+	if (snprintf(jpath, sizeof (jpath), "%s%s", a_contents,
+			CFJNL_SUFFIX) >= sizeof (jpath)) {
+		errno = ENAMETOOLONG;
+		return (-1);
+	}
+
+	if ((fd = open(jpath, O_RDWR|O_CREAT|O_EXCL, 0644)) >= 0) {
+		/* the header describes no contents file until cfjnlReset() */
+		(void) memset(&hdr, '\0', sizeof (hdr));
+		(void) memcpy(hdr.jh_magic, CFJNL_MAGIC, sizeof (hdr.jh_magic));
+		hdr.jh_version = CFJNL_VERSION;
+		created = 1;
+	} else if (errno != EEXIST) {
+		return (-1);
+	} else if ((fd = open(jpath, O_RDWR)) < 0) {
+		return (-1);
+	} else if (!orphaned(fd, &hdr)) {
+		(void) close(fd);
+		return (1);
+	}
+
+	hdr.jh_owner = (int32_t)getpid();
+
+	if (vfpSafePwrite(fd, (char *)&hdr, sizeof (hdr), (off_t)0) !=
+			sizeof (hdr)) {
+		lerrno = errno;
+		(void) close(fd);
+		if (created) {
+			(void) unlink(jpath);
+		}
+		errno = lerrno;
+		return (-1);
+	}
+
+	return ((close(fd) == 0) ? 0 : -1);
+}
+
+/*
+ * Name:	cfjnlOrphaned
+ * Description:	determine if the journal of a contents file was created for
+ *		a batch of packages that was not finished: the process that
+ *		owns the batch no longer exists
+ * Arguments:	a_contents - (char *) - [RO, *RO]
+ *			path of the contents file
+ * Returns:	int
+ *			== 0 - no journal, the journal is not owned by a batch
+ *				or the owner of the batch still exists
+ *			!= 0 - the journal was left behind by a batch; it is
+ *				to be removed once the journaled updates are
+ *				in the contents file
+ */
+
+int
+cfjnlOrphaned(char *a_contents)
+{
+	char		jpath[PATH_MAX];
+	int		fd;
+	int		n;
+	struct cfjnlhdr	hdr;
+
+	if (snprintf(jpath, sizeof (jpath), "%s%s", a_contents,
+			CFJNL_SUFFIX) >= sizeof (jpath)) {
+		return (0);
+	}
+
+	if ((fd = open(jpath, O_RDONLY)) < 0) {
+		return (0);
+	}
+
+	n = orphaned(fd, &hdr);
+	(void) close(fd);
+
+	return (n);
+}
+
+/*
+ * Name:	cfjnlRemove
+ * Description:	disable journaling of updates to a contents file by removing
+ *		the journal, provided that it does not hold any batches
+ * Arguments:	a_contents - (char *) - [RO, *RO]
+ *			path of the contents file
+ * Returns:	int
+ *			== 0 - the journal was removed or does not exist
+ *			!= 0 - the journal is not empty or cannot be removed
+ */
+
+int
+cfjnlRemove(char *a_contents)
+{
+	char		jpath[PATH_MAX];
+	struct stat	jstat;
+
+	if (snprintf(jpath, sizeof (jpath), "%s%s", a_contents,
+			CFJNL_SUFFIX) >= sizeof (jpath)) {
+		errno = ENAMETOOLONG;
+		return (-1);
+	}
+
+	if (stat(jpath, &jstat) != 0) {
+		return ((errno == ENOENT) ? 0 : -1);
+	}
+
+	if (jstat.st_size > sizeof (struct cfjnlhdr)) {
+		errno = ENOTEMPTY;
+		return (-1);
+	}
+
+	return (unlink(jpath));
+}
+
+/*
+ * Name:	cfjnlReset
+ * Description:	discard all batches recorded in the journal after the
+ *		contents file has been rewritten in full, leaving only a
+ *		header that describes the new contents file
+ * Arguments:	a_contents - (char *) - [RO, *RO]
+ *			path of the contents file
+ * Returns:	int
+ *			== 0 - the journal was reset or does not exist
+ *			!= 0 - the journal could not be reset; it holds no
+ *				batches that apply to the contents file
+ */
+
+int
+cfjnlReset(char *a_contents)
+{
+	char		jpath[PATH_MAX];
+	int		fd;
+	int		lerrno;
+	int32_t		owner;
+	struct cfjnlhdr	hdr;
+	struct stat	cstat;
+
+	if (snprintf(jpath, sizeof (jpath), "%s%s", a_contents,
+			CFJNL_SUFFIX) >= sizeof (jpath)) {
+		errno = ENAMETOOLONG;
+		return (-1);
+	}
+
+	if ((fd = open(jpath, O_RDWR)) < 0) {
+		return ((errno == ENOENT) ? 0 : -1);
+	}
+
+	/* a journal created for a batch remains owned by the batch */
+
+	if (readhdr(fd, &hdr) != 0) {
+		hdr.jh_owner = 0;
+	}
+	owner = hdr.jh_owner;
+
+	if (ftruncate(fd, (off_t)0) != 0) {
+		lerrno = errno;
+		(void) close(fd);
+		errno = lerrno;
+		return (-1);
+	}
+
+	(void) memset(&hdr, '\0', sizeof (hdr));
+	(void) memcpy(hdr.jh_magic, CFJNL_MAGIC, sizeof (hdr.jh_magic));
+	hdr.jh_version = CFJNL_VERSION;
+	hdr.jh_owner = owner;
+
+	if (stat(a_contents, &cstat) != 0) {
+		lerrno = errno;
+		(void) close(fd);
+		errno = lerrno;
+		return (-1);
+	}
+
+	hdr.jh_size = (uint64_t)cstat.st_size;
+	hdr.jh_mtime = (int64_t)cstat.st_mtim.tv_sec;
+	hdr.jh_mtimens = (uint32_t)cstat.st_mtim.tv_nsec;
+	hdr.jh_ino = (uint64_t)cstat.st_ino;
+	hdr.jh_dev = (uint64_t)cstat.st_dev;
+
+	if (vfpSafePwrite(fd, (char *)&hdr, sizeof (hdr), (off_t)0) !=
+			sizeof (hdr)) {
+		lerrno = errno;
+		(void) ftruncate(fd, (off_t)0);
+		(void) close(fd);
+		errno = lerrno;
+		return (-1);
+	}
+
+	return (close(fd));
+}
+
+/*
+ * Name:	cfjnlOpen
+ * Description:	attach the journal to the data of a contents file VFP; the
+ *		journaled entries are then merged with the contents file
+ *		data by srchcfile()
+ * Arguments:	a_vfp - (VFP_T *) - [RO, *RO]
+ *			VFP open for reading on the contents file; the journal
+ *			is expected next to the file the VFP is associated with.
+ *		a_track - (int) - [RO]
+ *			== 0 - the contents file is only read
+ *			!= 0 - the contents file is opened for update: the
+ *				paths looked up are recorded for cfjnlAppend(),
+ *				and a journal is attached even if it holds no
+ *				batches that apply to the contents file
+ * Returns:	int
+ *			== 0 - no journaled entries attached
+ *			== 1 - journaled entries attached
+ *			< 0 - the journal could not be read, errno contains
+ *				the reason; nothing attached
+ */
+
+int
+cfjnlOpen(VFP_T *a_vfp, int a_track)
+{
+	char		jpath[PATH_MAX];
+	char		*jbuf = (char *)NULL;
+	char		*le;
+	char		*p;
+	char		*pe;
+	char		*pend;
+	size_t		first;
+	size_t		i;
+	size_t		n;
+	size_t		nalloc = 0;
+	size_t		nent = 0;
+	size_t		off;
+	size_t		valid;
+	struct cfjnlbatch	bh;
+	struct stat	cstat;
+	uint32_t	nbatch;
+	CFJNLENT_T	*ent = (CFJNLENT_T *)NULL;
+
+	cfjnlClose();
+
+	if ((a_vfp == (VFP_T *)NULL) || (a_vfp->_vfpFile == (FILE *)NULL)) {
+		return (0);
+	}
+
+	if (fstat(fileno(a_vfp->_vfpFile), &cstat) != 0) {
+		return (-1);
+	}
+
+	if (snprintf(jpath, sizeof (jpath), "%s%s", vfpGetPath(a_vfp),
+			CFJNL_SUFFIX) >= sizeof (jpath)) {
+		return (0);
+	}
+
+	if (readjnl(jpath, &cstat, &jbuf, &first, &valid, &nbatch) != 0) {
+		return ((errno == ENOENT) ? 0 : -1);
+	}
+
+	if ((nbatch == 0) && (a_track == 0)) {
+		(void) free(jbuf);
+		return (0);
+	}
+
+	/* collect the entries of all batches, in the order recorded */
+
+	for (off = first; off < valid; ) {
+		(void) memcpy(&bh, jbuf+off, sizeof (bh));
+		p = jbuf + off + sizeof (bh);
+		pend = p + bh.jb_len;
+		off += sizeof (bh) + bh.jb_len + sizeof (struct cfjnlftr);
+
+		/* every entry is newline terminated (see nextbatch) */
+
+		for (; p < pend; p = le) {
+			le = (char *)memchr(p, '\n', pend - p) + 1;
+
+			if ((*p != '+') && (*p != '-')) {
+				continue;
+			}
+
+			if (nent >= nalloc) {
+				CFJNLENT_T	*ne;
+
+				nalloc = (nalloc == 0) ? 1024 : nalloc * 2;
+				ne = (CFJNLENT_T *)realloc(ent,
+					nalloc * sizeof (CFJNLENT_T));
+				if (ne == (CFJNLENT_T *)NULL) {
+					(void) free(ent);
+					(void) free(jbuf);
+					errno = ENOMEM;
+					return (-1);
+				}
+				ent = ne;
+			}
+
+			for (pe = p+1; !ISPATHEND(*pe); pe++)
+				;
+
+			ent[nent].je_path = p+1;
+			ent[nent].je_plen = pe - (p+1);
+			ent[nent].je_line = (*p == '+') ? p+1 : (char *)NULL;
+			ent[nent].je_llen = (*p == '+') ? le - (p+1) : 0;
+			ent[nent].je_seq = nent;
+			nent++;
+		}
+	}
+
+	/* sort by path; only the last entry recorded for a path counts */
+
+	qsort(ent, nent, sizeof (CFJNLENT_T), entcmp);
+
+	cfjnl.cj_size = 0;
+	for (i = 0, n = 0; i < nent; i++) {
+		if ((i+1 < nent) && (pathcmp(ent[i].je_path, ent[i].je_plen,
+				ent[i+1].je_path, ent[i+1].je_plen) == 0)) {
+			continue;
+		}
+		cfjnl.cj_size += ent[i].je_llen;
+		ent[n++] = ent[i];
+	}
+
+	cfjnl.cj_vfp = a_vfp;
+	cfjnl.cj_start = vfpGetFirstCharPtr(a_vfp);
+	cfjnl.cj_track = a_track;
+	cfjnl.cj_buf = jbuf;
+	cfjnl.cj_valid = valid;
+	cfjnl.cj_nbatch = nbatch;
+	cfjnl.cj_ent = ent;
+	cfjnl.cj_nent = n;
+
+	return (n > 0);
+}
+
+/*
+ * Name:	cfjnlClose
+ * Description:	detach any journal attached to a contents file VFP
+ * Returns:	void
+ */
+
+void
+cfjnlClose(void)
+{
+	(void) free(cfjnl.cj_buf);
+	(void) free(cfjnl.cj_ent);
+	(void) free(cfjnl.cj_touch.db_buf);
+
+	cfjnl.cj_vfp = (VFP_T *)NULL;
+	cfjnl.cj_start = (char *)NULL;
+	cfjnl.cj_track = 0;
+	cfjnl.cj_buf = (char *)NULL;
+	cfjnl.cj_valid = 0;
+	cfjnl.cj_nbatch = 0;
+	cfjnl.cj_ent = (CFJNLENT_T *)NULL;
+	cfjnl.cj_nent = 0;
+	cfjnl.cj_size = 0;
+	cfjnl.cj_touch.db_buf = (char *)NULL;
+	cfjnl.cj_touch.db_len = 0;
+	cfjnl.cj_touch.db_alloc = 0;
+	cfjnl.cj_last = 0;
+	cfjnl.cj_ntouch = 0;
+}
+
+/*
+ * Name:	cfjnlSize
+ * Description:	determine the size of the contents file lines journaled
+ *		for a VFP
+ * Arguments:	a_vfp - (VFP_T *) - [RO, *RO]
+ *			VFP open on the contents file
+ * Returns:	size_t - number of bytes the journaled entries attached to
+ *			a_vfp can add to the contents file data; 0 if no
+ *			journal is attached to a_vfp
+ */
+
+size_t
+cfjnlSize(VFP_T *a_vfp)
+{
+	size_t	nent;
+
+	return ((cfjnlTable(a_vfp, &nent) == (CFJNLENT_T *)NULL) ? 0 :
+		cfjnl.cj_size);
+}
+
+/*
+ * Name:	cfjnlTable
+ * Description:	get the journaled entries attached to a contents file VFP
+ * Arguments:	a_vfp - (VFP_T *) - [RO, *RO]
+ *			VFP open on the contents file
+ *		r_nent - (size_t *) - [RO, *RW]
+ *			set to the number of entries
+ * Returns:	CFJNLENT_T * - the entries, sorted by path
+ *			== (CFJNLENT_T *)NULL - no journaled entries attached
+ *			to a_vfp; *r_nent is 0
+ */
+
+CFJNLENT_T *
+cfjnlTable(VFP_T *a_vfp, size_t *r_nent)
+{
+	*r_nent = 0;
+
+	if ((cfjnl.cj_nent == 0) || (cfjnl.cj_vfp != a_vfp) ||
+		(cfjnl.cj_start != vfpGetFirstCharPtr(a_vfp))) {
+		return ((CFJNLENT_T *)NULL);
+	}
+
+	*r_nent = cfjnl.cj_nent;
+	return (cfjnl.cj_ent);
+}
+
+/*
+ * Name:	cfjnlLocate
+ * Description:	locate a path in a table of journaled entries
+ * Arguments:	a_ent - (CFJNLENT_T *) - [RO, *RO]
+ *			entries, sorted by path
+ *		a_nent - (size_t) - [RO]
+ *			number of entries
+ *		a_path - (char *) - [RO, *RO]
+ *			path to locate; need not be null terminated
+ *		a_len - (size_t) - [RO]
+ *			length of a_path
+ * Returns:	size_t - index of the first entry whose path sorts at or
+ *			after a_path; a_nent if there is none
+ */
+
+size_t
+cfjnlLocate(CFJNLENT_T *a_ent, size_t a_nent, char *a_path, size_t a_len)
+{
+	size_t	lo = 0;
+	size_t	hi = a_nent;
+	size_t	mid;
+
+	while (lo < hi) {
+		mid = lo + ((hi - lo) >> 1);
+		if (pathcmp(a_ent[mid].je_path, a_ent[mid].je_plen,
+				a_path, a_len) < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return (lo);
+}
+
+/*
+ * Name:	cfjnlTouch
+ * Description:	record a path looked up in a contents file VFP that was
+ *		opened for update; the entry for the path may be changed
+ *		in the new contents file image
+ * Arguments:	a_vfp - (VFP_T *) - [RO, *RO]
+ *			VFP open on the contents file
+ *		a_path - (char *) - [RO, *RO]
+ *			path looked up; need not be null terminated
+ *		a_len - (size_t) - [RO]
+ *			length of a_path
+ * Returns:	void
+ */
+
+void
+cfjnlTouch(VFP_T *a_vfp, char *a_path, size_t a_len)
+{
+	struct dbuf	*db = &cfjnl.cj_touch;
+	size_t		off;
+
+	if ((cfjnl.cj_track == 0) || (cfjnl.cj_vfp != a_vfp) ||
+		(cfjnl.cj_start != vfpGetFirstCharPtr(a_vfp))) {
+		return;
+	}
+
+	/* the same path is often looked up several times in a row */
+
+	if ((cfjnl.cj_ntouch > 0) &&
+		(strlen(db->db_buf + cfjnl.cj_last) == a_len) &&
+		(memcmp(db->db_buf + cfjnl.cj_last, a_path, a_len) == 0)) {
+		return;
+	}
+
+	off = db->db_len;
+	if ((putbuf(db, a_path, a_len) != 0) || (putbuf(db, "", 1) != 0)) {
+		/* cfjnlAppend() cannot tell what changed */
+		cfjnl.cj_track = 0;
+		return;
+	}
+
+	cfjnl.cj_last = off;
+	cfjnl.cj_ntouch++;
+}
+
+/*
+ * Name:	cfjnlAppend
+ * Description:	append a batch recording the entries changed by an update
+ *		to the journal
+ * Arguments:	a_oldVfp - (VFP_T *) - [RO, *RO]
+ *			VFP open for reading on the contents file, with the
+ *			journal attached by cfjnlOpen() for update
+ *		a_newVfp - (VFP_T *) - [RO, *RO]
+ *			VFP holding the updated contents file data, written by
+ *			way of srchcfile() on a_oldVfp
+ *		a_contents - (char *) - [RO, *RO]
+ *			path of the contents file
+ *		a_defer - (int) - [RO]
+ *			== 0 - do not let the journal grow beyond its limit
+ *			!= 0 - append regardless of the size of the journal;
+ *				the caller folds the journal into the contents
+ *				file later (see end_cfbatch())
+ * Returns:	int
+ *			== 0 - the changes were recorded in the journal;
+ *				the contents file must not be rewritten
+ *			== 1 - not recorded: there is no journal attached, the
+ *				journal was not started on the contents file or
+ *				would become too large; the contents file must
+ *				be rewritten
+ *			< 0 - the journal could not be written, errno contains
+ *				the reason; the contents file must be rewritten
+ */
+
+int
+cfjnlAppend(VFP_T *a_oldVfp, VFP_T *a_newVfp, char *a_contents, int a_defer)
+{
+	char		jpath[PATH_MAX];
+	char		**tp;
+	char		*ne;
+	char		*nl;
+	char		*ns;
+	char		*oe;
+	char		*ol;
+	char		*os;
+	char		*p;
+	int		fd;
+	int		lerrno;
+	int		rv;
+	size_t		bhoff;
+	size_t		i;
+	size_t		j;
+	size_t		len;
+	size_t		limit;
+	size_t		nlen;
+	size_t		nt;
+	size_t		olen;
+	struct cfjnlbatch	bh;
+	struct cfjnlftr	ft;
+	struct dbuf	db = { (char *)NULL, 0, 0 };
+	struct stat	cstat;
+
+	if (snprintf(jpath, sizeof (jpath), "%s%s", a_contents,
+			CFJNL_SUFFIX) >= sizeof (jpath)) {
+		return (1);
+	}
+
+	/*
+	 * the paths looked up must have been recorded, and batches can only
+	 * be added to a journal started on the contents file (see cfjnlReset)
+	 */
+
+	if ((cfjnl.cj_track == 0) || (cfjnl.cj_vfp != a_oldVfp) ||
+		(cfjnl.cj_start != vfpGetFirstCharPtr(a_oldVfp)) ||
+		(cfjnl.cj_valid == 0)) {
+		return (1);
+	}
+
+	if (stat(a_contents, &cstat) != 0) {
+		return (-1);
+	}
+
+	/* sort the paths looked up, dropping duplicates */
+
+	tp = (char **)malloc((cfjnl.cj_ntouch + 1) * sizeof (char *));
+	if (tp == (char **)NULL) {
+		errno = ENOMEM;
+		return (-1);
+	}
+
+	p = cfjnl.cj_touch.db_buf;
+	for (i = 0; i < cfjnl.cj_ntouch; i++) {
+		tp[i] = p;
+		p += strlen(p) + 1;
+	}
+
+	qsort(tp, cfjnl.cj_ntouch, sizeof (char *), strpcmp);
+
+	for (i = 0, nt = 0; i < cfjnl.cj_ntouch; i++) {
+		if ((nt == 0) || (strcmp(tp[nt-1], tp[i]) != 0)) {
+			tp[nt++] = tp[i];
+		}
+	}
+
+	(void) memset(&bh, '\0', sizeof (bh));
+	bhoff = db.db_len;
+	if (putbuf(&db, (char *)&bh, sizeof (bh)) != 0) {
+		(void) free(tp);
+		return (-1);
+	}
+
+	/* compare the old and the new entry of each path looked up */
+
+	os = vfpGetFirstCharPtr(a_oldVfp);
+	oe = dataend(a_oldVfp, vfpGetLastCharPtr(a_oldVfp));
+	ns = vfpGetFirstCharPtr(a_newVfp);
+	ne = dataend(a_newVfp, ns + vfpGetModifiedLen(a_newVfp) - 1);
+
+	for (i = 0; i < nt; i++) {
+		len = strlen(tp[i]);
+
+		j = cfjnlLocate(cfjnl.cj_ent, cfjnl.cj_nent, tp[i], len);
+		if ((j < cfjnl.cj_nent) &&
+			(pathcmp(cfjnl.cj_ent[j].je_path,
+			cfjnl.cj_ent[j].je_plen, tp[i], len) == 0)) {
+			ol = cfjnl.cj_ent[j].je_line;
+			olen = (ol == (char *)NULL) ? 0 :
+				cfjnl.cj_ent[j].je_llen - 1;
+		} else {
+			ol = findline(os, oe, tp[i], len, &olen);
+		}
+
+		nl = findline(ns, ne, tp[i], len, &nlen);
+
+		rv = 0;
+		if (nl == (char *)NULL) {
+			if (ol != (char *)NULL) {
+				rv |= putbuf(&db, "-", 1);
+				rv |= putbuf(&db, tp[i], len);
+				rv |= putbuf(&db, "\n", 1);
+				bh.jb_nent++;
+			}
+		} else if ((ol == (char *)NULL) || (olen != nlen) ||
+				(memcmp(ol, nl, nlen) != 0)) {
+			rv |= putbuf(&db, "+", 1);
+			rv |= putbuf(&db, nl, nlen);
+			rv |= putbuf(&db, "\n", 1);
+			bh.jb_nent++;
+		}
+
+		if (rv != 0) {
+			(void) free(db.db_buf);
+			(void) free(tp);
+			return (-1);
+		}
+	}
+
+	(void) free(tp);
+
+	/* nothing to record if no entry changed */
+
+	if (bh.jb_nent == 0) {
+		(void) free(db.db_buf);
+		return (0);
+	}
+
+	/* fold the journal into the contents file once it grows too large */
+
+	limit = (size_t)cstat.st_size / CFJNL_RATIO;
+	if (limit < CFJNL_MINSIZE) {
+		limit = CFJNL_MINSIZE;
+	}
+
+	if ((a_defer == 0) &&
+		(cfjnl.cj_valid + db.db_len + sizeof (ft) > limit)) {
+		(void) free(db.db_buf);
+		return (1);
+	}
+
+	/* complete the batch header and footer */
+
+	(void) memcpy(bh.jb_magic, CFJNL_BMAGIC, sizeof (bh.jb_magic));
+	bh.jb_seq = cfjnl.cj_nbatch + 1;
+	bh.jb_len = db.db_len - bhoff - sizeof (bh);
+	(void) memcpy(db.db_buf + bhoff, &bh, sizeof (bh));
+
+	(void) memset(&ft, '\0', sizeof (ft));
+	ft.jf_cksum = cfidxHash(db.db_buf + bhoff, db.db_len - bhoff);
+	(void) memcpy(ft.jf_magic, CFJNL_FMAGIC, sizeof (ft.jf_magic));
+	if (putbuf(&db, (char *)&ft, sizeof (ft)) != 0) {
+		(void) free(db.db_buf);
+		return (-1);
+	}
+
+	/* discard any torn batch and append the new one in a single write */
+
+	if ((fd = open(jpath, O_WRONLY)) < 0) {
+		lerrno = errno;
+		(void) free(db.db_buf);
+		errno = lerrno;
+		return (-1);
+	}
+
+	if ((ftruncate(fd, (off_t)cfjnl.cj_valid) != 0) ||
+		(vfpSafePwrite(fd, db.db_buf, db.db_len,
+			(off_t)cfjnl.cj_valid) != db.db_len)) {
+		lerrno = errno;
+		(void) ftruncate(fd, (off_t)cfjnl.cj_valid);
+		(void) close(fd);
+		(void) free(db.db_buf);
+		errno = lerrno;
+		return (-1);
+	}
+
+	(void) free(db.db_buf);
+
+	if (close(fd) != 0) {
+		return (-1);
+	}
+
+	return (0);
+}
+
+/*
+ * *****************************************************************************
+ * static internal (private) functions
+ * *****************************************************************************
+ */
+
+/*
+ * Name:	readjnl
+ * Description:	read the journal and locate the batches that are complete
+ * Arguments:	a_path - (char *) - [RO, *RO]
+ *			path of the journal
+ *		a_cstat - (struct stat *) - [RO, *RO]
+ *			stat of the contents file the journal must apply to
+ *		r_buf - (char **) - [RW, *RW]
+ *			set to the malloc()ed contents of the journal
+ *		r_first - (size_t *) - [RW, *RW]
+ *			set to the offset of the first batch, following the
+ *			header
+ *		r_valid - (size_t *) - [RW, *RW]
+ *			set to the number of bytes from the start of the
+ *			journal up to the end of the last complete batch;
+ *			0 if the journal does not apply to the contents file
+ *		r_nbatch - (uint32_t *) - [RW, *RW]
+ *			set to the number of complete batches
+ * Returns:	int
+ *			== 0 - the journal was read
+ *			!= 0 - the journal could not be read, errno contains
+ *				the reason (ENOENT if there is no journal)
+ */
+
+static int
+readjnl(char *a_path, struct stat *a_cstat, char **r_buf, size_t *r_first,
+	size_t *r_valid, uint32_t *r_nbatch)
+{
+	char		*buf;
+	int		fd;
+	int		lerrno;
+	size_t		hlen;
+	size_t		len;
+	size_t		n;
+	size_t		off;
+	struct cfjnlhdr	hdr;
+	struct stat	jstat;
+
+	*r_buf = (char *)NULL;
+	*r_first = 0;
+	*r_valid = 0;
+	*r_nbatch = 0;
+
+	if ((fd = open(a_path, O_RDONLY)) < 0) {
+		return (-1);
+	}
+
+	if (fstat(fd, &jstat) != 0) {
+		lerrno = errno;
+		(void) close(fd);
+		errno = lerrno;
+		return (-1);
+	}
+
+	len = (size_t)jstat.st_size;
+	buf = (char *)malloc(len + 1);
+	if (buf == (char *)NULL) {
+		(void) close(fd);
+		errno = ENOMEM;
+		return (-1);
+	}
+
+	if ((len > 0) && (read(fd, buf, len) != len)) {
+		lerrno = (errno == 0) ? EIO : errno;
+		(void) free(buf);
+		(void) close(fd);
+		errno = lerrno;
+		return (-1);
+	}
+
+	(void) close(fd);
+	buf[len] = '\0';
+	*r_buf = buf;
+
+	/*
+	 * the journal must have been started on this contents file; older
+	 * journals are still honored so that an upgrade does not drop their
+	 * entries: a version 1 journal recorded the mtime in whole seconds
+	 * only, and the header of version 1 and 2 journals is shorter
+	 */
+
+	if (len < OLDHDRSIZE) {
+		return (0);
+	}
+
+	(void) memset(&hdr, '\0', sizeof (hdr));
+	(void) memcpy(&hdr, buf, (len < sizeof (hdr)) ? len : sizeof (hdr));
+	hlen = (hdr.jh_version < CFJNL_VERSION) ? OLDHDRSIZE : sizeof (hdr);
+
+	if ((memcmp(hdr.jh_magic, CFJNL_MAGIC, sizeof (hdr.jh_magic)) != 0) ||
+		(hdr.jh_version < 1) || (hdr.jh_version > CFJNL_VERSION) ||
+		(len < hlen) ||
+		(hdr.jh_size != (uint64_t)a_cstat->st_size) ||
+		(hdr.jh_mtime != (int64_t)a_cstat->st_mtim.tv_sec) ||
+		((hdr.jh_version > 1) &&
+		(hdr.jh_mtimens != (uint32_t)a_cstat->st_mtim.tv_nsec)) ||
+		(hdr.jh_ino != (uint64_t)a_cstat->st_ino) ||
+		(hdr.jh_dev != (uint64_t)a_cstat->st_dev)) {
+		return (0);
+	}
+
+	for (off = hlen; (n = nextbatch(buf, off, len)) != 0; off = n) {
+		(*r_nbatch)++;
+	}
+
+	*r_first = hlen;
+	*r_valid = off;
+
+	return (0);
+}
+
+/*
+ * Name:	readhdr
+ * Description:	read the header of a current version journal
+ * Arguments:	a_fd - (int) - [RO]
+ *			file descriptor open for reading on the journal
+ *		r_hdr - (struct cfjnlhdr *) - [RO, *RW]
+ *			filled in with the header
+ * Returns:	int
+ *			== 0 - the journal has a current version header
+ *			!= 0 - the journal is empty, of an older version or
+ *				cannot be read
+ */
+
+static int
+readhdr(int a_fd, struct cfjnlhdr *r_hdr)
+{
+	if ((pread(a_fd, r_hdr, sizeof (*r_hdr), (off_t)0) !=
+			sizeof (*r_hdr)) ||
+		(memcmp(r_hdr->jh_magic, CFJNL_MAGIC,
+			sizeof (r_hdr->jh_magic)) != 0) ||
+		(r_hdr->jh_version != CFJNL_VERSION)) {
+		return (-1);
+	}
+
+	return (0);
+}
+
+/*
+ * Name:	orphaned
+ * Description:	determine if a journal is owned by a batch of packages whose
+ *		owner no longer exists
+ * Arguments:	a_fd - (int) - [RO]
+ *			file descriptor open for reading on the journal
+ *		r_hdr - (struct cfjnlhdr *) - [RO, *RW]
+ *			filled in with the header of the journal
+ * Returns:	int
+ *			== 0 - not a batch journal, or its owner exists
+ *			!= 0 - the batch owning the journal was not finished
+ */
+
+static int
+orphaned(int a_fd, struct cfjnlhdr *r_hdr)
+{
+	if ((readhdr(a_fd, r_hdr) != 0) || (r_hdr->jh_owner <= 0)) {
+		return (0);
+	}
+
+	return ((kill((pid_t)r_hdr->jh_owner, 0) != 0) && (errno == ESRCH));
+}
+
+/*
+ * Name:	findline
+ * Description:	locate the line of a path in sorted contents file data
+ * Arguments:	a_start - (char *) - [RO, *RO]
+ *			-> first byte of the data
+ *		a_end - (char *) - [RO, *RO]
+ *			-> byte following the data
+ *		a_path - (char *) - [RO, *RO]
+ *			path to locate
+ *		a_len - (size_t) - [RO]
+ *			length of a_path
+ *		r_len - (size_t *) - [RO, *RW]
+ *			set to the length of the line, less any newline
+ * Returns:	char * - the first byte of the line for a_path
+ *			== (char *)NULL - no entry for a_path in the data
+ */
+
+static char *
+findline(char *a_start, char *a_end, char *a_path, size_t a_len,
+	size_t *r_len)
+{
+	char	*hi = a_end;
+	char	*le;
+	char	*lo = a_start;
+	char	*mid;
+	char	*p;
+	char	*pe;
+	int	n;
+
+	/* bisect to the last line that starts at or before the path */
+
+	while (hi - lo > 1024) {
+		mid = lo + ((hi - lo) >> 1);
+		while ((mid > lo) && (mid[-1] != '\n')) {
+			mid--;
+		}
+		if ((mid == lo) || (*mid != '/')) {
+			break;
+		}
+		for (pe = mid; (pe < hi) && !ISPATHEND(*pe); pe++)
+			;
+		n = pathcmp(mid, pe - mid, a_path, a_len);
+		if (n == 0) {
+			lo = mid;
+			break;
+		}
+		if (n < 0) {
+			lo = mid;
+		} else {
+			hi = mid;
+		}
+	}
+
+	/* then scan forward, skipping comments */
+
+	for (p = lo; p < hi; p = le) {
+		le = memchr(p, '\n', a_end - p);
+		le = (le == (char *)NULL) ? a_end : le;
+
+		if (*p == '/') {
+			for (pe = p; (pe < le) && !ISPATHEND(*pe); pe++)
+				;
+			n = pathcmp(p, pe - p, a_path, a_len);
+			if (n == 0) {
+				*r_len = le - p;
+				return (p);
+			}
+			if (n > 0) {
+				break;
+			}
+		}
+
+		if (le < a_end) {
+			le++;
+		}
+	}
+
+	*r_len = 0;
+	return ((char *)NULL);
+}
+
+/*
+ * Name:	nextbatch
+ * Description:	validate the batch starting at an offset in the journal
+ * Arguments:	a_buf - (char *) - [RO, *RO]
+ *			contents of the journal
+ *		a_off - (size_t) - [RO]
+ *			offset of the batch header
+ *		a_len - (size_t) - [RO]
+ *			number of bytes in a_buf
+ * Returns:	size_t
+ *			== 0 - no complete batch at a_off
+ *			!= 0 - offset of the byte following the batch footer
+ */
+
+static size_t
+nextbatch(char *a_buf, size_t a_off, size_t a_len)
+{
+	size_t			end;
+	struct cfjnlbatch	bh;
+	struct cfjnlftr		ft;
+
+	if (a_len - a_off < sizeof (bh) + sizeof (ft)) {
+		return (0);
+	}
+
+	(void) memcpy(&bh, a_buf + a_off, sizeof (bh));
+	if ((memcmp(bh.jb_magic, CFJNL_BMAGIC, sizeof (bh.jb_magic)) != 0) ||
+		(bh.jb_len > a_len - a_off - sizeof (bh) - sizeof (ft))) {
+		return (0);
+	}
+
+	end = a_off + sizeof (bh) + bh.jb_len;
+	if ((bh.jb_len > 0) && (a_buf[end-1] != '\n')) {
+		return (0);
+	}
+
+	(void) memcpy(&ft, a_buf + end, sizeof (ft));
+	if ((memcmp(ft.jf_magic, CFJNL_FMAGIC, sizeof (ft.jf_magic)) != 0) ||
+		(ft.jf_cksum != cfidxHash(a_buf + a_off, end - a_off))) {
+		return (0);
+	}
+
+	return (end + sizeof (ft));
+}
+
+/*
+ * Name:	dataend
+ * Description:	determine the end of the text held in a VFP
+ * Arguments:	a_vfp - (VFP_T *) - [RO, *RO]
+ *			VFP holding contents file data
+ *		a_last - (char *) - [RO, *RO]
+ *			-> last byte of data in the VFP
+ * Returns:	char * - the byte following the data, or the first null
+ *			byte in the data if that comes before it
+ */
+
+static char *
+dataend(VFP_T *a_vfp, char *a_last)
+{
+	char	*p;
+	char	*ps = vfpGetFirstCharPtr(a_vfp);
+
+	if ((ps == (char *)NULL) || (a_last < ps)) {
+		return (ps);
+	}
+
+	p = memchr(ps, '\0', (a_last - ps) + 1);
+
+	return ((p == (char *)NULL) ? a_last + 1 : p);
+}
+
+/*
+ * Name:	pathcmp
+ * Description:	compare two paths in the order of the contents file
+ * Returns:	int - < 0, == 0 or > 0 as the first path sorts before, the same
+ *			as or after the second path
+ */
+
+static int
+pathcmp(char *a_p1, size_t a_l1, char *a_p2, size_t a_l2)
+{
+	int	n;
+
+	n = memcmp(a_p1, a_p2, (a_l1 < a_l2) ? a_l1 : a_l2);
+	if (n != 0) {
+		return (n);
+	}
+
+	return ((a_l1 < a_l2) ? -1 : ((a_l1 > a_l2) ? 1 : 0));
+}
+
+/*
+ * qsort() comparison function: order journal entries by path, and entries
+ * for the same path in the order in which they were recorded
+ */
+
+static int
+entcmp(const void *a_e1, const void *a_e2)
+{
+	const CFJNLENT_T	*e1 = (const CFJNLENT_T *)a_e1;
+	const CFJNLENT_T	*e2 = (const CFJNLENT_T *)a_e2;
+	int			n;
+
+	n = pathcmp(e1->je_path, e1->je_plen, e2->je_path, e2->je_plen);
+	if (n != 0) {
+		return (n);
+	}
+
+	return ((e1->je_seq < e2->je_seq) ? -1 : 1);
+}
+
+/*
+ * qsort() comparison function: order null terminated paths
+ */
+
+static int
+strpcmp(const void *a_s1, const void *a_s2)
+{
+	return (strcmp(*(char * const *)a_s1, *(char * const *)a_s2));
+}
+
+/*
+ * Name:	putbuf
+ * Description:	append bytes to a growable buffer
+ * Returns:	int
+ *			== 0 - bytes appended
+ *			!= 0 - out of memory; the buffer is unchanged
+ */
+
+static int
+putbuf(struct dbuf *a_db, char *a_data, size_t a_len)
+{
+	if (a_db->db_len + a_len > a_db->db_alloc) {
+		char	*nb;
+		size_t	nalloc;
+
+		nalloc = (a_db->db_alloc == 0) ? 65536 : a_db->db_alloc * 2;
+		while (nalloc < a_db->db_len + a_len) {
+			nalloc *= 2;
+		}
+
+		nb = (char *)realloc(a_db->db_buf, nalloc);
+		if (nb == (char *)NULL) {
+			errno = ENOMEM;
+			return (-1);
+		}
+		a_db->db_buf = nb;
+		a_db->db_alloc = nalloc;
+	}
+
+	(void) memcpy(a_db->db_buf + a_db->db_len, a_data, a_len);
+	a_db->db_len += a_len;
+
+	return (0);
+}
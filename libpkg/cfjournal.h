@@ -0,0 +1,136 @@
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at src/OPENSOLARIS.LICENSE
+ * or http://www.opensolaris.org/os/licensing.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+#ifndef	_CFJOURNAL_H
+#define	_CFJOURNAL_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <sys/types.h>
+#include <inttypes.h>
+
+/*
+ * On-disk layout of the contents file delta journal ("contents.jnl").
+ *
+ * The journal starts with a header that identifies the contents file the
+ * journal applies to, followed by any number of batches, one for each
+ * package operation that updated the database:
+ *
+ *	struct cfjnlhdr
+ *	struct cfjnlbatch	(batch 1)
+ *	jb_len bytes of entries
+ *	struct cfjnlftr
+ *	struct cfjnlbatch	(batch 2)
+ *	...
+ *
+ * The entries of a batch are newline terminated text lines sorted by path:
+ *
+ *	+<contents file line>	- add or replace the entry for a path
+ *	-<path>			- remove the entry for a path
+ *
+ * Removing a package from a shared path is recorded as a replacement of
+ * the entry with the package dropped from its package list.
+ *
+ * A batch is only used if its footer is present and the checksum in the
+ * footer matches; a batch torn by a crash is ignored and is overwritten by
+ * the next batch appended. Batches are only appended to a journal whose
+ * header describes the contents file; an empty journal file, or one whose
+ * header describes another contents file, has the next update rewrite the
+ * contents file in full and the journal started anew (see cfjnlReset()).
+ * If the journal file does not exist journaling is disabled.
+ *
+ * A journal created for a batch of packages (see cfjnlCreate()) records
+ * the process that owns the batch in jh_owner; if that process no longer
+ * exists the batch was not finished, and the next update that rewrites the
+ * contents file removes the journal (see cfjnlOrphaned()). The header of
+ * a version 1 or 2 journal ends before jh_owner.
+ *
+ * All values are stored in native byte order - the journal is private
+ * to the local contents file and is never transported.
+ */
+
+#define	CFJNL_MAGIC	"PKGCFJNL"
+#define	CFJNL_BMAGIC	"PKGCFBAT"
+#define	CFJNL_FMAGIC	"PKGCFEND"
+#define	CFJNL_VERSION	3
+#define	CFJNL_SUFFIX	".jnl"
+
+/*
+ * The journal is folded back into the contents file when appending a batch
+ * would make it larger than 1/CFJNL_RATIO of the contents file, or larger
+ * than CFJNL_MINSIZE if that is greater.
+ */
+
+#define	CFJNL_RATIO	8
+#define	CFJNL_MINSIZE	(1024*1024)	/* 1mb */
+
+struct cfjnlhdr {
+	char		jh_magic[8];	/* CFJNL_MAGIC */
+	uint32_t	jh_version;	/* CFJNL_VERSION */
+	uint32_t	jh_mtimens;	/* nanoseconds of jh_mtime */
+	uint64_t	jh_size;	/* size of base contents file */
+	int64_t		jh_mtime;	/* mtime of base contents file */
+	uint64_t	jh_ino;		/* inode of base contents file */
+	uint64_t	jh_dev;		/* device of base contents file */
+	int32_t		jh_owner;	/* process owning a batch journal */
+	uint32_t	jh_pad;
+};
+
+struct cfjnlbatch {
+	char		jb_magic[8];	/* CFJNL_BMAGIC */
+	uint32_t	jb_seq;		/* 1 for first batch in journal */
+	uint32_t	jb_nent;	/* number of entries in batch */
+	uint64_t	jb_len;		/* bytes of entries that follow */
+};
+
+struct cfjnlftr {
+	uint32_t	jf_cksum;	/* hash of batch header and entries */
+	uint32_t	jf_pad;
+	char		jf_magic[8];	/* CFJNL_FMAGIC */
+};
+
+/*
+ * The journaled entries attached to a contents file VFP by cfjnlOpen(): one
+ * entry for each path recorded in the journal, sorted by path, holding the
+ * last line recorded for the path. srchcfile() merges these entries with
+ * the contents file data.
+ */
+
+typedef struct _cfjnlent {
+	char	*je_path;	/* -> path of entry */
+	size_t	je_plen;	/* length of path */
+	char	*je_line;	/* -> contents line; NULL if path removed */
+	size_t	je_llen;	/* length of line including newline */
+	size_t	je_seq;		/* order in which entry was recorded */
+} CFJNLENT_T;
+
+extern size_t		cfjnlLocate(CFJNLENT_T *a_ent, size_t a_nent,
+				char *a_path, size_t a_len);
+extern CFJNLENT_T	*cfjnlTable(VFP_T *a_vfp, size_t *r_nent);
+extern void		cfjnlTouch(VFP_T *a_vfp, char *a_path, size_t a_len);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _CFJOURNAL_H */
@@ -0,0 +1,832 @@
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at src/OPENSOLARIS.LICENSE
+ * or http://www.opensolaris.org/os/licensing.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+/*LINTLIBRARY*/
+
+/*
+ * Module:	cfpkgindex.c
+ * Synopsis:	Maintain and use the contents file package index
+ * Description:
+ *
+ * Operations on the files of one package - pkgrm, pkginfo -l and pkgchk
+ * of a package - have to parse every line of the contents file to find
+ * the lines that name the package. This module maintains an optional
+ * sidecar file next to the contents file that maps each package instance
+ * to the byte offsets of the lines that name it, so that such operations
+ * can visit just those lines.
+ *
+ * Like the line-offset index (see cfindex.c) the package index is written
+ * by swapcfile() each time the contents file is replaced, and attached to
+ * the contents file VFP by ocfile()/socfile(). A missing or stale index is
+ * rebuilt from the contents file only by ocfile(), under the package
+ * database write lock; socfile() may not hold the lock, and leaves its
+ * callers to scan the file. The index is only trusted if the size,
+ * modification time and inode recorded in its header match the contents
+ * file it is attached to; without a trusted index (or when the contents
+ * file data was merged with the journal) callers fall back to scanning
+ * the whole file.
+ *
+ * Public Methods:
+ *
+ *   cfpkxClose - detach the package index from the contents file VFP
+ *   cfpkxFind - locate the lines naming a set of packages
+ *   cfpkxOpen - attach the package index to an open contents file VFP
+ *   cfpkxWrite - write the package index for the contents file in a VFP
+ */
+
+#include <stdio.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <pkglib.h>
+#include "libadm.h"
+#include "cfjournal.h"
+#include "cfpkgindex.h"
+
+/*
+ * the package index currently attached to a contents file VFP
+ */
+
+static struct {
+	VFP_T		*px_vfp;	/* VFP the index is attached to */
+	char		*px_start;	/* first data byte of that VFP */
+	void		*px_map;	/* mapping of the index file */
+	size_t		px_mapsize;	/* size of the mapping */
+	struct cfpkxpkg	*px_pkg;	/* -> first package record */
+	uint64_t	px_npkg;	/* number of package records */
+	uint64_t	*px_off;	/* -> first line offset */
+	uint64_t	px_noff;	/* number of line offsets */
+} cfpkx = { NULL, NULL, MAP_FAILED, 0, NULL, 0, NULL, 0 };
+
+/*
+ * line offsets collected for each package while the index is built; the
+ * table is indexed by the symbol of the package instance name
+ */
+
+struct pkxent {
+	uint64_t	*pe_off;		/* line offsets */
+	size_t		pe_noff;		/* number of line offsets */
+	size_t		pe_nalloc;		/* size of pe_off */
+};
+
+struct pkxtab {
+	struct pkxent	*pt_ent;	/* offsets of each symbol */
+	size_t		pt_size;	/* number of elements in pt_ent */
+};
+
+#define	PKXTAB_INITSIZE	1024	/* initial size of package table */
+#define	PKXENT_INITOFF	64	/* initial number of offsets per package */
+
+#define	ISBLANK(C)	(((C) == ' ') || ((C) == '\t'))
+#define	ISEOL(P, E)	(((P) >= (E)) || (*(P) == '\n') || (*(P) == '\0'))
+
+/* status characters that may precede a package name in the contents file */
+
+#define	ISPKGSTATUS(C)	(((C) == '-') || ((C) == '+') || ((C) == '*') || \
+			((C) == '~') || ((C) == '!') || ((C) == '%'))
+
+static int	addline(struct pkxtab *a_tab, char *a_line, char *a_end,
+			uint64_t a_off);
+static int	addoff(struct pkxtab *a_tab, char *a_pkg, size_t a_len,
+			uint64_t a_off);
+static void	freetab(struct pkxtab *a_tab);
+static int	linecmp(const void *a_l1, const void *a_l2);
+static int	nattrs(int a_ftype);
+static char	*nexttok(char *a_p, char *a_end);
+static int	pkgcmp(const void *a_p1, const void *a_p2);
+static int	symcmp(const void *a_s1, const void *a_s2);
+
+/*
+ * Name:	cfpkxClose
+ * Description:	detach any package index attached to a contents file VFP
+ * Returns:	void
+ */
+
+void
+cfpkxClose(void)
+{
+	if (cfpkx.px_map != MAP_FAILED) {
+		(void) munmap(cfpkx.px_map, cfpkx.px_mapsize);
+	}
+
+	cfpkx.px_vfp = (VFP_T *)NULL;
+	cfpkx.px_start = (char *)NULL;
+	cfpkx.px_map = MAP_FAILED;
+	cfpkx.px_mapsize = 0;
+	cfpkx.px_pkg = (struct cfpkxpkg *)NULL;
+	cfpkx.px_npkg = 0;
+	cfpkx.px_off = (uint64_t *)NULL;
+	cfpkx.px_noff = 0;
+}
+
+/*
+ * Name:	cfpkxOpen
+ * Description:	attach the package index for the contents file open on a VFP
+ * Arguments:	a_vfp - (VFP_T *) - [RO, *RO]
+ *			VFP open on the contents file; the index is expected
+ *			next to the file the VFP is associated with.
+ * Returns:	int
+ *			== 0 - a valid index is attached to the VFP
+ *			< 0 - no index or stale index; nothing attached
+ *			> 0 - the index records that the contents file
+ *				cannot be indexed; nothing attached
+ */
+
+int
+cfpkxOpen(VFP_T *a_vfp)
+{
+	char		path[PATH_MAX];
+	int		fd;
+	struct cfpkxhdr	*hdr;
+	struct stat	cstat;
+	struct stat	istat;
+	void		*map;
+	int		noindex;
+
+	cfpkxClose();
+
+	if ((a_vfp == (VFP_T *)NULL) || (a_vfp->_vfpFile == (FILE *)NULL)) {
+		return (-1);
+	}
+
+	if (fstat(fileno(a_vfp->_vfpFile), &cstat) != 0) {
+		return (-1);
+	}
+
+	if (snprintf(path, sizeof (path), "%s%s", vfpGetPath(a_vfp),
+			CFPKX_SUFFIX) >= sizeof (path)) {
+		return (-1);
+	}
+
+	if ((fd = open(path, O_RDONLY)) < 0) {
+		return (-1);
+	}
+
+	if ((fstat(fd, &istat) != 0) ||
+			(istat.st_size < sizeof (struct cfpkxhdr))) {
+		(void) close(fd);
+		return (-1);
+	}
+
+	map = mmap(NULL, istat.st_size, PROT_READ, MAP_SHARED, fd, (off_t)0);
+	(void) close(fd);
+	if (map == MAP_FAILED) {
+		return (-1);
+	}
+
+	/* the index must describe exactly the contents file opened */
+
+	hdr = (struct cfpkxhdr *)map;
+	noindex = (memcmp(hdr->ph_magic, CFPKX_NMAGIC,
+		sizeof (hdr->ph_magic)) == 0);
+	if ((!noindex && (memcmp(hdr->ph_magic, CFPKX_MAGIC,
+			sizeof (hdr->ph_magic)) != 0)) ||
+		(hdr->ph_version != CFPKX_VERSION) ||
+		(hdr->ph_size != (uint64_t)cstat.st_size) ||
+		(hdr->ph_mtime != (int64_t)cstat.st_mtim.tv_sec) ||
+		(hdr->ph_mtimens != (uint32_t)cstat.st_mtim.tv_nsec) ||
+		(hdr->ph_ino != (uint64_t)cstat.st_ino) ||
+		(hdr->ph_dev != (uint64_t)cstat.st_dev) ||
+		(istat.st_size != sizeof (struct cfpkxhdr) +
+			hdr->ph_npkg * sizeof (struct cfpkxpkg) +
+			hdr->ph_noff * sizeof (uint64_t))) {
+		(void) munmap(map, istat.st_size);
+		return (-1);
+	}
+
+	if (noindex) {
+		(void) munmap(map, istat.st_size);
+		return (1);
+	}
+
+	cfpkx.px_vfp = a_vfp;
+	cfpkx.px_start = vfpGetFirstCharPtr(a_vfp);
+	cfpkx.px_map = map;
+	cfpkx.px_mapsize = istat.st_size;
+	cfpkx.px_pkg = (struct cfpkxpkg *)(hdr+1);
+	cfpkx.px_npkg = hdr->ph_npkg;
+	cfpkx.px_off = (uint64_t *)(cfpkx.px_pkg + hdr->ph_npkg);
+	cfpkx.px_noff = hdr->ph_noff;
+
+	return (0);
+}
+
+/*
+ * Name:	cfpkxFind
+ * Description:	use the attached package index to locate all lines of the
+ *		contents file that name one of a set of packages
+ * Arguments:	a_vfp - (VFP_T *) - [RO, *RO]
+ *			VFP open on the contents file being searched
+ *		a_pkgs - (char **) - [RO, *RO]
+ *			package instance names to locate the lines of
+ *		a_npkgs - (int) - [RO]
+ *			number of names in a_pkgs
+ *		r_nlines - (size_t *) - [RO, *RW]
+ *			set to the number of lines located
+ * Returns:	char **	- allocated array of *r_nlines pointers to the first
+ *			byte of each line at or after the current position of
+ *			a_vfp that names one of the packages, in file order;
+ *			the caller must free() the array
+ *			== (char **)NULL - no index attached to a_vfp, a
+ *			name is a wildcard specification ("all", "pkg.*"),
+ *			or journaled entries are merged with the lines of
+ *			the file (see cfjnlOpen()); the caller must scan the
+ *			file.
+ */
+
+char **
+cfpkxFind(VFP_T *a_vfp, char **a_pkgs, int a_npkgs, size_t *r_nlines)
+{
+	char		**lines;
+	char		*curr;
+	char		*first;
+	int		i;
+	size_t		len;
+	size_t		n;
+	uint64_t	j;
+	uint64_t	total;
+	struct cfpkxpkg	key;
+	struct cfpkxpkg	*pp;
+
+	*r_nlines = 0;
+
+	if ((cfpkx.px_vfp == (VFP_T *)NULL) || (cfpkx.px_vfp != a_vfp) ||
+		(cfpkx.px_start != vfpGetFirstCharPtr(a_vfp)) ||
+		(cfjnlTable(a_vfp, &n) != (CFJNLENT_T *)NULL)) {
+		return ((char **)NULL);
+	}
+
+	/* only exact package instance names can be looked up */
+
+	total = 0;
+	for (i = 0; i < a_npkgs; i++) {
+		if ((a_pkgs[i] == (char *)NULL) ||
+				(strcmp(a_pkgs[i], "all") == 0) ||
+				(strchr(a_pkgs[i], '*') != (char *)NULL)) {
+			return ((char **)NULL);
+		}
+
+		if (strlcpy(key.cp_pkg, a_pkgs[i], sizeof (key.cp_pkg)) >=
+				sizeof (key.cp_pkg)) {
+			continue;
+		}
+
+		pp = (struct cfpkxpkg *)bsearch(&key, cfpkx.px_pkg,
+			cfpkx.px_npkg, sizeof (struct cfpkxpkg), pkgcmp);
+		if (pp == (struct cfpkxpkg *)NULL) {
+			continue;
+		}
+
+		if ((pp->cp_first > cfpkx.px_noff) ||
+				(pp->cp_count > cfpkx.px_noff - pp->cp_first)) {
+			return ((char **)NULL);
+		}
+
+		total += pp->cp_count;
+	}
+
+	lines = (char **)malloc((total + 1) * sizeof (char *));
+	if (lines == (char **)NULL) {
+		return ((char **)NULL);
+	}
+
+	/* verify each line offset against the data actually in the VFP */
+
+	first = vfpGetFirstCharPtr(a_vfp);
+	curr = vfpGetCurrCharPtr(a_vfp);
+	len = (size_t)(vfpGetLastCharPtr(a_vfp) - first) + 1;
+
+	n = 0;
+	for (i = 0; i < a_npkgs; i++) {
+		if (strlcpy(key.cp_pkg, a_pkgs[i], sizeof (key.cp_pkg)) >=
+				sizeof (key.cp_pkg)) {
+			continue;
+		}
+
+		pp = (struct cfpkxpkg *)bsearch(&key, cfpkx.px_pkg,
+			cfpkx.px_npkg, sizeof (struct cfpkxpkg), pkgcmp);
+		if (pp == (struct cfpkxpkg *)NULL) {
+			continue;
+		}
+
+		for (j = 0; j < pp->cp_count; j++) {
+			uint64_t	off = cfpkx.px_off[pp->cp_first + j];
+			char		*p = first + off;
+
+			if ((off >= len) || (*p != '/') ||
+					((off > 0) && (p[-1] != '\n'))) {
+				(void) free(lines);
+				return ((char **)NULL);
+			}
+
+			if (p >= curr) {
+				lines[n++] = p;
+			}
+		}
+	}
+
+	/* lines naming several of the packages are visited only once */
+
+	if (a_npkgs > 1) {
+		size_t	k;
+
+		qsort(lines, n, sizeof (char *), linecmp);
+
+		for (k = 0, j = 0; j < n; j++) {
+			if ((k == 0) || (lines[k-1] != lines[j])) {
+				lines[k++] = lines[j];
+			}
+		}
+		n = k;
+	}
+
+	*r_nlines = n;
+
+	return (lines);
+}
+
+/*
+ * Name:	cfpkxWrite
+ * Description:	write the package index describing the contents file data
+ *		in a VFP
+ * Arguments:	a_vfp - (VFP_T *) - [RO, *RO]
+ *			VFP holding the data just written to the contents
+ *			file, or open for reading on the contents file
+ *		a_contents - (char *) - [RO, *RO]
+ *			path of the contents file holding the data; the
+ *			index is written to the same path plus CFPKX_SUFFIX
+ * Returns:	int
+ *			== 0 - the index, or the record that the data cannot
+ *				be indexed, was written
+ *			!= 0 - the index could not be written; any previous
+ *				index has been removed
+ * NOTES:	The caller must hold the package database write lock. The
+ *		index is stamped with the identity of the file open on a_vfp;
+ *		if no file is open on it (the data was just written to
+ *		a_contents by swapcfile()) a_contents itself is examined.
+ */
+
+int
+cfpkxWrite(VFP_T *a_vfp, char *a_contents)
+{
+	char		ipath[PATH_MAX];
+	char		tpath[PATH_MAX];
+	char		*end;
+	char		*p;
+	char		*ps;
+	int		fd;
+	int		lerrno;
+	size_t		i;
+	size_t		n;
+	ssize_t		len;
+	ssize_t		wlen;
+	struct cfpkxhdr	hdr;
+	struct cfpkxpkg	*pkgs;
+	struct pkxtab	tab;
+	PKGSTRSYM_T	*syms;
+	struct stat	cstat;
+
+	if ((snprintf(ipath, sizeof (ipath), "%s%s", a_contents,
+			CFPKX_SUFFIX) >= sizeof (ipath)) ||
+		(snprintf(tpath, sizeof (tpath), "%s.XXXXXX", ipath) >=
+			sizeof (tpath))) {
+		errno = ENAMETOOLONG;
+		return (-1);
+	}
+
+	/* the index describes the file the data in the VFP was read from */
+
+	if ((a_vfp->_vfpFile != (FILE *)NULL) ?
+			(fstat(fileno(a_vfp->_vfpFile), &cstat) != 0) :
+			(stat(a_contents, &cstat) != 0)) {
+		lerrno = errno;
+		(void) unlink(ipath);
+		errno = lerrno;
+		return (-1);
+	}
+
+	(void) memset(&hdr, '\0', sizeof (hdr));
+	(void) memcpy(hdr.ph_magic, CFPKX_MAGIC, sizeof (hdr.ph_magic));
+	hdr.ph_version = CFPKX_VERSION;
+	hdr.ph_size = (uint64_t)cstat.st_size;
+	hdr.ph_mtime = (int64_t)cstat.st_mtim.tv_sec;
+	hdr.ph_mtimens = (uint32_t)cstat.st_mtim.tv_nsec;
+	hdr.ph_ino = (uint64_t)cstat.st_ino;
+	hdr.ph_dev = (uint64_t)cstat.st_dev;
+
+	/*
+	 * create the temporary file first, so that a caller that cannot
+	 * write the index does not pay for building it; the index must be
+	 * readable by the unprivileged users that may run pkgchk
+	 */
+
+	fd = mkstemp(tpath);
+	if ((fd < 0) || (fchmod(fd, 0644) != 0)) {
+		lerrno = errno;
+		if (fd >= 0) {
+			(void) close(fd);
+			(void) unlink(tpath);
+		}
+		(void) unlink(ipath);
+		errno = lerrno;
+		return (-1);
+	}
+
+	tab.pt_ent = (struct pkxent *)NULL;
+	tab.pt_size = 0;
+
+	syms = (PKGSTRSYM_T *)NULL;
+	pkgs = (struct cfpkxpkg *)NULL;
+	n = 0;
+
+	/*
+	 * collect the packages named on each line; lines in the old style
+	 * format (type class path) are not indexed, so a contents file that
+	 * holds any is only recorded as not indexable
+	 */
+
+	ps = vfpGetFirstCharPtr(a_vfp);
+	end = ps + vfpGetModifiedLen(a_vfp);
+
+	for (p = ps; (p < end) && (*p != '\0'); ) {
+		int	c = *p;
+
+		if (c == '/') {
+			if (addline(&tab, p, end, (uint64_t)(p - ps)) != 0) {
+				freetab(&tab);
+				if (errno != EINVAL) {
+					goto failed;
+				}
+				(void) memcpy(hdr.ph_magic, CFPKX_NMAGIC,
+					sizeof (hdr.ph_magic));
+				goto writeindex;
+			}
+		} else if (!isspace(c) && (c != '#') && (c != ':')) {
+			freetab(&tab);
+			(void) memcpy(hdr.ph_magic, CFPKX_NMAGIC,
+				sizeof (hdr.ph_magic));
+			goto writeindex;
+		}
+
+		/* advance to the start of the next line */
+
+		p = memchr(p, '\n', end - p);
+		if (p == (char *)NULL) {
+			break;
+		}
+		p++;
+	}
+
+	/* order the packages by name and lay out their line offsets */
+
+	for (i = 1, n = 0; i < tab.pt_size; i++) {
+		if (tab.pt_ent[i].pe_noff > 0) {
+			n++;
+		}
+	}
+
+	syms = (PKGSTRSYM_T *)malloc((n + 1) * sizeof (PKGSTRSYM_T));
+	pkgs = (struct cfpkxpkg *)calloc(n + 1, sizeof (struct cfpkxpkg));
+	if ((syms == (PKGSTRSYM_T *)NULL) ||
+			(pkgs == (struct cfpkxpkg *)NULL)) {
+		(void) free(syms);
+		(void) free(pkgs);
+		freetab(&tab);
+		errno = ENOMEM;
+		goto failed;
+	}
+
+	for (i = 1, n = 0; i < tab.pt_size; i++) {
+		if (tab.pt_ent[i].pe_noff > 0) {
+			syms[n++] = (PKGSTRSYM_T)i;
+		}
+	}
+
+	qsort(syms, n, sizeof (PKGSTRSYM_T), symcmp);
+
+	for (i = 0; i < n; i++) {
+		struct pkxent	*pe = &tab.pt_ent[syms[i]];
+
+		(void) strlcpy(pkgs[i].cp_pkg, pkgstrSymName(syms[i]),
+			sizeof (pkgs[i].cp_pkg));
+		pkgs[i].cp_first = hdr.ph_noff;
+		pkgs[i].cp_count = pe->pe_noff;
+		hdr.ph_noff += pe->pe_noff;
+	}
+	hdr.ph_npkg = n;
+
+	/* write the new index to the temporary file and move it into place */
+
+writeindex:
+	wlen = vfpSafeWrite(fd, &hdr, sizeof (hdr));
+	if (wlen == sizeof (hdr)) {
+		len = n * sizeof (struct cfpkxpkg);
+		if ((len > 0) && (vfpSafeWrite(fd, pkgs, len) != len)) {
+			wlen = -1;
+		}
+	}
+
+	for (i = 0; (wlen == sizeof (hdr)) && (i < n); i++) {
+		struct pkxent	*pe = &tab.pt_ent[syms[i]];
+
+		len = pe->pe_noff * sizeof (uint64_t);
+		if (vfpSafeWrite(fd, pe->pe_off, len) != len) {
+			wlen = -1;
+		}
+	}
+
+	(void) free(syms);
+	(void) free(pkgs);
+	freetab(&tab);
+
+	if ((close(fd) != 0) || (wlen != sizeof (hdr)) ||
+			(rename(tpath, ipath) != 0)) {
+		lerrno = errno;
+		(void) unlink(tpath);
+		(void) unlink(ipath);
+		errno = lerrno;
+		return (-1);
+	}
+
+	return (0);
+
+failed:
+	lerrno = errno;
+	(void) close(fd);
+	(void) unlink(tpath);
+	(void) unlink(ipath);
+	errno = lerrno;
+	return (-1);
+}
+
+/*
+ * Name:	addline
+ * Description:	add a line of the contents file to the offsets of each
+ *		package it names
+ * Arguments:	a_tab - (struct pkxtab *) - [RO, *RW]
+ *			package table to add the line to
+ *		a_line - (char *) - [RO, *RO]
+ *			first byte of the line - the path of the entry
+ *		a_end - (char *) - [RO, *RO]
+ *			one past the last byte of the contents file data
+ *		a_off - (uint64_t) - [RO]
+ *			byte offset of the line in the contents file
+ * Returns:	int
+ *			== 0 - the line was added
+ *			!= 0 - the line cannot be parsed or no memory
+ */
+
+static int
+addline(struct pkxtab *a_tab, char *a_line, char *a_end, uint64_t a_off)
+{
+	char	*p;
+	char	*pe;
+	int	n;
+
+	/* path[=local] ftype class [attributes] pkg[\][:class] ... */
+
+	p = nexttok(a_line, a_end);
+	if (ISEOL(p, a_end) || ((n = nattrs(*p)) < 0) ||
+			!(ISEOL(p+1, a_end) || ISBLANK(p[1]))) {
+		errno = EINVAL;
+		return (-1);
+	}
+
+	/* skip the class and the attributes of this type of entry */
+
+	for (n++; n > 0; n--) {
+		p = nexttok(p, a_end);
+		if (ISEOL(p, a_end)) {
+			errno = EINVAL;
+			return (-1);
+		}
+	}
+
+	for (p = nexttok(p, a_end); !ISEOL(p, a_end); p = nexttok(p, a_end)) {
+		if (ISPKGSTATUS(*p)) {
+			p++;
+		}
+
+		for (pe = p; !ISEOL(pe, a_end) && !ISBLANK(*pe) &&
+				(*pe != ':') && (*pe != '\\'); pe++)
+			;
+
+		if ((pe == p) || (pe - p > PKGSIZ)) {
+			errno = EINVAL;
+			return (-1);
+		}
+
+		if (addoff(a_tab, p, pe - p, a_off) != 0) {
+			return (-1);
+		}
+
+		p = pe;
+	}
+
+	return (0);
+}
+
+/*
+ * Name:	addoff
+ * Description:	add a line offset to a package in the package table
+ * Arguments:	a_tab - (struct pkxtab *) - [RO, *RW]
+ *			package table to add the offset to
+ *		a_pkg - (char *) - [RO, *RO]
+ *			name of the package (need not be null terminated)
+ *		a_len - (size_t) - [RO]
+ *			length of a_pkg, at most PKGSIZ
+ *		a_off - (uint64_t) - [RO]
+ *			byte offset of the line naming the package
+ * Returns:	int
+ *			== 0 - the offset was added
+ *			!= 0 - no memory
+ */
+
+static int
+addoff(struct pkxtab *a_tab, char *a_pkg, size_t a_len, uint64_t a_off)
+{
+	PKGSTRSYM_T	sym;
+	struct pkxent	*pe;
+
+	sym = pkgstrIntern(a_pkg, a_len);
+	if (sym == PKGSTRSYM_NONE) {
+		errno = ENOMEM;
+		return (-1);
+	}
+
+	/* grow the table to hold the offsets of the symbol */
+
+	if (sym >= a_tab->pt_size) {
+		struct pkxent	*nt;
+		size_t		nsize;
+
+		nsize = (a_tab->pt_size == 0) ? PKXTAB_INITSIZE :
+			a_tab->pt_size * 2;
+		if (nsize <= sym) {
+			nsize = (size_t)sym + 1;
+		}
+
+		nt = (struct pkxent *)realloc(a_tab->pt_ent,
+			nsize * sizeof (struct pkxent));
+		if (nt == (struct pkxent *)NULL) {
+			errno = ENOMEM;
+			return (-1);
+		}
+		(void) memset(nt + a_tab->pt_size, '\0',
+			(nsize - a_tab->pt_size) * sizeof (struct pkxent));
+
+		a_tab->pt_ent = nt;
+		a_tab->pt_size = nsize;
+	}
+
+	pe = &a_tab->pt_ent[sym];
+
+	/* a package named twice on one line is recorded once */
+
+	if ((pe->pe_noff > 0) && (pe->pe_off[pe->pe_noff-1] == a_off)) {
+		return (0);
+	}
+
+	if (pe->pe_noff >= pe->pe_nalloc) {
+		uint64_t	*no;
+		size_t		nalloc;
+
+		nalloc = (pe->pe_nalloc == 0) ? PKXENT_INITOFF :
+			pe->pe_nalloc * 2;
+		no = (uint64_t *)realloc(pe->pe_off,
+			nalloc * sizeof (uint64_t));
+		if (no == (uint64_t *)NULL) {
+			errno = ENOMEM;
+			return (-1);
+		}
+		pe->pe_off = no;
+		pe->pe_nalloc = nalloc;
+	}
+
+	pe->pe_off[pe->pe_noff++] = a_off;
+
+	return (0);
+}
+
+/*
+ * free a package table and the offsets in it
+ */
+
+static void
+freetab(struct pkxtab *a_tab)
+{
+	size_t	i;
+
+	for (i = 0; i < a_tab->pt_size; i++) {
+		(void) free(a_tab->pt_ent[i].pe_off);
+	}
+
+	(void) free(a_tab->pt_ent);
+	a_tab->pt_ent = (struct pkxent *)NULL;
+	a_tab->pt_size = 0;
+}
+
+/*
+ * return the start of the token following the one a_p points into, or the
+ * end of the line if there is none
+ */
+
+static char *
+nexttok(char *a_p, char *a_end)
+{
+	while (!ISEOL(a_p, a_end) && !ISBLANK(*a_p)) {
+		a_p++;
+	}
+
+	while (!ISEOL(a_p, a_end) && ISBLANK(*a_p)) {
+		a_p++;
+	}
+
+	return (a_p);
+}
+
+/*
+ * return the number of attribute fields that follow the class of an entry
+ * of the given file type, or -1 if the type cannot be in a contents file
+ */
+
+static int
+nattrs(int a_ftype)
+{
+	switch (a_ftype) {
+	case 'c': case 'b':
+		return (5);	/* major minor mode owner group */
+	case 'd': case 'x': case 'p':
+		return (3);	/* mode owner group */
+	case 'f': case 'v': case 'e':
+		return (6);	/* mode owner group size cksum modtime */
+	case 'l': case 's': case '?':
+		return (0);
+	default:
+		return (-1);
+	}
+}
+
+/*
+ * order package index records by name
+ */
+
+static int
+pkgcmp(const void *a_p1, const void *a_p2)
+{
+	return (strcmp(((const struct cfpkxpkg *)a_p1)->cp_pkg,
+		((const struct cfpkxpkg *)a_p2)->cp_pkg));
+}
+
+/*
+ * order package symbols by name
+ */
+
+static int
+symcmp(const void *a_s1, const void *a_s2)
+{
+	return (strcmp(pkgstrSymName(*(const PKGSTRSYM_T *)a_s1),
+		pkgstrSymName(*(const PKGSTRSYM_T *)a_s2)));
+}
+
+/*
+ * order line pointers by position in the contents file
+ */
+
+static int
+linecmp(const void *a_l1, const void *a_l2)
+{
+	char	*l1 = *(char * const *)a_l1;
+	char	*l2 = *(char * const *)a_l2;
+
+	if (l1 != l2) {
+		return (l1 < l2 ? -1 : 1);
+	}
+
+	return (0);
+}
@@ -0,0 +1,78 @@
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at src/OPENSOLARIS.LICENSE
+ * or http://www.opensolaris.org/os/licensing.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+#ifndef	_CFPKGINDEX_H
+#define	_CFPKGINDEX_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <sys/types.h>
+#include <inttypes.h>
+#include <pkgstrct.h>
+
+/*
+ * On-disk layout of the contents file package index ("contents.pkx").
+ *
+ * The index consists of a fixed size header, followed by ph_npkg package
+ * records sorted by package instance name, followed by ph_noff line
+ * offsets. The offsets of one package are the cp_count values starting at
+ * index cp_first; each is the byte offset in the contents file of a line
+ * that names the package, and they are in ascending order.
+ *
+ * A contents file that holds lines the index cannot describe (such as
+ * old style "type class path" entries) is given an index of just a header
+ * with the magic CFPKX_NMAGIC, so that the index is not rebuilt on every
+ * open of that contents file.
+ *
+ * All values are stored in native byte order - the index is a private
+ * cache of the local contents file and is never transported.
+ */
+
+#define	CFPKX_MAGIC	"PKGCFPKX"
+#define	CFPKX_NMAGIC	"PKGCFNOX"
+#define	CFPKX_VERSION	2
+#define	CFPKX_SUFFIX	".pkx"
+
+struct cfpkxhdr {
+	char		ph_magic[8];	/* CFPKX_MAGIC */
+	uint32_t	ph_version;	/* CFPKX_VERSION */
+	uint32_t	ph_mtimens;	/* nanoseconds of ph_mtime */
+	uint64_t	ph_size;	/* size of indexed contents file */
+	int64_t		ph_mtime;	/* mtime of indexed contents file */
+	uint64_t	ph_ino;		/* inode of indexed contents file */
+	uint64_t	ph_dev;		/* device of indexed contents file */
+	uint64_t	ph_npkg;	/* number of package records */
+	uint64_t	ph_noff;	/* number of line offsets */
+};
+
+struct cfpkxpkg {
+	uint64_t	cp_first;	/* index of first line offset */
+	uint64_t	cp_count;	/* number of line offsets */
+	char		cp_pkg[PKGSIZ+1]; /* package instance name */
+};
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _CFPKGINDEX_H */
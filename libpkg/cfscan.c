@@ -0,0 +1,310 @@
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at src/OPENSOLARIS.LICENSE
+ * or http://www.opensolaris.org/os/licensing.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+/*LINTLIBRARY*/
+
+/*
+ * Module:	cfscan.c
+ * Synopsis:	parallel scan of the contents file
+ * Taxonomy:	project private
+ * Description:
+ *
+ *   This module scans all entries of a contents file on several threads.
+ *   The data is split at line boundaries into one chunk for each thread;
+ *   each chunk is parsed with srchcfile_r() using its own parse state, and
+ *   the entries of a chunk are passed to a callback together with a
+ *   result object private to the chunk. Once all threads are done, the
+ *   chunk results are passed to a reduction callback in file order on the
+ *   calling thread.
+ *
+ *   The callbacks invoked for entries must only modify the chunk result
+ *   they are passed; anything else they touch must be read-only while the
+ *   scan runs.
+ *
+ *   If journaled entries are attached to the contents file (see
+ *   cfjnlOpen()) they are merged with the entries of the contents file in
+ *   path order; the data is then scanned as a single chunk on the calling
+ *   thread.
+ *
+ * Public Methods:
+ *
+ *   cfscan - Scan all entries of a contents file in parallel
+ */
+
+/*
+ * Unix Includes
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+/*
+ * pkglib Includes
+ */
+
+#include <pkglib.h>
+#include <pkgstrct.h>
+#include "libadm.h"
+#include "pkglocale.h"
+#include "pkglibmsgs.h"
+#include "cfjournal.h"
+#include "srchcfile.h"
+
+/*
+ * Each thread gets at least CFSCAN_MINCHUNK bytes to parse; smaller contents
+ * files are scanned with fewer threads, down to none at all.
+ */
+
+#define	CFSCAN_MINCHUNK	(256*1024)	/* 256kb */
+
+/*
+ * Private definitions
+ */
+
+struct cfchunk {
+	VFP_T		cc_vfp;		/* view of the chunk data */
+	VFP_T		*cc_scan;	/* VFP parsed: view or whole file */
+	SRCHSTATE_T	cc_state;	/* parse state of the chunk */
+	struct cfent	cc_ent;		/* entry being parsed */
+	CFSCANOPS_T	*cc_ops;	/* callbacks */
+	void		*cc_res;	/* chunk result */
+	int		cc_result;	/* < 0 if chunk could not be parsed */
+	int		cc_thread;	/* != 0 if parsed on own thread */
+	pthread_t	cc_tid;		/* thread parsing chunk */
+};
+
+/*
+ * Private methods
+ */
+
+static void	*scanchunk(void *a_chunk);
+
+/*
+ * Module globals
+ */
+
+static char	errpath[PATH_MAX];	/* path of entry that failed */
+
+/*
+ * Public methods
+ */
+
+/*
+ * Name:	cfscan
+ * Description:	Scan all entries of a contents file from the current position
+ *		of a VFP to its end, on several threads
+ * Arguments:	a_vfp - (VFP_T *) - [RO, *RW]
+ *			VFP open for reading on the contents file; the
+ *			current position is set to the end of the data
+ *		a_nthreads - (int) - [RO]
+ *			Maximum number of threads to use; if <= 0 one thread
+ *			for each online processor is used
+ *		a_ops - (CFSCANOPS_T *) - [RO, *RO]
+ *			Callbacks:
+ *			cso_start(a_arg) - called on the calling thread for
+ *			  each chunk before the scan starts; returns the
+ *			  result object of the chunk
+ *			cso_entry(res, ept) - called for each entry of a chunk
+ *			  on the thread parsing the chunk. ept and the data
+ *			  it points to is only valid during the call
+ *			cso_reduce(res, a_arg) - called on the calling thread
+ *			  for each chunk in file order once the scan is
+ *			  done, also if the scan failed; should release the
+ *			  result object of the chunk
+ *		a_arg - (void *) - [RO, *RW]
+ *			Argument passed to cso_start() and cso_reduce()
+ *		r_ept - (struct cfent *) - [RO, *RW]
+ *			If the scan fails, r_ept->path is set to the path of
+ *			the first entry that could not be parsed; the path is
+ *			statically allocated and will be overwritten by the
+ *			next failing call
+ * Returns:	int
+ *			== 0 - all entries were scanned
+ *			< 0 - an entry could not be parsed; use getErrstr() to
+ *			  retrieve a character-string describing the reason
+ *			  for failure. The entries of the chunks that precede
+ *			  the entry in the file have all been scanned.
+ */
+
+int
+cfscan(VFP_T *a_vfp, int a_nthreads, CFSCANOPS_T *a_ops, void *a_arg,
+	struct cfent *r_ept)
+{
+	struct cfchunk	*chunks;
+	char		*first;
+	char		*last;
+	char		*p;
+	char		*q;
+	int		i;
+	int		n;
+	int		result;
+	size_t		len;
+	size_t		nent;
+
+	first = vfpGetCurrCharPtr(a_vfp);
+	last = vfpGetLastCharPtr(a_vfp);
+	len = (first > last) ? 0 : (size_t)(last - first) + 1;
+
+	/* determine number of chunks to split the data into */
+
+	if (a_nthreads <= 0) {
+		long	ncpu;
+
+		ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+		a_nthreads = (ncpu > 0) ? (int)ncpu : 1;
+	}
+
+	n = len / CFSCAN_MINCHUNK;
+	if (n > a_nthreads) {
+		n = a_nthreads;
+	}
+	if (n < 1) {
+		n = 1;
+	}
+
+	/* journaled entries can only be merged in a scan of the whole file */
+
+	if (cfjnlTable(a_vfp, &nent) != (CFJNLENT_T *)NULL) {
+		n = 1;
+	}
+
+	chunks = (struct cfchunk *)calloc(n, sizeof (struct cfchunk));
+	if (chunks == (struct cfchunk *)NULL) {
+		setErrstr(pkg_gt(ERR_MEM));
+		return (-1);
+	}
+
+	srchcfile_init();
+
+	/*
+	 * split the data at line boundaries: each chunk but the last ends
+	 * with the new-line found at or after its share of the data
+	 */
+
+	p = first;
+	for (i = 0; i < n; i++) {
+		struct cfchunk	*cc = &chunks[i];
+
+		if (i == n - 1) {
+			q = last;
+		} else {
+			q = first + (len / n) * (i + 1);
+			if (q < p) {
+				q = p;
+			}
+			q = memchr(q, '\n', (last - q) + 1);
+			if (q == (char *)NULL) {
+				q = last;
+			}
+		}
+
+		cc->cc_vfp = *a_vfp;
+		cc->cc_vfp._vfpStart = p;
+		cc->cc_vfp._vfpCurr = p;
+		cc->cc_vfp._vfpHighWater = q;
+		cc->cc_scan = (n == 1) ? a_vfp : &cc->cc_vfp;
+		cc->cc_state.ss_arena = 1;
+		cc->cc_ops = a_ops;
+		cc->cc_res = a_ops->cso_start(a_arg);
+
+		/* data ends here: remaining chunks are empty */
+
+		if (q == last) {
+			n = i + 1;
+			break;
+		}
+
+		p = q + 1;
+	}
+
+	/* parse the chunks; the first chunk is parsed on this thread */
+
+	for (i = 1; i < n; i++) {
+		if (pthread_create(&chunks[i].cc_tid, NULL, scanchunk,
+				&chunks[i]) == 0) {
+			chunks[i].cc_thread = 1;
+		}
+	}
+
+	for (i = 0; i < n; i++) {
+		if (chunks[i].cc_thread == 0) {
+			(void) scanchunk(&chunks[i]);
+		} else {
+			(void) pthread_join(chunks[i].cc_tid, NULL);
+		}
+	}
+
+	/* reduce the chunk results in file order */
+
+	result = 0;
+
+	for (i = 0; i < n; i++) {
+		struct cfchunk	*cc = &chunks[i];
+
+		if ((result == 0) && (cc->cc_result < 0)) {
+			result = -1;
+			(void) strlcpy(errpath, cc->cc_state.ss_path,
+				sizeof (errpath));
+			r_ept->path = errpath;
+			setErrstr(cc->cc_state.ss_errstr);
+		}
+
+		a_ops->cso_reduce(cc->cc_res, a_arg);
+
+		srchcfile_free(&cc->cc_state);
+	}
+
+	free(chunks);
+
+	vfpSeekToEnd(a_vfp);
+
+	return (result);
+}
+
+/*
+ * Name:	scanchunk
+ * Description:	parse all entries of a chunk of the contents file
+ * Arguments:	a_chunk - (struct cfchunk *) - [RO, *RW]
+ *			Chunk to parse
+ * Returns:	void * - NULL
+ */
+
+static void *
+scanchunk(void *a_chunk)
+{
+	struct cfchunk	*cc = (struct cfchunk *)a_chunk;
+	int		n;
+
+	while ((n = srchcfile_r(&cc->cc_state, &cc->cc_ent, "*",
+			cc->cc_scan, (VFP_T *)NULL)) > 0) {
+		cc->cc_ops->cso_entry(cc->cc_res, &cc->cc_ent);
+	}
+
+	cc->cc_result = n;
+
+	return (NULL);
+}
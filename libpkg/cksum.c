@@ -0,0 +1,285 @@
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at src/OPENSOLARIS.LICENSE
+ * or http://www.opensolaris.org/os/licensing.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+/*LINTLIBRARY*/
+
+/*
+ * Module:	cksum.c
+ * Synopsis:	byte sums for package object checksums
+ * Taxonomy:	project private
+ * Description:
+ *
+ *   This module adds up the bytes of a buffer as the first step of the
+ *   System V sum(1) algorithm used for the checksums in pkgmap and contents
+ *   files. The sum is computed modulo 2^32, so it can be carried across
+ *   several buffers; the caller folds the final sum into 16 bits.
+ *
+ *   The bytes are summed with the fastest kernel the processor supports:
+ *   on x86 processors with AVX2 or SSE2 the PSADBW instruction adds up 32
+ *   or 16 bytes at a time, elsewhere eight bytes are loaded at a time and
+ *   added up in four 16-bit lanes of a 64-bit word. The kernel is selected
+ *   once, on the first call.
+ *
+ * Public Methods:
+ *
+ *   cksumBytes - Add up the bytes of a buffer
+ */
+
+/*
+ * Unix Includes
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define	CKSUM_X86
+#include <immintrin.h>
+#endif
+
+/*
+ * pkglib Includes
+ */
+
+#include <pkglib.h>
+
+/*
+ * The scalar kernel adds the bytes of each 64-bit word into four 16-bit
+ * lanes; each lane grows by at most 2 * 255 per word, so the lanes are
+ * added up and cleared every CKSUM_LANEWORDS words before they overflow.
+ */
+
+#define	CKSUM_LANEWORDS	128
+#define	CKSUM_LANEMASK	0x00FF00FF00FF00FFULL
+#define	CKSUM_PAIRMASK	0x0000FFFF0000FFFFULL
+
+/*
+ * Private methods
+ */
+
+static uint64_t	sum_bytes(unsigned char *a_buf, size_t a_len);
+static uint64_t	sum_words(unsigned char *a_buf, size_t a_len);
+#ifdef	CKSUM_X86
+static uint64_t	sum_avx2(unsigned char *a_buf, size_t a_len);
+#ifdef	__SSE2__
+static uint64_t	sum_sse2(unsigned char *a_buf, size_t a_len);
+#endif
+#endif
+static void	select_kernel(void);
+
+/*
+ * Module globals
+ */
+
+static uint64_t	(*sum_kernel)(unsigned char *, size_t) = sum_words;
+static pthread_once_t	sum_once = PTHREAD_ONCE_INIT;
+
+/*
+ * Public methods
+ */
+
+/*
+ * Name:	cksumBytes
+ * Description:	Add up the bytes of a buffer to a running byte sum
+ * Arguments:	a_sum - (uint32_t) - [RO]
+ *			Byte sum of the data preceding the buffer; 0 for the
+ *			first buffer
+ *		a_buf - (void *) - [RO, *RO]
+ *			Buffer to add up
+ *		a_len - (size_t) - [RO]
+ *			Number of bytes in the buffer
+ * Returns:	uint32_t
+ *			a_sum plus the sum of all bytes in the buffer, each
+ *			byte taken as an unsigned value, modulo 2^32
+ */
+
+uint32_t
+cksumBytes(uint32_t a_sum, void *a_buf, size_t a_len)
+{
+	(void) pthread_once(&sum_once, select_kernel);
+
+	return ((uint32_t)(a_sum + (*sum_kernel)((unsigned char *)a_buf,
+		a_len)));
+}
+
+/*
+ * Private methods
+ */
+
+/*
+ * Name:	select_kernel
+ * Description:	select the fastest byte sum kernel the processor supports
+ * Arguments:	void
+ * Returns:	void
+ */
+
+static void
+select_kernel(void)
+{
+#ifdef	CKSUM_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		sum_kernel = sum_avx2;
+		return;
+	}
+#ifdef	__SSE2__
+	sum_kernel = sum_sse2;
+#endif
+#endif
+}
+
+/*
+ * Name:	sum_bytes
+ * Description:	add up the bytes of a buffer one at a time
+ * Arguments:	a_buf - (unsigned char *) - [RO, *RO]
+ *			Buffer to add up
+ *		a_len - (size_t) - [RO]
+ *			Number of bytes in the buffer
+ * Returns:	uint64_t - sum of all bytes in the buffer
+ */
+
+static uint64_t
+sum_bytes(unsigned char *a_buf, size_t a_len)
+{
+	uint64_t	sum = 0;
+
+	while (a_len-- > 0) {
+		sum += *a_buf++;
+	}
+
+	return (sum);
+}
+
+/*
+ * Name:	sum_words
+ * Description:	add up the bytes of a buffer eight at a time
+ * Arguments:	a_buf - (unsigned char *) - [RO, *RO]
+ *			Buffer to add up
+ *		a_len - (size_t) - [RO]
+ *			Number of bytes in the buffer
+ * Returns:	uint64_t - sum of all bytes in the buffer
+ */
+
+static uint64_t
+sum_words(unsigned char *a_buf, size_t a_len)
+{
+	uint64_t	sum = 0;
+	uint64_t	lanes;
+	uint64_t	w;
+	int		n;
+
+	while (a_len >= sizeof (w)) {
+		lanes = 0;
+		for (n = 0; (n < CKSUM_LANEWORDS) && (a_len >= sizeof (w));
+				n++) {
+			(void) memcpy(&w, a_buf, sizeof (w));
+			lanes += (w & CKSUM_LANEMASK) +
+				((w >> 8) & CKSUM_LANEMASK);
+			a_buf += sizeof (w);
+			a_len -= sizeof (w);
+		}
+		/* add up the four lanes, first in pairs of two */
+		lanes = (lanes & CKSUM_PAIRMASK) +
+			((lanes >> 16) & CKSUM_PAIRMASK);
+		sum += (lanes & 0xFFFFFFFFULL) + (lanes >> 32);
+	}
+
+	return (sum + sum_bytes(a_buf, a_len));
+}
+
+#ifdef	CKSUM_X86
+
+#ifdef	__SSE2__
+/*
+ * Name:	sum_sse2
+ * Description:	add up the bytes of a buffer sixteen at a time with SSE2
+ * Arguments:	a_buf - (unsigned char *) - [RO, *RO]
+ *			Buffer to add up
+ *		a_len - (size_t) - [RO]
+ *			Number of bytes in the buffer
+ * Returns:	uint64_t - sum of all bytes in the buffer
+ */
+
+static uint64_t
+sum_sse2(unsigned char *a_buf, size_t a_len)
+{
+	__m128i		zero = _mm_setzero_si128();
+	__m128i		acc = _mm_setzero_si128();
+	uint64_t	part[2];
+
+	/* PSADBW adds up each half of the bytes into a 64-bit lane */
+
+	while (a_len >= sizeof (__m128i)) {
+		__m128i	v = _mm_loadu_si128((__m128i *)a_buf);
+
+		acc = _mm_add_epi64(acc, _mm_sad_epu8(v, zero));
+		a_buf += sizeof (__m128i);
+		a_len -= sizeof (__m128i);
+	}
+
+	_mm_storeu_si128((__m128i *)part, acc);
+
+	return (part[0] + part[1] + sum_bytes(a_buf, a_len));
+}
+#endif	/* __SSE2__ */
+
+/*
+ * Name:	sum_avx2
+ * Description:	add up the bytes of a buffer 32 at a time with AVX2
+ * Arguments:	a_buf - (unsigned char *) - [RO, *RO]
+ *			Buffer to add up
+ *		a_len - (size_t) - [RO]
+ *			Number of bytes in the buffer
+ * Returns:	uint64_t - sum of all bytes in the buffer
+ */
+
+__attribute__((target("avx2")))
+static uint64_t
+sum_avx2(unsigned char *a_buf, size_t a_len)
+{
+	__m256i		zero = _mm256_setzero_si256();
+	__m256i		acc0 = _mm256_setzero_si256();
+	__m256i		acc1 = _mm256_setzero_si256();
+	uint64_t	part[4];
+
+	/* two accumulators keep two PSADBW in flight */
+
+	while (a_len >= 2 * sizeof (__m256i)) {
+		__m256i	v0 = _mm256_loadu_si256((__m256i *)a_buf);
+		__m256i	v1 = _mm256_loadu_si256((__m256i *)a_buf + 1);
+
+		acc0 = _mm256_add_epi64(acc0, _mm256_sad_epu8(v0, zero));
+		acc1 = _mm256_add_epi64(acc1, _mm256_sad_epu8(v1, zero));
+		a_buf += 2 * sizeof (__m256i);
+		a_len -= 2 * sizeof (__m256i);
+	}
+
+	_mm256_storeu_si256((__m256i *)part, _mm256_add_epi64(acc0, acc1));
+
+	return (part[0] + part[1] + part[2] + part[3] +
+		sum_words(a_buf, a_len));
+}
+
+#endif	/* CKSUM_X86 */
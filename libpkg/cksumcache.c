@@ -0,0 +1,486 @@
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at src/OPENSOLARIS.LICENSE
+ * or http://www.opensolaris.org/os/licensing.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+/*LINTLIBRARY*/
+
+/*
+ * Module:	cksumcache.c
+ * Synopsis:	Cache the checksums of package objects across runs
+ * Description:
+ *
+ * Verifying the contents of package objects means reading every byte of
+ * every file, although most files have not changed since they were last
+ * verified. This module keeps an optional cache file that records, for each
+ * file checksummed, the checksum together with the device, inode number,
+ * size, modification time and change time of the file. cverify() looks up
+ * a file here before computing its checksum, and adds the checksum it
+ * computes; a cached checksum is only used if the file still has the same
+ * identity, which any write to the file or change of its inode alters.
+ *
+ * The cache file is mapped read-only when opened and replaced by a new
+ * file, merging the checksums added, when closed; readers that have the
+ * old file mapped are not disturbed. Lookups may run on several threads at
+ * once; additions are serialized.
+ *
+ * Records of files that are removed are never looked up again. So that
+ * they do not accumulate, the cache holds at most CKSUMCACHE_MAXREC
+ * records: when it is written back, the records looked up or added in
+ * the current run are always kept, and the other records of the old file
+ * only as far as they fit.
+ *
+ * Public Methods:
+ *
+ *   cksumCacheAdd - add the checksum of a file to the cache
+ *   cksumCacheClose - write back and close the cache
+ *   cksumCacheFind - look up the checksum of a file in the cache
+ *   cksumCacheOpen - open the cache
+ */
+
+#include <stdio.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <pkglib.h>
+#include "cksumcache.h"
+
+#define	CKSUMCACHE_INITNEW	1024	/* initial number of new records */
+#define	CKSUMCACHE_WRBATCH	1024	/* records written at a time */
+#define	CKSUMCACHE_MAXREC	(512 * 1024) /* records kept when written */
+
+/*
+ * A file whose modification or change time is this close to the time the
+ * cache was opened, or later, may be written to while it is checksummed
+ * without its times changing; its checksum is not cached.
+ */
+
+#define	CKSUMCACHE_RACY		2	/* seconds */
+
+/*
+ * the cache currently open
+ */
+
+static struct {
+	int		cc_open;	/* != 0 if the cache is open */
+	char		cc_path[PATH_MAX]; /* path of cache file */
+	time_t		cc_start;	/* time the cache was opened */
+	void		*cc_map;	/* mapping of cache file */
+	size_t		cc_mapsize;	/* size of the mapping */
+	struct cksumrec	*cc_rec;	/* -> first record of the mapping */
+	uint64_t	cc_nrec;	/* number of records in the mapping */
+	char		*cc_used;	/* != 0 for each record looked up */
+	struct cksumrec	*cc_new;	/* records added */
+	size_t		cc_nnew;	/* number of records added */
+	size_t		cc_nalloc;	/* size of cc_new */
+} cksumcache = { 0, "", 0, MAP_FAILED, 0, NULL, 0, NULL, NULL, 0, 0 };
+
+static pthread_mutex_t	cksumlock = PTHREAD_MUTEX_INITIALIZER;
+
+static void	mkrec(struct cksumrec *r_rec, struct stat *a_st,
+			unsigned long a_cksum);
+static int	reccmp(const void *a_r1, const void *a_r2);
+static void	release(void);
+static int	writecache(void);
+
+/*
+ * Name:	cksumCacheOpen
+ * Description:	open the checksum cache kept in a directory; a missing or
+ *		damaged cache file is treated as empty, and created when
+ *		the cache is closed
+ * Arguments:	a_dir - (char *) - [RO, *RO]
+ *			directory of the cache file (the package
+ *			administration directory)
+ * Returns:	int
+ *			== 0 - the cache is open
+ *			!= 0 - the path is too long; the cache is not open
+ */
+
+int
+cksumCacheOpen(char *a_dir)
+{
+	int		fd;
+	struct cksumhdr	*hdr;
+	struct stat	st;
+	void		*map;
+
+	release();
+
+	if (snprintf(cksumcache.cc_path, sizeof (cksumcache.cc_path),
+			"%s/%s", a_dir, CKSUMCACHE_FILE) >=
+			sizeof (cksumcache.cc_path)) {
+		cksumcache.cc_path[0] = '\0';
+		errno = ENAMETOOLONG;
+		return (-1);
+	}
+
+	cksumcache.cc_open = 1;
+	cksumcache.cc_start = time((time_t *)NULL);
+
+	if ((fd = open(cksumcache.cc_path, O_RDONLY)) < 0) {
+		return (0);
+	}
+
+	if ((fstat(fd, &st) != 0) ||
+			(st.st_size < sizeof (struct cksumhdr))) {
+		(void) close(fd);
+		return (0);
+	}
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, (off_t)0);
+	(void) close(fd);
+	if (map == MAP_FAILED) {
+		return (0);
+	}
+
+	hdr = (struct cksumhdr *)map;
+	if ((memcmp(hdr->ch_magic, CKSUMCACHE_MAGIC,
+			sizeof (hdr->ch_magic)) != 0) ||
+		(hdr->ch_version != CKSUMCACHE_VERSION) ||
+		(st.st_size != sizeof (struct cksumhdr) +
+			hdr->ch_nrec * sizeof (struct cksumrec))) {
+		(void) munmap(map, st.st_size);
+		return (0);
+	}
+
+	/* without a record of the lookups, no record is dropped */
+
+	cksumcache.cc_used = (char *)calloc(hdr->ch_nrec + 1, sizeof (char));
+
+	cksumcache.cc_map = map;
+	cksumcache.cc_mapsize = st.st_size;
+	cksumcache.cc_rec = (struct cksumrec *)(hdr+1);
+	cksumcache.cc_nrec = hdr->ch_nrec;
+
+	return (0);
+}
+
+/*
+ * Name:	cksumCacheFind
+ * Description:	look up the checksum of a file in the open cache
+ * Arguments:	a_st - (struct stat *) - [RO, *RO]
+ *			status of the file, taken before it is read
+ *		r_cksum - (unsigned long *) - [RO, *RW]
+ *			set to the cached checksum of the file
+ * Returns:	int
+ *			== 0 - the checksum was found
+ *			!= 0 - no cache is open, or the file is not in the
+ *			  cache or has changed since its checksum was added
+ */
+
+int
+cksumCacheFind(struct stat *a_st, unsigned long *r_cksum)
+{
+	struct cksumrec	key;
+	struct cksumrec	*rec;
+
+	if ((cksumcache.cc_open == 0) || (cksumcache.cc_nrec == 0)) {
+		return (-1);
+	}
+
+	mkrec(&key, a_st, 0);
+
+	rec = (struct cksumrec *)bsearch(&key, cksumcache.cc_rec,
+		cksumcache.cc_nrec, sizeof (struct cksumrec), reccmp);
+
+	if ((rec == (struct cksumrec *)NULL) ||
+		(rec->cr_size != key.cr_size) ||
+		(rec->cr_mtime != key.cr_mtime) ||
+		(rec->cr_mtimens != key.cr_mtimens) ||
+		(rec->cr_ctime != key.cr_ctime) ||
+		(rec->cr_ctimens != key.cr_ctimens)) {
+		return (-1);
+	}
+
+	if (cksumcache.cc_used != (char *)NULL) {
+		cksumcache.cc_used[rec - cksumcache.cc_rec] = 1;
+	}
+
+	*r_cksum = (unsigned long)rec->cr_cksum;
+	return (0);
+}
+
+/*
+ * Name:	cksumCacheAdd
+ * Description:	add the checksum of a file to the open cache; nothing is
+ *		added if no cache is open, or if the file was changed so
+ *		recently that it may have changed while it was read
+ * Arguments:	a_st - (struct stat *) - [RO, *RO]
+ *			status of the file, taken before it was read
+ *		a_cksum - (unsigned long) - [RO]
+ *			checksum of the file
+ * Returns:	void
+ */
+
+void
+cksumCacheAdd(struct stat *a_st, unsigned long a_cksum)
+{
+	struct cksumrec	*new;
+	size_t		nalloc;
+
+	if ((cksumcache.cc_open == 0) ||
+		(a_st->st_mtime >= cksumcache.cc_start - CKSUMCACHE_RACY) ||
+		(a_st->st_ctime >= cksumcache.cc_start - CKSUMCACHE_RACY)) {
+		return;
+	}
+
+	(void) pthread_mutex_lock(&cksumlock);
+
+	if (cksumcache.cc_nnew >= cksumcache.cc_nalloc) {
+		nalloc = (cksumcache.cc_nalloc == 0) ? CKSUMCACHE_INITNEW :
+			cksumcache.cc_nalloc * 2;
+		new = (struct cksumrec *)realloc(cksumcache.cc_new,
+			nalloc * sizeof (struct cksumrec));
+		if (new == (struct cksumrec *)NULL) {
+			(void) pthread_mutex_unlock(&cksumlock);
+			return;
+		}
+		cksumcache.cc_new = new;
+		cksumcache.cc_nalloc = nalloc;
+	}
+
+	mkrec(&cksumcache.cc_new[cksumcache.cc_nnew++], a_st, a_cksum);
+
+	(void) pthread_mutex_unlock(&cksumlock);
+}
+
+/*
+ * Name:	cksumCacheClose
+ * Description:	close the open cache; if checksums were added, the cache
+ *		file is replaced by one that holds the records of the old
+ *		file and the records added, the latter taking precedence
+ * Returns:	int
+ *			== 0 - the cache was closed
+ *			!= 0 - the cache file could not be written; errno
+ *			  is set. The cache is closed nonetheless.
+ */
+
+int
+cksumCacheClose(void)
+{
+	int	n = 0;
+
+	if ((cksumcache.cc_open != 0) && (cksumcache.cc_nnew > 0)) {
+		n = writecache();
+	}
+
+	release();
+
+	return (n);
+}
+
+/*
+ * Name:	writecache
+ * Description:	write the records of the open cache file merged with the
+ *		records added to a new cache file, and move it into place;
+ *		old records not looked up are dropped beyond
+ *		CKSUMCACHE_MAXREC records
+ * Returns:	int
+ *			== 0 - the cache file was written
+ *			!= 0 - the cache file could not be written
+ */
+
+static int
+writecache(void)
+{
+	char		tpath[PATH_MAX];
+	int		c;
+	int		fd;
+	int		lerrno;
+	size_t		i;
+	size_t		j;
+	size_t		n;
+	size_t		nb;
+	size_t		nspare;
+	ssize_t		len;
+	struct cksumhdr	hdr;
+	struct cksumrec	buf[CKSUMCACHE_WRBATCH];
+	struct cksumrec	*old = cksumcache.cc_rec;
+	struct cksumrec	*new = cksumcache.cc_new;
+
+	if (snprintf(tpath, sizeof (tpath), "%s.XXXXXX", cksumcache.cc_path)
+			>= sizeof (tpath)) {
+		errno = ENAMETOOLONG;
+		return (-1);
+	}
+
+	if ((fd = mkstemp(tpath)) < 0) {
+		return (-1);
+	}
+
+	(void) fchmod(fd, 0644);
+
+	/* order the records added, keeping one record for each file */
+
+	qsort(new, cksumcache.cc_nnew, sizeof (struct cksumrec), reccmp);
+
+	for (i = 1, n = 1; i < cksumcache.cc_nnew; i++) {
+		if (reccmp(&new[i], &new[n-1]) != 0) {
+			new[n++] = new[i];
+		}
+	}
+
+	/*
+	 * count the room left for old records not looked up; an old record
+	 * of a file also added is replaced, and may be counted twice
+	 */
+
+	nspare = n;
+	if (cksumcache.cc_used != (char *)NULL) {
+		for (i = 0; i < cksumcache.cc_nrec; i++) {
+			if (cksumcache.cc_used[i] != 0) {
+				nspare++;
+			}
+		}
+	}
+	nspare = (nspare < CKSUMCACHE_MAXREC) ? CKSUMCACHE_MAXREC - nspare : 0;
+
+	/* the header is written once the number of records is known */
+
+	(void) memset(&hdr, '\0', sizeof (hdr));
+	(void) memcpy(hdr.ch_magic, CKSUMCACHE_MAGIC, sizeof (hdr.ch_magic));
+	hdr.ch_version = CKSUMCACHE_VERSION;
+
+	if (lseek(fd, (off_t)sizeof (hdr), SEEK_SET) < 0) {
+		goto failed;
+	}
+
+	for (i = 0, j = 0, nb = 0; (i < cksumcache.cc_nrec) || (j < n); ) {
+		if ((i < cksumcache.cc_nrec) &&
+			((j >= n) || ((c = reccmp(&old[i], &new[j])) < 0))) {
+			if ((cksumcache.cc_used == (char *)NULL) ||
+				(cksumcache.cc_used[i] != 0)) {
+				buf[nb++] = old[i];
+			} else if (nspare > 0) {
+				nspare--;
+				buf[nb++] = old[i];
+			}
+			i++;
+		} else if (i >= cksumcache.cc_nrec) {
+			buf[nb++] = new[j++];
+		} else {
+			if (c == 0) {
+				i++;
+			}
+			buf[nb++] = new[j++];
+		}
+
+		if ((nb == CKSUMCACHE_WRBATCH) ||
+			((nb > 0) && (i >= cksumcache.cc_nrec) && (j >= n))) {
+			len = nb * sizeof (struct cksumrec);
+			if (vfpSafeWrite(fd, buf, len) != len) {
+				goto failed;
+			}
+			hdr.ch_nrec += nb;
+			nb = 0;
+		}
+	}
+
+	if ((lseek(fd, (off_t)0, SEEK_SET) < 0) ||
+		(vfpSafeWrite(fd, &hdr, sizeof (hdr)) != sizeof (hdr))) {
+		goto failed;
+	}
+
+	if ((close(fd) != 0) || (rename(tpath, cksumcache.cc_path) != 0)) {
+		lerrno = errno;
+		(void) unlink(tpath);
+		errno = lerrno;
+		return (-1);
+	}
+
+	return (0);
+
+failed:
+	lerrno = errno;
+	(void) close(fd);
+	(void) unlink(tpath);
+	errno = lerrno;
+	return (-1);
+}
+
+/*
+ * release all resources of the open cache
+ */
+
+static void
+release(void)
+{
+	if (cksumcache.cc_map != MAP_FAILED) {
+		(void) munmap(cksumcache.cc_map, cksumcache.cc_mapsize);
+	}
+	free(cksumcache.cc_used);
+	free(cksumcache.cc_new);
+
+	cksumcache.cc_open = 0;
+	cksumcache.cc_path[0] = '\0';
+	cksumcache.cc_start = 0;
+	cksumcache.cc_map = MAP_FAILED;
+	cksumcache.cc_mapsize = 0;
+	cksumcache.cc_rec = (struct cksumrec *)NULL;
+	cksumcache.cc_nrec = 0;
+	cksumcache.cc_used = (char *)NULL;
+	cksumcache.cc_new = (struct cksumrec *)NULL;
+	cksumcache.cc_nnew = 0;
+	cksumcache.cc_nalloc = 0;
+}
+
+/*
+ * fill in a cache record from the status of a file
+ */
+
+static void
+mkrec(struct cksumrec *r_rec, struct stat *a_st, unsigned long a_cksum)
+{
+	(void) memset(r_rec, '\0', sizeof (struct cksumrec));
+	r_rec->cr_dev = (uint64_t)a_st->st_dev;
+	r_rec->cr_ino = (uint64_t)a_st->st_ino;
+	r_rec->cr_size = (uint64_t)a_st->st_size;
+	r_rec->cr_mtime = (int64_t)a_st->st_mtim.tv_sec;
+	r_rec->cr_mtimens = (uint32_t)a_st->st_mtim.tv_nsec;
+	r_rec->cr_ctime = (int64_t)a_st->st_ctim.tv_sec;
+	r_rec->cr_ctimens = (uint32_t)a_st->st_ctim.tv_nsec;
+	r_rec->cr_cksum = (uint64_t)a_cksum;
+}
+
+/*
+ * order cache records by device and inode number
+ */
+
+static int
+reccmp(const void *a_r1, const void *a_r2)
+{
+	const struct cksumrec	*r1 = (const struct cksumrec *)a_r1;
+	const struct cksumrec	*r2 = (const struct cksumrec *)a_r2;
+
+	if (r1->cr_dev != r2->cr_dev) {
+		return ((r1->cr_dev < r2->cr_dev) ? -1 : 1);
+	}
+	if (r1->cr_ino != r2->cr_ino) {
+		return ((r1->cr_ino < r2->cr_ino) ? -1 : 1);
+	}
+	return (0);
+}
@@ -0,0 +1,71 @@
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at src/OPENSOLARIS.LICENSE
+ * or http://www.opensolaris.org/os/licensing.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+#ifndef	_CKSUMCACHE_H
+#define	_CKSUMCACHE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <sys/types.h>
+#include <inttypes.h>
+
+/*
+ * On-disk layout of the checksum cache ("cksumcache").
+ *
+ * The cache consists of a fixed size header followed by ch_nrec records
+ * sorted by device and inode number. A record holds the checksum last
+ * computed for a file together with the identity of the file at that time;
+ * the checksum is only used while the device, inode number, size and the
+ * modification and change times of the file are all still the same.
+ *
+ * All values are stored in native byte order - the cache describes local
+ * files only and is never transported.
+ */
+
+#define	CKSUMCACHE_MAGIC	"PKGCKSUM"
+#define	CKSUMCACHE_VERSION	1
+#define	CKSUMCACHE_FILE		"cksumcache"
+
+struct cksumhdr {
+	char		ch_magic[8];	/* CKSUMCACHE_MAGIC */
+	uint32_t	ch_version;	/* CKSUMCACHE_VERSION */
+	uint32_t	ch_pad;		/* unused, zero */
+	uint64_t	ch_nrec;	/* number of records */
+};
+
+struct cksumrec {
+	uint64_t	cr_dev;		/* device of file */
+	uint64_t	cr_ino;		/* inode number of file */
+	uint64_t	cr_size;	/* size of file */
+	int64_t		cr_mtime;	/* modification time, seconds */
+	int64_t		cr_ctime;	/* change time, seconds */
+	uint32_t	cr_mtimens;	/* modification time, nanoseconds */
+	uint32_t	cr_ctimens;	/* change time, nanoseconds */
+	uint64_t	cr_cksum;	/* checksum of file */
+};
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _CKSUMCACHE_H */
@@ -0,0 +1,228 @@
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at src/OPENSOLARIS.LICENSE
+ * or http://www.opensolaris.org/os/licensing.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+/*
+ * Module:	cksumtest.c
+ * Synopsis:	check the byte sum kernels of cksum.c
+ * Taxonomy:	project private
+ * Description:
+ *
+ *   Standalone check, run with "make check", that every byte sum kernel
+ *   of cksum.c and cksumBytes() agree with a byte at a time reference of
+ *   the System V sum(1) algorithm. Buffers of random length are summed at
+ *   every misalignment, with random bytes and with all bytes 0xFF (which
+ *   carry every lane of the kernels as far as they go), both whole and in
+ *   random pieces carried across calls. The random numbers come from a
+ *   fixed seed, so a failure can be reproduced.
+ *
+ *   cksum.c is included so the static kernels can be called directly;
+ *   kernels the processor does not support are skipped.
+ */
+
+#include "cksum.c"
+
+#define	CT_MAXLEN	(3 * 65536)	/* longest buffer summed */
+#define	CT_ALIGN	64		/* misalignments checked */
+#define	CT_ROUNDS	256		/* random lengths per kernel */
+
+/*
+ * A kernel to check
+ */
+
+struct ctkernel {
+	char		*ck_name;
+	uint64_t	(*ck_func)(unsigned char *, size_t);
+};
+
+static uint64_t	ct_seed = 0x2545F4914F6CDD1DULL;
+
+/*
+ * Name:	ct_random
+ * Description:	return the next number of a fixed xorshift sequence
+ */
+
+static uint32_t
+ct_random(void)
+{
+	ct_seed ^= ct_seed << 13;
+	ct_seed ^= ct_seed >> 7;
+	ct_seed ^= ct_seed << 17;
+
+	return ((uint32_t)(ct_seed >> 16));
+}
+
+/*
+ * Name:	ct_sum
+ * Description:	reference: fold the bytes of a buffer as sum(1) does
+ */
+
+static unsigned
+ct_sum(unsigned char *a_buf, size_t a_len)
+{
+	uint32_t	s = 0;
+	uint32_t	r;
+
+	while (a_len-- > 0) {
+		s += *a_buf++;
+	}
+
+	r = (s & 0xFFFF) + (s >> 16);
+	r = (r & 0xFFFF) + (r >> 16);
+
+	return ((unsigned)r);
+}
+
+/*
+ * Name:	ct_fold
+ * Description:	fold a byte sum as compute_checksum() does
+ */
+
+static unsigned
+ct_fold(uint32_t a_sum)
+{
+	uint32_t	r;
+
+	r = (a_sum & 0xFFFF) + (a_sum >> 16);
+	r = (r & 0xFFFF) + (r >> 16);
+
+	return ((unsigned)r);
+}
+
+/*
+ * Name:	ct_check
+ * Description:	check one kernel, or cksumBytes() if a_kernel is NULL,
+ *		against the reference on a buffer filled by the caller
+ * Returns:	int - number of mismatches reported
+ */
+
+static int
+ct_check(struct ctkernel *a_kernel, unsigned char *a_data, char *a_fill)
+{
+	unsigned char	*p;
+	size_t		len;
+	size_t		off;
+	size_t		n;
+	uint32_t	sum;
+	int		align;
+	int		round;
+	int		errs = 0;
+
+	for (round = 0; round < CT_ROUNDS; round++) {
+		/* mostly short lengths, to cover every tail */
+		len = ((round % 8) == 0) ? (ct_random() % CT_MAXLEN) :
+			(ct_random() % 300);
+
+		for (align = 0; align < CT_ALIGN; align++) {
+			p = a_data + align;
+
+			if (a_kernel != (struct ctkernel *)NULL) {
+				sum = (uint32_t)(*a_kernel->ck_func)(p, len);
+			} else {
+				/* carry the sum across random pieces */
+				sum = 0;
+				for (off = 0; off < len; off += n) {
+					n = ct_random() % (len - off + 1);
+					if (n == 0) {
+						n = 1;
+					}
+					sum = cksumBytes(sum, p + off, n);
+				}
+			}
+
+			if (ct_fold(sum) != ct_sum(p, len)) {
+				(void) fprintf(stderr,
+					"cksumtest: %s: %s data, length %lu, "
+					"offset %d: %u, expected %u\n",
+					(a_kernel != (struct ctkernel *)NULL) ?
+					a_kernel->ck_name : "cksumBytes",
+					a_fill, (unsigned long)len, align,
+					ct_fold(sum), ct_sum(p, len));
+				errs++;
+			}
+		}
+	}
+
+	return (errs);
+}
+
+int
+main(void)
+{
+	static struct ctkernel	kernels[] = {
+		{ "sum_bytes",	sum_bytes },
+		{ "sum_words",	sum_words },
+#ifdef	CKSUM_X86
+#ifdef	__SSE2__
+		{ "sum_sse2",	sum_sse2 },
+#endif
+		{ "sum_avx2",	sum_avx2 },
+#endif
+		{ (char *)NULL,	NULL }
+	};
+	unsigned char	*data;
+	size_t		i;
+	int		fill;
+	int		k;
+	int		errs = 0;
+
+	data = (unsigned char *)malloc(CT_MAXLEN + CT_ALIGN);
+	if (data == (unsigned char *)NULL) {
+		(void) fprintf(stderr, "cksumtest: out of memory\n");
+		return (2);
+	}
+
+#ifdef	CKSUM_X86
+	__builtin_cpu_init();
+#endif
+
+	for (fill = 0; fill < 2; fill++) {
+		for (i = 0; i < CT_MAXLEN + CT_ALIGN; i++) {
+			data[i] = (fill == 0) ? (unsigned char)ct_random() :
+				0xFF;
+		}
+
+		for (k = 0; kernels[k].ck_name != (char *)NULL; k++) {
+#ifdef	CKSUM_X86
+			if ((kernels[k].ck_func == sum_avx2) &&
+				!__builtin_cpu_supports("avx2")) {
+				(void) printf("cksumtest: %s: not supported, "
+					"skipped\n", kernels[k].ck_name);
+				continue;
+			}
+#endif
+			errs += ct_check(&kernels[k], data,
+				(fill == 0) ? "random" : "0xFF");
+		}
+
+		errs += ct_check((struct ctkernel *)NULL, data,
+			(fill == 0) ? "random" : "0xFF");
+	}
+
+	free(data);
+
+	if (errs != 0) {
+		(void) printf("cksumtest: %d mismatches\n", errs);
+		return (1);
+	}
+
+	(void) printf("cksumtest: all kernels match sum(1)\n");
+	return (0);
+}
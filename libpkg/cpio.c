@@ -0,0 +1,1587 @@
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at src/OPENSOLARIS.LICENSE
+ * or http://www.opensolaris.org/os/licensing.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+/*LINTLIBRARY*/
+
+/*
+ * Module:	cpio.c
+ * Synopsis:	read and write the cpio archives of a package datastream
+ * Taxonomy:	project private
+ * Description:
+ *
+ *   This module reads and writes cpio archives in the process, so the
+ *   datastream code does not have to run cpio(1) for each archive of a
+ *   datastream. The archives are read and written in whole blocks of the
+ *   datastream block size, just as "cpio -C <blksize>" does: an archive is
+ *   padded to a multiple of the block size, and reading an archive leaves
+ *   the file descriptor at the block following it, where the next archive
+ *   of the datastream begins.
+ *
+ *   Archives with ASCII headers (-c or -H odc, 070707), SVR4 ASCII headers
+ *   (070701) and SVR4 headers with checksums (070702) can be read; archives
+ *   are written with SVR4 ASCII headers, as "cpio -oc" does.
+ *
+ *   An archive can also be read one member at a time, so the caller can
+ *   decide for each member whether it is extracted, skipped or its data is
+ *   copied somewhere else.
+ *
+ *   Archives can be written gzip or zstd compressed; compressed archives
+ *   are told by their first bytes and decompressed as they are read (see
+ *   cpiozip.c).
+ *
+ * Public Methods:
+ *
+ *   cpioArchive - Write a cpio archive of files to a file descriptor
+ *   cpioClose - Release an archive read member by member
+ *   cpioCopy - Write the data of the current member to a file descriptor
+ *   cpioExtract - Read a cpio archive from a file descriptor
+ *   cpioNext - Read the header of the next member of an archive
+ *   cpioOpen - Start reading an archive member by member
+ *   cpioRestore - Extract the current member of an archive
+ *   cpioSetCompression - Set how compressed archives are compressed
+ *   cpioSkip - Skip the data of the current member of an archive
+ */
+
+/*
+ * Unix Includes
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <dirent.h>
+#include <utime.h>
+#include <inttypes.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef __sun
+#include <sys/mkdev.h>
+#else
+#include <sys/sysmacros.h>
+#endif
+
+/*
+ * pkglib Includes
+ */
+
+#include <pkglib.h>
+#include <archives.h>
+#include "libadm.h"
+#include "pkglocale.h"
+#include "pkglibmsgs.h"
+#include "cpiozip.h"
+
+/*
+ * Archive data is read and written CPIO_IOSIZE bytes at a time, rounded to
+ * whole blocks.
+ */
+
+#define	CPIO_IOSIZE	(64*1024)	/* 64kb */
+
+#define	CPIO_TRAILER	"TRAILER!!!"
+
+/*
+ * Private definitions
+ */
+
+struct cpiohdr {
+	int		ch_crc;		/* != 0 if data has a checksum */
+	int		ch_svr4;	/* != 0 if 070701 or 070702 header */
+	mode_t		ch_mode;
+	uid_t		ch_uid;
+	gid_t		ch_gid;
+	unsigned long	ch_nlink;
+	unsigned long	ch_ino;
+	dev_t		ch_dev;
+	dev_t		ch_rdev;
+	time_t		ch_mtime;
+	off_t		ch_size;
+	uint32_t	ch_chksum;
+	char		ch_name[PATH_MAX];
+};
+
+/* SVR4 hard link whose data is stored with another link */
+
+struct cpiolink {
+	struct cpiolink	*cl_next;
+	struct cpiohdr	cl_hdr;
+	int		cl_done;	/* != 0 if ch_name has the data */
+};
+
+struct cpiord {
+	int		cr_fd;
+	size_t		cr_blksize;
+	char		*cr_buf;
+	size_t		cr_len;		/* bytes in buffer */
+	size_t		cr_pos;		/* next byte of buffer to be read */
+	off_t		cr_base;	/* archive offset of first byte */
+	struct cpiolink	*cr_links;
+	struct cpiohdr	*cr_hdr;	/* header of current member */
+	int		cr_data;	/* != 0 if its data is still unread */
+	int		cr_eof;		/* != 0 if trailer has been read */
+	int		cr_failed;	/* != 0 if no longer readable */
+	int		cr_checked;	/* != 0 if compression is known */
+	CPIOZIP_T	*cr_zip;	/* decompressor, NULL if none */
+};
+
+struct cpiowr {
+	int		cw_fd;
+	size_t		cw_blksize;
+	char		*cw_buf;
+	size_t		cw_bufsize;	/* multiple of cw_blksize */
+	size_t		cw_len;		/* bytes in buffer */
+	off_t		cw_off;		/* archive offset of next byte */
+	int		cw_record;	/* != 0 to write block by block */
+	int		cw_flags;
+	unsigned long	cw_ino;		/* last inode number assigned */
+	CPIOZIP_T	*cw_zip;	/* compressor, NULL if none */
+};
+
+/*
+ * Private methods
+ */
+
+static int	rd_fill(struct cpiord *r, size_t a_len);
+static int	rd_skip(struct cpiord *r, off_t a_len);
+static int	rd_align(struct cpiord *r, size_t a_align);
+static int	rd_header(struct cpiord *r, struct cpiohdr *h);
+static int	rd_entry(struct cpiord *r, struct cpiohdr *h);
+static int	rd_done(struct cpiord *r);
+static int	rd_file(struct cpiord *r, struct cpiohdr *h);
+static int	rd_data(struct cpiord *r, struct cpiohdr *h, int a_fd,
+			char *a_path);
+static int	rd_link(struct cpiord *r, struct cpiohdr *h);
+static int	rd_attrs(struct cpiohdr *h);
+static int	rd_remove(char *a_path, int a_isdir);
+static int	rd_mkparents(char *a_path);
+static int	getnum(char *a_field, size_t a_len, int a_base,
+			unsigned long long *r_num);
+static int	wr_path(struct cpiowr *w, char *a_path);
+static int	wr_entry(struct cpiowr *w, char *a_name, struct stat *a_st,
+			char *a_path);
+static int	wr_put(struct cpiowr *w, char *a_data, size_t a_len);
+static int	wr_pad(struct cpiowr *w, size_t a_align);
+static int	wr_flush(struct cpiowr *w, size_t a_len);
+static void	seterr(char *a_fmt, ...);
+
+/*
+ * Module globals
+ */
+
+static char	errbuf[PATH_MAX+256];	/* reason of last failure */
+static int	ziplevel = 0;		/* compression level, 0 = default */
+static int	zipthreads = 1;		/* threads to compress on */
+
+/*
+ * Public methods
+ */
+
+/*
+ * Name:	cpioOpen
+ * Description:	Start reading a cpio archive from a file descriptor member
+ *		by member; see cpioNext()
+ * Arguments:	a_fd - (int) - [RO]
+ *			File descriptor to read the archive from
+ *		a_blksize - (int) - [RO]
+ *			Block size of the archive
+ * Returns:	CPIO_T *
+ *			!= NULL - the archive to pass to the other cpio*()
+ *			  methods; release it with cpioClose()
+ *			== NULL - out of memory; use getErrstr() to retrieve
+ *			  a character-string describing the reason for failure
+ */
+
+CPIO_T *
+cpioOpen(int a_fd, int a_blksize)
+{
+	struct cpiord	*r;
+
+	if ((r = calloc(1, sizeof (struct cpiord))) == NULL) {
+		seterr(pkg_gt(ERR_MEM));
+		return (NULL);
+	}
+
+	r->cr_fd = a_fd;
+	r->cr_blksize = (a_blksize > 0) ? a_blksize : BLK_SIZE;
+	r->cr_buf = malloc(CPIO_IOSIZE + r->cr_blksize);
+	r->cr_hdr = malloc(sizeof (struct cpiohdr));
+	if ((r->cr_buf == NULL) || (r->cr_hdr == NULL)) {
+		seterr(pkg_gt(ERR_MEM));
+		cpioClose(r);
+		return (NULL);
+	}
+
+	return (r);
+}
+
+/*
+ * Name:	cpioNext
+ * Description:	Read the header of the next member of a cpio archive; the
+ *		data of the previous member is skipped if it has not been
+ *		read with cpioRestore(), cpioCopy() or cpioSkip()
+ * Arguments:	a_cpio - (CPIO_T *) - [RO, *RW]
+ *			Archive being read
+ *		r_name - (char **) - [RO, *RW]
+ *			Set to the name of the member; the name is valid up
+ *			to the next call
+ *		r_st - (struct stat *) - [RO, *RW]
+ *			If not NULL, the mode, owner, size, link count, device
+ *			and modification time of the member are returned here
+ * Returns:	int
+ *			== 1 - the header of the next member was read
+ *			== 0 - the archive ends here; the file descriptor is
+ *			  left at the block that follows the archive, and the
+ *			  hard links still waiting for their data have been
+ *			  extracted as empty files
+ *			< 0 - the archive could not be read; use getErrstr()
+ *			  to retrieve a character-string describing the
+ *			  reason for failure
+ */
+
+int
+cpioNext(CPIO_T *a_cpio, char **r_name, struct stat *r_st)
+{
+	struct cpiord	*r = a_cpio;
+	struct cpiohdr	*h = r->cr_hdr;
+	struct cpiolink	*cl;
+	int		result = 0;
+
+	if (r->cr_failed) {
+		return (-1);
+	}
+
+	if (r->cr_eof) {
+		return (0);
+	}
+
+	if (r->cr_data && (cpioSkip(r) != 0)) {
+		return (-1);
+	}
+
+	if (rd_header(r, h) != 0) {
+		r->cr_failed = 1;
+		return (-1);
+	}
+
+	if (strcmp(h->ch_name, CPIO_TRAILER) != 0) {
+		r->cr_data = 1;
+		*r_name = h->ch_name;
+		if (r_st != NULL) {
+			(void) memset(r_st, 0, sizeof (struct stat));
+			r_st->st_mode = h->ch_mode;
+			r_st->st_uid = h->ch_uid;
+			r_st->st_gid = h->ch_gid;
+			r_st->st_nlink = h->ch_nlink;
+			r_st->st_ino = h->ch_ino;
+			r_st->st_dev = h->ch_dev;
+			r_st->st_rdev = h->ch_rdev;
+			r_st->st_mtime = h->ch_mtime;
+			r_st->st_atime = h->ch_mtime;
+			r_st->st_size = h->ch_size;
+		}
+		return (1);
+	}
+
+	/* the archive ends with the block of its trailer */
+
+	if ((rd_align(r, r->cr_blksize) != 0) ||
+			((r->cr_zip != NULL) && (zipFinish(r->cr_zip) != 0))) {
+		r->cr_failed = 1;
+		return (-1);
+	}
+	r->cr_eof = 1;
+
+	/* SVR4 links whose data never came are empty files */
+
+	while ((cl = r->cr_links) != NULL) {
+		r->cr_links = cl->cl_next;
+		if ((result == 0) && !cl->cl_done) {
+			cl->cl_hdr.ch_size = 0;
+			cl->cl_hdr.ch_nlink = 1;
+			result = rd_file(r, &cl->cl_hdr);
+		}
+		free(cl);
+	}
+
+	return (result);
+}
+
+/*
+ * Name:	cpioRestore
+ * Description:	Extract the member whose header was just read with
+ *		cpioNext(), as "cpio -idum" does
+ * Arguments:	a_cpio - (CPIO_T *) - [RO, *RW]
+ *			Archive being read
+ *		a_dir - (char *) - [RO, *RO]
+ *			Directory to extract the member below; if NULL, the
+ *			member is extracted below the current directory
+ * Returns:	int
+ *			== 0 - the member was extracted
+ *			< 0 - the member could not be extracted; use
+ *			  getErrstr() to retrieve a character-string
+ *			  describing the reason for failure
+ */
+
+int
+cpioRestore(CPIO_T *a_cpio, char *a_dir)
+{
+	struct cpiord	*r = a_cpio;
+	struct cpiohdr	*h = r->cr_hdr;
+	char		name[PATH_MAX];
+
+	if (!r->cr_data) {
+		return (0);
+	}
+
+	if (a_dir != NULL) {
+		(void) strlcpy(name, h->ch_name, sizeof (name));
+		if (snprintf(h->ch_name, sizeof (h->ch_name), "%s/%s", a_dir,
+				name) >= sizeof (h->ch_name)) {
+			seterr(pkg_gt(ERR_CPIO_NAMELEN), name);
+			return (-1);
+		}
+	}
+
+	if ((rd_entry(r, h) != 0) || (rd_done(r) != 0)) {
+		r->cr_failed = 1;
+		return (-1);
+	}
+
+	return (0);
+}
+
+/*
+ * Name:	cpioCopy
+ * Description:	Write the data of the regular file whose header was just
+ *		read with cpioNext() to a file descriptor
+ * Arguments:	a_cpio - (CPIO_T *) - [RO, *RW]
+ *			Archive being read
+ *		a_fd - (int) - [RO]
+ *			File descriptor to write the data to
+ *		a_path - (char *) - [RO, *RO]
+ *			Path a_fd is open on, for error messages
+ * Returns:	int
+ *			== 0 - the data was written
+ *			< 0 - the data could not be read or written; use
+ *			  getErrstr() to retrieve a character-string
+ *			  describing the reason for failure
+ */
+
+int
+cpioCopy(CPIO_T *a_cpio, int a_fd, char *a_path)
+{
+	struct cpiord	*r = a_cpio;
+	struct cpiohdr	*h = r->cr_hdr;
+	int		n;
+
+	if (!r->cr_data) {
+		return (0);
+	}
+
+	/* the archive can still be read if only the data was bad */
+
+	if (((n = rd_data(r, h, a_fd, a_path)) < 0) || (rd_done(r) != 0)) {
+		r->cr_failed = 1;
+		return (-1);
+	}
+
+	return ((n == 0) ? 0 : -1);
+}
+
+/*
+ * Name:	cpioSkip
+ * Description:	Skip the data of the member whose header was just read
+ *		with cpioNext()
+ * Arguments:	a_cpio - (CPIO_T *) - [RO, *RW]
+ *			Archive being read
+ * Returns:	int
+ *			== 0 - the data was skipped
+ *			< 0 - the archive could not be read; use getErrstr()
+ *			  to retrieve a character-string describing the
+ *			  reason for failure
+ */
+
+int
+cpioSkip(CPIO_T *a_cpio)
+{
+	struct cpiord	*r = a_cpio;
+
+	if (!r->cr_data) {
+		return (0);
+	}
+
+	if ((rd_skip(r, r->cr_hdr->ch_size) != 0) || (rd_done(r) != 0)) {
+		r->cr_failed = 1;
+		return (-1);
+	}
+
+	return (0);
+}
+
+/*
+ * Name:	cpioClose
+ * Description:	Release an archive opened with cpioOpen(); the file
+ *		descriptor it was read from is not closed
+ * Arguments:	a_cpio - (CPIO_T *) - [RO, *RW]
+ *			Archive to release
+ * Returns:	void
+ */
+
+void
+cpioClose(CPIO_T *a_cpio)
+{
+	struct cpiolink	*cl;
+
+	if (a_cpio == NULL) {
+		return;
+	}
+
+	while ((cl = a_cpio->cr_links) != NULL) {
+		a_cpio->cr_links = cl->cl_next;
+		free(cl);
+	}
+
+	zipClose(a_cpio->cr_zip);
+	free(a_cpio->cr_buf);
+	free(a_cpio->cr_hdr);
+	free(a_cpio);
+}
+
+/*
+ * Name:	cpioExtract
+ * Description:	Read a cpio archive from a file descriptor and extract the
+ *		files in it below the current directory, as
+ *		"cpio -icdum -C <a_blksize>" does
+ * Arguments:	a_fd - (int) - [RO]
+ *			File descriptor to read the archive from; on success
+ *			it is left at the block that follows the archive
+ *		a_blksize - (int) - [RO]
+ *			Block size of the archive
+ *		a_patterns - (char **) - [RO, *RO]
+ *			NULL terminated list of shell patterns; only the files
+ *			whose names match one of them are extracted. If NULL
+ *			or empty, all files are extracted.
+ *		a_flags - (int) - [RO]
+ *			CPIO_SKIP - read the archive, but do not extract
+ *			anything from it
+ * Returns:	int
+ *			== 0 - the archive was read
+ *			< 0 - the archive could not be read or a file could
+ *			  not be extracted; use getErrstr() to retrieve a
+ *			  character-string describing the reason for failure
+ */
+
+int
+cpioExtract(int a_fd, int a_blksize, char **a_patterns, int a_flags)
+{
+	CPIO_T	*c;
+	char	*name;
+	int	match;
+	int	i;
+	int	n;
+
+	if ((c = cpioOpen(a_fd, a_blksize)) == NULL) {
+		return (-1);
+	}
+
+	while ((n = cpioNext(c, &name, NULL)) > 0) {
+		match = (a_patterns == NULL) || (a_patterns[0] == NULL);
+		for (i = 0; !match && (a_patterns[i] != NULL); i++) {
+			match = (fnmatch(a_patterns[i], name, 0) == 0);
+		}
+
+		if ((a_flags & CPIO_SKIP) || !match ||
+				(strcmp(name, ".") == 0)) {
+			n = cpioSkip(c);
+		} else {
+			n = cpioRestore(c, NULL);
+		}
+		if (n != 0) {
+			break;
+		}
+	}
+
+	cpioClose(c);
+
+	return ((n == 0) ? 0 : -1);
+}
+
+/*
+ * Name:	cpioArchive
+ * Description:	Write a cpio archive of files to a file descriptor, as
+ *		"cpio -oc -C <a_blksize>" does
+ * Arguments:	a_fd - (int) - [RO]
+ *			File descriptor to write the archive to
+ *		a_blksize - (int) - [RO]
+ *			Block size of the archive; the archive is padded to a
+ *			multiple of it. If a_fd is a character device, each
+ *			block is written with a write of its own.
+ *		a_paths - (char **) - [RO, *RO]
+ *			NULL terminated list of the files to archive, in the
+ *			order they are archived
+ *		a_flags - (int) - [RO]
+ *			CPIO_RECURSE - archive the files below each directory
+ *			  after the directory, as "find <paths> -print"
+ *			  lists them
+ *			CPIO_FOLLOW - archive the files symbolic links point
+ *			  to instead of the links themselves
+ *			CPIO_GZIP - gzip compress the archive
+ *			CPIO_ZSTD - zstd compress the archive; see
+ *			  cpioSetCompression()
+ * Returns:	int
+ *			== 0 - the archive was written
+ *			< 0 - the archive could not be written; use getErrstr()
+ *			  to retrieve a character-string describing the
+ *			  reason for failure
+ */
+
+int
+cpioArchive(int a_fd, int a_blksize, char **a_paths, int a_flags)
+{
+	struct cpiowr	w;
+	struct stat	st;
+	int		result = 0;
+	int		i;
+
+	(void) memset(&w, 0, sizeof (w));
+	w.cw_fd = a_fd;
+	w.cw_flags = a_flags;
+	w.cw_blksize = (a_blksize > 0) ? a_blksize : BLK_SIZE;
+	w.cw_bufsize = w.cw_blksize;
+	while (w.cw_bufsize < CPIO_IOSIZE) {
+		w.cw_bufsize += w.cw_blksize;
+	}
+	w.cw_record = (fstat(a_fd, &st) == 0) && S_ISCHR(st.st_mode);
+
+	if ((w.cw_buf = malloc(w.cw_bufsize)) == NULL) {
+		seterr(pkg_gt(ERR_MEM));
+		return (-1);
+	}
+
+	if (a_flags & (CPIO_GZIP|CPIO_ZSTD)) {
+		w.cw_zip = zipOpenWrite(a_fd, w.cw_blksize, w.cw_record,
+			(a_flags & CPIO_ZSTD) ? ZIP_ZSTD : ZIP_GZIP,
+			ziplevel, zipthreads);
+		if (w.cw_zip == NULL) {
+			free(w.cw_buf);
+			return (-1);
+		}
+	}
+
+	for (i = 0; (result == 0) && (a_paths[i] != NULL); i++) {
+		result = wr_path(&w, a_paths[i]);
+	}
+
+	/* trailer, then pad the archive to the next block */
+
+	if (result == 0) {
+		(void) memset(&st, 0, sizeof (st));
+		st.st_nlink = 1;
+		w.cw_ino = (unsigned long)-1;
+		result = wr_entry(&w, CPIO_TRAILER, &st, NULL);
+	}
+
+	if ((result == 0) && ((result = wr_pad(&w, w.cw_blksize)) == 0)) {
+		result = wr_flush(&w, w.cw_len);
+	}
+
+	if ((result == 0) && (w.cw_zip != NULL)) {
+		result = zipFinish(w.cw_zip);
+	}
+
+	zipClose(w.cw_zip);
+	free(w.cw_buf);
+
+	return (result);
+}
+
+/*
+ * Name:	cpioSetCompression
+ * Description:	Set how the archives cpioArchive() compresses are compressed
+ * Arguments:	a_level - (int) - [RO]
+ *			Compression level; if <= 0 the default level of the
+ *			compression method is used
+ *		a_nthreads - (int) - [RO]
+ *			Number of threads to compress an archive on; if <= 0
+ *			one thread for each online processor is used
+ * Returns:	void
+ */
+
+void
+cpioSetCompression(int a_level, int a_nthreads)
+{
+	ziplevel = a_level;
+	zipthreads = a_nthreads;
+}
+
+/*
+ * Private methods
+ */
+
+/*
+ * Name:	rd_fill
+ * Description:	make sure the next a_len bytes of the archive are buffered;
+ *		the archive is read up to the end of the block they end in
+ * Arguments:	r - (struct cpiord *) - [RO, *RW]
+ *			Archive being read
+ *		a_len - (size_t) - [RO]
+ *			Number of bytes needed, at most CPIO_IOSIZE
+ * Returns:	int - == 0 if the bytes are buffered, < 0 otherwise
+ */
+
+static int
+rd_fill(struct cpiord *r, size_t a_len)
+{
+	off_t	end;
+	size_t	len;
+	ssize_t	n;
+
+	if (r->cr_len - r->cr_pos >= a_len) {
+		return (0);
+	}
+
+	if (r->cr_pos > 0) {
+		(void) memmove(r->cr_buf, r->cr_buf + r->cr_pos,
+			r->cr_len - r->cr_pos);
+		r->cr_base += r->cr_pos;
+		r->cr_len -= r->cr_pos;
+		r->cr_pos = 0;
+	}
+
+	/* never read past the block the requested bytes end in */
+
+	end = r->cr_base + a_len + r->cr_blksize - 1;
+	end -= end % r->cr_blksize;
+
+	while (r->cr_len < a_len) {
+		len = (size_t)(end - r->cr_base) - r->cr_len;
+		if (r->cr_zip != NULL) {
+			if ((n = zipRead(r->cr_zip, r->cr_buf + r->cr_len,
+					len)) < 0) {
+				return (-1);
+			}
+		} else if ((n = read(r->cr_fd, r->cr_buf + r->cr_len,
+				len)) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			seterr(pkg_gt(ERR_CPIO_READ), errno, strerror(errno));
+			return (-1);
+		}
+		if (n == 0) {
+			seterr(pkg_gt(ERR_CPIO_EOF));
+			return (-1);
+		}
+		r->cr_len += n;
+
+		/* the first bytes tell whether the archive is compressed */
+
+		if (!r->cr_checked && (r->cr_len >= ZIP_MAGICLEN)) {
+			int	method = zipMethod(r->cr_buf, r->cr_len);
+
+			r->cr_checked = 1;
+			if (method != ZIP_NONE) {
+				r->cr_zip = zipOpenRead(r->cr_fd,
+					r->cr_blksize, method, r->cr_buf,
+					r->cr_len);
+				if (r->cr_zip == NULL) {
+					return (-1);
+				}
+				r->cr_len = 0;
+			}
+		}
+	}
+
+	return (0);
+}
+
+/*
+ * Name:	rd_skip
+ * Description:	skip the next a_len bytes of the archive
+ * Arguments:	r - (struct cpiord *) - [RO, *RW]
+ *			Archive being read
+ *		a_len - (off_t) - [RO]
+ *			Number of bytes to skip
+ * Returns:	int - == 0 if the bytes were skipped, < 0 otherwise
+ */
+
+static int
+rd_skip(struct cpiord *r, off_t a_len)
+{
+	size_t	n;
+
+	while (a_len > 0) {
+		n = (a_len > CPIO_IOSIZE) ? CPIO_IOSIZE : (size_t)a_len;
+		if (rd_fill(r, n) != 0) {
+			return (-1);
+		}
+		r->cr_pos += n;
+		a_len -= n;
+	}
+
+	return (0);
+}
+
+/* skip to the next multiple of a_align bytes from the archive start */
+
+static int
+rd_align(struct cpiord *r, size_t a_align)
+{
+	off_t	off = r->cr_base + r->cr_pos;
+
+	return (rd_skip(r, (a_align - off % a_align) % a_align));
+}
+
+/* done with the data of the current member: skip its padding */
+
+static int
+rd_done(struct cpiord *r)
+{
+	r->cr_data = 0;
+
+	return (r->cr_hdr->ch_svr4 ? rd_align(r, 4) : 0);
+}
+
+/*
+ * Name:	rd_header
+ * Description:	read the header and name of the next file of the archive
+ * Arguments:	r - (struct cpiord *) - [RO, *RW]
+ *			Archive being read; on success it is positioned at
+ *			the data of the file
+ *		h - (struct cpiohdr *) - [RO, *RW]
+ *			Header to fill in
+ * Returns:	int - == 0 if the header was read, < 0 otherwise
+ */
+
+static int
+rd_header(struct cpiord *r, struct cpiohdr *h)
+{
+	unsigned long long	v[13];
+	unsigned long long	namesz;
+	char			*p;
+	int			ok;
+
+	if (rd_fill(r, CMS_LEN) != 0) {
+		return (-1);
+	}
+
+	p = r->cr_buf + r->cr_pos;
+
+	(void) memset(h, 0, offsetof(struct cpiohdr, ch_name));
+
+	if (strncmp(p, CMS_CHR, CMS_LEN) == 0) {
+		struct c_hdr	*c;
+
+		if (rd_fill(r, CHRSZ) != 0) {
+			return (-1);
+		}
+		c = (struct c_hdr *)(r->cr_buf + r->cr_pos);
+		ok = (getnum(c->c_dev, 6, 8, &v[0]) == 0) &&
+			(getnum(c->c_ino, 6, 8, &v[1]) == 0) &&
+			(getnum(c->c_mode, 6, 8, &v[2]) == 0) &&
+			(getnum(c->c_uid, 6, 8, &v[3]) == 0) &&
+			(getnum(c->c_gid, 6, 8, &v[4]) == 0) &&
+			(getnum(c->c_nlink, 6, 8, &v[5]) == 0) &&
+			(getnum(c->c_rdev, 6, 8, &v[6]) == 0) &&
+			(getnum(c->c_mtime, 11, 8, &v[7]) == 0) &&
+			(getnum(c->c_namesz, 6, 8, &namesz) == 0) &&
+			(getnum(c->c_filesz, 11, 8, &v[8]) == 0);
+		if (ok) {
+			h->ch_dev = (dev_t)v[0];
+			h->ch_ino = (unsigned long)v[1];
+			h->ch_mode = (mode_t)v[2];
+			h->ch_uid = (uid_t)v[3];
+			h->ch_gid = (gid_t)v[4];
+			h->ch_nlink = (unsigned long)v[5];
+			h->ch_rdev = (dev_t)v[6];
+			h->ch_mtime = (time_t)v[7];
+			h->ch_size = (off_t)v[8];
+		}
+		r->cr_pos += CHRSZ;
+	} else if ((strncmp(p, CMS_ASC, CMS_LEN) == 0) ||
+			(strncmp(p, CMS_CRC, CMS_LEN) == 0)) {
+		struct Exp_cpio_hdr	*e;
+
+		h->ch_svr4 = 1;
+		h->ch_crc = (strncmp(p, CMS_CRC, CMS_LEN) == 0);
+		if (rd_fill(r, ASCSZ) != 0) {
+			return (-1);
+		}
+		e = (struct Exp_cpio_hdr *)(r->cr_buf + r->cr_pos);
+		ok = (getnum(e->E_ino, 8, 16, &v[0]) == 0) &&
+			(getnum(e->E_mode, 8, 16, &v[1]) == 0) &&
+			(getnum(e->E_uid, 8, 16, &v[2]) == 0) &&
+			(getnum(e->E_gid, 8, 16, &v[3]) == 0) &&
+			(getnum(e->E_nlink, 8, 16, &v[4]) == 0) &&
+			(getnum(e->E_mtime, 8, 16, &v[5]) == 0) &&
+			(getnum(e->E_filesize, 8, 16, &v[6]) == 0) &&
+			(getnum(e->E_maj, 8, 16, &v[7]) == 0) &&
+			(getnum(e->E_min, 8, 16, &v[8]) == 0) &&
+			(getnum(e->E_rmaj, 8, 16, &v[9]) == 0) &&
+			(getnum(e->E_rmin, 8, 16, &v[10]) == 0) &&
+			(getnum(e->E_namesize, 8, 16, &namesz) == 0) &&
+			(getnum(e->E_chksum, 8, 16, &v[12]) == 0);
+		if (ok) {
+			h->ch_ino = (unsigned long)v[0];
+			h->ch_mode = (mode_t)v[1];
+			h->ch_uid = (uid_t)v[2];
+			h->ch_gid = (gid_t)v[3];
+			h->ch_nlink = (unsigned long)v[4];
+			h->ch_mtime = (time_t)v[5];
+			h->ch_size = (off_t)v[6];
+			h->ch_dev = makedev(v[7], v[8]);
+			h->ch_rdev = makedev(v[9], v[10]);
+			h->ch_chksum = (uint32_t)v[12];
+		}
+		r->cr_pos += ASCSZ;
+	} else {
+		seterr(pkg_gt(ERR_CPIO_HEADER));
+		return (-1);
+	}
+
+	if (!ok) {
+		seterr(pkg_gt(ERR_CPIO_HEADER));
+		return (-1);
+	}
+
+	/* the name includes its terminating null byte */
+
+	if ((namesz < 2) || (namesz > sizeof (h->ch_name))) {
+		seterr(pkg_gt(ERR_CPIO_NAMESZ), namesz);
+		return (-1);
+	}
+
+	if (rd_fill(r, (size_t)namesz) != 0) {
+		return (-1);
+	}
+	(void) memcpy(h->ch_name, r->cr_buf + r->cr_pos, (size_t)namesz);
+	h->ch_name[namesz - 1] = '\0';
+	r->cr_pos += namesz;
+
+	return (h->ch_svr4 ? rd_align(r, 4) : 0);
+}
+
+/*
+ * Name:	rd_entry
+ * Description:	extract the file of the header just read
+ * Arguments:	r - (struct cpiord *) - [RO, *RW]
+ *			Archive being read; positioned at the data of the
+ *			file, which is consumed
+ *		h - (struct cpiohdr *) - [RO, *RO]
+ *			Header of the file
+ * Returns:	int - == 0 if the file was extracted, < 0 otherwise
+ */
+
+static int
+rd_entry(struct cpiord *r, struct cpiohdr *h)
+{
+	char	target[PATH_MAX];
+	int	n;
+
+	switch (h->ch_mode & S_IFMT) {
+	case S_IFREG:
+		if (h->ch_svr4 && (h->ch_nlink > 1)) {
+			return (rd_link(r, h));
+		}
+		return (rd_file(r, h));
+
+	case S_IFDIR:
+		if (rd_skip(r, h->ch_size) != 0) {
+			return (-1);
+		}
+		if (rd_remove(h->ch_name, 1) != 0) {
+			return (-1);
+		}
+		n = mkdir(h->ch_name, 0700);
+		if ((n != 0) && (errno == ENOENT) &&
+				(rd_mkparents(h->ch_name) == 0)) {
+			n = mkdir(h->ch_name, 0700);
+		}
+		if ((n != 0) && (errno != EEXIST)) {
+			seterr(pkg_gt(ERR_CPIO_CREATE), h->ch_name, errno,
+				strerror(errno));
+			return (-1);
+		}
+		return (rd_attrs(h));
+
+	case S_IFLNK:
+		if ((h->ch_size <= 0) || (h->ch_size >= sizeof (target))) {
+			seterr(pkg_gt(ERR_CPIO_HEADER));
+			return (-1);
+		}
+		if (rd_fill(r, (size_t)h->ch_size) != 0) {
+			return (-1);
+		}
+		(void) memcpy(target, r->cr_buf + r->cr_pos,
+			(size_t)h->ch_size);
+		target[h->ch_size] = '\0';
+		r->cr_pos += h->ch_size;
+		if (rd_remove(h->ch_name, 0) != 0) {
+			return (-1);
+		}
+		n = symlink(target, h->ch_name);
+		if ((n != 0) && (errno == ENOENT) &&
+				(rd_mkparents(h->ch_name) == 0)) {
+			n = symlink(target, h->ch_name);
+		}
+		if (n != 0) {
+			seterr(pkg_gt(ERR_CPIO_CREATE), h->ch_name, errno,
+				strerror(errno));
+			return (-1);
+		}
+		if (geteuid() == 0) {
+			(void) lchown(h->ch_name, h->ch_uid, h->ch_gid);
+		}
+		return (0);
+
+	case S_IFCHR:
+	case S_IFBLK:
+	case S_IFIFO:
+		if (rd_skip(r, h->ch_size) != 0) {
+			return (-1);
+		}
+		if (rd_remove(h->ch_name, 0) != 0) {
+			return (-1);
+		}
+		n = mknod(h->ch_name, h->ch_mode, h->ch_rdev);
+		if ((n != 0) && (errno == ENOENT) &&
+				(rd_mkparents(h->ch_name) == 0)) {
+			n = mknod(h->ch_name, h->ch_mode, h->ch_rdev);
+		}
+		if (n != 0) {
+			seterr(pkg_gt(ERR_CPIO_CREATE), h->ch_name, errno,
+				strerror(errno));
+			return (-1);
+		}
+		return (rd_attrs(h));
+
+	default:
+		/* sockets and unknown types cannot be restored */
+		return (rd_skip(r, h->ch_size));
+	}
+}
+
+/*
+ * Name:	rd_file
+ * Description:	extract a regular file from its data in the archive
+ * Arguments:	r - (struct cpiord *) - [RO, *RW]
+ *			Archive being read; positioned at the data of the
+ *			file, which is consumed
+ *		h - (struct cpiohdr *) - [RO, *RO]
+ *			Header of the file
+ * Returns:	int - == 0 if the file was extracted, < 0 otherwise
+ */
+
+static int
+rd_file(struct cpiord *r, struct cpiohdr *h)
+{
+	int	fd;
+
+	if (rd_remove(h->ch_name, 0) != 0) {
+		return (-1);
+	}
+
+	fd = open(h->ch_name, O_WRONLY | O_CREAT | O_EXCL, 0600);
+	if ((fd < 0) && (errno == ENOENT) && (rd_mkparents(h->ch_name) == 0)) {
+		fd = open(h->ch_name, O_WRONLY | O_CREAT | O_EXCL, 0600);
+	}
+	if (fd < 0) {
+		seterr(pkg_gt(ERR_CPIO_CREATE), h->ch_name, errno,
+			strerror(errno));
+		return (-1);
+	}
+
+	if (rd_data(r, h, fd, h->ch_name) != 0) {
+		(void) close(fd);
+		return (-1);
+	}
+
+	if (geteuid() == 0) {
+		(void) fchown(fd, h->ch_uid, h->ch_gid);
+	}
+	(void) fchmod(fd, h->ch_mode & 07777);
+
+	if (close(fd) != 0) {
+		seterr(pkg_gt(ERR_CPIO_WRITE), h->ch_name, errno,
+			strerror(errno));
+		return (-1);
+	}
+
+	return (rd_attrs(h));
+}
+
+/*
+ * Name:	rd_data
+ * Description:	write the data of a regular file to a file descriptor,
+ *		straight from the archive buffer
+ * Arguments:	r - (struct cpiord *) - [RO, *RW]
+ *			Archive being read; positioned at the data of the
+ *			file, which is consumed
+ *		h - (struct cpiohdr *) - [RO, *RO]
+ *			Header of the file
+ *		a_fd - (int) - [RO]
+ *			File descriptor to write the data to
+ *		a_path - (char *) - [RO, *RO]
+ *			Path a_fd is open on, for error messages
+ * Returns:	int
+ *			== 0 - the data was written and its checksum, if any,
+ *			  is correct
+ *			> 0 - the data was read, but could not be written or
+ *			  its checksum is wrong
+ *			< 0 - the data could not be read
+ */
+
+static int
+rd_data(struct cpiord *r, struct cpiohdr *h, int a_fd, char *a_path)
+{
+	uint32_t	sum = 0;
+	off_t		left;
+	ssize_t		n;
+	size_t		len;
+
+	for (left = h->ch_size; left > 0; left -= len) {
+		len = (left > CPIO_IOSIZE) ? CPIO_IOSIZE : (size_t)left;
+		if (rd_fill(r, len) != 0) {
+			return (-1);
+		}
+		if (h->ch_crc) {
+			sum = cksumBytes(sum, r->cr_buf + r->cr_pos, len);
+		}
+		while ((n = write(a_fd, r->cr_buf + r->cr_pos, len)) !=
+				(ssize_t)len) {
+			if ((n < 0) && (errno == EINTR)) {
+				continue;
+			}
+			if (n >= 0) {
+				errno = ENOSPC;
+			}
+			seterr(pkg_gt(ERR_CPIO_WRITE), a_path, errno,
+				strerror(errno));
+			/* skip the rest, so the next member can be read */
+			return ((rd_skip(r, left) != 0) ? -1 : 1);
+		}
+		r->cr_pos += len;
+	}
+
+	if (h->ch_crc && (sum != h->ch_chksum)) {
+		seterr(pkg_gt(ERR_CPIO_CHKSUM), h->ch_name);
+		return (1);
+	}
+
+	return (0);
+}
+
+/*
+ * Name:	rd_link
+ * Description:	extract a regular file with several links from an SVR4
+ *		archive; the data is stored with one of the links only, the
+ *		other links are archived with no data and are created as
+ *		links to the one with the data once it has been extracted
+ * Arguments:	r - (struct cpiord *) - [RO, *RW]
+ *			Archive being read; positioned at the data of the
+ *			file, which is consumed
+ *		h - (struct cpiohdr *) - [RO, *RO]
+ *			Header of the file
+ * Returns:	int - == 0 if the file was extracted, < 0 otherwise
+ */
+
+static int
+rd_link(struct cpiord *r, struct cpiohdr *h)
+{
+	struct cpiolink	*cl;
+	struct cpiolink	*data = NULL;
+	int		n;
+
+	for (cl = r->cr_links; cl != NULL; cl = cl->cl_next) {
+		if (cl->cl_done && (cl->cl_hdr.ch_dev == h->ch_dev) &&
+				(cl->cl_hdr.ch_ino == h->ch_ino)) {
+			data = cl;
+			break;
+		}
+	}
+
+	if ((h->ch_size == 0) && (data != NULL)) {
+		/* the data came with an earlier link */
+		if (rd_remove(h->ch_name, 0) != 0) {
+			return (-1);
+		}
+		n = link(data->cl_hdr.ch_name, h->ch_name);
+		if ((n != 0) && (errno == ENOENT) &&
+				(rd_mkparents(h->ch_name) == 0)) {
+			n = link(data->cl_hdr.ch_name, h->ch_name);
+		}
+		if (n != 0) {
+			seterr(pkg_gt(ERR_CPIO_LINK), h->ch_name,
+				data->cl_hdr.ch_name, errno, strerror(errno));
+			return (-1);
+		}
+		return (0);
+	}
+
+	if ((cl = malloc(sizeof (struct cpiolink))) == NULL) {
+		seterr(pkg_gt(ERR_MEM));
+		return (-1);
+	}
+	cl->cl_hdr = *h;
+	cl->cl_done = (h->ch_size > 0);
+	cl->cl_next = r->cr_links;
+	r->cr_links = cl;
+
+	if (!cl->cl_done) {
+		/* wait for the link the data comes with */
+		return (0);
+	}
+
+	if (rd_file(r, h) != 0) {
+		return (-1);
+	}
+
+	/* link the names that came before the data */
+
+	for (cl = cl->cl_next; cl != NULL; cl = cl->cl_next) {
+		if (cl->cl_done || (cl->cl_hdr.ch_dev != h->ch_dev) ||
+				(cl->cl_hdr.ch_ino != h->ch_ino)) {
+			continue;
+		}
+		if (rd_remove(cl->cl_hdr.ch_name, 0) != 0) {
+			return (-1);
+		}
+		n = link(h->ch_name, cl->cl_hdr.ch_name);
+		if ((n != 0) && (errno == ENOENT) &&
+				(rd_mkparents(cl->cl_hdr.ch_name) == 0)) {
+			n = link(h->ch_name, cl->cl_hdr.ch_name);
+		}
+		if (n != 0) {
+			seterr(pkg_gt(ERR_CPIO_LINK), cl->cl_hdr.ch_name,
+				h->ch_name, errno, strerror(errno));
+			return (-1);
+		}
+		cl->cl_done = 1;
+	}
+
+	return (0);
+}
+
+/*
+ * Name:	rd_attrs
+ * Description:	restore owner, mode and modification time of a file just
+ *		extracted; the owner is only restored for the super user
+ * Arguments:	h - (struct cpiohdr *) - [RO, *RO]
+ *			Header of the file
+ * Returns:	int - == 0 if the attributes were restored, < 0 otherwise
+ */
+
+static int
+rd_attrs(struct cpiohdr *h)
+{
+	struct utimbuf	ut;
+
+	if (geteuid() == 0) {
+		(void) lchown(h->ch_name, h->ch_uid, h->ch_gid);
+	}
+
+	if (chmod(h->ch_name, h->ch_mode & 07777) != 0) {
+		seterr(pkg_gt(ERR_CPIO_CREATE), h->ch_name, errno,
+			strerror(errno));
+		return (-1);
+	}
+
+	ut.actime = ut.modtime = h->ch_mtime;
+	(void) utime(h->ch_name, &ut);
+
+	return (0);
+}
+
+/*
+ * Name:	rd_remove
+ * Description:	remove what is in the way of a file to be extracted; an
+ *		existing directory is kept if a directory is extracted
+ * Arguments:	a_path - (char *) - [RO, *RO]
+ *			Path of the file to be extracted
+ *		a_isdir - (int) - [RO]
+ *			!= 0 if a directory is extracted
+ * Returns:	int - == 0 if nothing is in the way, < 0 otherwise
+ */
+
+static int
+rd_remove(char *a_path, int a_isdir)
+{
+	struct stat	st;
+
+	if (lstat(a_path, &st) != 0) {
+		return (0);
+	}
+
+	if (S_ISDIR(st.st_mode)) {
+		if (a_isdir || (rmdir(a_path) == 0)) {
+			return (0);
+		}
+	} else if (unlink(a_path) == 0) {
+		return (0);
+	}
+
+	seterr(pkg_gt(ERR_CPIO_REMOVE), a_path, errno, strerror(errno));
+	return (-1);
+}
+
+/* create the missing parent directories of a path, as "cpio -d" does */
+
+static int
+rd_mkparents(char *a_path)
+{
+	char	path[PATH_MAX];
+	char	*p;
+
+	(void) strlcpy(path, a_path, sizeof (path));
+
+	for (p = strchr(path + 1, '/'); p != NULL; p = strchr(p + 1, '/')) {
+		*p = '\0';
+		if ((mkdir(path, 0755) != 0) && (errno != EEXIST)) {
+			seterr(pkg_gt(ERR_CPIO_CREATE), path, errno,
+				strerror(errno));
+			return (-1);
+		}
+		*p = '/';
+	}
+
+	return (0);
+}
+
+/* convert a fixed width numeric header field */
+
+static int
+getnum(char *a_field, size_t a_len, int a_base, unsigned long long *r_num)
+{
+	char	buf[16];
+	char	*end;
+
+	(void) memcpy(buf, a_field, a_len);
+	buf[a_len] = '\0';
+
+	errno = 0;
+	*r_num = strtoull(buf, &end, a_base);
+
+	return (((end == buf) || (*end != '\0') || (errno != 0)) ? -1 : 0);
+}
+
+/*
+ * Name:	wr_path
+ * Description:	archive a file, and the files below it if it is a
+ *		directory and CPIO_RECURSE is set
+ * Arguments:	w - (struct cpiowr *) - [RO, *RW]
+ *			Archive being written
+ *		a_path - (char *) - [RO, *RO]
+ *			Path of the file
+ * Returns:	int - == 0 if the file was archived, < 0 otherwise
+ */
+
+static int
+wr_path(struct cpiowr *w, char *a_path)
+{
+	struct dirent	**list;
+	struct stat	st;
+	char		path[PATH_MAX];
+	int		result = 0;
+	int		i;
+	int		n;
+
+	n = (w->cw_flags & CPIO_FOLLOW) ? stat(a_path, &st) :
+		lstat(a_path, &st);
+	if (n != 0) {
+		seterr(pkg_gt(ERR_CPIO_STAT), a_path, errno, strerror(errno));
+		return (-1);
+	}
+
+	if (wr_entry(w, a_path, &st, a_path) != 0) {
+		return (-1);
+	}
+
+	if (!S_ISDIR(st.st_mode) || !(w->cw_flags & CPIO_RECURSE)) {
+		return (0);
+	}
+
+	if ((n = scandir(a_path, &list, NULL, alphasort)) < 0) {
+		seterr(pkg_gt(ERR_CPIO_OPEN), a_path, errno, strerror(errno));
+		return (-1);
+	}
+
+	for (i = 0; i < n; i++) {
+		char	*name = list[i]->d_name;
+
+		if ((result == 0) && (strcmp(name, ".") != 0) &&
+				(strcmp(name, "..") != 0)) {
+			if (snprintf(path, sizeof (path), "%s/%s", a_path,
+					name) >= sizeof (path)) {
+				seterr(pkg_gt(ERR_CPIO_NAMELEN), a_path);
+				result = -1;
+			} else {
+				result = wr_path(w, path);
+			}
+		}
+		free(list[i]);
+	}
+	free(list);
+
+	return (result);
+}
+
+/*
+ * Name:	wr_entry
+ * Description:	write the header and data of a file to the archive
+ * Arguments:	w - (struct cpiowr *) - [RO, *RW]
+ *			Archive being written
+ *		a_name - (char *) - [RO, *RO]
+ *			Name of the file in the archive
+ *		a_st - (struct stat *) - [RO, *RO]
+ *			Status of the file
+ *		a_path - (char *) - [RO, *RO]
+ *			Path to read the data of regular files and symbolic
+ *			links from
+ * Returns:	int - == 0 if the file was archived, < 0 otherwise
+ */
+
+static int
+wr_entry(struct cpiowr *w, char *a_name, struct stat *a_st, char *a_path)
+{
+	char		hdr[ASCSZ + 1];
+	char		target[PATH_MAX];
+	off_t		size = 0;
+	off_t		left;
+	size_t		namesz = strlen(a_name) + 1;
+	ssize_t		n;
+	int		fd = -1;
+
+	if (namesz > EXPNLEN) {
+		seterr(pkg_gt(ERR_CPIO_NAMELEN), a_name);
+		return (-1);
+	}
+
+	if (S_ISREG(a_st->st_mode)) {
+		size = a_st->st_size;
+		if ((fd = open(a_path, O_RDONLY)) < 0) {
+			seterr(pkg_gt(ERR_CPIO_OPEN), a_path, errno,
+				strerror(errno));
+			return (-1);
+		}
+	} else if (S_ISLNK(a_st->st_mode)) {
+		if ((n = readlink(a_path, target, sizeof (target))) < 0) {
+			seterr(pkg_gt(ERR_CPIO_OPEN), a_path, errno,
+				strerror(errno));
+			return (-1);
+		}
+		size = n;
+	} else if (S_ISSOCK(a_st->st_mode)) {
+		/* cpio(1) does not archive sockets either */
+		return (0);
+	}
+
+	if ((uintmax_t)size > 0xFFFFFFFFUL) {
+		seterr(pkg_gt(ERR_CPIO_TOOBIG), a_path);
+		if (fd >= 0) {
+			(void) close(fd);
+		}
+		return (-1);
+	}
+
+	/*
+	 * every file gets an inode number of its own and a single link,
+	 * so its data is always archived with it
+	 */
+
+	(void) snprintf(hdr, sizeof (hdr), "%s%08lx%08lx%08lx%08lx%08lx%08lx"
+		"%08lx%08lx%08lx%08lx%08lx%08lx%08lx", CMS_ASC,
+		++w->cw_ino, (unsigned long)a_st->st_mode,
+		(unsigned long)a_st->st_uid, (unsigned long)a_st->st_gid,
+		S_ISDIR(a_st->st_mode) ? (unsigned long)a_st->st_nlink : 1UL,
+		(unsigned long)a_st->st_mtime, (unsigned long)size, 0UL, 0UL,
+		(unsigned long)major(a_st->st_rdev),
+		(unsigned long)minor(a_st->st_rdev), (unsigned long)namesz,
+		0UL);
+
+	if ((wr_put(w, hdr, ASCSZ) != 0) ||
+			(wr_put(w, a_name, namesz) != 0) ||
+			(wr_pad(w, 4) != 0)) {
+		if (fd >= 0) {
+			(void) close(fd);
+		}
+		return (-1);
+	}
+
+	if (S_ISLNK(a_st->st_mode)) {
+		return ((wr_put(w, target, size) != 0) ? -1 : wr_pad(w, 4));
+	}
+
+	if (fd < 0) {
+		return (0);
+	}
+
+	/* read the data straight into the archive buffer */
+
+	for (left = size; left > 0; left -= n) {
+		size_t	len = w->cw_bufsize - w->cw_len;
+
+		if ((len == 0) && (wr_flush(w, w->cw_len) != 0)) {
+			(void) close(fd);
+			return (-1);
+		}
+		len = w->cw_bufsize - w->cw_len;
+		if (len > left) {
+			len = (size_t)left;
+		}
+		n = read(fd, w->cw_buf + w->cw_len, len);
+		if ((n < 0) && (errno == EINTR)) {
+			n = 0;
+			continue;
+		}
+		if (n <= 0) {
+			if (n == 0) {
+				seterr(pkg_gt(ERR_CPIO_CHANGED), a_path);
+			} else {
+				seterr(pkg_gt(ERR_CPIO_OPEN), a_path, errno,
+					strerror(errno));
+			}
+			(void) close(fd);
+			return (-1);
+		}
+		w->cw_len += n;
+		w->cw_off += n;
+	}
+
+	(void) close(fd);
+
+	return (wr_pad(w, 4));
+}
+
+/* append bytes to the archive */
+
+static int
+wr_put(struct cpiowr *w, char *a_data, size_t a_len)
+{
+	size_t	n;
+
+	while (a_len > 0) {
+		if ((w->cw_len == w->cw_bufsize) &&
+				(wr_flush(w, w->cw_len) != 0)) {
+			return (-1);
+		}
+		n = w->cw_bufsize - w->cw_len;
+		if (n > a_len) {
+			n = a_len;
+		}
+		(void) memcpy(w->cw_buf + w->cw_len, a_data, n);
+		w->cw_len += n;
+		w->cw_off += n;
+		a_data += n;
+		a_len -= n;
+	}
+
+	return (0);
+}
+
+/* append null bytes up to the next multiple of a_align bytes */
+
+static int
+wr_pad(struct cpiowr *w, size_t a_align)
+{
+	static char	zeros[BLK_SIZE];
+	size_t		n;
+
+	n = (a_align - w->cw_off % a_align) % a_align;
+
+	while (n > 0) {
+		size_t	len = (n > sizeof (zeros)) ? sizeof (zeros) : n;
+
+		if (wr_put(w, zeros, len) != 0) {
+			return (-1);
+		}
+		n -= len;
+	}
+
+	return (0);
+}
+
+/*
+ * Name:	wr_flush
+ * Description:	write the first bytes of the archive buffer out
+ * Arguments:	w - (struct cpiowr *) - [RO, *RW]
+ *			Archive being written
+ *		a_len - (size_t) - [RO]
+ *			Number of bytes to write; a multiple of the block size
+ * Returns:	int - == 0 if the bytes were written, < 0 otherwise
+ */
+
+static int
+wr_flush(struct cpiowr *w, size_t a_len)
+{
+	size_t	done = 0;
+	size_t	len;
+	ssize_t	n;
+
+	if (w->cw_zip != NULL) {
+		if (zipWrite(w->cw_zip, w->cw_buf, a_len) != 0) {
+			return (-1);
+		}
+		done = a_len;
+	}
+
+	while (done < a_len) {
+		len = w->cw_record ? w->cw_blksize : a_len - done;
+		n = write(w->cw_fd, w->cw_buf + done, len);
+		if ((n < 0) && (errno == EINTR)) {
+			continue;
+		}
+		if (n <= 0) {
+			if (n == 0) {
+				errno = ENOSPC;
+			}
+			seterr(pkg_gt(ERR_CPIO_OUT), errno, strerror(errno));
+			return (-1);
+		}
+		done += n;
+	}
+
+	(void) memmove(w->cw_buf, w->cw_buf + a_len, w->cw_len - a_len);
+	w->cw_len -= a_len;
+
+	return (0);
+}
+
+/* format the reason of a failure for getErrstr() */
+
+/*PRINTFLIKE1*/
+static void
+seterr(char *a_fmt, ...)
+{
+	va_list	ap;
+
+	va_start(ap, a_fmt);
+	(void) vsnprintf(errbuf, sizeof (errbuf), a_fmt, ap);
+	va_end(ap);
+
+	setErrstr(errbuf);
+}
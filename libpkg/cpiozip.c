@@ -0,0 +1,1048 @@
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at src/OPENSOLARIS.LICENSE
+ * or http://www.opensolaris.org/os/licensing.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+/*LINTLIBRARY*/
+
+/*
+ * Module:	cpiozip.c
+ * Synopsis:	gzip and zstd compressed cpio archives of a datastream
+ * Taxonomy:	project private
+ * Description:
+ *
+ *   This module compresses the cpio archives that cpio.c writes to a
+ *   package datastream and decompresses the ones it reads, in the process
+ *   and while the data streams through; no gzip(1) or zstd(1) processes
+ *   are run.
+ *
+ *   gzip archives are written as a series of gzip members holding
+ *   ZIP_CHUNK bytes of archive data each, so that several members can be
+ *   compressed at the same time on several threads; gzip(1) reads such a
+ *   series as a single file. zstd archives are written as a single frame
+ *   by the zstd library, which runs threads of its own when asked to.
+ *
+ *   The compressed data is padded with null bytes to a multiple of the
+ *   datastream block size. It is read in whole blocks, so the file
+ *   descriptor ends up at the block that follows the archive; where the
+ *   file descriptor can seek, larger reads are made and what was read of
+ *   the next archive is given back once the archive ends.
+ *
+ *   zstd archives can only be read and written if built with USE_ZSTD.
+ *
+ * Public Methods:
+ *
+ *   zipClose - Release a compressed archive
+ *   zipFinish - Read or write the end of a compressed archive
+ *   zipMethod - Determine how an archive is compressed
+ *   zipOpenRead - Start reading a compressed archive
+ *   zipOpenWrite - Start writing a compressed archive
+ *   zipRead - Read data from a compressed archive
+ *   zipWrite - Write data to a compressed archive
+ */
+
+/*
+ * Unix Includes
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#ifdef	USE_ZSTD
+#include <zstd.h>
+#endif
+
+/*
+ * pkglib Includes
+ */
+
+#include <pkglib.h>
+#include "pkglocale.h"
+#include "pkglibmsgs.h"
+#include "cpiozip.h"
+
+/*
+ * Compressed data is read and written ZIP_IOSIZE bytes at a time, rounded
+ * to whole blocks. gzip archives are compressed ZIP_CHUNK bytes at a time,
+ * one chunk on each thread.
+ */
+
+#define	ZIP_IOSIZE	(64*1024)	/* 64kb */
+#define	ZIP_CHUNK	(1024*1024)	/* 1mb */
+
+#define	ZIP_GZIPMAGIC	"\037\213"
+#define	ZIP_ZSTDMAGIC	"\050\265\057\375"
+
+#define	ZIP_GZIPBITS	(MAX_WBITS + 16)	/* gzip header and trailer */
+#define	ZIP_GZIPWRAP	18			/* their size */
+
+/*
+ * Private definitions
+ */
+
+/* chunk of archive data compressed into a gzip member */
+
+struct zipchunk {
+	char		*zc_in;		/* archive data */
+	size_t		zc_inlen;
+	char		*zc_out;	/* gzip member */
+	size_t		zc_outsize;
+	size_t		zc_outlen;
+	int		zc_level;
+	char		*zc_msg;	/* reason of failure, NULL if none */
+	int		zc_thread;	/* != 0 if compressed on own thread */
+	pthread_t	zc_tid;		/* thread compressing chunk */
+};
+
+struct cpiozip {
+	int		cz_fd;
+	size_t		cz_blksize;
+	int		cz_method;
+	int		cz_write;	/* != 0 if archive is written */
+	int		cz_record;	/* != 0 to write block by block */
+	int		cz_seek;	/* != 0 if reads can be given back */
+	char		*cz_buf;	/* compressed data */
+	size_t		cz_bufsize;	/* multiple of cz_blksize */
+	size_t		cz_len;		/* bytes in buffer */
+	size_t		cz_pos;		/* next byte of buffer to decompress */
+	off_t		cz_base;	/* offset of first byte in archive */
+	int		cz_end;		/* != 0 if member or frame ended */
+	z_stream	cz_zs;		/* gzip decompressor */
+	int		cz_zsinit;	/* != 0 if cz_zs is initialized */
+	struct zipchunk	*cz_chunks;	/* gzip compressor chunks */
+	int		cz_nchunks;
+	int		cz_nfull;	/* number of chunks filled */
+#ifdef	USE_ZSTD
+	ZSTD_DCtx	*cz_zd;		/* zstd decompressor */
+	ZSTD_CCtx	*cz_zc;		/* zstd compressor */
+	char		*cz_zbuf;	/* zstd compressor output */
+	size_t		cz_zbufsize;
+#endif
+};
+
+/*
+ * Private methods
+ */
+
+static CPIOZIP_T	*zip_new(int a_fd, size_t a_blksize, int a_method);
+static int	zr_fill(CPIOZIP_T *z);
+static ssize_t	zr_decode(CPIOZIP_T *z, char *a_buf, size_t a_len);
+static int	zr_member(CPIOZIP_T *z);
+static int	zw_chunks(CPIOZIP_T *z, int a_n);
+static void	*zw_deflate(void *a_chunk);
+#ifdef	USE_ZSTD
+static int	zw_zstd(CPIOZIP_T *z, char *a_buf, size_t a_len,
+			ZSTD_EndDirective a_op);
+#endif
+static int	zw_put(CPIOZIP_T *z, char *a_data, size_t a_len);
+static int	zw_flush(CPIOZIP_T *z, size_t a_len);
+static void	seterr(char *a_fmt, ...);
+
+/*
+ * Module globals
+ */
+
+static char	errbuf[256];	/* reason of last failure */
+
+/*
+ * Public methods
+ */
+
+/*
+ * Name:	zipMethod
+ * Description:	Determine how an archive is compressed from its first bytes
+ * Arguments:	a_buf - (char *) - [RO, *RO]
+ *			First bytes of the archive
+ *		a_len - (size_t) - [RO]
+ *			Number of bytes in a_buf; at least ZIP_MAGICLEN bytes
+ *			are needed to tell all methods
+ * Returns:	int
+ *			ZIP_GZIP - the archive is gzip compressed
+ *			ZIP_ZSTD - the archive is zstd compressed
+ *			ZIP_NONE - the archive is not compressed
+ */
+
+int
+zipMethod(char *a_buf, size_t a_len)
+{
+	if ((a_len >= 2) && (memcmp(a_buf, ZIP_GZIPMAGIC, 2) == 0)) {
+		return (ZIP_GZIP);
+	}
+
+	if ((a_len >= 4) && (memcmp(a_buf, ZIP_ZSTDMAGIC, 4) == 0)) {
+		return (ZIP_ZSTD);
+	}
+
+	return (ZIP_NONE);
+}
+
+/*
+ * Name:	zipOpenRead
+ * Description:	Start reading a compressed archive from a file descriptor
+ * Arguments:	a_fd - (int) - [RO]
+ *			File descriptor to read the archive from
+ *		a_blksize - (size_t) - [RO]
+ *			Block size of the datastream
+ *		a_method - (int) - [RO]
+ *			Compression method, as returned by zipMethod()
+ *		a_buf - (char *) - [RO, *RO]
+ *			Bytes of the archive already read from a_fd; the
+ *			archive starts with them
+ *		a_len - (size_t) - [RO]
+ *			Number of bytes in a_buf, at most a_blksize
+ * Returns:	CPIOZIP_T *
+ *			!= NULL - the archive to pass to zipRead()
+ *			== NULL - the archive cannot be read; use getErrstr()
+ *			  to retrieve a character-string describing the
+ *			  reason for failure
+ */
+
+CPIOZIP_T *
+zipOpenRead(int a_fd, size_t a_blksize, int a_method, char *a_buf,
+	size_t a_len)
+{
+	CPIOZIP_T	*z;
+	struct stat	st;
+	int		ret;
+
+	if ((z = zip_new(a_fd, a_blksize, a_method)) == NULL) {
+		return (NULL);
+	}
+
+	(void) memcpy(z->cz_buf, a_buf, a_len);
+	z->cz_len = a_len;
+
+	/* reads past the archive can be given back to regular files */
+
+	z->cz_seek = (fstat(a_fd, &st) == 0) && S_ISREG(st.st_mode) &&
+		(lseek(a_fd, (off_t)0, SEEK_CUR) >= 0);
+
+	switch (a_method) {
+	    case ZIP_GZIP:
+		if ((ret = inflateInit2(&z->cz_zs, ZIP_GZIPBITS)) != Z_OK) {
+			seterr(pkg_gt(ERR_CPIO_UNZIP), zError(ret));
+			zipClose(z);
+			return (NULL);
+		}
+		z->cz_zsinit = 1;
+		break;
+
+	    case ZIP_ZSTD:
+#ifdef	USE_ZSTD
+		if ((z->cz_zd = ZSTD_createDCtx()) == NULL) {
+			seterr(pkg_gt(ERR_MEM));
+			zipClose(z);
+			return (NULL);
+		}
+		break;
+#else
+		seterr(pkg_gt(ERR_CPIO_NOZSTD));
+		zipClose(z);
+		return (NULL);
+#endif
+
+	    default:
+		seterr(pkg_gt(ERR_CPIO_HEADER));
+		zipClose(z);
+		return (NULL);
+	}
+
+	return (z);
+}
+
+/*
+ * Name:	zipOpenWrite
+ * Description:	Start writing a compressed archive to a file descriptor
+ * Arguments:	a_fd - (int) - [RO]
+ *			File descriptor to write the archive to
+ *		a_blksize - (size_t) - [RO]
+ *			Block size of the datastream
+ *		a_record - (int) - [RO]
+ *			!= 0 to write each block with a write of its own
+ *		a_method - (int) - [RO]
+ *			Compression method, ZIP_GZIP or ZIP_ZSTD
+ *		a_level - (int) - [RO]
+ *			Compression level; if <= 0 the default level of the
+ *			method is used
+ *		a_nthreads - (int) - [RO]
+ *			Number of threads to compress on; if <= 0 one thread
+ *			for each online processor is used
+ * Returns:	CPIOZIP_T *
+ *			!= NULL - the archive to pass to zipWrite()
+ *			== NULL - the archive cannot be written; use
+ *			  getErrstr() to retrieve a character-string
+ *			  describing the reason for failure
+ */
+
+CPIOZIP_T *
+zipOpenWrite(int a_fd, size_t a_blksize, int a_record, int a_method,
+	int a_level, int a_nthreads)
+{
+	CPIOZIP_T	*z;
+	int		i;
+
+	if (a_nthreads <= 0) {
+		long	ncpu;
+
+		ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+		a_nthreads = (ncpu > 0) ? (int)ncpu : 1;
+	}
+
+	if ((z = zip_new(a_fd, a_blksize, a_method)) == NULL) {
+		return (NULL);
+	}
+
+	z->cz_write = 1;
+	z->cz_record = a_record;
+
+	switch (a_method) {
+	    case ZIP_GZIP:
+		if (a_level > Z_BEST_COMPRESSION) {
+			seterr(pkg_gt(ERR_CPIO_LEVEL), a_level);
+			zipClose(z);
+			return (NULL);
+		}
+
+		z->cz_chunks = calloc(a_nthreads, sizeof (struct zipchunk));
+		if (z->cz_chunks == NULL) {
+			seterr(pkg_gt(ERR_MEM));
+			zipClose(z);
+			return (NULL);
+		}
+		z->cz_nchunks = a_nthreads;
+
+		for (i = 0; i < a_nthreads; i++) {
+			struct zipchunk	*zc = &z->cz_chunks[i];
+
+			zc->zc_level = (a_level > 0) ?
+				a_level : Z_DEFAULT_COMPRESSION;
+			zc->zc_outsize = compressBound(ZIP_CHUNK) +
+				ZIP_GZIPWRAP;
+			zc->zc_in = malloc(ZIP_CHUNK);
+			zc->zc_out = malloc(zc->zc_outsize);
+			if ((zc->zc_in == NULL) || (zc->zc_out == NULL)) {
+				seterr(pkg_gt(ERR_MEM));
+				zipClose(z);
+				return (NULL);
+			}
+		}
+		break;
+
+	    case ZIP_ZSTD:
+#ifdef	USE_ZSTD
+		if (a_level > ZSTD_maxCLevel()) {
+			seterr(pkg_gt(ERR_CPIO_LEVEL), a_level);
+			zipClose(z);
+			return (NULL);
+		}
+
+		z->cz_zbufsize = ZSTD_CStreamOutSize();
+		z->cz_zbuf = malloc(z->cz_zbufsize);
+		z->cz_zc = ZSTD_createCCtx();
+		if ((z->cz_zbuf == NULL) || (z->cz_zc == NULL)) {
+			seterr(pkg_gt(ERR_MEM));
+			zipClose(z);
+			return (NULL);
+		}
+
+		(void) ZSTD_CCtx_setParameter(z->cz_zc,
+			ZSTD_c_compressionLevel,
+			(a_level > 0) ? a_level : ZSTD_CLEVEL_DEFAULT);
+
+		/* checked on reading, like the CRC of gzip members */
+
+		(void) ZSTD_CCtx_setParameter(z->cz_zc, ZSTD_c_checksumFlag, 1);
+
+		/* a zstd library built without threads ignores this */
+
+		if (a_nthreads > 1) {
+			(void) ZSTD_CCtx_setParameter(z->cz_zc,
+				ZSTD_c_nbWorkers, a_nthreads);
+		}
+		break;
+#else
+		seterr(pkg_gt(ERR_CPIO_NOZSTD));
+		zipClose(z);
+		return (NULL);
+#endif
+
+	    default:
+		seterr(pkg_gt(ERR_CPIO_HEADER));
+		zipClose(z);
+		return (NULL);
+	}
+
+	return (z);
+}
+
+/*
+ * Name:	zipRead
+ * Description:	Read decompressed data from a compressed archive
+ * Arguments:	a_zip - (CPIOZIP_T *) - [RO, *RW]
+ *			Archive being read
+ *		a_buf - (char *) - [RO, *RW]
+ *			Buffer to read the data into
+ *		a_len - (size_t) - [RO]
+ *			Maximum number of bytes to read
+ * Returns:	ssize_t
+ *			> 0 - number of bytes read
+ *			== 0 - the compressed data ends before the archive
+ *			< 0 - the archive could not be read; use getErrstr()
+ *			  to retrieve a character-string describing the
+ *			  reason for failure
+ */
+
+ssize_t
+zipRead(CPIOZIP_T *a_zip, char *a_buf, size_t a_len)
+{
+	CPIOZIP_T	*z = a_zip;
+	ssize_t		n;
+
+	for (;;) {
+		if (z->cz_end && (zr_member(z) != 0)) {
+			return (-1);
+		}
+
+		if (z->cz_pos == z->cz_len) {
+			if ((n = zr_fill(z)) <= 0) {
+				return (n);
+			}
+		}
+
+		/* headers and trailers are consumed without output */
+
+		if ((n = zr_decode(z, a_buf, a_len)) != 0) {
+			return (n);
+		}
+	}
+	/*NOTREACHED*/
+}
+
+/*
+ * Name:	zipWrite
+ * Description:	Compress data and write it to a compressed archive
+ * Arguments:	a_zip - (CPIOZIP_T *) - [RO, *RW]
+ *			Archive being written
+ *		a_buf - (char *) - [RO, *RO]
+ *			Data to write
+ *		a_len - (size_t) - [RO]
+ *			Number of bytes to write
+ * Returns:	int
+ *			== 0 - the data was written or is buffered
+ *			< 0 - the data could not be compressed or written;
+ *			  use getErrstr() to retrieve a character-string
+ *			  describing the reason for failure
+ */
+
+int
+zipWrite(CPIOZIP_T *a_zip, char *a_buf, size_t a_len)
+{
+	CPIOZIP_T	*z = a_zip;
+	struct zipchunk	*zc;
+	size_t		n;
+
+#ifdef	USE_ZSTD
+	if (z->cz_method == ZIP_ZSTD) {
+		return (zw_zstd(z, a_buf, a_len, ZSTD_e_continue));
+	}
+#endif
+
+	/* compress the chunks once there is one for each thread */
+
+	while (a_len > 0) {
+		zc = &z->cz_chunks[z->cz_nfull];
+		n = ZIP_CHUNK - zc->zc_inlen;
+		if (n > a_len) {
+			n = a_len;
+		}
+		(void) memcpy(zc->zc_in + zc->zc_inlen, a_buf, n);
+		zc->zc_inlen += n;
+		a_buf += n;
+		a_len -= n;
+
+		if ((zc->zc_inlen == ZIP_CHUNK) &&
+				(++z->cz_nfull == z->cz_nchunks) &&
+				(zw_chunks(z, z->cz_nfull) != 0)) {
+			return (-1);
+		}
+	}
+
+	return (0);
+}
+
+/*
+ * Name:	zipFinish
+ * Description:	Read or write the end of a compressed archive. When reading,
+ *		the compressed data must end along with the archive; the file
+ *		descriptor is left at the block that follows it. When writing,
+ *		the rest of the data is compressed and the compressed data is
+ *		padded to the next block.
+ * Arguments:	a_zip - (CPIOZIP_T *) - [RO, *RW]
+ *			Archive being read or written; all of the archive
+ *			must have been read or written
+ * Returns:	int
+ *			== 0 - the end of the archive was read or written
+ *			< 0 - it could not be read or written; use getErrstr()
+ *			  to retrieve a character-string describing the
+ *			  reason for failure
+ */
+
+int
+zipFinish(CPIOZIP_T *a_zip)
+{
+	CPIOZIP_T	*z = a_zip;
+	char		data[BLK_SIZE];
+	off_t		end;
+	ssize_t		n;
+
+	if (z->cz_write) {
+		static char	zeros[BLK_SIZE];
+
+		if (z->cz_method == ZIP_GZIP) {
+			n = z->cz_nfull +
+				(z->cz_chunks[z->cz_nfull].zc_inlen > 0);
+			if ((n > 0) && (zw_chunks(z, n) != 0)) {
+				return (-1);
+			}
+		}
+#ifdef	USE_ZSTD
+		if ((z->cz_method == ZIP_ZSTD) &&
+				(zw_zstd(z, NULL, 0, ZSTD_e_end) != 0)) {
+			return (-1);
+		}
+#endif
+
+		end = z->cz_base + z->cz_len;
+		n = (z->cz_blksize - end % z->cz_blksize) % z->cz_blksize;
+		while (n > 0) {
+			size_t	len = (n > sizeof (zeros)) ?
+				sizeof (zeros) : n;
+
+			if (zw_put(z, zeros, len) != 0) {
+				return (-1);
+			}
+			n -= len;
+		}
+
+		return (zw_flush(z, z->cz_len));
+	}
+
+	/* no data may follow the archive in the compressed data */
+
+	while (!z->cz_end) {
+		if (z->cz_pos == z->cz_len) {
+			if ((n = zr_fill(z)) <= 0) {
+				if (n == 0) {
+					seterr(pkg_gt(ERR_CPIO_EOF));
+				}
+				return (-1);
+			}
+		}
+		if ((n = zr_decode(z, data, sizeof (data))) != 0) {
+			if (n > 0) {
+				seterr(pkg_gt(ERR_CPIO_ZIPEND));
+			}
+			return (-1);
+		}
+	}
+
+	/* skip the padding, give back what was read beyond it */
+
+	end = z->cz_base + z->cz_pos;
+	end += (z->cz_blksize - end % z->cz_blksize) % z->cz_blksize;
+
+	while (z->cz_base + z->cz_len < end) {
+		z->cz_pos = z->cz_len;
+		if ((n = zr_fill(z)) <= 0) {
+			if (n == 0) {
+				seterr(pkg_gt(ERR_CPIO_EOF));
+			}
+			return (-1);
+		}
+	}
+
+	if ((z->cz_base + z->cz_len > end) &&
+			(lseek(z->cz_fd, end - (z->cz_base + z->cz_len),
+			SEEK_CUR) < 0)) {
+		seterr(pkg_gt(ERR_CPIO_READ), errno, strerror(errno));
+		return (-1);
+	}
+
+	z->cz_base = end;
+	z->cz_len = 0;
+	z->cz_pos = 0;
+
+	return (0);
+}
+
+/*
+ * Name:	zipClose
+ * Description:	Release a compressed archive; the file descriptor it was
+ *		read from or written to is not closed
+ * Arguments:	a_zip - (CPIOZIP_T *) - [RO, *RW]
+ *			Archive to release
+ * Returns:	void
+ */
+
+void
+zipClose(CPIOZIP_T *a_zip)
+{
+	int	i;
+
+	if (a_zip == NULL) {
+		return;
+	}
+
+	if (a_zip->cz_zsinit) {
+		(void) inflateEnd(&a_zip->cz_zs);
+	}
+
+	if (a_zip->cz_chunks != NULL) {
+		for (i = 0; i < a_zip->cz_nchunks; i++) {
+			free(a_zip->cz_chunks[i].zc_in);
+			free(a_zip->cz_chunks[i].zc_out);
+		}
+		free(a_zip->cz_chunks);
+	}
+
+#ifdef	USE_ZSTD
+	(void) ZSTD_freeDCtx(a_zip->cz_zd);
+	(void) ZSTD_freeCCtx(a_zip->cz_zc);
+	free(a_zip->cz_zbuf);
+#endif
+
+	free(a_zip->cz_buf);
+	free(a_zip);
+}
+
+/*
+ * Private methods
+ */
+
+/* allocate a compressed archive and its buffer */
+
+static CPIOZIP_T *
+zip_new(int a_fd, size_t a_blksize, int a_method)
+{
+	CPIOZIP_T	*z;
+
+	if ((z = calloc(1, sizeof (CPIOZIP_T))) == NULL) {
+		seterr(pkg_gt(ERR_MEM));
+		return (NULL);
+	}
+
+	z->cz_fd = a_fd;
+	z->cz_blksize = (a_blksize > 0) ? a_blksize : BLK_SIZE;
+	z->cz_method = a_method;
+	z->cz_bufsize = z->cz_blksize;
+	while (z->cz_bufsize < ZIP_IOSIZE) {
+		z->cz_bufsize += z->cz_blksize;
+	}
+
+	/* room for a block more, see zr_fill() */
+
+	if ((z->cz_buf = malloc(z->cz_bufsize + z->cz_blksize)) == NULL) {
+		seterr(pkg_gt(ERR_MEM));
+		free(z);
+		return (NULL);
+	}
+
+	return (z);
+}
+
+/*
+ * Name:	zr_fill
+ * Description:	read more compressed data into the buffer, after the bytes
+ *		not yet decompressed; unless the read can be given back, no
+ *		more than the rest of the current block is read
+ * Arguments:	z - (CPIOZIP_T *) - [RO, *RW]
+ *			Archive being read
+ * Returns:	int - > 0 if data was read, == 0 at the end of the file,
+ *			< 0 if the data could not be read
+ */
+
+static int
+zr_fill(CPIOZIP_T *z)
+{
+	size_t	len;
+	ssize_t	n;
+
+	if (z->cz_pos > 0) {
+		(void) memmove(z->cz_buf, z->cz_buf + z->cz_pos,
+			z->cz_len - z->cz_pos);
+		z->cz_base += z->cz_pos;
+		z->cz_len -= z->cz_pos;
+		z->cz_pos = 0;
+	}
+
+	if (z->cz_seek && (z->cz_len < z->cz_bufsize)) {
+		len = z->cz_bufsize - z->cz_len;
+	} else {
+		len = z->cz_blksize -
+			(size_t)((z->cz_base + z->cz_len) % z->cz_blksize);
+	}
+
+	while ((n = read(z->cz_fd, z->cz_buf + z->cz_len, len)) < 0) {
+		if (errno != EINTR) {
+			seterr(pkg_gt(ERR_CPIO_READ), errno, strerror(errno));
+			return (-1);
+		}
+	}
+
+	z->cz_len += n;
+
+	return (n > 0);
+}
+
+/*
+ * Name:	zr_decode
+ * Description:	decompress the buffered compressed data, up to the end of
+ *		the current gzip member or zstd frame
+ * Arguments:	z - (CPIOZIP_T *) - [RO, *RW]
+ *			Archive being read
+ *		a_buf - (char *) - [RO, *RW]
+ *			Buffer to decompress into
+ *		a_len - (size_t) - [RO]
+ *			Size of the buffer
+ * Returns:	ssize_t - number of bytes decompressed, < 0 if the data
+ *			could not be decompressed
+ */
+
+static ssize_t
+zr_decode(CPIOZIP_T *z, char *a_buf, size_t a_len)
+{
+	size_t	in = z->cz_len - z->cz_pos;
+	int	ret;
+
+#ifdef	USE_ZSTD
+	if (z->cz_method == ZIP_ZSTD) {
+		ZSTD_inBuffer	zin;
+		ZSTD_outBuffer	zout;
+		size_t		zret;
+
+		zin.src = z->cz_buf + z->cz_pos;
+		zin.size = in;
+		zin.pos = 0;
+		zout.dst = a_buf;
+		zout.size = a_len;
+		zout.pos = 0;
+
+		zret = ZSTD_decompressStream(z->cz_zd, &zout, &zin);
+		z->cz_pos += zin.pos;
+		if (ZSTD_isError(zret)) {
+			seterr(pkg_gt(ERR_CPIO_UNZIP),
+				ZSTD_getErrorName(zret));
+			return (-1);
+		}
+		if (zret == 0) {
+			z->cz_end = 1;
+		}
+		return ((ssize_t)zout.pos);
+	}
+#endif
+
+	z->cz_zs.next_in = (Bytef *)z->cz_buf + z->cz_pos;
+	z->cz_zs.avail_in = (uInt)in;
+	z->cz_zs.next_out = (Bytef *)a_buf;
+	z->cz_zs.avail_out = (uInt)a_len;
+
+	ret = inflate(&z->cz_zs, Z_NO_FLUSH);
+	z->cz_pos += in - z->cz_zs.avail_in;
+	if (ret == Z_STREAM_END) {
+		z->cz_end = 1;
+	} else if ((ret != Z_OK) && (ret != Z_BUF_ERROR)) {
+		seterr(pkg_gt(ERR_CPIO_UNZIP), (z->cz_zs.msg != NULL) ?
+			z->cz_zs.msg : zError(ret));
+		return (-1);
+	}
+
+	return ((ssize_t)(a_len - z->cz_zs.avail_out));
+}
+
+/*
+ * Name:	zr_member
+ * Description:	start decompressing the gzip member or zstd frame that
+ *		follows the one that ended, as the archive is not over yet
+ * Arguments:	z - (CPIOZIP_T *) - [RO, *RW]
+ *			Archive being read
+ * Returns:	int - == 0 if the next member or frame follows, < 0 if the
+ *			compressed data ends or is followed by other data
+ */
+
+static int
+zr_member(CPIOZIP_T *z)
+{
+	int	n;
+
+	while (z->cz_len - z->cz_pos < ZIP_MAGICLEN) {
+		if ((n = zr_fill(z)) <= 0) {
+			if (n == 0) {
+				seterr(pkg_gt(ERR_CPIO_EOF));
+			}
+			return (-1);
+		}
+	}
+
+	if (zipMethod(z->cz_buf + z->cz_pos, z->cz_len - z->cz_pos) !=
+			z->cz_method) {
+		seterr(pkg_gt(ERR_CPIO_EOF));
+		return (-1);
+	}
+
+#ifdef	USE_ZSTD
+	if (z->cz_method == ZIP_ZSTD) {
+		(void) ZSTD_DCtx_reset(z->cz_zd, ZSTD_reset_session_only);
+	}
+#endif
+	if (z->cz_method == ZIP_GZIP) {
+		(void) inflateReset(&z->cz_zs);
+	}
+	z->cz_end = 0;
+
+	return (0);
+}
+
+/*
+ * Name:	zw_chunks
+ * Description:	compress the first chunks of a gzip archive into gzip
+ *		members, each on a thread of its own, and write them out in
+ *		order; the chunks are empty afterwards
+ * Arguments:	z - (CPIOZIP_T *) - [RO, *RW]
+ *			Archive being written
+ *		a_n - (int) - [RO]
+ *			Number of chunks to compress
+ * Returns:	int - == 0 if the chunks were written, < 0 otherwise
+ */
+
+static int
+zw_chunks(CPIOZIP_T *z, int a_n)
+{
+	struct zipchunk	*zc = z->cz_chunks;
+	int		result = 0;
+	int		i;
+
+	/* the first chunk is compressed on this thread */
+
+	for (i = 1; i < a_n; i++) {
+		if (pthread_create(&zc[i].zc_tid, NULL, zw_deflate,
+				&zc[i]) == 0) {
+			zc[i].zc_thread = 1;
+		}
+	}
+
+	for (i = 0; i < a_n; i++) {
+		if (zc[i].zc_thread == 0) {
+			(void) zw_deflate(&zc[i]);
+		} else {
+			(void) pthread_join(zc[i].zc_tid, NULL);
+			zc[i].zc_thread = 0;
+		}
+	}
+
+	for (i = 0; i < a_n; i++) {
+		if ((result == 0) && (zc[i].zc_msg != NULL)) {
+			seterr(pkg_gt(ERR_CPIO_ZIP), zc[i].zc_msg);
+			result = -1;
+		}
+		if (result == 0) {
+			result = zw_put(z, zc[i].zc_out, zc[i].zc_outlen);
+		}
+		zc[i].zc_inlen = 0;
+	}
+
+	z->cz_nfull = 0;
+
+	return (result);
+}
+
+/*
+ * Name:	zw_deflate
+ * Description:	compress a chunk of a gzip archive into a gzip member
+ * Arguments:	a_chunk - (struct zipchunk *) - [RO, *RW]
+ *			Chunk to compress
+ * Returns:	void * - NULL
+ */
+
+static void *
+zw_deflate(void *a_chunk)
+{
+	struct zipchunk	*zc = (struct zipchunk *)a_chunk;
+	z_stream	zs;
+	int		ret;
+
+	(void) memset(&zs, 0, sizeof (zs));
+	zc->zc_msg = NULL;
+	zc->zc_outlen = 0;
+
+	ret = deflateInit2(&zs, zc->zc_level, Z_DEFLATED, ZIP_GZIPBITS,
+		8, Z_DEFAULT_STRATEGY);
+	if (ret != Z_OK) {
+		zc->zc_msg = (char *)zError(ret);
+		return (NULL);
+	}
+
+	zs.next_in = (Bytef *)zc->zc_in;
+	zs.avail_in = (uInt)zc->zc_inlen;
+	zs.next_out = (Bytef *)zc->zc_out;
+	zs.avail_out = (uInt)zc->zc_outsize;
+
+	if ((ret = deflate(&zs, Z_FINISH)) == Z_STREAM_END) {
+		zc->zc_outlen = zc->zc_outsize - zs.avail_out;
+	} else {
+		zc->zc_msg = (zs.msg != NULL) ? zs.msg : (char *)zError(ret);
+	}
+
+	(void) deflateEnd(&zs);
+
+	return (NULL);
+}
+
+#ifdef	USE_ZSTD
+/*
+ * Name:	zw_zstd
+ * Description:	pass data to the compressor of a zstd archive and write
+ *		out what it returns
+ * Arguments:	z - (CPIOZIP_T *) - [RO, *RW]
+ *			Archive being written
+ *		a_buf - (char *) - [RO, *RO]
+ *			Data to compress
+ *		a_len - (size_t) - [RO]
+ *			Number of bytes to compress
+ *		a_op - (ZSTD_EndDirective) - [RO]
+ *			ZSTD_e_continue, or ZSTD_e_end to end the frame
+ * Returns:	int - == 0 if the data was compressed, < 0 otherwise
+ */
+
+static int
+zw_zstd(CPIOZIP_T *z, char *a_buf, size_t a_len, ZSTD_EndDirective a_op)
+{
+	ZSTD_inBuffer	zin;
+	ZSTD_outBuffer	zout;
+	size_t		zret;
+
+	zin.src = a_buf;
+	zin.size = a_len;
+	zin.pos = 0;
+
+	do {
+		zout.dst = z->cz_zbuf;
+		zout.size = z->cz_zbufsize;
+		zout.pos = 0;
+
+		zret = ZSTD_compressStream2(z->cz_zc, &zout, &zin, a_op);
+		if (ZSTD_isError(zret)) {
+			seterr(pkg_gt(ERR_CPIO_ZIP), ZSTD_getErrorName(zret));
+			return (-1);
+		}
+		if (zw_put(z, z->cz_zbuf, zout.pos) != 0) {
+			return (-1);
+		}
+	} while ((a_op == ZSTD_e_end) ? (zret != 0) : (zin.pos < zin.size));
+
+	return (0);
+}
+#endif	/* USE_ZSTD */
+
+/* append compressed data to the buffer, write out full buffers */
+
+static int
+zw_put(CPIOZIP_T *z, char *a_data, size_t a_len)
+{
+	size_t	n;
+
+	while (a_len > 0) {
+		if ((z->cz_len == z->cz_bufsize) &&
+				(zw_flush(z, z->cz_len) != 0)) {
+			return (-1);
+		}
+		n = z->cz_bufsize - z->cz_len;
+		if (n > a_len) {
+			n = a_len;
+		}
+		(void) memcpy(z->cz_buf + z->cz_len, a_data, n);
+		z->cz_len += n;
+		a_data += n;
+		a_len -= n;
+	}
+
+	return (0);
+}
+
+/*
+ * Name:	zw_flush
+ * Description:	write the first bytes of the buffer out
+ * Arguments:	z - (CPIOZIP_T *) - [RO, *RW]
+ *			Archive being written
+ *		a_len - (size_t) - [RO]
+ *			Number of bytes to write; a multiple of the block size
+ * Returns:	int - == 0 if the bytes were written, < 0 otherwise
+ */
+
+static int
+zw_flush(CPIOZIP_T *z, size_t a_len)
+{
+	size_t	done = 0;
+	size_t	len;
+	ssize_t	n;
+
+	while (done < a_len) {
+		len = z->cz_record ? z->cz_blksize : a_len - done;
+		n = write(z->cz_fd, z->cz_buf + done, len);
+		if ((n < 0) && (errno == EINTR)) {
+			continue;
+		}
+		if (n <= 0) {
+			if (n == 0) {
+				errno = ENOSPC;
+			}
+			seterr(pkg_gt(ERR_CPIO_OUT), errno, strerror(errno));
+			return (-1);
+		}
+		done += n;
+	}
+
+	(void) memmove(z->cz_buf, z->cz_buf + a_len, z->cz_len - a_len);
+	z->cz_len -= a_len;
+	z->cz_base += a_len;
+
+	return (0);
+}
+
+/* format the reason of a failure for getErrstr() */
+
+/*PRINTFLIKE1*/
+static void
+seterr(char *a_fmt, ...)
+{
+	va_list	ap;
+
+	va_start(ap, a_fmt);
+	(void) vsnprintf(errbuf, sizeof (errbuf), a_fmt, ap);
+	va_end(ap);
+
+	setErrstr(errbuf);
+}
@@ -0,0 +1,63 @@
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at src/OPENSOLARIS.LICENSE
+ * or http://www.opensolaris.org/os/licensing.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+#ifndef	_CPIOZIP_H
+#define	_CPIOZIP_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <sys/types.h>
+
+/*
+ * Compressed cpio archives of a package datastream (see cpiozip.c).
+ *
+ * A compressed archive is a gzip or zstd compressed cpio archive that is
+ * padded with null bytes to a multiple of the datastream block size, so
+ * the next archive of the datastream starts at a block boundary as usual.
+ * The compression method is told by the first bytes of the archive.
+ */
+
+#define	ZIP_NONE	0	/* not compressed */
+#define	ZIP_GZIP	1	/* one or more gzip members */
+#define	ZIP_ZSTD	2	/* one or more zstd frames */
+
+#define	ZIP_MAGICLEN	4	/* bytes needed by zipMethod() */
+
+typedef struct cpiozip	CPIOZIP_T;
+
+extern int		zipMethod(char *a_buf, size_t a_len);
+extern CPIOZIP_T	*zipOpenRead(int a_fd, size_t a_blksize, int a_method,
+				char *a_buf, size_t a_len);
+extern CPIOZIP_T	*zipOpenWrite(int a_fd, size_t a_blksize,
+				int a_record, int a_method, int a_level,
+				int a_nthreads);
+extern ssize_t		zipRead(CPIOZIP_T *a_zip, char *a_buf, size_t a_len);
+extern int		zipWrite(CPIOZIP_T *a_zip, char *a_buf, size_t a_len);
+extern int		zipFinish(CPIOZIP_T *a_zip);
+extern void		zipClose(CPIOZIP_T *a_zip);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _CPIOZIP_H */
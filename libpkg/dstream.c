@@ -64,10 +64,8 @@
 extern int	pkgnmchk(register char *pkg, register char *spec,
 				int presvr4flg);
 
-#define	CMDSIZ	512
 #define	LSIZE	128
 #define	DDPROC		BINDIR "/dd"
-#define	CPIOPROC	BINDIR "/cpio"
 
 struct dstoc {
 	int	cnt;
@@ -103,6 +101,19 @@ static int	ds_skippart; 	/* number of parts skipped in current volume */
 static int	ds_getnextvol(char *device);
 static int	ds_skip(char *device, int nskip);
 
+/*
+ * part of a package whose objects are installed straight from the
+ * datastream, see ds_nextstream()
+ */
+static CPIO_T	*ds_cpio;
+static char	ds_cpiodir[PATH_MAX];	/* directory the part is unpacked in */
+static char	*ds_cpioname;		/* current member, NULL if none */
+static struct stat	ds_cpiost;	/* status of current member */
+
+static int	ds_cpionext(void);
+static int	ds_cpiostage(void);
+static char	*ds_cpiomember(char *name);
+
 void
 ds_order(char *list[])
 {
@@ -278,7 +289,7 @@ ds_init(char *device, char **pkg, char *norewind)
 {
 	struct dstoc *tail, *toc_pt;
 	char	*ret;
-	char	cmd[CMDSIZ];
+	char	**pats;
 	char	line[LSIZE+1];
 	int	i, n, count = 0, header_size = BLK_SIZE;
 
@@ -447,32 +458,46 @@ ds_init(char *device, char **pkg, char *norewind)
 		(void) free(ds_header);
 		return (-1);
 	}
-	/* this could break, thanks to cpio command limit */
-	(void) sprintf(cmd, "%s -icdumD -C %d", CPIOPROC, (int)BLK_SIZE);
+	/*
+	 * extract pkginfo and pkgmap of the packages asked for and the
+	 * signature, if present; if we are extracting all packages
+	 * (pkgs == NULL), everything including the signature is extracted
+	 */
+	for (n = 0; pkg[n]; n++)
+		;
+	if ((pats = (char **)calloc(n + 2, sizeof (char *))) == NULL) {
+		progerr(pkg_gt(ERR_UNPACK));
+		logerr(pkg_gt(MSG_MEM));
+		(void) free(ds_header);
+		return (-1);
+	}
 	n = 0;
 	for (i = 0; pkg[i]; i++) {
 		if (strcmp(pkg[i], "all") == 0)
 			continue;
-		if (n == 0) {
-			strcat(cmd, " ");
-			n = 1;
+		if ((pats[n] = malloc(strlen(pkg[i]) + 3)) == NULL) {
+			progerr(pkg_gt(ERR_UNPACK));
+			logerr(pkg_gt(MSG_MEM));
+			while (n > 0)
+				free(pats[--n]);
+			free(pats);
+			(void) free(ds_header);
+			return (-1);
 		}
-		strlcat(cmd, pkg[i], CMDSIZ);
-		strlcat(cmd, "'/*' ", CMDSIZ);
-
-		/* extract signature too, if present. */
-		strlcat(cmd, SIGNATURE_FILENAME, CMDSIZ);
-		strlcat(cmd, " ", CMDSIZ);
+		(void) sprintf(pats[n++], "%s/*", pkg[i]);
 	}
+	if (n > 0)
+		pats[n] = SIGNATURE_FILENAME;
 
-	/*
-	 * if we are extracting all packages (pkgs == NULL),
-	 * signature will automatically be extracted
-	 */
-	if (n = esystem(cmd, ds_fd, -1)) {
-		rpterr();
+	i = cpioExtract(ds_fd, BLK_SIZE, pats, 0);
+
+	while (n > 0)
+		free(pats[--n]);
+	free(pats);
+
+	if (i != 0) {
 		progerr(pkg_gt(ERR_UNPACK));
-		logerr(pkg_gt(MSG_CMDFAIL), cmd, n);
+		logerr(pkg_gt(MSG_CPIOFAIL), getErrstr());
 		(void) free(ds_header);
 		return (-1);
 	}
@@ -603,17 +628,13 @@ ds_getnextvol(char *device)
 static int
 ds_skip(char *device, int nskip)
 {
-	char	cmd[CMDSIZ];
 	int	n, onskip = nskip;
 
 	while (nskip--) {
 		/* skip this one */
-		(void) sprintf(cmd, "%s -ictD -C %d > /dev/null",
-		    CPIOPROC, (int)BLK_SIZE);
-		if (n = esystem(cmd, ds_fd, -1)) {
-			rpterr();
+		if (n = cpioExtract(ds_fd, BLK_SIZE, NULL, CPIO_SKIP)) {
 			progerr(pkg_gt(ERR_UNPACK));
-			logerr(pkg_gt(MSG_CMDFAIL), cmd, n);
+			logerr(pkg_gt(MSG_CPIOFAIL), getErrstr());
 			nskip = onskip;
 			if (ds_volno == 1 || ds_volpart > 0)
 				return (n);
@@ -631,6 +652,17 @@ ds_skip(char *device, int nskip)
 void
 ds_skiptoend(char *device)
 {
+	char	*name;
+
+	/* the rest of a part being streamed is not needed anymore */
+	if (ds_cpio) {
+		while (cpioNext(ds_cpio, &name, NULL) > 0)
+			;
+		cpioClose(ds_cpio);
+		ds_cpio = NULL;
+		ds_cpioname = NULL;
+	}
+
 	if (ds_read < ds_nparts && ds_curpartcnt < 0)
 		(void) ds_skip(device, ds_nparts - ds_read);
 }
@@ -638,7 +670,7 @@ ds_skiptoend(char *device)
 int
 ds_next(char *device, char *instdir)
 {
-	char	cmd[CMDSIZ], tmpvol[128];
+	char	tmpvol[128];
 	int	nparts, n, index;
 
 	/*CONSTCOND*/
@@ -651,12 +683,9 @@ ds_next(char *device, char *instdir)
 			(void) strcpy(ds_volnos, tmpvol);
 			ds_curpartcnt += index;
 		}
-		(void) sprintf(cmd, "%s -icdumD -C %d",
-		    CPIOPROC, (int)BLK_SIZE);
-		if (n = esystem(cmd, ds_fd, -1)) {
-			rpterr();
+		if (n = cpioExtract(ds_fd, BLK_SIZE, NULL, 0)) {
 			progerr(pkg_gt(ERR_UNPACK));
-			logerr(pkg_gt(MSG_CMDFAIL), cmd, n);
+			logerr(pkg_gt(MSG_CPIOFAIL), getErrstr());
 		}
 		if (ds_read == 0)
 			nparts = 0;
@@ -679,6 +708,207 @@ ds_next(char *device, char *instdir)
 	/*NOTREACHED*/
 }
 
+/*
+ * Name:		ds_nextstream
+ * Description:	Read in the next part of the package like ds_next(), but
+ *		leave the package objects (the files below the reloc and
+ *		root directories) in the datastream: only the package
+ *		information files and the directories are unpacked, so the
+ *		objects can be installed straight from the datastream in
+ *		the order they are needed; see ds_fetch(). Parts that are
+ *		not the only part of their package, or that need a new
+ *		volume, are unpacked with ds_next().
+ *
+ * Arguments:	device - datastream device
+ *		instdir - directory the part is unpacked in
+ *
+ * Returns :	zero - the part was read in
+ *		non-zero - some failure occurred.
+ */
+int
+ds_nextstream(char *device, char *instdir)
+{
+	char	path[PATH_MAX];
+	char	*name;
+	int	n;
+
+	if (ds_read != 0 || ds_toc == NULL || ds_nparts != 1 ||
+	    ds_curpartcnt == 0 || ds_cpio)
+		return (ds_next(device, instdir));
+
+	if ((ds_cpio = cpioOpen(ds_fd, BLK_SIZE)) == NULL) {
+		progerr(pkg_gt(ERR_UNPACK));
+		logerr(pkg_gt(MSG_CPIOFAIL), getErrstr());
+		return (-1);
+	}
+	(void) strlcpy(ds_cpiodir, instdir, sizeof (ds_cpiodir));
+
+	/* unpack everything up to the first package object */
+	while ((n = ds_cpionext()) == 0 && ds_cpio) {
+		name = ds_cpiomember(ds_cpioname);
+		if (!S_ISDIR(ds_cpiost.st_mode) &&
+		    (strncmp(name, "reloc/", 6) == 0 ||
+		    strncmp(name, "root/", 5) == 0)) {
+			/* the directory of the objects is looked for */
+			(void) snprintf(path, sizeof (path), "%s/%.*s",
+			    instdir, (int)strcspn(name, "/"), name);
+			(void) mkdir(path, 0755);
+			break;
+		}
+		if (n = ds_cpiostage())
+			break;
+	}
+
+	if (n || (n = ckvolseq(instdir, ds_read + 1, 0))) {
+		if (ds_cpio) {
+			cpioClose(ds_cpio);
+			ds_cpio = NULL;
+			ds_cpioname = NULL;
+		}
+		return (-1);
+	}
+	ds_read++;
+	ds_totread++;
+	ds_volpart++;
+
+	return (0);
+}
+
+/*
+ * Name:		ds_fetch
+ * Description:	Make a package object of the part read in by
+ *		ds_nextstream() available: the datastream is read up to the
+ *		object, and the members before it are unpacked. A regular
+ *		file can be left in the datastream for the caller to copy
+ *		its data straight to where it is installed.
+ *
+ * Arguments:	a_path - path the object is unpacked to, below the
+ *			directory passed to ds_nextstream()
+ *		r_cpio - if not NULL and the object is a regular file with
+ *			a single link, set to the archive positioned at the
+ *			data of the file; the data must be consumed with
+ *			cpioCopy() before ds_fetch() is called again, or it
+ *			is lost. If NULL the object is always unpacked.
+ *		r_st - status of the file, if *r_cpio is set
+ *
+ * Returns :	1 - *r_cpio is positioned at the data of the object
+ *		0 - the object is unpacked at a_path, or is not in the
+ *		    part being streamed
+ *		-1 - the datastream could not be read or the object could
+ *		    not be unpacked
+ */
+int
+ds_fetch(char *a_path, CPIO_T **r_cpio, struct stat *r_st)
+{
+	size_t	len;
+	char	*name;
+	int	match;
+
+	if (ds_cpio == NULL)
+		return (0);
+
+	/* objects already unpacked stay where they are */
+	len = strlen(ds_cpiodir);
+	if (strncmp(a_path, ds_cpiodir, len) != 0 || a_path[len] != '/' ||
+	    access(a_path, F_OK) == 0)
+		return (0);
+	name = a_path + len + 1;
+
+	while (ds_cpio) {
+		if (ds_cpioname == NULL) {
+			if (ds_cpionext())
+				return (-1);
+			continue;
+		}
+		match = (strcmp(ds_cpiomember(ds_cpioname), name) == 0);
+		if (match && r_cpio && S_ISREG(ds_cpiost.st_mode) &&
+		    ds_cpiost.st_nlink <= 1) {
+			*r_cpio = ds_cpio;
+			*r_st = ds_cpiost;
+			ds_cpioname = NULL;
+			return (1);
+		}
+		if (ds_cpiostage())
+			return (-1);
+		if (match)
+			return (0);
+	}
+
+	return (0);
+}
+
+/*
+ * Name:		ds_drain
+ * Description:	Unpack the rest of the part read in by ds_nextstream(),
+ *		for whatever needs the unpacked package
+ *
+ * Returns :	zero - the rest of the part was unpacked
+ *		non-zero - some failure occurred.
+ */
+int
+ds_drain(void)
+{
+	while (ds_cpio) {
+		if (ds_cpioname == NULL) {
+			if (ds_cpionext())
+				return (-1);
+		} else if (ds_cpiostage())
+			return (-1);
+	}
+
+	return (0);
+}
+
+/* read the header of the next member of the part being streamed */
+static int
+ds_cpionext(void)
+{
+	int	n;
+
+	if ((n = cpioNext(ds_cpio, &ds_cpioname, &ds_cpiost)) > 0)
+		return (0);
+
+	cpioClose(ds_cpio);
+	ds_cpio = NULL;
+	ds_cpioname = NULL;
+
+	if (n < 0) {
+		progerr(pkg_gt(ERR_UNPACK));
+		logerr(pkg_gt(MSG_CPIOFAIL), getErrstr());
+		return (-1);
+	}
+	return (0);
+}
+
+/* unpack the current member of the part being streamed */
+static int
+ds_cpiostage(void)
+{
+	int	n;
+
+	if (strcmp(ds_cpiomember(ds_cpioname), "") == 0)
+		n = cpioSkip(ds_cpio);
+	else
+		n = cpioRestore(ds_cpio, ds_cpiodir);
+	ds_cpioname = NULL;
+
+	if (n) {
+		progerr(pkg_gt(ERR_UNPACK));
+		logerr(pkg_gt(MSG_CPIOFAIL), getErrstr());
+		return (-1);
+	}
+	return (0);
+}
+
+/* name of a member without leading "./" */
+static char *
+ds_cpiomember(char *name)
+{
+	while (name[0] == '.' && (name[1] == '/' || name[1] == '\0'))
+		name += (name[1] == '/') ? 2 : 1;
+	return (name);
+}
+
 /*
  * Name:		BIO_ds_dump
  * Description:	Dumps all data from the static 'ds_fd' file handle into
@@ -766,6 +996,12 @@ ds_close(int pkgendflg)
 		ds_totread = 0;
 	}
 
+	if (ds_cpio) {
+		cpioClose(ds_cpio);
+		ds_cpio = NULL;
+		ds_cpioname = NULL;
+	}
+
 	if (ds_pp) {
 		(void) pclose(ds_pp);
 		ds_pp = 0;
@@ -78,6 +78,12 @@ static int	getvalmodevfp(char **cp, mode_t *d, long bad, int map);
 
 static char	mypath[PATH_MAX];
 static char	mylocal[PATH_MAX];
+
+/* delimiters scanned for by getstrvfp() with and without "=" */
+
+static PKGSTRSCAN_T	wordsep;
+static PKGSTRSCAN_T	pathsep;
+static int		sepInit = 0;
 static int	mapmode = MAPNONE;
 static char	*maptype = "";
 static mode_t	d_mode = BADMODE;
@@ -1031,6 +1037,7 @@ getstrvfp(char **cp, char *sep, int n, char *str)
 	char	*p = *cp;
 	char	*p1;
 	size_t	len;
+	PKGSTRSCAN_T	*scan;
 
 	if (*p == '\0') {
 		return (1);
@@ -1048,22 +1055,40 @@ getstrvfp(char **cp, char *sep, int n, char *str)
 
 	p--;
 
-	/* generate complete list of delimiters to scan for */
+	/* the delimiters used by the pkgmap parser are scanned for quickly */
 
-	(void) strlcpy(delims, " \t\n", sizeof (delims));
-	if ((sep != (char *)NULL) && (*sep != '\0')) {
-		(void) strlcat(delims, sep, sizeof (delims));
+	if (sepInit == 0) {
+		pkgstrScanInit(&wordsep, " \t\n");
+		pkgstrScanInit(&pathsep, " \t\n=");
+		sepInit = 1;
+	}
+
+	if ((sep == (char *)NULL) || (*sep == '\0')) {
+		scan = &wordsep;
+	} else if (strcmp(sep, "=") == 0) {
+		scan = &pathsep;
+	} else {
+		scan = (PKGSTRSCAN_T *)NULL;
 	}
 
 	/* compute length based on delimiter found or not */
 
-	p1 = strpbrk(p, delims);
-	if (p1 == (char *)NULL) {
-		len = strlen(p);
+	if (scan != (PKGSTRSCAN_T *)NULL) {
+		p1 = pkgstrScan(scan, p);
 	} else {
-		len = (ptrdiff_t)p1 - (ptrdiff_t)p;
+		/* generate complete list of delimiters to scan for */
+
+		(void) strlcpy(delims, " \t\n", sizeof (delims));
+		(void) strlcat(delims, sep, sizeof (delims));
+
+		p1 = strpbrk(p, delims);
+		if (p1 == (char *)NULL) {
+			p1 = strchr(p, '\0');
+		}
 	}
 
+	len = (ptrdiff_t)p1 - (ptrdiff_t)p;
+
 	/* if string will fit in result buffer copy string and return success */
 
 	if (len < n) {
@@ -41,6 +41,7 @@
 #include <string.h>
 #include <stdarg.h>
 #include "pkglocale.h"
+#include "pkglib.h"
 
 /*VARARGS*/
 void
@@ -52,6 +53,7 @@ logerr(char *fmt, ...)
 	char	*estr = pkg_gt("ERROR:");
 	char	*wstr = pkg_gt("WARNING:");
 	char	*nstr = pkg_gt("NOTE:");
+	FILE	*fp = get_msg_stream();
 
 	va_start(ap, fmt);
 	flag = 0;
@@ -60,7 +62,7 @@ logerr(char *fmt, ...)
 	    strncmp(fmt, wstr, strlen(wstr)) &&
 	    strncmp(fmt, nstr, strlen(nstr))) {
 		flag++;
-		(void) fprintf(stderr, "    ");
+		(void) fprintf(fp, "    ");
 	}
 	/*
 	 * NOTE: internationalization in next line REQUIRES that caller of
@@ -72,9 +74,9 @@ logerr(char *fmt, ...)
 	va_end(ap);
 
 	for (pt = buffer; *pt; pt++) {
-		(void) putc(*pt, stderr);
+		(void) putc(*pt, fp);
 		if (flag && (*pt == '\n') && pt[1])
-			(void) fprintf(stderr, "    ");
+			(void) fprintf(fp, "    ");
 	}
-	(void) putc('\n', stderr);
+	(void) putc('\n', fp);
 }
@@ -43,6 +43,8 @@ extern "C" {
 #endif
 
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <inttypes.h>
 #include <limits.h>
 #include <stdio.h>
 #include <pkgdev.h>
@@ -282,6 +284,59 @@ struct dstr {
 	int   max;
 };
 
+/*
+ * Set of characters to scan for with pkgstrScan(); initialize with
+ * pkgstrScanInit(). The null character is always a member of the set.
+ */
+
+#define	PKGSTRSCAN_MAXCHARS	8	/* max members greater than ' ' */
+
+typedef struct _pkgstrscan {
+	unsigned long	ss_chars[PKGSTRSCAN_MAXCHARS];	/* member in each byte */
+	int		ss_nchars;			/* # ss_chars used */
+	char		ss_table[UCHAR_MAX+1];		/* != 0 if member */
+} PKGSTRSCAN_T;
+
+/*
+ * Symbol of a string interned with pkgstrIntern(); equal strings have equal
+ * symbols. PKGSTRSYM_NONE is never the symbol of a string.
+ */
+
+typedef uint32_t	PKGSTRSYM_T;
+
+#define	PKGSTRSYM_NONE	((PKGSTRSYM_T)0)
+
+/*
+ * Callbacks of a parallel scan of the contents file (see cfscan())
+ */
+
+typedef struct _cfscanops {
+	void	*(*cso_start)(void *a_arg);		/* new chunk result */
+	void	(*cso_entry)(void *a_res, struct cfent *a_ept);
+	void	(*cso_reduce)(void *a_res, void *a_arg);	/* in order */
+} CFSCANOPS_T;
+
+/*
+ * Position in the entries srchcfile() returns from a contents file VFP,
+ * including any journaled entries merged with them (see srchcfileGetPos())
+ */
+
+typedef struct _srchpos {
+	char	*sp_curr;	/* current position of the VFP */
+	size_t	sp_jnext;	/* next journaled entry */
+} SRCHPOS_T;
+
+/* cpio archive read member by member (see cpioOpen()) */
+
+typedef struct cpiord CPIO_T;
+
+/* cpioExtract() and cpioArchive() flags */
+#define	CPIO_SKIP	0x01	/* read archive, extract nothing */
+#define	CPIO_RECURSE	0x02	/* archive files below directories too */
+#define	CPIO_FOLLOW	0x04	/* archive what symbolic links point to */
+#define	CPIO_GZIP	0x08	/* gzip compress archive */
+#define	CPIO_ZSTD	0x10	/* zstd compress archive */
+
 /* setmapmode() defines */
 #define	MAPALL		0	/* resolve all variables */
 #define	MAPBUILD	1	/* map only build variables */
@@ -384,9 +439,49 @@ extern void	pkglist_cont(char *keyword);
 extern char	**pkgalias(char *pkg);
 extern char	*get_prog_name(void);
 extern char 	*set_prog_name(char *name);
+extern FILE	*get_msg_stream(void);
+extern FILE	*set_msg_stream(FILE *fp);
 extern int	averify(int fix, char *ftype, char *path, struct ainfo *ainfo);
 extern int	ckparam(char *param, char *value);
+extern void	cfidxClose(void);
+extern char	*cfidxFind(VFP_T *a_vfp, char *a_path, size_t a_pathLen);
+extern uint32_t	cfidxHash(char *a_path, size_t a_len);
+extern int	cfidxOpen(VFP_T *a_vfp);
+extern int	cfidxWrite(VFP_T *a_vfp, char *a_contents);
+extern int	cfjnlAppend(VFP_T *a_oldVfp, VFP_T *a_newVfp,
+			char *a_contents, int a_defer);
+extern void	cfjnlClose(void);
+extern int	cfjnlCreate(char *a_contents);
+extern int	cfjnlEnabled(char *a_contents);
+extern int	cfjnlOpen(VFP_T *a_vfp, int a_track);
+extern int	cfjnlOrphaned(char *a_contents);
+extern int	cfjnlRemove(char *a_contents);
+extern int	cfjnlReset(char *a_contents);
+extern size_t	cfjnlSize(VFP_T *a_vfp);
+extern void	cfpkxClose(void);
+extern char	**cfpkxFind(VFP_T *a_vfp, char **a_pkgs, int a_npkgs,
+			size_t *r_nlines);
+extern int	cfpkxOpen(VFP_T *a_vfp);
+extern int	cfpkxWrite(VFP_T *a_vfp, char *a_contents);
+extern int	cfscan(VFP_T *a_vfp, int a_nthreads, CFSCANOPS_T *a_ops,
+			void *a_arg, struct cfent *r_ept);
+extern uint32_t	cksumBytes(uint32_t a_sum, void *a_buf, size_t a_len);
+extern void	cksumCacheAdd(struct stat *a_st, unsigned long a_cksum);
+extern int	cksumCacheClose(void);
+extern int	cksumCacheFind(struct stat *a_st, unsigned long *r_cksum);
+extern int	cksumCacheOpen(char *a_dir);
 extern int	ckvolseq(char *dir, int part, int nparts);
+extern int	cpioArchive(int a_fd, int a_blksize, char **a_paths,
+			int a_flags);
+extern void	cpioClose(CPIO_T *a_cpio);
+extern int	cpioCopy(CPIO_T *a_cpio, int a_fd, char *a_path);
+extern int	cpioExtract(int a_fd, int a_blksize, char **a_patterns,
+			int a_flags);
+extern int	cpioNext(CPIO_T *a_cpio, char **r_name, struct stat *r_st);
+extern CPIO_T	*cpioOpen(int a_fd, int a_blksize);
+extern int	cpioRestore(CPIO_T *a_cpio, char *a_dir);
+extern void	cpioSetCompression(int a_level, int a_nthreads);
+extern int	cpioSkip(CPIO_T *a_cpio);
 extern int	cverify(int fix, char *ftype, char *path, struct cinfo *cinfo,
 			int allow_checksum);
 extern unsigned long	compute_checksum(int *r_cksumerr, char *a_path);
@@ -399,6 +494,8 @@ extern void	setErrstr(char *errstr);
 extern int	devtype(char *alias, struct pkgdev *devp);
 extern int	ds_totread;	/* total number of parts read */
 extern int	ds_close(int pkgendflg);
+extern int	ds_drain(void);
+extern int	ds_fetch(char *a_path, CPIO_T **r_cpio, struct stat *r_st);
 extern int	ds_findpkg(char *device, char *pkg);
 extern int	ds_getinfo(char *string);
 extern int	ds_getpkg(char *device, int n, char *dstdir);
@@ -409,6 +506,7 @@ extern int	BIO_ds_dump_header(PKG_ERR *, BIO *);
 extern int	BIO_ds_dump(PKG_ERR *, char *, BIO *);
 extern int	BIO_dump_cmd(char *cmd, BIO *bio);
 extern int	ds_next(char *, char *);
+extern int	ds_nextstream(char *device, char *instdir);
 extern int	ds_readbuf(char *device);
 extern int	epclose(FILE *pp);
 extern int	esystem(char *cmd, int ifd, int ofd);
@@ -449,6 +547,9 @@ extern int	pkg_passphrase_cb(char *, int, int, void *);
 
 extern int	srchcfile(struct cfent *ept, char *path, VFP_T *vfp,
 			VFP_T *vfpout);
+extern void	srchcfileArena(boolean_t a_enable);
+extern void	srchcfileGetPos(VFP_T *a_vfp, SRCHPOS_T *r_pos);
+extern void	srchcfileSetPos(VFP_T *a_vfp, SRCHPOS_T *a_pos);
 extern struct	group *cgrgid(gid_t gid);
 extern struct	group *cgrnam(char *nam);
 extern struct	passwd *cpwnam(char *nam);
@@ -493,8 +594,14 @@ boolean_t	pkgstrContainsToken(char *a_string, char *a_token,
 			char *a_separators);
 void		pkgstrGetToken_r(char *r_sep, char *a_string, int a_index,
 			char *a_separators, char *a_buf, int a_bufLen);
+PKGSTRSYM_T	pkgstrIntern(char *a_string, size_t a_len);
 char		*pkgstrPrintf(char *a_format, ...);
 void		pkgstrPrintf_r(char *a_buf, int a_bufLen, char *a_format, ...);
+char		*pkgstrScan(PKGSTRSCAN_T *a_scan, char *a_string);
+void		pkgstrScanInit(PKGSTRSCAN_T *r_scan, char *a_chars);
+PKGSTRSYM_T	pkgstrSymCount(void);
+PKGSTRSYM_T	pkgstrSymFind(char *a_string, size_t a_len);
+char		*pkgstrSymName(PKGSTRSYM_T a_sym);
 /* vfpops.c */
 extern int	vfpCheckpointFile(VFP_T **r_destVfp, VFP_T **a_vfp,
 			char *a_path);
@@ -522,9 +629,44 @@ extern char	**gpkglist();
 extern char	**pkgalias();
 extern char	*get_prog_name();
 extern char 	*set_prog_name();
+extern FILE	*get_msg_stream();
+extern FILE	*set_msg_stream();
 extern int	averify();
 extern int	ckparam();
+extern void	cfidxClose();
+extern char	*cfidxFind();
+extern uint32_t	cfidxHash();
+extern int	cfidxOpen();
+extern int	cfidxWrite();
+extern int	cfjnlAppend();
+extern void	cfjnlClose();
+extern int	cfjnlCreate();
+extern int	cfjnlEnabled();
+extern int	cfjnlOpen();
+extern int	cfjnlOrphaned();
+extern int	cfjnlRemove();
+extern int	cfjnlReset();
+extern size_t	cfjnlSize();
+extern void	cfpkxClose();
+extern char	**cfpkxFind();
+extern int	cfpkxOpen();
+extern int	cfpkxWrite();
+extern int	cfscan();
+extern uint32_t	cksumBytes();
+extern void	cksumCacheAdd();
+extern int	cksumCacheClose();
+extern int	cksumCacheFind();
+extern int	cksumCacheOpen();
 extern int	ckvolseq();
+extern int	cpioArchive();
+extern void	cpioClose();
+extern int	cpioCopy();
+extern int	cpioExtract();
+extern int	cpioNext();
+extern CPIO_T	*cpioOpen();
+extern int	cpioRestore();
+extern void	cpioSetCompression();
+extern int	cpioSkip();
 extern int	cverify();
 extern unsigned long	compute_checksum();
 extern int	fverify();
@@ -534,12 +676,15 @@ extern char	*getErrstr();
 extern void	setErrstr();
 extern int	devtype();
 extern int	ds_close();
+extern int	ds_drain();
+extern int	ds_fetch();
 extern int	ds_findpkg();
 extern int	ds_getinfo();
 extern int	ds_getpkg();
 extern boolean_t	ds_fd_open();
 extern int	ds_init();
 extern int	ds_next();
+extern int	ds_nextstream();
 extern int	ds_readbuf();
 extern int	epclose();
 extern int	esystem();
@@ -563,6 +708,9 @@ extern int	putcfile();
 extern int	putcvfpfile();
 extern int	rrmdir();
 extern int	srchcfile();
+extern void	srchcfileArena();
+extern void	srchcfileGetPos();
+extern void	srchcfileSetPos();
 extern struct	group *cgrgid();
 extern struct	group *cgrnam();
 extern struct	passwd *cpwnam();
@@ -243,6 +243,29 @@ extern "C" {
 #define	MSG_NOPKG	"- package <%s> not in datastream"
 #define	MSG_STATFS	"- unable to stat filesystem, errno=%d"
 #define	MSG_NOSPACE	"- not enough space, %d blocks required, %d available"
+#define	MSG_CPIOFAIL	"- cpio archive processing failed: %s"
+
+/* cpio archive errors */
+#define	ERR_CPIO_READ	"unable to read archive, errno=%d (%s)"
+#define	ERR_CPIO_OUT	"unable to write archive, errno=%d (%s)"
+#define	ERR_CPIO_EOF	"unexpected end of archive"
+#define	ERR_CPIO_HEADER	"bad header in archive"
+#define	ERR_CPIO_NAMESZ	"bad name size <%llu> in archive header"
+#define	ERR_CPIO_NAMELEN	"name of <%s> is too long for archive"
+#define	ERR_CPIO_TOOBIG	"<%s> is too large for archive"
+#define	ERR_CPIO_CHANGED	"<%s> changed size while being archived"
+#define	ERR_CPIO_CHKSUM	"checksum error on <%s>"
+#define	ERR_CPIO_STAT	"unable to stat <%s>, errno=%d (%s)"
+#define	ERR_CPIO_OPEN	"unable to read <%s>, errno=%d (%s)"
+#define	ERR_CPIO_CREATE	"unable to create <%s>, errno=%d (%s)"
+#define	ERR_CPIO_WRITE	"unable to write <%s>, errno=%d (%s)"
+#define	ERR_CPIO_REMOVE	"unable to remove existing <%s>, errno=%d (%s)"
+#define	ERR_CPIO_LINK	"unable to link <%s> to <%s>, errno=%d (%s)"
+#define	ERR_CPIO_ZIP	"unable to compress archive: %s"
+#define	ERR_CPIO_UNZIP	"unable to decompress archive: %s"
+#define	ERR_CPIO_ZIPEND	"compressed data continues after end of archive"
+#define	ERR_CPIO_LEVEL	"compression level <%d> is not supported"
+#define	ERR_CPIO_NOZSTD	"zstd compressed archives are not supported"
 
 /* pkglist errors */
 #define	ERR_MEMORY	"memory allocation failure, errno=%d"
@@ -302,6 +325,7 @@ extern "C" {
 #define	ERR_MODFAIL	"unable to fix modification time"
 #define	ERR_LINKFAIL	"unable to create link to <%s>"
 #define	ERR_LINKISDIR	"<%s> is a directory, link() not performed"
+#define	ERR_LINKLONG	"link target <%s> is too long"
 #define	ERR_SLINKFAIL	"unable to create symbolic link to <%s>"
 #define	ERR_DIRFAIL	"unable to create directory"
 #define	ERR_CDEVFAIL	"unable to create character-special device"
@@ -47,9 +47,15 @@
  *
  *   pkgstrContainsToken - Determine if a string contains a specified token
  *   pkgstrGetToken_r - Get a token from a string into a fixed buffer
+ *   pkgstrIntern - Return the symbol of a string, interning it if needed
  *   pkgstrPrintf - Create a string from a printf style format and arguments
  *   pkgstrPrintf_r - Create a string from a printf style format and arguments
  *			into a fixed buffer
+ *   pkgstrScan - Locate the first character of a string from a set
+ *   pkgstrScanInit - Initialize a set of characters to scan for
+ *   pkgstrSymCount - Return the number of symbols interned
+ *   pkgstrSymFind - Return the symbol of a string if it is interned
+ *   pkgstrSymName - Return the string of a symbol
  */
 
 /*
@@ -71,6 +77,7 @@
 #include <unistd.h>
 #include <strings.h>
 #include <stdarg.h>
+#include <inttypes.h>
 
 /*
  * pkglib Includes
@@ -81,6 +88,41 @@
 #include <libintl.h>
 #include "pkglocale.h"
 
+/*
+ * Word at a time scanning: ONES has the low bit of each byte of a word set;
+ * HASZERO(w) is non-zero if any byte of w is zero, and HASLESS(w, n) is
+ * non-zero if any byte of w is less than n (n <= 128). Neither reports a
+ * byte that does not qualify unless another byte of the word does.
+ */
+
+#define	ONES		((unsigned long)~0UL / UCHAR_MAX)
+#define	HIGHS		(ONES << (CHAR_BIT - 1))
+#define	HASLESS(w, n)	(((w) - ONES * (n)) & ~(w) & HIGHS)
+#define	HASZERO(w)	HASLESS((w), 1)
+
+/*
+ * Interned strings: each distinct string passed to pkgstrIntern() is stored
+ * once, in blocks that are never freed, and is identified by a symbol - the
+ * number of strings interned before it plus one. A hash table of symbols
+ * locates the symbol of a string; PKGSTRSYM_NONE (0) is never assigned.
+ */
+
+#define	SYMBLK_SIZE	(64*1024)	/* bytes of string space per block */
+#define	SYMBLK_MAXSTR	(SYMBLK_SIZE/16) /* longer strings: own allocation */
+#define	SYMTAB_INITSIZE	1024		/* initial size of hash table */
+#define	SYMNAMES_INCR	1024		/* symbols added to name table */
+
+static char		**symNames = (char **)NULL;	/* string of symbol */
+static size_t		symNamesAlloc = 0;	/* size of symNames */
+static PKGSTRSYM_T	symCount = 0;		/* # symbols assigned */
+static PKGSTRSYM_T	*symTable = (PKGSTRSYM_T *)NULL; /* hash table */
+static size_t		symTableSize = 0;	/* size of symTable, power of 2 */
+static char		*symBlk = (char *)NULL;	/* free space in block */
+static size_t		symBlkFree = 0;		/* # bytes free in block */
+
+static uint32_t		symhash(char *a_string, size_t a_len);
+static size_t		symslot(char *a_string, size_t a_len);
+
 /*
  * External definitions
  */
@@ -368,3 +410,310 @@ pkgstrContainsToken(char *a_string, char *a_token, char *a_separators)
 
 	return (B_FALSE);
 }
+
+/*
+ * Name:	pkgstrScanInit
+ * Synopsis:	Initialize a set of characters to scan for
+ * Description:	Prepare a set of characters for use with pkgstrScan(); the
+ *		set is fixed, so initialize it once and reuse it for each scan
+ * Arguments:	r_scan - [RO, *RW] - (PKGSTRSCAN_T *)
+ *			Pointer to set to initialize
+ *		a_chars - [RO, *RO] - (char *)
+ *			Pointer to string of characters in the set; the null
+ *			character is always a member of the set. No more than
+ *			PKGSTRSCAN_MAXCHARS characters may be greater than ' '
+ * Returns:	void
+ */
+
+void
+pkgstrScanInit(PKGSTRSCAN_T *r_scan, char *a_chars)
+{
+	unsigned char	*p;
+
+	/* entry assertions */
+
+	assert(r_scan != (PKGSTRSCAN_T *)NULL);
+	assert(a_chars != (char *)NULL);
+
+	(void) memset(r_scan, 0, sizeof (PKGSTRSCAN_T));
+
+	r_scan->ss_table['\0'] = 1;
+
+	for (p = (unsigned char *)a_chars; *p != '\0'; p++) {
+		if (r_scan->ss_table[*p] != 0) {
+			continue;
+		}
+
+		r_scan->ss_table[*p] = 1;
+
+		/* characters up to ' ' are found by the HASLESS() test */
+
+		if (*p <= ' ') {
+			continue;
+		}
+
+		assert(r_scan->ss_nchars < PKGSTRSCAN_MAXCHARS);
+		r_scan->ss_chars[r_scan->ss_nchars++] = ONES * *p;
+	}
+}
+
+/*
+ * Name:	pkgstrScan
+ * Synopsis:	Locate the first character of a string from a set
+ * Description:	Equivalent to strpbrk() except that the end of the string is
+ *		returned if no character from the set is present; the string
+ *		is scanned a word rather than a byte at a time.
+ * Arguments:	a_scan - [RO, *RO] - (PKGSTRSCAN_T *)
+ *			Pointer to set initialized by pkgstrScanInit()
+ *		a_string - [RO, *RO] - (char *)
+ *			Pointer to null terminated string to scan
+ * Returns:	char *
+ *			Pointer to the first character of a_string that is
+ *			in the set, or to the terminating null character
+ * NOTE:	Words are only read from aligned addresses, so the bytes past
+ *		the terminating null that are read are always in the same
+ *		page as the terminating null.
+ */
+
+char *
+pkgstrScan(PKGSTRSCAN_T *a_scan, char *a_string)
+{
+	unsigned char	*p = (unsigned char *)a_string;
+	unsigned long	*wp;
+	unsigned long	w;
+	unsigned long	m;
+	int		i;
+
+	/* scan a byte at a time until aligned */
+
+	while (((uintptr_t)p & (sizeof (unsigned long) - 1)) != 0) {
+		if (a_scan->ss_table[*p] != 0) {
+			return ((char *)p);
+		}
+		p++;
+	}
+
+	/* scan a word at a time */
+
+	for (wp = (unsigned long *)p; ; wp++) {
+		w = *wp;
+
+		m = HASLESS(w, ' ' + 1);
+		for (i = 0; i < a_scan->ss_nchars; i++) {
+			m |= HASZERO(w ^ a_scan->ss_chars[i]);
+		}
+
+		if (m == 0) {
+			continue;
+		}
+
+		/* word may hold a member: locate it, else scan on */
+
+		p = (unsigned char *)wp;
+		for (i = 0; i < sizeof (unsigned long); i++, p++) {
+			if (a_scan->ss_table[*p] != 0) {
+				return ((char *)p);
+			}
+		}
+	}
+	/*NOTREACHED*/
+}
+
+/*
+ * Name:	pkgstrIntern
+ * Synopsis:	Return the symbol of a string, interning it if needed
+ * Description:	Map a string to a small integer that identifies it for the
+ *		life of the process: two strings have the same symbol if and
+ *		only if they are equal, so symbols can be compared instead of
+ *		strings, and the string of a symbol is stored only once.
+ * Arguments:	a_string - [RO, *RO] - (char *)
+ *			Pointer to string to intern (need not be null
+ *			terminated)
+ *		a_len - [RO] - (size_t)
+ *			Number of bytes in a_string
+ * Returns:	PKGSTRSYM_T
+ *			!= PKGSTRSYM_NONE - symbol of the string
+ *			== PKGSTRSYM_NONE - unable to allocate memory
+ * NOTE:	Not MT-safe: symbols must not be interned while another thread
+ *		uses any of the pkgstrSym*() methods.
+ */
+
+PKGSTRSYM_T
+pkgstrIntern(char *a_string, size_t a_len)
+{
+	char	*p;
+	size_t	i;
+
+	/* grow the hash table to keep it at most half full */
+
+	if ((symCount + 1) * 2 > symTableSize) {
+		PKGSTRSYM_T	*ot = symTable;
+		size_t		osize = symTableSize;
+		PKGSTRSYM_T	sym;
+
+		symTableSize = (osize == 0) ? SYMTAB_INITSIZE : osize * 2;
+		symTable = (PKGSTRSYM_T *)calloc(symTableSize,
+			sizeof (PKGSTRSYM_T));
+		if (symTable == (PKGSTRSYM_T *)NULL) {
+			symTable = ot;
+			symTableSize = osize;
+			return (PKGSTRSYM_NONE);
+		}
+
+		for (sym = 1; sym <= symCount; sym++) {
+			symTable[symslot(symNames[sym],
+				strlen(symNames[sym]))] = sym;
+		}
+
+		free(ot);
+	}
+
+	i = symslot(a_string, a_len);
+	if (symTable[i] != PKGSTRSYM_NONE) {
+		return (symTable[i]);
+	}
+
+	/* new string: store a copy and assign the next symbol */
+
+	if (symCount + 1 >= symNamesAlloc) {
+		char	**nn;
+
+		nn = (char **)realloc(symNames,
+			(symNamesAlloc + SYMNAMES_INCR) * sizeof (char *));
+		if (nn == (char **)NULL) {
+			return (PKGSTRSYM_NONE);
+		}
+		symNames = nn;
+		symNamesAlloc += SYMNAMES_INCR;
+	}
+
+	if (a_len >= SYMBLK_MAXSTR) {
+		p = (char *)malloc(a_len + 1);
+	} else {
+		if (a_len + 1 > symBlkFree) {
+			symBlk = (char *)malloc(SYMBLK_SIZE);
+			symBlkFree = (symBlk == (char *)NULL) ? 0 : SYMBLK_SIZE;
+		}
+		p = symBlk;
+		if (p != (char *)NULL) {
+			symBlk += a_len + 1;
+			symBlkFree -= a_len + 1;
+		}
+	}
+
+	if (p == (char *)NULL) {
+		return (PKGSTRSYM_NONE);
+	}
+
+	(void) memcpy(p, a_string, a_len);
+	p[a_len] = '\0';
+
+	symNames[++symCount] = p;
+	symTable[i] = symCount;
+
+	return (symCount);
+}
+
+/*
+ * Name:	pkgstrSymFind
+ * Synopsis:	Return the symbol of a string if it is interned
+ * Arguments:	a_string - [RO, *RO] - (char *)
+ *			Pointer to string to look up (need not be null
+ *			terminated)
+ *		a_len - [RO] - (size_t)
+ *			Number of bytes in a_string
+ * Returns:	PKGSTRSYM_T
+ *			!= PKGSTRSYM_NONE - symbol of the string
+ *			== PKGSTRSYM_NONE - the string has not been interned
+ */
+
+PKGSTRSYM_T
+pkgstrSymFind(char *a_string, size_t a_len)
+{
+	if (symTableSize == 0) {
+		return (PKGSTRSYM_NONE);
+	}
+
+	return (symTable[symslot(a_string, a_len)]);
+}
+
+/*
+ * Name:	pkgstrSymName
+ * Synopsis:	Return the string of a symbol
+ * Arguments:	a_sym - [RO] - (PKGSTRSYM_T)
+ *			Symbol returned by pkgstrIntern()
+ * Returns:	char *
+ *			Pointer to the null terminated string of the symbol,
+ *			valid for the life of the process; must not be freed
+ *			or modified
+ *			== (char *)NULL - a_sym is not a symbol
+ */
+
+char *
+pkgstrSymName(PKGSTRSYM_T a_sym)
+{
+	if ((a_sym == PKGSTRSYM_NONE) || (a_sym > symCount)) {
+		return ((char *)NULL);
+	}
+
+	return (symNames[a_sym]);
+}
+
+/*
+ * Name:	pkgstrSymCount
+ * Synopsis:	Return the number of symbols interned
+ * Description:	Symbols are assigned in sequence, so arrays indexed by symbol
+ *		need pkgstrSymCount()+1 elements.
+ * Returns:	PKGSTRSYM_T - the largest symbol assigned so far
+ */
+
+PKGSTRSYM_T
+pkgstrSymCount(void)
+{
+	return (symCount);
+}
+
+/*
+ * Private methods
+ */
+
+/*
+ * compute the 32-bit FNV-1a hash of a string
+ */
+
+static uint32_t
+symhash(char *a_string, size_t a_len)
+{
+	uint32_t	h = 2166136261U;
+
+	while (a_len-- > 0) {
+		h ^= (unsigned char)*a_string++;
+		h *= 16777619U;
+	}
+
+	return (h);
+}
+
+/*
+ * return the slot of the hash table that holds the symbol of a string, or
+ * the empty slot where it would be entered
+ */
+
+static size_t
+symslot(char *a_string, size_t a_len)
+{
+	size_t		mask = symTableSize - 1;
+	size_t		i;
+	PKGSTRSYM_T	sym;
+
+	i = symhash(a_string, a_len) & mask;
+	while ((sym = symTable[i]) != PKGSTRSYM_NONE) {
+		if ((strncmp(symNames[sym], a_string, a_len) == 0) &&
+				(symNames[sym][a_len] == '\0')) {
+			break;
+		}
+		i = (i + 1) & mask;
+	}
+
+	return (i);
+}
@@ -948,11 +948,10 @@ wdsheader(struct dm_buf *hdr, char *src, char *device, char **pkg, PKCS7 *sig)
 {
 	char	template[] = "/var/tmp/wdXXXXXX";
 	FILE	*fp;
-	char	path[PATH_MAX], tmp_entry[ENTRY_MAX],
-	    tmp_file[L_tmpnam+1];
+	char	path[PATH_MAX], tmp_entry[ENTRY_MAX];
 	char	srcpath[PATH_MAX];
-	int	i, n;
-	int	list_fd;
+	char	**list;
+	int	i, n, r;
 	int	block_cnt;
 	int 	len;
 	char	cwd[MAXPATHLEN + 1];
@@ -985,55 +984,12 @@ wdsheader(struct dm_buf *hdr, char *src, char *device, char **pkg, PKCS7 *sig)
 	}
 
 	/*
-	 * write the first cpio() archive to the datastream
-	 * which should contain the pkginfo & pkgmap files
-	 * for all packages
+	 * if we're making a signature, we must make a temporary area
+	 * full of symlinks to the requisite files, plus an extra entry
+	 * for the signature, so that all files and the signature are
+	 * put in the same archive.
 	 */
-	strcpy(tmp_file, template);
-	if (close(mkstemp(tmp_file)) < 0 ||	/* temporary file name */
-			(list_fd = open(tmp_file, O_RDWR | O_CREAT)) == -1) {
-		progerr(pkg_gt(ERR_TRANSFER));
-		logerr(pkg_gt(MSG_NOTMPFIL));
-		return (1);
-	}
-
-	/*
-	 * Create a cpio-compatible list of the requisite files in
-	 * the temporary file.
-	 */
-	if (!making_sig) {
-		for (i = 0; pkg[i]; i++) {
-			register ssize_t entry_size;
-
-			/*
-			 * Copy pkginfo and pkgmap filenames into the
-			 * temporary string allowing for the first line
-			 * as a special case.
-			 */
-			entry_size = sprintf(tmp_entry,
-			    (i == 0) ? "%s/%s\n%s/%s" : "\n%s/%s\n%s/%s",
-			    pkg[i], PKGINFO, pkg[i], PKGMAP);
-
-			if (write(list_fd, tmp_entry,
-			    entry_size) != entry_size) {
-				progerr(pkg_gt(ERR_TRANSFER));
-				logerr(pkg_gt(MSG_NOTMPFIL));
-				(void) close(list_fd);
-				ecleanup();
-				return (1);
-			}
-		}
-
-	} else {
-		register ssize_t entry_size;
-
-		/*
-		 * if we're making a signature, we must make a
-		 * temporary area full of symlinks to the requisite
-		 * files, plus an extra entry for the signature, so
-		 * that cpio will put all files and signature in the
-		 * same archive in a single invocation of cpio.
-		 */
+	if (making_sig) {
 		close(mkstemp(template));
 		unlink(template);
 		tmpsymdir = xstrdup(template);
@@ -1092,56 +1048,9 @@ wdsheader(struct dm_buf *hdr, char *src, char *device, char **pkg, PKCS7 *sig)
 				cleanup();
 				return (1);
 			}
-
-			/*
-			 * Copy pkginfo and pkgmap filenames into the
-			 * temporary string allowing for the first line
-			 * as a special case.
-			 */
-			entry_size = sprintf(tmp_entry,
-			    (i == 0) ? "%s/%s\n%s/%s" : "\n%s/%s\n%s/%s",
-			    pkg[i], PKGINFO, pkg[i], PKGMAP);
-
-			if (write(list_fd, tmp_entry,
-			    entry_size) != entry_size) {
-				progerr(pkg_gt(ERR_TRANSFER));
-				logerr(pkg_gt(MSG_NOTMPFIL));
-				(void) close(list_fd);
-				ecleanup();
-				cleanup();
-				return (1);
-			}
-		}
-
-		/* add signature to list of files */
-		entry_size = sprintf(tmp_entry, "\n%s", SIGNATURE_FILENAME);
-		if (write(list_fd, tmp_entry, entry_size) != entry_size) {
-			progerr(pkg_gt(ERR_TRANSFER));
-			logerr(pkg_gt(MSG_NOTMPFIL), tmp_file);
-			(void) close(list_fd);
-			ecleanup();
-			cleanup();
-			return (1);
 		}
-	}
-
-	(void) lseek(list_fd, 0, SEEK_SET);
-
-	if (!making_sig) {
-		(void) sprintf(tmp_entry, "%s -ocD -C %d",
-		    CPIOPROC, (int)BLK_SIZE);
-	} else {
-		/*
-		 * when making a signature, we must make sure to follow
-		 * symlinks during the cpio so that we don't archive
-		 * the links themselves
-		 */
-		(void) sprintf(tmp_entry, "%s -ocDL -C %d",
-		    CPIOPROC, (int)BLK_SIZE);
-	}
 
-	if (making_sig) {
-		/* save cwd and change to symlink dir for cpio invocation */
+		/* save cwd and change to symlink dir for the archive */
 		if (getcwd(cwd, MAXPATHLEN + 1) == NULL) {
 			logerr(pkg_gt(ERR_GETWD));
 			progerr(pkg_gt(ERR_TRANSFER));
@@ -1157,19 +1066,43 @@ wdsheader(struct dm_buf *hdr, char *src, char *device, char **pkg, PKCS7 *sig)
 		}
 	}
 
-	if (n = esystem(tmp_entry, list_fd, ds_fd)) {
-		rpterr();
+	/*
+	 * write the first cpio() archive to the datastream
+	 * which should contain the pkginfo & pkgmap files
+	 * for all packages, and the signature if we're making one
+	 */
+	for (n = 0; pkg[n]; n++)
+		;
+	list = (char **)xmalloc((2 * n + 2) * sizeof (char *));
+	for (i = 0; i < n; i++) {
+		(void) snprintf(tmp_entry, ENTRY_MAX, "%s/%s",
+		    pkg[i], PKGINFO);
+		list[2 * i] = xstrdup(tmp_entry);
+		(void) snprintf(tmp_entry, ENTRY_MAX, "%s/%s",
+		    pkg[i], PKGMAP);
+		list[2 * i + 1] = xstrdup(tmp_entry);
+	}
+	list[2 * n] = making_sig ? SIGNATURE_FILENAME : NULL;
+	list[2 * n + 1] = NULL;
+
+	/*
+	 * when making a signature, we must make sure to follow
+	 * symlinks so that we don't archive the links themselves
+	 */
+	r = cpioArchive(ds_fd, BLK_SIZE, list,
+	    making_sig ? CPIO_FOLLOW : 0);
+
+	for (i = 0; i < 2 * n; i++)
+		free(list[i]);
+	free(list);
+
+	if (r != 0) {
 		progerr(pkg_gt(ERR_TRANSFER));
-		logerr(pkg_gt(MSG_CMDFAIL), tmp_entry, n);
-		(void) close(list_fd);
-		(void) unlink(tmp_file);
+		logerr(pkg_gt(MSG_CPIOFAIL), getErrstr());
 		cleanup();
 		return (1);
 	}
 
-	(void) close(list_fd);
-	(void) unlink(tmp_file);
-
 	if (making_sig) {
 		/* change to back to src dir for subsequent operations */
 		if (chdir(cwd)) {
@@ -1207,10 +1140,13 @@ pkgxfer(char *srcinst, int options)
 	char	*pt, *src, *dst;
 	char	dstdir[PATH_MAX],
 		temp[PATH_MAX],
+		reloctmp[PATH_MAX],
+		roottmp[PATH_MAX],
 		srcdir[PATH_MAX],
 		cmd[CMDSIZE],
 		pkgname[NON_ABI_NAMELNGTH];
-	int	i, n, part, nparts, maxpartsize, curpartcnt, iscomp;
+	char	*plist[16];
+	int	i, n, np, part, nparts, maxpartsize, curpartcnt, iscomp;
 	char	volnos[128], tmpvol[128];
 	struct	statvfs svfsb;
 	long long free_blocks;
@@ -1506,55 +1442,56 @@ pkgxfer(char *srcinst, int options)
 		if (options & PT_INFO_ONLY)
 			nparts = 0;
 
+		/* list the files of this part */
+		np = 0;
+		plist[np++] = PKGINFO;
 		if (part == 1) {
-			(void) sprintf(cmd, "find %s %s", PKGINFO, PKGMAP);
-			if (nparts && (isdir(INSTALL) == 0)) {
-				(void) strcat(cmd, " ");
-				(void) strcat(cmd, INSTALL);
-			}
-		} else
-			(void) sprintf(cmd, "find %s", PKGINFO);
+			plist[np++] = PKGMAP;
+			if (nparts && (isdir(INSTALL) == 0))
+				plist[np++] = INSTALL;
+		}
 
 		if (nparts > 1) {
-			(void) sprintf(temp, "%s.%d", RELOC, part);
-			if (iscpio(temp, &iscomp) || isdir(temp) == 0) {
-				(void) strcat(cmd, " ");
-				(void) strcat(cmd, temp);
-			}
-			(void) sprintf(temp, "%s.%d", ROOT, part);
-			if (iscpio(temp, &iscomp) || isdir(temp) == 0) {
-				(void) strcat(cmd, " ");
-				(void) strcat(cmd, temp);
-			}
+			(void) sprintf(reloctmp, "%s.%d", RELOC, part);
+			if (iscpio(reloctmp, &iscomp) || isdir(reloctmp) == 0)
+				plist[np++] = reloctmp;
+			(void) sprintf(roottmp, "%s.%d", ROOT, part);
+			if (iscpio(roottmp, &iscomp) || isdir(roottmp) == 0)
+				plist[np++] = roottmp;
 			(void) sprintf(temp, "%s.%d", ARCHIVE, part);
-			if (isdir(temp) == 0) {
-				(void) strcat(cmd, " ");
-				(void) strcat(cmd, temp);
-			}
+			if (isdir(temp) == 0)
+				plist[np++] = temp;
 		} else if (nparts) {
 			for (i = 0; reloc_names[i] != NULL; i++) {
 				if (iscpio(reloc_names[i], &iscomp) ||
-				    isdir(reloc_names[i]) == 0) {
-					(void) strcat(cmd, " ");
-					(void) strcat(cmd, reloc_names[i]);
-				}
+				    isdir(reloc_names[i]) == 0)
+					plist[np++] = reloc_names[i];
 			}
 			for (i = 0; root_names[i] != NULL; i++) {
 				if (iscpio(root_names[i], &iscomp) ||
-				    isdir(root_names[i]) == 0) {
-					(void) strcat(cmd, " ");
-					(void) strcat(cmd, root_names[i]);
-				}
-			}
-			if (isdir(ARCHIVE) == 0) {
-				(void) strcat(cmd, " ");
-				(void) strcat(cmd, ARCHIVE);
+				    isdir(root_names[i]) == 0)
+					plist[np++] = root_names[i];
 			}
+			if (isdir(ARCHIVE) == 0)
+				plist[np++] = ARCHIVE;
 		}
+		plist[np] = NULL;
+
 		if (options & PT_ODTSTREAM) {
-			(void) sprintf(cmd+strlen(cmd),
-			    " -print | %s -ocD -C %d",
-				CPIOPROC, (int)BLK_SIZE);
+			int	flags = CPIO_RECURSE;
+
+			/* only the parts are compressed, not the TOC archive */
+			if (options & PT_GZIP)
+				flags |= CPIO_GZIP;
+			else if (options & PT_ZSTD)
+				flags |= CPIO_ZSTD;
+
+			/* archive the files as "find <files> -print" lists */
+			if (cpioArchive(ds_fd, BLK_SIZE, plist, flags)) {
+				progerr(pkg_gt(ERR_TRANSFER));
+				logerr(pkg_gt(MSG_CPIOFAIL), getErrstr());
+				return (1);
+			}
 		} else {
 			if (statvfs(dstdir, &svfsb) == -1) {
 				progerr(pkg_gt(ERR_TRANSFER));
@@ -1572,16 +1509,22 @@ pkgxfer(char *srcinst, int options)
 				logerr(pkg_gt(MSG_NOSPACE));
 				return (1);
 			}
+
+			(void) strcpy(cmd, "find");
+			for (i = 0; i < np; i++) {
+				(void) strcat(cmd, " ");
+				(void) strcat(cmd, plist[i]);
+			}
 			(void) sprintf(cmd+strlen(cmd), " -print | %s -pdum %s",
 				CPIOPROC, dstdir);
-		}
 
-		n = esystem(cmd, -1, (options & PT_ODTSTREAM) ? ds_fd : -1);
-		if (n) {
-			rpterr();
-			progerr(pkg_gt(ERR_TRANSFER));
-			logerr(pkg_gt(MSG_CMDFAIL), cmd, n);
-			return (1);
+			n = esystem(cmd, -1, -1);
+			if (n) {
+				rpterr();
+				progerr(pkg_gt(ERR_TRANSFER));
+				logerr(pkg_gt(MSG_CMDFAIL), cmd, n);
+				return (1);
+			}
 		}
 
 		part++;
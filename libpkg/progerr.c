@@ -48,6 +48,12 @@
 
 static char	*ProgName = NULL; 	/* Set via set_prog_name() */
 
+/*
+ * Stream the messages of the calling thread are written to; set via
+ * set_msg_stream(), stderr if not set
+ */
+static __thread FILE	*MsgStream = NULL;
+
 /* default memory allocation failure routine */
 static void		error_and_exit(int);
 
@@ -76,25 +82,47 @@ get_prog_name(void)
 	return (ProgName);
 }
 
+/*
+ * Divert the messages output by the calling thread to a stream, or with
+ * NULL restore output to stderr. A thread working on behalf of another can
+ * collect its messages this way and have them output in a defined order.
+ * Returns the stream previously set.
+ */
+FILE *
+set_msg_stream(FILE *fp)
+{
+	FILE	*ofp = MsgStream;
+
+	MsgStream = fp;
+	return (ofp);
+}
+
+FILE *
+get_msg_stream(void)
+{
+	return (MsgStream ? MsgStream : stderr);
+}
+
 
 /*VARARGS*/
 void
 progerr(char *fmt, ...)
 {
 	va_list ap;
+	FILE	*fp = get_msg_stream();
 
 	va_start(ap, fmt);
 
 	if (ProgName && *ProgName)
-		(void) fprintf(stderr, pkg_gt("%s: ERROR: "), ProgName);
+		(void) fprintf(fp, pkg_gt("%s: ERROR: "), ProgName);
 	else
-		(void) fprintf(stderr, pkg_gt(" ERROR: "));
+		(void) fprintf(fp, pkg_gt(" ERROR: "));
 
-	(void) vfprintf(stderr, fmt, ap);
+	(void) vfprintf(fp, fmt, ap);
 
 	va_end(ap);
 
-	(void) fprintf(stderr, "\n");
+	(void) fprintf(fp, "\n");
 }
 
 void
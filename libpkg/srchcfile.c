@@ -50,6 +50,8 @@
 #include "pkglocale.h"
 #include "pkglibmsgs.h"
 #include "libadm.h"
+#include "cfjournal.h"
+#include "srchcfile.h"
 
 /*
  * Forward declarations
@@ -58,23 +60,49 @@
 static void	findend(char **cp);
 static int	getend(char **cp);
 static int	getnum(char **cp, int base, long *d, long bad);
-static int	getstr(char **cp, int n, char *str, int separator[]);
+static int	getstr(char **cp, int n, char *str, PKGSTRSCAN_T *separator);
+static int	jnlent(SRCHSTATE_T *a_state, struct cfent *ept, VFP_T *cfVfp,
+			CFJNLENT_T *a_je);
+static size_t	jnlnext(VFP_T *a_vfp, CFJNLENT_T *a_ent, size_t a_nent);
+static char	*nextpath(VFP_T *a_vfp, size_t *r_len);
+static int	pathcmp(char *a_p1, size_t a_l1, char *a_p2, size_t a_l2);
+static struct pinfo	*pinfoalloc(SRCHSTATE_T *a_state);
+static void	skipto(VFP_T *a_vfp, VFP_T *a_tmpVfp, char *a_path,
+			size_t a_len);
+static int	srchjnl(SRCHSTATE_T *a_state, struct cfent *ept, char *path,
+			VFP_T *cfVfp, VFP_T *cfTmpVfp, CFJNLENT_T *a_ent,
+			size_t a_nent);
+static int	srchvfp(SRCHSTATE_T *a_state, struct cfent *ept, char *path,
+			VFP_T *cfVfp, VFP_T *cfTmpVfp);
 
 /*
  * Module globals
  */
 
-static char	lpath[PATH_MAX];	/* for ept->path */
-static char	mylocal[PATH_MAX];	/* for ept->ainfo.local */
-static int	decisionTableInit = 0;
+static SRCHSTATE_T	srchstate;	/* parse state of srchcfile() */
+static int		decisionTableInit = 0;
 
 /*
- * These arrays must be indexable by an unsigned char.
+ * Character sets scanned for with pkgstrScan()
  */
 
-static int	ISPKGPATHSEP[UCHAR_MAX+1];
-static int	ISWORDSEP[UCHAR_MAX+1];
-static int	ISPKGNAMESEP[UCHAR_MAX+1];
+static PKGSTRSCAN_T	ISPKGPATHSEP;
+static PKGSTRSCAN_T	ISWORDSEP;
+static PKGSTRSCAN_T	ISPKGNAMESEP;
+
+/*
+ * When enabled with srchcfileArena(), the pinfo structures of the entry
+ * returned by srchcfile() are allocated from blocks that are reused by the
+ * next call to srchcfile(), instead of one calloc() per package.
+ */
+
+#define	PINFO_BLKSIZE	64	/* pinfo structures per block */
+
+struct pinfoblk {
+	struct pinfoblk	*pb_next;
+	int		pb_used;
+	struct pinfo	pb_pinfo[PINFO_BLKSIZE];
+};
 
 /*
  * Name:	WRITEDATA
@@ -99,24 +127,36 @@ static int	ISPKGNAMESEP[UCHAR_MAX+1];
 /*
  * Name:	COPYPATH
  * Description:	copy path limiting size to destination capacity
- * Arguments:	DEST - (char []) - [RW]
+ * Arguments:	STATE - (SRCHSTATE_T *) - [RO, *RW]
+ *			Parse state to copy path to (ss_path)
  *		SRC - (char *) - [RO, *RO]
  *			Pointer to first byte of path to copy
  *		LEN - (int) - [RO]
  *			Number of bytes to copy
  */
 
-#define	COPYPATH(DEST, SRC, LEN)					\
+#define	COPYPATH(STATE, SRC, LEN)					\
 	{								\
 		/* assure return path does not overflow */		\
-		if ((LEN) > sizeof ((DEST))) {				\
-			(LEN) = sizeof ((DEST))-1;			\
+		if ((LEN) > sizeof ((STATE)->ss_path)) {		\
+			(LEN) = sizeof ((STATE)->ss_path)-1;		\
 		}							\
 		/* copy return path to local storage */			\
-		(void) memcpy((DEST), (SRC), (LEN));			\
-		(DEST)[(LEN)] = '\0';					\
+		(void) memcpy((STATE)->ss_path, (SRC), (LEN));		\
+		(STATE)->ss_path[(LEN)] = '\0';				\
 	}
 
+/*
+ * Name:	SRCHERR
+ * Description:	cache error message describing reason for failure
+ * Arguments:	STATE - (SRCHSTATE_T *) - [RO, *RW]
+ *			Parse state to cache error message in
+ *		ERRSTR - (char *) - [RO, *RO]
+ *			Error message
+ */
+
+#define	SRCHERR(STATE, ERRSTR)	((STATE)->ss_errstr = (ERRSTR))
+
 /*
  * Name:	narrowSearch
  * Description:	narrow the search location for a specified path
@@ -180,9 +220,7 @@ narrowSearch(VFP_T *a_vfp, char *a_path, size_t a_pathLen)
 
 	/* find end of path */
 
-	while (ISPKGPATHSEP[(int)*pmid] == 0) {
-		pmid++;
-	}
+	pmid = pkgstrScan(&ISPKGPATHSEP, pmid);
 
 	/* determine length of path */
 
@@ -228,9 +266,7 @@ narrowSearch(VFP_T *a_vfp, char *a_path, size_t a_pathLen)
 
 		/* find end of path */
 
-		while (ISPKGPATHSEP[(int)*pmid] == 0) {
-			pmid++;
-		}
+		pmid = pkgstrScan(&ISPKGPATHSEP, pmid);
 
 		/* determine length of path */
 
@@ -292,9 +328,7 @@ narrowSearch(VFP_T *a_vfp, char *a_path, size_t a_pathLen)
 
 		/* find end of path */
 
-		while (ISPKGPATHSEP[(int)*pmid] == 0) {
-			pmid++;
-		}
+		pmid = pkgstrScan(&ISPKGPATHSEP, pmid);
 
 		/* determine length of path */
 
@@ -371,10 +405,80 @@ narrowSearch(VFP_T *a_vfp, char *a_path, size_t a_pathLen)
  *		  allocated and will be overwritten on the next call.
  *		- NOTE: the ept->ainfo.local item points to a path that is
  *		  statically allocated and will be overwritten on the next call.
+ *		- NOTE: the ept->pinfo list is allocated with calloc() and
+ *		  belongs to the caller, unless srchcfileArena() is enabled in
+ *		  which case it will be overwritten on the next call.
+ *		- NOTE: if a journal is attached to cfVfp (see cfjnlOpen()),
+ *		  the journaled entries are merged with those of the contents
+ *		  file; each entry the caller writes to cfTmpVfp must have
+ *		  been returned by or searched for with srchcfile().
  */
 
 int
 srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
+{
+	int	n;
+
+	n = srchcfile_r(&srchstate, ept, path, cfVfp, cfTmpVfp);
+
+	setErrstr(srchstate.ss_errstr);
+
+	return (n);
+}
+
+/*
+ * Name:	srchcfile_r
+ * Description:	srchcfile() using the parse state provided
+ * Arguments:	a_state - (SRCHSTATE_T *) - [RO, *RW]
+ *			- parse state; ept->path, ept->ainfo.local and (if
+ *			  ss_arena is set) ept->pinfo point into it
+ *		ept, path, cfVfp, cfTmpVfp - as srchcfile()
+ * Returns:	int - as srchcfile(); on error a_state->ss_errstr describes
+ *			the reason for failure
+ * NOTE:	srchcfile_init() must be called before threads are started;
+ *		threads may search
+ *		the same data concurrently with different parse states.
+ */
+
+int
+srchcfile_r(SRCHSTATE_T *a_state, struct cfent *ept, char *path,
+	VFP_T *cfVfp, VFP_T *cfTmpVfp)
+{
+	CFJNLENT_T	*ent;
+	size_t		nent;
+	int		n;
+
+	srchcfile_init();
+
+	ent = cfjnlTable(cfVfp, &nent);
+	if (ent == (CFJNLENT_T *)NULL) {
+		n = srchvfp(a_state, ept, path, cfVfp, cfTmpVfp);
+	} else {
+		n = srchjnl(a_state, ept, path, cfVfp, cfTmpVfp, ent, nent);
+	}
+
+	/* record the entries the caller may change (see cfjnlAppend) */
+
+	if ((path != (char *)NULL) && (*path == '/')) {
+		cfjnlTouch(cfVfp, path, strlen(path));
+	} else if ((n == 1) && (ept->path != (char *)NULL)) {
+		cfjnlTouch(cfVfp, ept->path, strlen(ept->path));
+	}
+
+	return (n);
+}
+
+/*
+ * Name:	srchvfp
+ * Description:	search the contents file data in a VFP, as srchcfile_r()
+ *		does if no journaled entries are attached to the VFP
+ * Arguments:	a_state, ept, path, cfVfp, cfTmpVfp - as srchcfile_r()
+ * Returns:	int - as srchcfile_r()
+ */
+
+static int
+srchvfp(SRCHSTATE_T *a_state, struct cfent *ept, char *path,
+	VFP_T *cfVfp, VFP_T *cfTmpVfp)
 {
 	char		*cpath_start = (char *)NULL;
 	char		*firstPos = vfpGetCurrCharPtr(cfVfp);
@@ -399,10 +503,10 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 
 	/* initialize local variables */
 
-	setErrstr(NULL);	/* no error message currently cached */
+	a_state->ss_errstr = NULL;	/* no error message currently cached */
 	pathLength = (path == (char *)NULL ? 0 : strlen(path));
-	lpath[0] = '\0';
-	lpath[sizeof (lpath)-1] = '\0';
+	a_state->ss_path[0] = '\0';
+	a_state->ss_path[sizeof (a_state->ss_path)-1] = '\0';
 
 	/* initialize ept structure values */
 
@@ -421,54 +525,13 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 	ept->pkg_class_idx = -1;
 	ept->volno = 0;
 
-	/*
-	 * populate decision tables that implement fast character checking;
-	 * this is much faster than the equivalent strpbrk() call or a
-	 * while() loop checking for the characters. It is only faster if
-	 * there are at least 3 characters to scan for - when checking for
-	 * one or two characters (such as '\n' or '\0') its faster to do
-	 * a simple while() loop.
-	 */
+	/* reuse the pinfo structures of the last entry returned */
 
-	if (decisionTableInit == 0) {
-		/*
-		 * any chars listed stop scan;
-		 * scan stops on first byte found that is set to '1' below
-		 */
-
-		/*
-		 * Separators for path names, normal space and =
-		 * for linked filenames
-		 */
-		bzero(ISPKGPATHSEP, sizeof (ISPKGPATHSEP));
-		ISPKGPATHSEP['='] = 1;		/* = */
-		ISPKGPATHSEP[' '] = 1;		/* space */
-		ISPKGPATHSEP['\t'] = 1;		/* horizontal-tab */
-		ISPKGPATHSEP['\n'] = 1;		/* new-line */
-		ISPKGPATHSEP['\0'] = 1;		/* NULL character */
-
-		/*
-		 * Separators for normal words
-		 */
-		bzero(ISWORDSEP, sizeof (ISWORDSEP));
-		ISWORDSEP[' '] = 1;
-		ISWORDSEP['\t'] = 1;
-		ISWORDSEP['\n'] = 1;
-		ISWORDSEP['\0'] = 1;
-
-		/*
-		 * Separators for list of packages, includes \\ for
-		 * alternate ftype and : for classname
-		 */
-		bzero(ISPKGNAMESEP, sizeof (ISPKGNAMESEP));
-		ISPKGNAMESEP[' '] = 1;
-		ISPKGNAMESEP['\t'] = 1;
-		ISPKGNAMESEP['\n'] = 1;
-		ISPKGNAMESEP[':'] = 1;
-		ISPKGNAMESEP['\\'] = 1;
-		ISPKGNAMESEP['\0'] = 1;
-
-		decisionTableInit = 1;
+	if (a_state->ss_arena != 0) {
+		a_state->ss_curr = a_state->ss_head;
+		if (a_state->ss_curr != (struct pinfoblk *)NULL) {
+			a_state->ss_curr->pb_used = 0;
+		}
 	}
 
 	/* if no bytes in contents file, return 0 */
@@ -490,7 +553,7 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 
 	if ((path != (char *)NULL) && (path[0] != '/')) {
 		if (strcmp(path, "*") != 0) {
-			setErrstr(pkg_gt(ERR_ILLEGAL_SEARCH_PATH));
+			SRCHERR(a_state, pkg_gt(ERR_ILLEGAL_SEARCH_PATH));
 			return (-1);
 		}
 		anypath = 1;
@@ -499,9 +562,17 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 	/* attempt to narrow down the search for the specified path */
 
 	if (anypath == 0) {
-		char	*np;
+		char	*np = (char *)NULL;
 
-		np = narrowSearch(cfVfp, path, pathLength);
+		/* exact match via the contents index, if one is attached */
+
+		if (path != (char *)NULL) {
+			np = cfidxFind(cfVfp, path, pathLength);
+		}
+
+		if (np == (char *)NULL) {
+			np = narrowSearch(cfVfp, path, pathLength);
+		}
 		if (np != (char *)NULL) {
 			dataSkipped = 1;
 			lastPos = np;
@@ -598,7 +669,7 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 			 *	ftype class path
 			 * set ept->ftype to the type
 			 * set ept->class to the class
-			 * set ept->path to point to lpath
+			 * set ept->path to point to ss_path
 			 * set cpath_start/cpath_len to point to the file name
 			 * set rdpath to '1' to indicate old style entry parsed
 			 */
@@ -615,8 +686,9 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 
 				/* save class */
 				if (getstr(&vfpGetCurrCharPtr(cfVfp), CLSSIZ,
-						ept->pkg_class, ISWORDSEP)) {
-					setErrstr(ERR_CANNOT_READ_CLASS_TOKEN);
+						ept->pkg_class, &ISWORDSEP)) {
+					SRCHERR(a_state,
+						ERR_CANNOT_READ_CLASS_TOKEN);
 					findend(&vfpGetCurrCharPtr(cfVfp));
 					return (-1);
 				}
@@ -632,10 +704,7 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 				 * skip past all bytes until first '= \t\n\0':
 				 */
 
-				while (ISPKGPATHSEP[(int)*p]
-									== 0) {
-					p++;
-				}
+				p = pkgstrScan(&ISPKGPATHSEP, p);
 
 				cpath_len = vfpGetCurrPtrDelta(cfVfp, p);
 
@@ -644,7 +713,8 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 				 */
 
 				if (cpath_len < 1) {
-					setErrstr(ERR_CANNOT_READ_PATHNAME_FLD);
+					SRCHERR(a_state,
+						ERR_CANNOT_READ_PATHNAME_FLD);
 					findend(&vfpGetCurrCharPtr(cfVfp));
 					return (-1);
 				}
@@ -652,7 +722,7 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 				vfpIncCurrPtrBy(cfVfp, cpath_len);
 
 				/* set path to point to local path cache */
-				ept->path = lpath;
+				ept->path = a_state->ss_path;
 
 				/* set flag indicating path already parsed */
 				rdpath = 1;
@@ -661,32 +731,32 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 			case '\0':
 				/* end of line before new-line seen */
 				vfpDecCurrPtr(cfVfp);
-				setErrstr(ERR_INCOMPLETE_ENTRY);
+				SRCHERR(a_state, ERR_INCOMPLETE_ENTRY);
 				return (-1);
 
 			case '0': case '1': case '2': case '3': case '4':
 			case '5': case '6': case '7': case '8': case '9':
 				/* volume number seen */
-				setErrstr(ERR_VOLUMENO_UNEXPECTED);
+				SRCHERR(a_state, ERR_VOLUMENO_UNEXPECTED);
 				findend(&vfpGetCurrCharPtr(cfVfp));
 				return (-1);
 
 			case 'i':
 				/* type i files are not cataloged */
-				setErrstr(ERR_FTYPE_I_UNEXPECTED);
+				SRCHERR(a_state, ERR_FTYPE_I_UNEXPECTED);
 				findend(&vfpGetCurrCharPtr(cfVfp));
 				return (-1);
 
 			default:
 				/* unknown ftype */
-				setErrstr(ERR_UNKNOWN_FTYPE);
+				SRCHERR(a_state, ERR_UNKNOWN_FTYPE);
 				findend(&vfpGetCurrCharPtr(cfVfp));
 				return (-1);
 			}
 		} else {
 			/*
 			 * current entry DOES start with absolute path
-			 * set ept->path to point to lpath
+			 * set ept->path to point to ss_path
 			 * set cpath_start/cpath_len to point to the file name
 			 */
 		/* copy first token into path element of passed structure */
@@ -699,21 +769,19 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 			 * skip past all bytes until first from '= \t\n\0':
 			 */
 
-			while (ISPKGPATHSEP[(int)*p] == 0) {
-				p++;
-			}
+			p = pkgstrScan(&ISPKGPATHSEP, p);
 
 			cpath_len = vfpGetCurrPtrDelta(cfVfp, p);
 
 			vfpIncCurrPtrBy(cfVfp, cpath_len);
 
 			if (vfpGetcNoInc(cfVfp) == '\0') {
-				setErrstr(ERR_INCOMPLETE_ENTRY);
+				SRCHERR(a_state, ERR_INCOMPLETE_ENTRY);
 				findend(&vfpGetCurrCharPtr(cfVfp));
 				return (-1);
 			}
 
-			ept->path = lpath;
+			ept->path = a_state->ss_path;
 		}
 
 		/*
@@ -755,16 +823,19 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 			if (c == '=') {
 				/* parse local path specification */
 				if (getstr(&vfpGetCurrCharPtr(cfVfp), PATH_MAX,
-						mylocal, ISWORDSEP)) {
+						a_state->ss_local,
+						&ISWORDSEP)) {
 
-					/* copy path found to 'lpath' */
-					COPYPATH(lpath, cpath_start, cpath_len);
+					/* copy path found to 'ss_path' */
+					COPYPATH(a_state, cpath_start,
+						cpath_len);
 
-					setErrstr(ERR_CANNOT_READ_LL_PATH);
+					SRCHERR(a_state,
+						ERR_CANNOT_READ_LL_PATH);
 					findend(&vfpGetCurrCharPtr(cfVfp));
 					return (-1);
 				}
-				ept->ainfo.local = mylocal;
+				ept->ainfo.local = a_state->ss_local;
 			}
 		}
 
@@ -789,12 +860,14 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 
 				/* save class */
 				if (getstr(&vfpGetCurrCharPtr(cfVfp), CLSSIZ,
-						ept->pkg_class, ISWORDSEP)) {
+						ept->pkg_class, &ISWORDSEP)) {
 
-					/* copy path found to 'lpath' */
-					COPYPATH(lpath, cpath_start, cpath_len);
+					/* copy path found to 'ss_path' */
+					COPYPATH(a_state, cpath_start,
+						cpath_len);
 
-					setErrstr(ERR_CANNOT_READ_CLASS_TOKEN);
+					SRCHERR(a_state,
+						ERR_CANNOT_READ_CLASS_TOKEN);
 					findend(&vfpGetCurrCharPtr(cfVfp));
 					return (-1);
 				}
@@ -804,38 +877,38 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 				/* end of line before new-line seen */
 				vfpDecCurrPtr(cfVfp);
 
-				/* copy path found to 'lpath' */
-				COPYPATH(lpath, cpath_start, cpath_len);
+				/* copy path found to 'ss_path' */
+				COPYPATH(a_state, cpath_start, cpath_len);
 
-				setErrstr(ERR_INCOMPLETE_ENTRY);
+				SRCHERR(a_state, ERR_INCOMPLETE_ENTRY);
 				return (-1);
 
 			case '0': case '1': case '2': case '3': case '4':
 			case '5': case '6': case '7': case '8': case '9':
 
-				/* copy path found to 'lpath' */
-				COPYPATH(lpath, cpath_start, cpath_len);
+				/* copy path found to 'ss_path' */
+				COPYPATH(a_state, cpath_start, cpath_len);
 
-				setErrstr(ERR_VOLUMENO_UNEXPECTED);
+				SRCHERR(a_state, ERR_VOLUMENO_UNEXPECTED);
 				findend(&vfpGetCurrCharPtr(cfVfp));
 				return (-1);
 
 			case 'i':
 
-				/* copy path found to 'lpath' */
-				COPYPATH(lpath, cpath_start, cpath_len);
+				/* copy path found to 'ss_path' */
+				COPYPATH(a_state, cpath_start, cpath_len);
 
-				setErrstr(ERR_FTYPE_I_UNEXPECTED);
+				SRCHERR(a_state, ERR_FTYPE_I_UNEXPECTED);
 				findend(&vfpGetCurrCharPtr(cfVfp));
 				return (-1);
 
 			default:
 				/* unknown ftype */
 
-				/* copy path found to 'lpath' */
-				COPYPATH(lpath, cpath_start, cpath_len);
+				/* copy path found to 'ss_path' */
+				COPYPATH(a_state, cpath_start, cpath_len);
 
-				setErrstr(ERR_UNKNOWN_FTYPE);
+				SRCHERR(a_state, ERR_UNKNOWN_FTYPE);
 				findend(&vfpGetCurrCharPtr(cfVfp));
 				return (-1);
 			}
@@ -868,8 +941,8 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 
 			vfpSetCurrCharPtr(cfVfp, pos);
 
-			/* copy path found to 'lpath' */
-			COPYPATH(lpath, cpath_start, cpath_len);
+			/* copy path found to 'ss_path' */
+			COPYPATH(a_state, cpath_start, cpath_len);
 
 			/* write out any skipped data before returning */
 			if (dataSkipped && (cfTmpVfp != (VFP_T *)NULL)) {
@@ -955,10 +1028,10 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 			if (px == (char *)NULL) {
 				vfpSeekToEnd(cfVfp);
 
-				/* copy path found to 'lpath' */
-				COPYPATH(lpath, cpath_start, cpath_len);
+				/* copy path found to 'ss_path' */
+				COPYPATH(a_state, cpath_start, cpath_len);
 
-				setErrstr(pkg_gt(ERR_MISSING_NEWLINE));
+				SRCHERR(a_state, pkg_gt(ERR_MISSING_NEWLINE));
 				findend(&vfpGetCurrCharPtr(cfVfp));
 				return (-1);
 			} else {
@@ -986,10 +1059,10 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 
 	if (((ept->ftype == 's') || (ept->ftype == 'l')) &&
 					(ept->ainfo.local == NULL)) {
-		/* copy path found to 'lpath' */
-		COPYPATH(lpath, cpath_start, cpath_len);
+		/* copy path found to 'ss_path' */
+		COPYPATH(a_state, cpath_start, cpath_len);
 
-		setErrstr(ERR_NO_LINK_SOURCE_SPECIFIED);
+		SRCHERR(a_state, ERR_NO_LINK_SOURCE_SPECIFIED);
 		findend(&vfpGetCurrCharPtr(cfVfp));
 		return (-1);
 	}
@@ -1003,10 +1076,10 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 				(long *)&ept->ainfo.major, BADMAJOR) ||
 		    getnum(&vfpGetCurrCharPtr(cfVfp), 10,
 				(long *)&ept->ainfo.minor, BADMINOR)) {
-			/* copy path found to 'lpath' */
-			COPYPATH(lpath, cpath_start, cpath_len);
+			/* copy path found to 'ss_path' */
+			COPYPATH(a_state, cpath_start, cpath_len);
 
-			setErrstr(pkg_gt(ERR_CANNOT_READ_MM_NUMS));
+			SRCHERR(a_state, pkg_gt(ERR_CANNOT_READ_MM_NUMS));
 			findend(&vfpGetCurrCharPtr(cfVfp));
 			return (-1);
 		}
@@ -1022,13 +1095,13 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 		if (getnum(&vfpGetCurrCharPtr(cfVfp), 8,
 				(long *)&ept->ainfo.mode, BADMODE) ||
 		    getstr(&vfpGetCurrCharPtr(cfVfp), sizeof (ept->ainfo.owner),
-				ept->ainfo.owner, ISWORDSEP) ||
+				ept->ainfo.owner, &ISWORDSEP) ||
 		    getstr(&vfpGetCurrCharPtr(cfVfp), sizeof (ept->ainfo.group),
-				ept->ainfo.group, ISWORDSEP)) {
-			/* copy path found to 'lpath' */
-			COPYPATH(lpath, cpath_start, cpath_len);
+				ept->ainfo.group, &ISWORDSEP)) {
+			/* copy path found to 'ss_path' */
+			COPYPATH(a_state, cpath_start, cpath_len);
 
-			setErrstr(ERR_CANNOT_READ_MOG);
+			SRCHERR(a_state, ERR_CANNOT_READ_MOG);
 			findend(&vfpGetCurrCharPtr(cfVfp));
 			return (-1);
 		}
@@ -1045,10 +1118,10 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 				(long *)&ept->cinfo.cksum, BADCONT) ||
 		    getnum(&vfpGetCurrCharPtr(cfVfp), 10,
 				(long *)&ept->cinfo.modtime, BADCONT)) {
-			/* copy path found to 'lpath' */
-			COPYPATH(lpath, cpath_start, cpath_len);
+			/* copy path found to 'ss_path' */
+			COPYPATH(a_state, cpath_start, cpath_len);
 
-			setErrstr(ERR_CANNOT_READ_CONTENT_INFO);
+			SRCHERR(a_state, ERR_CANNOT_READ_CONTENT_INFO);
 			findend(&vfpGetCurrCharPtr(cfVfp));
 			return (-1);
 		}
@@ -1057,14 +1130,14 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 	/* i files processing is completed - return 'exact match found' */
 
 	if (ept->ftype == 'i') {
-		/* copy path found to 'lpath' */
-		COPYPATH(lpath, cpath_start, cpath_len);
+		/* copy path found to 'ss_path' */
+		COPYPATH(a_state, cpath_start, cpath_len);
 
 		if (getend(&vfpGetCurrCharPtr(cfVfp))) {
-			/* copy path found to 'lpath' */
-			COPYPATH(lpath, cpath_start, cpath_len);
+			/* copy path found to 'ss_path' */
+			COPYPATH(a_state, cpath_start, cpath_len);
 
-			setErrstr(ERR_EXTRA_TOKENS);
+			SRCHERR(a_state, ERR_EXTRA_TOKENS);
 			return (-1);
 		}
 
@@ -1082,26 +1155,26 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 
 	lastpinfo = (struct pinfo *)NULL;
 	while ((c = getstr(&vfpGetCurrCharPtr(cfVfp), sizeof (pkgname),
-						pkgname, ISPKGNAMESEP)) <= 0) {
+						pkgname, &ISPKGNAMESEP)) <= 0) {
 		/* if c < 0 the string was too long to fix in the buffer */
 
 		if (c < 0) {
-			/* copy path found to 'lpath' */
-			COPYPATH(lpath, cpath_start, cpath_len);
+			/* copy path found to 'ss_path' */
+			COPYPATH(a_state, cpath_start, cpath_len);
 
-			setErrstr(ERR_PACKAGE_NAME_TOO_LONG);
+			SRCHERR(a_state, ERR_PACKAGE_NAME_TOO_LONG);
 			findend(&vfpGetCurrCharPtr(cfVfp));
 			return (-1);
 		}
 
 		/* a package is present - create and populate pinfo structure */
 
-		pinfo = (struct pinfo *)calloc(1, sizeof (struct pinfo));
+		pinfo = pinfoalloc(a_state);
 		if (!pinfo) {
-			/* copy path found to 'lpath' */
-			COPYPATH(lpath, cpath_start, cpath_len);
+			/* copy path found to 'ss_path' */
+			COPYPATH(a_state, cpath_start, cpath_len);
 
-			setErrstr(ERR_NO_MEMORY);
+			SRCHERR(a_state, ERR_NO_MEMORY);
 			findend(&vfpGetCurrCharPtr(cfVfp));
 			return (-1);
 		}
@@ -1134,7 +1207,7 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 		if (c == ':') {
 			/* get special classname */
 			(void) getstr(&vfpGetCurrCharPtr(cfVfp),
-				sizeof (classname), classname, ISWORDSEP);
+				sizeof (classname), classname, &ISWORDSEP);
 			(void) strlcpy(pinfo->aclass, classname,
 							sizeof (pinfo->aclass));
 			c = (vfpGetc(cfVfp));
@@ -1150,10 +1223,10 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 		/* if package not separated by a space return an error */
 
 		if (!isspace(c)) {
-			/* copy path found to 'lpath' */
-			COPYPATH(lpath, cpath_start, cpath_len);
+			/* copy path found to 'ss_path' */
+			COPYPATH(a_state, cpath_start, cpath_len);
 
-			setErrstr(ERR_BAD_ENTRY_END);
+			SRCHERR(a_state, ERR_BAD_ENTRY_END);
 			findend(&vfpGetCurrCharPtr(cfVfp));
 			return (-1);
 		}
@@ -1163,8 +1236,8 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 	 * parsing of the entry is complete
 	 */
 
-	/* copy path found to 'lpath' */
-	COPYPATH(lpath, cpath_start, cpath_len);
+	/* copy path found to 'ss_path' */
+	COPYPATH(a_state, cpath_start, cpath_len);
 
 	/* write out any skipped data before returning */
 	if (dataSkipped && (cfTmpVfp != (VFP_T *)NULL)) {
@@ -1175,7 +1248,7 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 
 	if ((c != '\n') && (c != '\0')) {
 		if (getend(&vfpGetCurrCharPtr(cfVfp)) && ept->pinfo) {
-			setErrstr(ERR_EXTRA_TOKENS);
+			SRCHERR(a_state, ERR_EXTRA_TOKENS);
 			return (-1);
 		}
 	}
@@ -1183,6 +1256,520 @@ srchcfile(struct cfent *ept, char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp)
 	return (1);
 }
 
+/*
+ * Name:	srchjnl
+ * Description:	search the contents file data in a VFP that journaled
+ *		entries are attached to: the entries of the contents file
+ *		and the journaled entries are merged in path order, and a
+ *		journaled entry takes the place of any contents file entry
+ *		for the same path
+ * Arguments:	a_state, ept, path, cfVfp, cfTmpVfp - as srchcfile_r()
+ *		a_ent - (CFJNLENT_T *) - [RO, *RO]
+ *			journaled entries, sorted by path
+ *		a_nent - (size_t) - [RO]
+ *			number of journaled entries
+ * Returns:	int - as srchcfile_r()
+ * NOTE:	a_state->ss_jnext is the next journaled entry to return or to
+ *		copy out; it is located again if the caller moved cfVfp
+ *		since the last call (see srchcfileSetPos()).
+ */
+
+static int
+srchjnl(SRCHSTATE_T *a_state, struct cfent *ept, char *path, VFP_T *cfVfp,
+	VFP_T *cfTmpVfp, CFJNLENT_T *a_ent, size_t a_nent)
+{
+	CFJNLENT_T	*je;
+	char		*cp;
+	int		c;
+	int		n;
+	size_t		clen;
+	size_t		len;
+
+	if ((path != (char *)NULL) && (*path == '\0')) {
+		path = (char *)NULL;
+	}
+
+	/* srchvfp() reports a path that cannot be searched for */
+
+	if ((path != (char *)NULL) && (*path != '/') &&
+			(strcmp(path, "*") != 0)) {
+		return (srchvfp(a_state, ept, path, cfVfp, cfTmpVfp));
+	}
+
+	if ((a_state->ss_jvfp != cfVfp) || (a_state->ss_jent != a_ent) ||
+			(a_state->ss_jpos != vfpGetCurrCharPtr(cfVfp))) {
+		a_state->ss_jvfp = cfVfp;
+		a_state->ss_jent = a_ent;
+		a_state->ss_jnext = jnlnext(cfVfp, a_ent, a_nent);
+	}
+
+	len = (path == (char *)NULL) ? 0 : strlen(path);
+
+	for (;;) {
+		je = (a_state->ss_jnext < a_nent) ?
+			&a_ent[a_state->ss_jnext] : (CFJNLENT_T *)NULL;
+
+		if ((path != (char *)NULL) && (*path == '*')) {
+			/* return whichever of the next entries sorts first */
+
+			cp = nextpath(cfVfp, &clen);
+			if (je == (CFJNLENT_T *)NULL) {
+				c = -1;
+			} else if (cp == (char *)NULL) {
+				c = 1;
+			} else {
+				c = pathcmp(cp, clen, je->je_path, je->je_plen);
+			}
+
+			if (c < 0) {
+				n = srchvfp(a_state, ept, path, cfVfp,
+					cfTmpVfp);
+				break;
+			}
+
+			/* the journaled entry replaces the contents entry */
+
+			if (c == 0) {
+				if ((cp = strchr(cp, '\n')) == (char *)NULL) {
+					cp = vfpGetLastCharPtr(cfVfp);
+				}
+				vfpGetCurrCharPtr(cfVfp) = cp + 1;
+			}
+
+			a_state->ss_jnext++;
+			if (je->je_line != (char *)NULL) {
+				n = jnlent(a_state, ept, cfVfp, je);
+				break;
+			}
+			continue;
+		}
+
+		if (je == (CFJNLENT_T *)NULL) {
+			c = 1;
+		} else if (path == (char *)NULL) {
+			c = -1;
+		} else {
+			c = pathcmp(je->je_path, je->je_plen, path, len);
+		}
+
+		if (c > 0) {
+			/* the next journaled entry is past the path */
+
+			n = srchvfp(a_state, ept, path, cfVfp, cfTmpVfp);
+			if ((je != (CFJNLENT_T *)NULL) && ((n == 0) ||
+				((n == 2) && (pathcmp(je->je_path, je->je_plen,
+				a_state->ss_path,
+				strlen(a_state->ss_path)) < 0)))) {
+				clen = je->je_plen;
+				COPYPATH(a_state, je->je_path, clen);
+				ept->path = a_state->ss_path;
+				n = 2;
+			}
+			break;
+		}
+
+		/*
+		 * copy out the contents entries that sort before the journaled
+		 * entry and skip the one it replaces
+		 */
+
+		skipto(cfVfp, cfTmpVfp, je->je_path, je->je_plen);
+		a_state->ss_jnext++;
+
+		if (c == 0) {
+			/* the path searched for is journaled */
+			if (je->je_line != (char *)NULL) {
+				n = jnlent(a_state, ept, cfVfp, je);
+				break;
+			}
+			continue;
+		}
+
+		if ((je->je_line != (char *)NULL) &&
+				(cfTmpVfp != (VFP_T *)NULL)) {
+			vfpPutBytes(cfTmpVfp, je->je_line, je->je_llen);
+		}
+	}
+
+	a_state->ss_jpos = vfpGetCurrCharPtr(cfVfp);
+
+	return (n);
+}
+
+/*
+ * Name:	jnlent
+ * Description:	parse a journaled entry as srchcfile_r() parses the entry
+ *		it returns
+ * Arguments:	a_state, ept - as srchcfile_r()
+ *		cfVfp - (VFP_T *) - [RO, *RO]
+ *			VFP the journaled entry is attached to
+ *		a_je - (CFJNLENT_T *) - [RO, *RO]
+ *			journaled entry to parse; not a removal
+ * Returns:	int - as srchcfile_r() for the path "*"
+ */
+
+static int
+jnlent(SRCHSTATE_T *a_state, struct cfent *ept, VFP_T *cfVfp,
+	CFJNLENT_T *a_je)
+{
+	VFP_T	jvfp;
+
+	/* a view of the line; it ends with a new-line */
+
+	jvfp = *cfVfp;
+	jvfp._vfpStart = a_je->je_line;
+	jvfp._vfpCurr = a_je->je_line;
+	jvfp._vfpHighWater = a_je->je_line + a_je->je_llen - 1;
+	jvfp._vfpEnd = jvfp._vfpHighWater;
+
+	return (srchvfp(a_state, ept, "*", &jvfp, (VFP_T *)NULL));
+}
+
+/*
+ * Name:	jnlnext
+ * Description:	locate the first journaled entry that sorts after the last
+ *		contents file entry before the current position of a VFP
+ * Arguments:	a_vfp - (VFP_T *) - [RO, *RO]
+ *			VFP the journaled entries are attached to
+ *		a_ent - (CFJNLENT_T *) - [RO, *RO]
+ *			journaled entries, sorted by path
+ *		a_nent - (size_t) - [RO]
+ *			number of journaled entries
+ * Returns:	size_t - index of the entry in a_ent; a_nent if none
+ */
+
+static size_t
+jnlnext(VFP_T *a_vfp, CFJNLENT_T *a_ent, size_t a_nent)
+{
+	char	*p = vfpGetCurrCharPtr(a_vfp);
+	char	*pe;
+	char	*ps = vfpGetFirstCharPtr(a_vfp);
+	size_t	i;
+
+	do {
+		if (p <= ps) {
+			return (0);
+		}
+		for (p--; (p > ps) && (p[-1] != '\n'); p--)
+			;
+	} while (*p != '/');
+
+	pe = pkgstrScan(&ISPKGPATHSEP, p);
+
+	i = cfjnlLocate(a_ent, a_nent, p, pe - p);
+	if ((i < a_nent) && (pathcmp(a_ent[i].je_path, a_ent[i].je_plen,
+			p, pe - p) == 0)) {
+		i++;
+	}
+
+	return (i);
+}
+
+/*
+ * Name:	nextpath
+ * Description:	locate the next contents file entry at or after the current
+ *		position of a VFP, skipping comments
+ * Arguments:	a_vfp - (VFP_T *) - [RO, *RO]
+ *			VFP open on the contents file
+ *		r_len - (size_t *) - [RO, *RW]
+ *			set to the length of the path of the entry
+ * Returns:	char * - the first byte of the entry
+ *			== (char *)NULL - no more entries
+ */
+
+static char *
+nextpath(VFP_T *a_vfp, size_t *r_len)
+{
+	char	*end = vfpGetLastCharPtr(a_vfp) + 1;
+	char	*p;
+
+	for (p = vfpGetCurrCharPtr(a_vfp); (p < end) && (*p != '\0'); p++) {
+		if (*p == '/') {
+			*r_len = pkgstrScan(&ISPKGPATHSEP, p) - p;
+			return (p);
+		}
+		if ((p = memchr(p, '\n', end - p)) == (char *)NULL) {
+			break;
+		}
+	}
+
+	return ((char *)NULL);
+}
+
+/*
+ * Name:	skipto
+ * Description:	copy out the contents file entries from the current position
+ *		of a VFP that sort before a path, and skip the entry for the
+ *		path if there is one
+ * Arguments:	a_vfp - (VFP_T *) - [RO, *RW]
+ *			VFP open on the contents file; the current position is
+ *			set to the first entry that sorts after the path, or
+ *			to the end of the last entry before the path
+ *		a_tmpVfp - (VFP_T *) - [RO, *RW]
+ *			VFP to copy the entries to, or (VFP_T *)NULL
+ *		a_path - (char *) - [RO, *RO]
+ *			path to skip to; need not be null terminated
+ *		a_len - (size_t) - [RO]
+ *			length of a_path
+ * Returns:	void
+ */
+
+static void
+skipto(VFP_T *a_vfp, VFP_T *a_tmpVfp, char *a_path, size_t a_len)
+{
+	char	*curr = vfpGetCurrCharPtr(a_vfp);
+	char	*end = vfpGetLastCharPtr(a_vfp) + 1;
+	char	*last;
+	char	*le = (char *)NULL;
+	char	*p;
+	int	n = 1;
+
+	if ((p = cfidxFind(a_vfp, a_path, a_len)) == (char *)NULL) {
+		p = narrowSearch(a_vfp, a_path, a_len);
+		if ((p == (char *)NULL) || (p < curr)) {
+			p = curr;
+		}
+	}
+
+	/* the entries before where the search starts sort before the path */
+
+	for (last = p; (p < end) && (*p != '\0'); p = le) {
+		le = memchr(p, '\n', end - p);
+		le = (le == (char *)NULL) ? end : le + 1;
+
+		if (*p != '/') {
+			continue;
+		}
+
+		n = pathcmp(p, pkgstrScan(&ISPKGPATHSEP, p) - p, a_path, a_len);
+		if (n >= 0) {
+			break;
+		}
+		last = le;
+	}
+
+	/* comments after the last entry stay behind for the end of the data */
+
+	if ((p >= end) || (*p == '\0')) {
+		p = last;
+		n = 1;
+	}
+
+	if ((a_tmpVfp != (VFP_T *)NULL) && (p > curr)) {
+		vfpPutBytes(a_tmpVfp, curr, p - curr);
+	}
+
+	vfpGetCurrCharPtr(a_vfp) = (n == 0) ? le : p;
+}
+
+/*
+ * Name:	pathcmp
+ * Description:	compare two paths in the order of the contents file
+ * Returns:	int - < 0, == 0 or > 0 as the first path sorts before, the same
+ *			as or after the second path
+ */
+
+static int
+pathcmp(char *a_p1, size_t a_l1, char *a_p2, size_t a_l2)
+{
+	int	n;
+
+	n = memcmp(a_p1, a_p2, (a_l1 < a_l2) ? a_l1 : a_l2);
+	if (n != 0) {
+		return (n);
+	}
+
+	return ((a_l1 < a_l2) ? -1 : ((a_l1 > a_l2) ? 1 : 0));
+}
+
+/*
+ * Name:	srchcfileArena
+ * Description:	select how srchcfile() allocates the pinfo structures of the
+ *		entries it returns
+ * Arguments:	a_enable - (boolean_t) - [RO]
+ *			B_TRUE - allocate them from blocks that are reused by
+ *			  the next call to srchcfile(); the caller must not
+ *			  free them or use them after the next call. This
+ *			  suits scans of a whole contents file.
+ *			B_FALSE - allocate each of them with calloc(); the
+ *			  caller owns them (default). Any blocks in use are
+ *			  freed.
+ * Returns:	void
+ */
+
+void
+srchcfileArena(boolean_t a_enable)
+{
+	srchstate.ss_arena = (a_enable == B_TRUE);
+
+	if (srchstate.ss_arena == 0) {
+		srchcfile_free(&srchstate);
+	}
+}
+
+/*
+ * Name:	srchcfileGetPos
+ * Description:	get the position of srchcfile() in the entries of a contents
+ *		file VFP, for srchcfileSetPos() to return to
+ * Arguments:	a_vfp - (VFP_T *) - [RO, *RO]
+ *			VFP open on the contents file
+ *		r_pos - (SRCHPOS_T *) - [RO, *RW]
+ *			set to the position
+ * Returns:	void
+ * NOTE:	With journaled entries merged, the current position of the
+ *		VFP alone does not tell which of the journaled entries that
+ *		sort before the contents entry there have been returned.
+ */
+
+void
+srchcfileGetPos(VFP_T *a_vfp, SRCHPOS_T *r_pos)
+{
+	size_t	nent;
+
+	r_pos->sp_curr = vfpGetCurrCharPtr(a_vfp);
+	r_pos->sp_jnext = ((srchstate.ss_jvfp == a_vfp) &&
+		(srchstate.ss_jent == cfjnlTable(a_vfp, &nent)) &&
+		(srchstate.ss_jpos == r_pos->sp_curr)) ?
+		srchstate.ss_jnext : (size_t)-1;
+}
+
+/*
+ * Name:	srchcfileSetPos
+ * Description:	return srchcfile() to a position in the entries of a
+ *		contents file VFP
+ * Arguments:	a_vfp - (VFP_T *) - [RO, *RW]
+ *			VFP open on the contents file
+ *		a_pos - (SRCHPOS_T *) - [RO, *RO]
+ *			position returned by srchcfileGetPos() for a_vfp
+ * Returns:	void
+ */
+
+void
+srchcfileSetPos(VFP_T *a_vfp, SRCHPOS_T *a_pos)
+{
+	size_t	nent;
+
+	vfpGetCurrCharPtr(a_vfp) = a_pos->sp_curr;
+
+	if (a_pos->sp_jnext != (size_t)-1) {
+		srchstate.ss_jvfp = a_vfp;
+		srchstate.ss_jent = cfjnlTable(a_vfp, &nent);
+		srchstate.ss_jpos = a_pos->sp_curr;
+		srchstate.ss_jnext = a_pos->sp_jnext;
+	}
+}
+
+/*
+ * Name:	srchcfile_init
+ * Description:	populate the character sets that implement fast character
+ *		checking; pkgstrScan() checks a word at a time, which is much
+ *		faster than the equivalent strpbrk() call or a while() loop
+ *		checking each byte against a decision table. The null
+ *		character is a member of every set.
+ * NOTE:	Must be called before srchcfile_r() is called on more than
+ *		one thread.
+ */
+
+void
+srchcfile_init(void)
+{
+	if (decisionTableInit != 0) {
+		return;
+	}
+
+	/*
+	 * Separators for path names, normal space and =
+	 * for linked filenames
+	 */
+	pkgstrScanInit(&ISPKGPATHSEP, "= \t\n");
+
+	/*
+	 * Separators for normal words
+	 */
+	pkgstrScanInit(&ISWORDSEP, " \t\n");
+
+	/*
+	 * Separators for list of packages, includes \\ for
+	 * alternate ftype and : for classname
+	 */
+	pkgstrScanInit(&ISPKGNAMESEP, " \t\n:\\");
+
+	decisionTableInit = 1;
+}
+
+/*
+ * Name:	srchcfile_free
+ * Description:	free the pinfo blocks held by a parse state
+ * Arguments:	a_state - (SRCHSTATE_T *) - [RO, *RW]
+ *			- parse state to free pinfo blocks of
+ * Returns:	void
+ */
+
+void
+srchcfile_free(SRCHSTATE_T *a_state)
+{
+	struct pinfoblk	*pb;
+
+	while ((pb = a_state->ss_head) != (struct pinfoblk *)NULL) {
+		a_state->ss_head = pb->pb_next;
+		free(pb);
+	}
+
+	a_state->ss_curr = (struct pinfoblk *)NULL;
+}
+
+/*
+ * Name:	pinfoalloc
+ * Description:	allocate a zeroed pinfo structure for the entry being parsed
+ * Arguments:	a_state - (SRCHSTATE_T *) - [RO, *RW]
+ *			- parse state of the entry
+ * Returns:	struct pinfo *
+ *			== NULL - no memory
+ *			!= NULL - the pinfo structure allocated
+ */
+
+static struct pinfo *
+pinfoalloc(SRCHSTATE_T *a_state)
+{
+	struct pinfoblk	*pb;
+	struct pinfo	*pinfo;
+
+	if (a_state->ss_arena == 0) {
+		return ((struct pinfo *)calloc(1, sizeof (struct pinfo)));
+	}
+
+	/* move on to the next block if the current block is used up */
+
+	pb = a_state->ss_curr;
+	if ((pb == (struct pinfoblk *)NULL) || (pb->pb_used == PINFO_BLKSIZE)) {
+		if ((pb != (struct pinfoblk *)NULL) &&
+				(pb->pb_next != (struct pinfoblk *)NULL)) {
+			pb = pb->pb_next;
+		} else {
+			struct pinfoblk	*npb;
+
+			npb = (struct pinfoblk *)malloc(sizeof (*npb));
+			if (npb == (struct pinfoblk *)NULL) {
+				return ((struct pinfo *)NULL);
+			}
+			npb->pb_next = (struct pinfoblk *)NULL;
+			if (pb == (struct pinfoblk *)NULL) {
+				a_state->ss_head = npb;
+			} else {
+				pb->pb_next = npb;
+			}
+			pb = npb;
+		}
+		pb->pb_used = 0;
+		a_state->ss_curr = pb;
+	}
+
+	pinfo = &pb->pb_pinfo[pb->pb_used++];
+	(void) memset(pinfo, 0, sizeof (struct pinfo));
+
+	return (pinfo);
+}
+
 static int
 getnum(char **cp, int base, long *d, long bad)
 {
@@ -1220,7 +1807,7 @@ getnum(char **cp, int base, long *d, long bad)
 }
 
 static int
-getstr(char **cp, int n, char *str, int separator[])
+getstr(char **cp, int n, char *str, PKGSTRSCAN_T *separator)
 {
 	int	c;
 	char	*p = *cp;
@@ -1245,10 +1832,7 @@ getstr(char **cp, int n, char *str, int separator[])
 
 	/* compute length based on delimiter found or not */
 
-	p1 = p;
-	while (separator[(int)*p1] == 0) {
-		p1++;
-	}
+	p1 = pkgstrScan(separator, p);
 
 	len = (ptrdiff_t)p1 - (ptrdiff_t)p;
 
@@ -0,0 +1,63 @@
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at src/OPENSOLARIS.LICENSE
+ * or http://www.opensolaris.org/os/licensing.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+#ifndef	_SRCHCFILE_H
+#define	_SRCHCFILE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <limits.h>
+#include <pkgstrct.h>
+
+/*
+ * Parse state of srchcfile(): srchcfile() itself uses a single static
+ * instance; the parallel contents file scan (cfscan.c) uses one instance
+ * for each thread.
+ */
+
+struct pinfoblk;
+struct _cfjnlent;
+
+typedef struct _srchstate {
+	char		ss_path[PATH_MAX];	/* for ept->path */
+	char		ss_local[PATH_MAX];	/* for ept->ainfo.local */
+	char		*ss_errstr;		/* reason for last failure */
+	int		ss_arena;		/* allocate pinfo from blocks */
+	struct pinfoblk	*ss_head;		/* first pinfo block */
+	struct pinfoblk	*ss_curr;		/* pinfo block in use */
+	VFP_T		*ss_jvfp;		/* VFP journal merged into */
+	struct _cfjnlent *ss_jent;		/* journaled entries merged */
+	char		*ss_jpos;		/* position after last call */
+	size_t		ss_jnext;		/* next journaled entry */
+} SRCHSTATE_T;
+
+extern void	srchcfile_free(SRCHSTATE_T *a_state);
+extern void	srchcfile_init(void);
+extern int	srchcfile_r(SRCHSTATE_T *a_state, struct cfent *ept,
+			char *path, VFP_T *cfVfp, VFP_T *cfTmpVfp);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _SRCHCFILE_H */
@@ -56,16 +56,23 @@
 #include <pkglib.h>
 #include <pkglibmsgs.h>
 #include <fcntl.h>
+#include <pthread.h>
 #ifdef __sun
 #include <sys/mkdev.h>
 #endif
 #include "pkglocale.h"
 
 #define	WDMSK	0xFFFF
+#define	CKSUM_IOSIZE	(64*1024)	/* 64kb read by compute_checksum() */
 static const char	DATEFMT[] ="%D %r";
-#define	LONG_BOUNDARY	((sizeof (unsigned long))-1)
 
-static char	theErrBuf[PATH_MAX+512] = {'\0'};
+/*
+ * averify() and cverify() may run on several threads at once (pkgchk -j);
+ * the error buffer they fill in and the status buffers fverify() reuses
+ * are therefore kept for each thread.
+ */
+
+static __thread char	theErrBuf[PATH_MAX+512] = {'\0'};
 static char	*theErrStr = NULL;
 
 /* checksum disable switch */
@@ -82,13 +89,6 @@ static int	clear_target(char *path, char *ftype, int is_a_dir);
 
 unsigned	long compute_checksum(int *r_err, char *path);
 
-/* union used to generate checksum */
-
-typedef union hilo { /* this only works right in case short is 1/2 of long */
-	struct part { unsigned short hi, lo; } hl;
-	long	lg;
-} CHECKSUM_T;
-
 /*PRINTFLIKE1*/
 static void
 reperr(char *fmt, ...)
@@ -152,6 +152,7 @@ cverify(int fix, char *ftype, char *path, struct cinfo *cinfo,
 {
 	struct stat	status; 	/* file status buffer */
 	struct utimbuf	times;
+	struct tm	tm;
 	unsigned long	mycksum;
 	int		setval, retcode;
 	char		tbuf1[512];
@@ -185,11 +186,11 @@ cverify(int fix, char *ftype, char *path, struct cinfo *cinfo,
 		} else if (fix < 0) {
 			/* modtimes must be the same */
 			if (strftime(tbuf1, sizeof (tbuf1), DATEFMT,
-				localtime(&cinfo->modtime)) == 0) {
+				localtime_r(&cinfo->modtime, &tm)) == 0) {
 				reperr(pkg_gt(ERR_MEM));
 			}
 			if (strftime(tbuf2, sizeof (tbuf2), DATEFMT,
-				localtime(&status.st_mtime)) == 0) {
+				localtime_r(&status.st_mtime, &tm)) == 0) {
 				reperr(pkg_gt(ERR_MEM));
 			}
 			reperr(pkg_gt(ERR_MTIME), tbuf1, tbuf2);
@@ -219,9 +220,14 @@ cverify(int fix, char *ftype, char *path, struct cinfo *cinfo,
 		return (retcode);
 	}
 
-	/* compute checksum */
+	/* compute checksum, unless the checksum cache holds it */
 
-	mycksum = compute_checksum(&cksumerr, path);
+	if (cksumCacheFind(&status, &mycksum) != 0) {
+		mycksum = compute_checksum(&cksumerr, path);
+		if (cksumerr == 0) {
+			cksumCacheAdd(&status, mycksum);
+		}
+	}
 
 	/* set value if not set or if checksum cannot be computed */
 
@@ -262,93 +268,73 @@ cverify(int fix, char *ftype, char *path, struct cinfo *cinfo,
 unsigned long
 compute_checksum(int *r_cksumerr, char *a_path)
 {
-	CHECKSUM_T	suma;	/* to split four-bytes into 2 two-byte values */
-	CHECKSUM_T	tempa;
-	VFP_T		*vfp;	/* -> VFP open on file to checksum */
-	long		lg;	/* running checksum value */
-	unsigned char	*ucp;	/* -> current byte to checksum */
-	unsigned char	*uep;	/* -> last byte to checksum */
-	unsigned long	*ulep;	/* -> current quad-byte word to checksum */
-	unsigned long	lsavhi;	/* high order two-bytes of four-byte checksum */
-	unsigned long	lsavlo;	/* low order two-bytes of four-byte checksum */
+	char		*buf;	/* -> buffer the file is read into */
+	int		fd;	/* file descriptor open on file to checksum */
+	ssize_t		n;	/* number of bytes read */
+	uint32_t	sum;	/* sum of all data bytes in file */
+	uint32_t	r;	/* sum folded into 17 bits */
 
 	/* reset error flag */
 
 	*r_cksumerr = 0;
 
-	/* open file and obtain -> where file is mapped/read */
+	/*
+	 * the file is read rather than mapped: it may be any file on the
+	 * system, and a mapped file truncated while it is summed would
+	 * kill the process with SIGBUS
+	 */
 
-	if (vfpOpen(&vfp, a_path, "r", VFP_SEQUENTIAL) != 0) {
+	if ((fd = open(a_path, O_RDONLY)) < 0) {
 		*r_cksumerr = 1;
 		reperr(pkg_gt(ERR_NO_CKSUM));
 		return (0);
 	}
 
-	/* initialize checksum value */
-
-	lg = 0;
-
-	/* establish -> last data byte in file */
-
-	uep = (unsigned char *)(vfpGetLastCharPtr(vfp));
-
-	/* establish -> first data byte in file */
-
-	ucp = (unsigned char *)(vfpGetFirstCharPtr(vfp));
-
-	/*
-	 * add up first few starting bytes until pointer is word aligned:
-	 * while the current byte pointer is not aligned on a unsigned long
-	 * boundary, add that byte into the checksum. By doing word-aligned
-	 * reading of the data bytes, memory access is reduced by 3/4.
-	 */
-
-	while (((((ptrdiff_t)ucp) & LONG_BOUNDARY) != 0) && (ucp <= uep)) {
-		lg += (((int)(*ucp++)) & WDMSK);
+	if ((buf = malloc(CKSUM_IOSIZE)) == (char *)NULL) {
+		(void) close(fd);
+		*r_cksumerr = 1;
+		reperr(pkg_gt(ERR_NO_CKSUM));
+		return (0);
 	}
 
-	/*
-	 * now word aligned - load one quad-byte word and add up bytes until
-	 * less than one quad-byte word left to process
-	 */
-
-	/* LINTED pointer cast may result in improper alignment */
-	ulep = ((unsigned long *)uep)-1;
-	/* LINTED pointer cast may result in improper alignment */
-	while ((unsigned long *)ucp < ulep) {
-		/* LINTED pointer cast may result in improper alignment */
-		unsigned long z = *(unsigned long *)ucp;
-		lg += (((int)(z>>24)&0xFF) & WDMSK);
-		lg += (((int)(z>>16)&0xFF) & WDMSK);
-		lg += (((int)(z>>8)&0xFF) & WDMSK);
-		lg += (((int)(z)&0xFF) & WDMSK);
-		ucp += sizeof (unsigned long);
-	}
+#ifdef	POSIX_FADV_SEQUENTIAL
+	(void) posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
 
-	/* add up bytes of remaining partial quad-word at end of file */
+	/* add up all data bytes in the file */
 
-	while (ucp <= uep) {
-		lg += (((int)(*ucp++)) & WDMSK);
+	sum = 0;
+	while ((n = read(fd, buf, CKSUM_IOSIZE)) != 0) {
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			free(buf);
+			(void) close(fd);
+			*r_cksumerr = 1;
+			reperr(pkg_gt(ERR_NO_CKSUM));
+			return (0);
+		}
+		sum = cksumBytes(sum, buf, (size_t)n);
 	}
 
 	/* close file */
 
-	(void) vfpClose(&vfp);
-
-	/* compute checksum components */
+	free(buf);
+	(void) close(fd);
 
-	suma.lg = lg;
-	tempa.lg = (suma.hl.lo & WDMSK) + (suma.hl.hi & WDMSK);
-	lsavhi = (unsigned long)tempa.hl.hi;
-	lsavlo = (unsigned long)tempa.hl.lo;
+	/* fold the two-byte halves of the sum as sum(1) does */
 
-	/* return final checksum value */
+	r = (sum & WDMSK) + (sum >> 16);
 
-	return (lsavhi+lsavlo);
+	return ((unsigned long)((r & WDMSK) + (r >> 16)));
 }
 
-static 	struct stat	status; 	/* file status buffer */
-static  struct statvfs	vfsstatus;	/* filesystem status buffer */
+static __thread struct stat	status; 	/* file status buffer */
+static __thread struct statvfs	vfsstatus;	/* filesystem status buffer */
+
+/* serializes the cached group and password lookups of averify() */
+static pthread_mutex_t	pwgrlock = PTHREAD_MUTEX_INITIALIZER;
 
 /*
  * Remove the thing that's currently in place so we can put down the package
@@ -416,9 +402,11 @@ averify(int fix, char *ftype, char *path, struct ainfo *ainfo)
 	char		buf[PATH_MAX];
 	ino_t		my_ino;
 	dev_t		my_dev;
-	char 		cwd[MAXPATHLEN];
-	char 		*cd;
+	char		dir[PATH_MAX];
+	char		target[PATH_MAX];
+	char		*local;
 	char 		*c;
+	struct stat	dirstatus;
 
 	setval = (*ftype == '?');
 	retcode = 0;
@@ -437,42 +425,45 @@ averify(int fix, char *ftype, char *path, struct ainfo *ainfo)
 		my_ino = status.st_ino;
 		my_dev = status.st_dev;
 
-		/* Get copy of the current working directory */
-		if (getcwd(cwd, MAXPATHLEN) == NULL) {
-			reperr(pkg_gt(ERR_GETWD), ainfo->local);
-			return (VE_FAIL);
-		}
-
 		/*
-		 * Change to the directory in which the hard
-		 * link is to be created.
+		 * A relative link target is relative to the directory in
+		 * which the hard link is to be created; rather than changing
+		 * to that directory, which would affect all threads of the
+		 * process, the target is prefixed with the directory.
 		 */
-		cd = strdup(path);
-		c = strrchr(cd, '/');
+		local = ainfo->local;
+		c = strrchr(path, '/');
 		if (c) {
 			/* bugid 4247895 */
-			if (strcmp(cd, c) == 0)
-				strcpy(cd, "/");
-			else
-				*c = 0;
+			(void) snprintf(dir, sizeof (dir), "%.*s",
+			    (c == path) ? 1 : (int)(c - path), path);
 
-			if (chdir(cd) != 0) {
-				reperr(pkg_gt(ERR_CHDIR), cd);
+			if ((stat(dir, &dirstatus) < 0) ||
+			    !S_ISDIR(dirstatus.st_mode)) {
+				reperr(pkg_gt(ERR_CHDIR), dir);
 				return (VE_FAIL);
 			}
+
+			if (*ainfo->local != '/') {
+				if (snprintf(target, sizeof (target), "%s/%s",
+				    dir, ainfo->local) >= sizeof (target)) {
+					reperr(pkg_gt(ERR_LINKLONG),
+					    ainfo->local);
+					return (VE_FAIL);
+				}
+				local = target;
+			}
 		}
-		free(cd);
 
 		if (retcode || (status.st_nlink < 2) ||
-		    (stat(ainfo->local, &status) < 0) ||
+		    (stat(local, &status) < 0) ||
 		    (my_dev != status.st_dev) || (my_ino != status.st_ino)) {
 			if (fix) {
 				/*
 				 * Don't want to do a hard link to a
 				 * directory.
 				 */
-				if (!isdir(ainfo->local)) {
-					chdir(cwd);
+				if (!isdir(local)) {
 					reperr(pkg_gt(ERR_LINKISDIR),
 					    ainfo->local);
 					return (VE_FAIL);
@@ -481,29 +472,18 @@ averify(int fix, char *ftype, char *path, struct ainfo *ainfo)
 				if (!clear_target(path, ftype, targ_is_dir))
 					return (VE_FAIL);
 
-				if (link(ainfo->local, path)) {
-					chdir(cwd);
+				if (link(local, path)) {
 					reperr(pkg_gt(ERR_LINKFAIL),
 					    ainfo->local);
 					return (VE_FAIL);
 				}
 				retcode = 0;
 			} else {
-				/* Go back to previous working directory */
-				if (chdir(cwd) != 0)
-					reperr(pkg_gt(ERR_CHDIR), cwd);
-
 				reperr(pkg_gt(ERR_LINK), ainfo->local);
 				return (VE_CONT);
 			}
 		}
 
-		/* Go back to previous working directory */
-		if (chdir(cwd) != 0) {
-			reperr(pkg_gt(ERR_CHDIR), cwd);
-			return (VE_CONT);
-		}
-
 		return (retcode);
 	}
 
@@ -709,6 +689,8 @@ averify(int fix, char *ftype, char *path, struct ainfo *ainfo)
 
 	dochown = 0;
 
+	(void) pthread_mutex_lock(&pwgrlock);
+
 	/* get group entry for specified group */
 	if (setval || strcmp(ainfo->group, BADGROUP) == 0) {
 		grp = cgrgid(status.st_gid);
@@ -778,6 +760,8 @@ averify(int fix, char *ftype, char *path, struct ainfo *ainfo)
 		}
 	}
 
+	(void) pthread_mutex_unlock(&pwgrlock);
+
 	if (statvfs(path, &vfsstatus) < 0) {
 		reperr(pkg_gt(ERR_EXIST));
 		retcode = VE_FAIL;
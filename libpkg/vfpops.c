@@ -122,10 +122,16 @@
 
 #define	VFP_ANONYMOUS_PATH	"<<string>>"
 
-/* minimum size file to mmap (64mb) */
+/* minimum size file to mmap (64kb) */
 
 #define	MIN_MMAP_SIZE	(64*1024)
 
+#ifndef	MAP_ANON
+#define	MAP_ANON	MAP_ANONYMOUS
+#endif
+
+static int	vfpPromote(VFP_T *a_vfp);
+
 /*
  * *****************************************************************************
  * global external (public) functions
@@ -242,62 +248,63 @@ vfpOpen(VFP_T **r_vfp, char *a_path, char *a_mode, VFPFLAGS_T a_flags)
 
 	vfp->_vfpStart = MAP_FAILED;	/* assume map failed if not allowed */
 
-#if 0
 	/*
-	 * if file is a regular file, and if mmap allowed,
+	 * if file is a regular file opened read-only, and if mmap allowed,
 	 * and (malloc not forbidden or size is > minumum size to mmap)
 	 */
 
-	if ((S_ISREG(statbuf.st_mode)) && (!(a_flags & VFP_NOMMAP)) &&
+	if ((S_ISREG(statbuf.st_mode)) && (statbuf.st_size > 0) &&
+		(*a_mode == 'r') && (strchr(a_mode, '+') == (char *)NULL) &&
+		(!(a_flags & VFP_NOMMAP)) &&
 		((a_flags & VFP_NOMALLOC) || statbuf.st_size > MIN_MMAP_SIZE)) {
 		char *p;
+
 		/* set size to current size of file */
 
 		vfp->_vfpMapSize = statbuf.st_size;
 
 		/*
 		 * compute proper size for mapping for the file contents;
-		 * add in one extra page so falling off end when file size is
-		 * exactly modulo page size does not cause a page fault to
-		 * guarantee that the end of the file contents will always
-		 * contain a '\0' null character.
+		 * round up to a whole number of pages and add in one extra
+		 * page so falling off end when file size is exactly modulo
+		 * page size does not cause a page fault to guarantee that the
+		 * end of the file contents will always contain a '\0' null
+		 * character.
 		 */
 
-		vfp->_vfpSize = (statbuf.st_size + pagesize +
-				(pagesize-(statbuf.st_size % pagesize)));
+		vfp->_vfpSize = (((statbuf.st_size + pagesize - 1) /
+				pagesize) * pagesize) + pagesize;
 
 		/*
 		 * mmap allowed: mmap file into memory
-		 * first allocate space on top of which the mapping can be done;
-		 * this way we can guarantee that if the mapping happens to be
-		 * an exact multiple of a page size, that there will be at least
-		 * one byte past the end of the mapping that can be accessed and
-		 * that is guaranteed to be zero.
+		 * first reserve zero-filled anonymous space on top of which
+		 * the mapping can be done; this way we can guarantee that if
+		 * the mapping happens to be an exact multiple of a page size,
+		 * that there will be at least one page past the end of the
+		 * mapping that can be accessed and that is guaranteed to be
+		 * zero. The mappings are private and writable, so a caller
+		 * that modifies the data gets a copy of just the pages it
+		 * touches - the file itself is never changed.
 		 */
 
-		/* allocate backing space */
-
-		p = (char *)memalign(pagesize, vfp->_vfpSize);
-		if (p == (char *)NULL) {
-			vfp->_vfpStart = MAP_FAILED;
-		} else {
-			/* guarantee first byte after end of data is zero */
+		p = mmap(NULL, vfp->_vfpSize, PROT_READ|PROT_WRITE,
+				MAP_PRIVATE|MAP_ANON, -1, (off_t)0);
+		if (p != MAP_FAILED) {
+			/* map file on top of the reserved space */
 
-			p[vfp->_vfpMapSize] = '\0';
-
-			/* map file on top of the backing space */
-
-			vfp->_vfpStart = mmap(p, vfp->_vfpMapSize, PROT_READ,
-				MAP_PRIVATE|MAP_FIXED, fileno(fp), (off_t)0);
+			vfp->_vfpStart = mmap(p, vfp->_vfpMapSize,
+				PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_FIXED,
+				fileno(fp), (off_t)0);
 
 			/* if mmap succeeded set mmap used flag in vfp */
 
 			if (vfp->_vfpStart != MAP_FAILED) {
 				vfp->_vfpFlags |= _VFP_MMAP;
+			} else {
+				(void) munmap(p, vfp->_vfpSize);
 			}
 		}
 	}
-#endif
 
 	/* if map failed (or not allowed) attempt malloc (if allowed) */
 
@@ -472,13 +479,9 @@ vfpClose(VFP_T **r_vfp)
 	if (vfp->_vfpFlags & _VFP_MALLOC) {
 		(void) free(vfp->_vfpStart);
 	} else if (vfp->_vfpFlags & _VFP_MMAP) {
-		/* unmap the file mapping */
+		/* unmap the file mapping and the reserved space behind it */
 
-		(void) munmap(vfp->_vfpStart, vfp->_vfpMapSize);
-
-		/* free the backing allocation */
-
-		(void) free(vfp->_vfpStart);
+		(void) munmap(vfp->_vfpStart, vfp->_vfpSize);
 	}
 
 	/* free up path */
@@ -596,9 +599,9 @@ vfpRewind(VFP_T *a_vfp)
  * Returns:	int	== 0 - operation was successful
  *			!= 0 - operation failed, errno contains reason
  * Side Effects:
- *		Currently only a file that is in malloc()ed memory can
- *		have its in-memory size changed.
- *		An error is returned If the file is mapped into memory.
+ *		Only a file that is in malloc()ed memory can have its
+ *		in-memory size changed. If the file is mapped into memory
+ *		the data is first copied into malloc()ed memory.
  *		A file cannot be decreased in size - if the specified
  *		size is less than the current size, the operation is
  *		successful but no change in file size occurs.
@@ -624,6 +627,12 @@ vfpSetSize(VFP_T *a_vfp, size_t a_size)
 		return (0);
 	}
 
+	/* a mapped file must be copied to allocated memory to be resized */
+
+	if ((a_vfp->_vfpFlags & _VFP_MMAP) && (vfpPromote(a_vfp) != 0)) {
+		return (-1);
+	}
+
 	/* if malloc not used don't know how to set size right now */
 
 	if (!(a_vfp->_vfpFlags & _VFP_MALLOC)) {
@@ -1299,3 +1308,56 @@ vfpSafePwrite(int a_fildes, void *a_buf, size_t a_nbyte, off_t a_offset)
 		a_offset += (off_t)r;
 	}
 }
+
+/*
+ * *****************************************************************************
+ * static internal (private) functions
+ * *****************************************************************************
+ */
+
+/*
+ * Name:	vfpPromote
+ * Description:	Replace the mapping of a mmap()ed VFP with a malloc()ed copy
+ *		of the same data, so the VFP can be resized and written out
+ * Arguments:	VFP_T *a_vfp - VFP_T pointer associated with mapped file
+ * Returns:	int	== 0 - operation was successful
+ *			!= 0 - operation failed, errno contains reason;
+ *				the VFP is still mapped and usable
+ */
+
+static int
+vfpPromote(VFP_T *a_vfp)
+{
+	char	*np;
+	size_t	size;
+
+	/* allocate the same size the malloc() path of vfpOpen would use */
+
+	size = a_vfp->_vfpMapSize + getpagesize();
+
+	np = (char *)malloc(size);
+	if (np == (char *)NULL) {
+		return (-1);
+	}
+
+	/* copy the data including any pages already modified in place */
+
+	(void) memcpy(np, a_vfp->_vfpStart, a_vfp->_vfpMapSize);
+	(void) memset(np + a_vfp->_vfpMapSize, '\0', size - a_vfp->_vfpMapSize);
+
+	/* adjust all pointers to account for buffer address change */
+
+	a_vfp->_vfpCurr = np + (a_vfp->_vfpCurr - a_vfp->_vfpStart);
+	a_vfp->_vfpHighWater = np + (a_vfp->_vfpHighWater - a_vfp->_vfpStart);
+	a_vfp->_vfpEnd = np + (a_vfp->_vfpEnd - a_vfp->_vfpStart);
+
+	(void) munmap(a_vfp->_vfpStart, a_vfp->_vfpSize);
+
+	a_vfp->_vfpStart = np;
+	a_vfp->_vfpSize = size;
+	a_vfp->_vfpMapSize = 0;
+	a_vfp->_vfpFlags &= ~_VFP_MMAP;
+	a_vfp->_vfpFlags |= _VFP_MALLOC;
+
+	return (0);
+}
@@ -14,7 +14,7 @@ OBJ = dofinal.o installf.o main.o removef.o ../../version/version.o
 all: $(BIN)
 
 $(BIN): $(OBJ)
-	$(CC) $(LDFLAGS) $(OBJ) $(PKGLIBS) $(LIBS) -o $@
+	$(CC) $(LDFLAGS) $(OBJ) $(PKGLIBS) $(LIBS) -lpthread -o $@
 
 $(BIN): ../../libadm/libadm.a ../../libgendb/libgendb.a \
 	../../libinst/libinst.a ../../libpkg/libpkgu.a
@@ -9,12 +9,12 @@ PKGLIBS = -L../../libinst -linst -L../../libpkg -lpkgu -L../../libgendb -lgendb
 	-L$(CCSDIR)/lib -ll
 
 BIN = pkgadd
-OBJ = check.o main.o quit.o ../../version/version.o
+OBJ = check.o main.o pkgorder.o quit.o ../../version/version.o
 
 all: $(BIN)
 
 $(BIN): $(OBJ)
-	$(CC) $(LDFLAGS) $(OBJ) $(PKGLIBS) $(LIBS) -o $@
+	$(CC) $(LDFLAGS) $(OBJ) $(PKGLIBS) $(LIBS) -lz -lpthread -o $@
 
 $(BIN): ../../libadm/libadm.a ../../libgendb/libgendb.a \
 	../../libinst/libinst.a ../../libpkg/libpkgu.a
@@ -46,7 +46,12 @@ main.o: main.c ../../hdrs/pkgdev.h ../../hdrs/pkginfo.h \
   ../../hdrs/install.h ../../hdrs/libinst.h ../../libpkg/cfext.h \
   ../../hdrs/install.h ../../hdrs/libadm.h ../ \
   ../../hdrs/sys/dklabel.h ../../hdrs/valtools.h ../../hdrs/messages.h \
-  quit.h
+  quit.h pkgadd.h
+pkgorder.o: pkgorder.c ../../hdrs/pkgstrct.h ../../libpkg/pkglib.h \
+  ../../hdrs/pkgdev.h ../../libpkg/pkgerr.h ../../libpkg/keystore.h \
+  ../../libpkg/cfext.h ../../hdrs/libadm.h ../../hdrs/pkginfo.h \
+  ../../hdrs/valtools.h ../../hdrs/install.h ../../hdrs/libinst.h \
+  ../../hdrs/messages.h pkgadd.h
 quit.o: quit.c ../../hdrs/pkgdev.h ../../libpkg/pkglib.h \
   ../../hdrs/pkgstrct.h ../../libpkg/pkgerr.h ../../libpkg/keystore.h \
   ../../libpkg/cfext.h ../../hdrs/libadm.h \
@@ -95,6 +95,7 @@
  */
 
 #include "quit.h"
+#include "pkgadd.h"
 
 #undef	P_tmpdir
 #define	P_tmpdir	"/var/tmp/"
@@ -182,6 +183,9 @@ static boolean_t	debugFlag = B_FALSE;
 
 static boolean_t	globalZoneOnly = B_FALSE;
 
+/* Set while a batch of packages is added to the global zone */
+static boolean_t	contentsBatch = B_FALSE;
+
 /* Set by -O patchPkgRemoval */
 
 static boolean_t	patchPkgRemoval = B_FALSE;
@@ -1211,6 +1215,17 @@ main(int argc, char **argv)
 			/* NOTREACHED */
 		}
 
+		/*
+		 * add the packages after those of the list they depend on;
+		 * the depend files of a data stream are not unpacked yet
+		 */
+
+		if ((npkgs > 1) && (ids_name == (char *)NULL) &&
+			(pkgorder(pkglist, pkgdev.dirname) != 0)) {
+			quit(1);
+			/* NOTREACHED */
+		}
+
 		/*
 		 * package list generated - add packages
 		 */
@@ -2022,6 +2037,13 @@ pkgInstall(char *a_altRoot, char *a_idsName, char *a_pkgDir, char *a_altBinDir,
 		arg[nargs++] = "-G";
 	}
 
+	/* batch of packages: pass -O contents-batch to pkginstall */
+
+	if (contentsBatch == B_TRUE) {
+		arg[nargs++] = "-O";
+		arg[nargs++] = "contents-batch";
+	}
+
 	/* pkgadd -b dir: pass -b to pkginstall */
 
 	if (a_altBinDir != (char *)NULL) {
@@ -2955,7 +2977,7 @@ unpack_and_check_packages(char **a_pkgList, char *a_idsName, char *a_packageDir)
 		if (a_idsName != (char *)NULL) {
 			/* create stream out of package if not already one */
 			if (unpack_package_from_stream(a_idsName, pkginst,
-				a_packageDir) == B_FALSE) {
+				a_packageDir, B_FALSE) == B_FALSE) {
 				progerr(ERR_CANNOT_UNPACK_PKGSTRM,
 					PSTR(pkginst), PSTR(a_idsName),
 					PSTR(a_packageDir));
@@ -4275,6 +4297,7 @@ add_packages(char **a_pkgList, char *a_uri,
 	zoneList_t	zlst;
 #endif
 	boolean_t	b;
+	int		n;
 
 	/* entry assertions */
 
@@ -4376,9 +4399,31 @@ add_packages(char **a_pkgList, char *a_uri,
 		return (B_FALSE);
 	}
 
+	/*
+	 * if more than one package is added, journal the contents file
+	 * updates of all packages and rewrite the contents file only once
+	 * when all packages have been added
+	 */
+
+	for (n = 0; a_pkgList[n] != (char *)NULL; n++)
+		;
+
+	if ((n > 1) && (askflag == 0) && (pkgdrtarg == (char *)NULL)) {
+		contentsBatch = (begin_cfbatch() != 0) ? B_TRUE : B_FALSE;
+		if (contentsBatch == B_TRUE) {
+			quitSetContentsBatch(a_pkgList[n-1]);
+		}
+	}
+
 	b = add_packages_in_global_no_zones(a_pkgList, a_uri, a_idsName,
 		a_repeat, a_altBinDir, a_device);
 
+	if (contentsBatch == B_TRUE) {
+		contentsBatch = B_FALSE;
+		quitSetContentsBatch((char *)NULL);
+		(void) end_cfbatch(a_pkgList[n-1]);
+	}
+
 	(void) z_unlock_this_zone(ZLOCKS_ALL);
 
 	return (B_FALSE);
@@ -0,0 +1,36 @@
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at src/OPENSOLARIS.LICENSE
+ * or http://www.opensolaris.org/os/licensing.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+#ifndef __PKG_PKGADD_H__
+#define	__PKG_PKGADD_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* pkgorder.c */
+extern int	pkgorder(char **a_pkgList, char *a_dirname);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __PKG_PKGADD_H__ */
@@ -0,0 +1,484 @@
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at src/OPENSOLARIS.LICENSE
+ * or http://www.opensolaris.org/os/licensing.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+/*
+ * Order in which the packages of a batch are added.
+ *
+ * pkginstall checks the prerequisites of one package at a time, so a
+ * package given before one of its prerequisites in the same batch fails
+ * its dependency check. The depend files of all packages of the batch are
+ * read before any is added: a package is added after the packages of the
+ * batch it names in a prerequisite ('P') entry, and before those it names
+ * in a reverse dependency ('R') entry. Otherwise the order given is kept;
+ * of the packages that can be added next, the one given first is taken.
+ *
+ * If packages wait for one another, a warning names the one given first
+ * of a cycle, which is then added before its prerequisites. If packages
+ * of the batch are incompatible ('I') with one another, none is added:
+ * pkginstall would only find out after the first of them was added.
+ * The instance suffix of a package named in a depend file is ignored, as
+ * the packages of the batch are matched by abbreviation. Dependencies on
+ * installed packages are left to pkginstall.
+ *
+ * The layer of a package is the length of the longest chain of packages
+ * of the batch it waits for; the packages of a layer do not depend on one
+ * another. It is shown in debug output.
+ */
+
+#include <stdio.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <pkgstrct.h>
+#include <locale.h>
+#include <libintl.h>
+#include <pkglib.h>
+#include <libadm.h>
+#include <libinst.h>
+#include <messages.h>
+#include "install.h"
+#include "pkgadd.h"
+
+#define	PO_LSIZE	256
+
+/* a package of the batch */
+
+struct pkgnode {
+	char	*pn_pkg;	/* package, as given */
+	size_t	pn_len;		/* length of the package abbreviation */
+	int	*pn_next;	/* packages to add after this one */
+	int	pn_nnext;
+	int	*pn_prev;	/* packages to add before this one */
+	int	pn_nprev;
+	int	pn_nwait;	/* packages of pn_prev not yet added */
+	int	pn_layer;	/* longest chain of packages waited for */
+	int	pn_done;	/* != 0 once ready to be added */
+	int	pn_mark;	/* last search of oncycle() to see it */
+};
+
+static struct pkgnode	*nodes;
+static int		nnodes;
+static int		*byname;	/* packages sorted by abbreviation */
+static int		*heap;		/* packages ready, given first on top */
+static int		nheap;
+static int		nincompat;	/* incompatible packages found */
+
+extern struct admin	adm;
+
+static void	freenodes(void);
+static void	readdepend(int a_i, char *a_dirname);
+static void	addedge(int a_from, int a_to);
+static void	addint(int **a_list, int *a_n, int a_val);
+static int	abbrcmp(char *a_pkg1, size_t a_len1, char *a_pkg2,
+			size_t a_len2);
+static int	namecmp(const void *a_i1, const void *a_i2);
+static int	findpkg(char *a_abbrev, size_t a_len);
+static int	oncycle(int a_start);
+static int	waiting(int a_i);
+static void	push(int a_i);
+static int	pop(void);
+
+/*
+ * Name:	pkgorder
+ * Description:	Order a list of packages to add so that each package is
+ *		added after the packages of the list it depends on
+ * Arguments:	a_pkgList - (char **) - [RO, *RW]
+ *			Packages to add, terminated by NULL; reordered in
+ *			place
+ *		a_dirname - (char *) - [RO, *RO]
+ *			Directory the packages are in
+ * Returns:	int
+ *			== 0 - the packages are ordered
+ *			!= 0 - packages of the list are incompatible with one
+ *				another, and none should be added
+ */
+
+int
+pkgorder(char **a_pkgList, char *a_dirname)
+{
+	int	*order;
+	int	norder = 0;
+	int	first = 0;
+	int	i;
+	int	u;
+	int	v;
+	char	*p;
+
+	for (nnodes = 0; a_pkgList[nnodes] != (char *)NULL; nnodes++)
+		;
+
+	if (nnodes < 2) {
+		return (0);
+	}
+
+	nodes = (struct pkgnode *)calloc(nnodes, sizeof (struct pkgnode));
+	byname = (int *)calloc(nnodes, sizeof (int));
+	heap = (int *)calloc(nnodes, sizeof (int));
+	order = (int *)calloc(nnodes, sizeof (int));
+	if ((nodes == (struct pkgnode *)NULL) || (byname == (int *)NULL) ||
+	    (heap == (int *)NULL) || (order == (int *)NULL)) {
+		progerr(ERR_MEMORY, errno);
+		quit(99);
+	}
+
+	for (i = 0; i < nnodes; i++) {
+		nodes[i].pn_pkg = a_pkgList[i];
+		p = strchr(a_pkgList[i], '.');
+		nodes[i].pn_len = (p == (char *)NULL) ? strlen(a_pkgList[i]) :
+		    (size_t)(p - a_pkgList[i]);
+		byname[i] = i;
+	}
+	qsort(byname, nnodes, sizeof (int), namecmp);
+
+	nincompat = 0;
+	for (i = 0; i < nnodes; i++) {
+		readdepend(i, a_dirname);
+	}
+
+	if (nincompat != 0) {
+		free(order);
+		freenodes();
+		return (1);
+	}
+
+	nheap = 0;
+	for (i = 0; i < nnodes; i++) {
+		if (nodes[i].pn_nwait == 0) {
+			nodes[i].pn_done = 1;
+			push(i);
+		}
+	}
+
+	for (;;) {
+		while (nheap > 0) {
+			u = pop();
+			order[norder++] = u;
+			echoDebug(DBG_PKGADD_ORDER, nodes[u].pn_pkg,
+			    nodes[u].pn_layer);
+
+			for (i = 0; i < nodes[u].pn_nnext; i++) {
+				v = nodes[u].pn_next[i];
+				if (nodes[v].pn_done) {
+					continue;
+				}
+				if (nodes[v].pn_layer <= nodes[u].pn_layer) {
+					nodes[v].pn_layer =
+					    nodes[u].pn_layer + 1;
+				}
+				if (--nodes[v].pn_nwait == 0) {
+					nodes[v].pn_done = 1;
+					push(v);
+				}
+			}
+		}
+
+		if (norder >= nnodes) {
+			break;
+		}
+
+		/* the packages left wait for one another */
+
+		while (nodes[first].pn_done) {
+			first++;
+		}
+		u = oncycle(first);
+		logerr(WRN_PKGADD_CYCLE, nodes[u].pn_pkg);
+		nodes[u].pn_done = 1;
+		push(u);
+	}
+
+	for (i = 0; i < nnodes; i++) {
+		a_pkgList[i] = nodes[order[i]].pn_pkg;
+	}
+
+	free(order);
+	freenodes();
+
+	return (0);
+}
+
+/* release the packages of the batch */
+
+static void
+freenodes(void)
+{
+	int	i;
+
+	for (i = 0; i < nnodes; i++) {
+		free(nodes[i].pn_next);
+		free(nodes[i].pn_prev);
+	}
+
+	free(heap);
+	free(byname);
+	free(nodes);
+	nodes = (struct pkgnode *)NULL;
+	nnodes = 0;
+}
+
+/*
+ * read the depend file of a package, adding the dependencies on other
+ * packages of the batch
+ */
+
+static void
+readdepend(int a_i, char *a_dirname)
+{
+	FILE	*fp;
+	char	path[PATH_MAX];
+	char	line[PO_LSIZE];
+	char	abbrev[128+1];
+	char	type;
+	char	*p;
+	size_t	len;
+	int	bol = 1;
+	int	start;
+	int	j;
+
+	if (snprintf(path, sizeof (path), "%s/%s/%s", a_dirname,
+	    nodes[a_i].pn_pkg, DEPEND_FILE) >= sizeof (path)) {
+		return;
+	}
+
+	if ((fp = fopen(path, "r")) == (FILE *)NULL) {
+		return;
+	}
+
+	while (fgets(line, sizeof (line), fp) != (char *)NULL) {
+		/* an entry begins at the start of a line only */
+		start = bol;
+		bol = (strchr(line, '\n') != (char *)NULL);
+
+		abbrev[0] = '\0';
+		if (!start || (sscanf(line, "%c %128s", &type, abbrev) != 2)) {
+			continue;
+		}
+
+		/* any instance of the package named matches */
+		if ((p = strchr(abbrev, '.')) != (char *)NULL) {
+			*p = '\0';
+		}
+
+		len = strlen(abbrev);
+		for (j = findpkg(abbrev, len); (j < nnodes) &&
+		    (abbrcmp(nodes[byname[j]].pn_pkg, nodes[byname[j]].pn_len,
+		    abbrev, len) == 0); j++) {
+			switch (type) {
+			    case 'P':
+				addedge(byname[j], a_i);
+				break;
+
+			    case 'R':
+				addedge(a_i, byname[j]);
+				break;
+
+			    case 'I':
+				if (byname[j] == a_i) {
+					break;
+				}
+				/* pkginstall does not check either */
+				if (ADM(idepend, "nocheck")) {
+					logerr(WRN_PKGADD_INCOMPAT,
+					    nodes[a_i].pn_pkg,
+					    nodes[byname[j]].pn_pkg);
+					break;
+				}
+				progerr(ERR_PKGADD_INCOMPAT,
+				    nodes[a_i].pn_pkg,
+				    nodes[byname[j]].pn_pkg);
+				nincompat++;
+				break;
+
+			    default:
+				/* dockdeps() reports unknown types */
+				break;
+			}
+		}
+	}
+
+	(void) fclose(fp);
+}
+
+/* have a package added before another */
+
+static void
+addedge(int a_from, int a_to)
+{
+	if (a_from == a_to) {
+		return;
+	}
+
+	addint(&nodes[a_from].pn_next, &nodes[a_from].pn_nnext, a_to);
+	addint(&nodes[a_to].pn_prev, &nodes[a_to].pn_nprev, a_from);
+	nodes[a_to].pn_nwait++;
+}
+
+static void
+addint(int **a_list, int *a_n, int a_val)
+{
+	int	*p;
+
+	p = (int *)realloc(*a_list, (*a_n + 1) * sizeof (int));
+	if (p == (int *)NULL) {
+		progerr(ERR_MEMORY, errno);
+		quit(99);
+	}
+
+	p[(*a_n)++] = a_val;
+	*a_list = p;
+}
+
+/* compare two package abbreviations */
+
+static int
+abbrcmp(char *a_pkg1, size_t a_len1, char *a_pkg2, size_t a_len2)
+{
+	int	n;
+
+	n = strncmp(a_pkg1, a_pkg2, (a_len1 < a_len2) ? a_len1 : a_len2);
+	if (n != 0) {
+		return (n);
+	}
+	if (a_len1 != a_len2) {
+		return ((a_len1 < a_len2) ? -1 : 1);
+	}
+
+	return (0);
+}
+
+/* order packages by abbreviation, then as given */
+
+static int
+namecmp(const void *a_i1, const void *a_i2)
+{
+	int	i1 = *(const int *)a_i1;
+	int	i2 = *(const int *)a_i2;
+	int	n;
+
+	n = abbrcmp(nodes[i1].pn_pkg, nodes[i1].pn_len,
+	    nodes[i2].pn_pkg, nodes[i2].pn_len);
+
+	return ((n != 0) ? n : (i1 - i2));
+}
+
+/* return the first position of byname at or after a package abbreviation */
+
+static int
+findpkg(char *a_abbrev, size_t a_len)
+{
+	int	lo = 0;
+	int	hi = nnodes;
+	int	mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (abbrcmp(nodes[byname[mid]].pn_pkg,
+		    nodes[byname[mid]].pn_len, a_abbrev, a_len) < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return (lo);
+}
+
+/*
+ * find a cycle of packages waiting for one another by following, from a
+ * package not yet added, the packages it waits for; return the package
+ * of the cycle given first
+ */
+
+static int
+oncycle(int a_start)
+{
+	static int	mark = 0;
+	int		u;
+	int		v;
+	int		m;
+
+	mark++;
+	for (u = a_start; nodes[u].pn_mark != mark; u = waiting(u)) {
+		nodes[u].pn_mark = mark;
+	}
+
+	for (m = u, v = waiting(u); v != u; v = waiting(v)) {
+		if (v < m) {
+			m = v;
+		}
+	}
+
+	return (m);
+}
+
+/* return the first package a package not yet added waits for */
+
+static int
+waiting(int a_i)
+{
+	int	i;
+
+	for (i = 0; i < nodes[a_i].pn_nprev; i++) {
+		if (!nodes[nodes[a_i].pn_prev[i]].pn_done) {
+			return (nodes[a_i].pn_prev[i]);
+		}
+	}
+
+	/* NOTREACHED - a package not yet added waits for another */
+	return (a_i);
+}
+
+static void
+push(int a_i)
+{
+	int	i;
+
+	for (i = nheap++; (i > 0) && (heap[(i - 1) / 2] > a_i);
+	    i = (i - 1) / 2) {
+		heap[i] = heap[(i - 1) / 2];
+	}
+	heap[i] = a_i;
+}
+
+static int
+pop(void)
+{
+	int	top = heap[0];
+	int	last = heap[--nheap];
+	int	i = 0;
+	int	c;
+
+	while ((c = 2 * i + 1) < nheap) {
+		if ((c + 1 < nheap) && (heap[c + 1] < heap[c])) {
+			c++;
+		}
+		if (heap[c] >= last) {
+			break;
+		}
+		heap[i] = heap[c];
+		i = c;
+	}
+	heap[i] = last;
+
+	return (top);
+}
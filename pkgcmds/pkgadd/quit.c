@@ -69,6 +69,7 @@ extern int	warnflag;	/* != 0 if non-fatal error has occurred (2) */
  * forward declarations
  */
 
+static char		*contentsBatch = (char *)NULL;
 static char		*dwnldTempDir = (char *)NULL;
 static char		*idsName = (char *)NULL;
 static char		*zoneTempDir = (char *)NULL;
@@ -83,6 +84,7 @@ static zoneList_t	zoneList = (zoneList_t)NULL;
 
 void		quit(int retcode);
 void		quitSetCkreturnFunc(ckreturnFunc_t *a_ckreturnFunc);
+void		quitSetContentsBatch(char *a_pkginst);
 void		quitSetDwnldTmpdir(char *a_dwnldTempDir);
 void		quitSetIdsName(char *a_idsName);
 void		quitSetZoneName(char *a_zoneName);
@@ -221,6 +223,24 @@ quitSetDwnldTmpdir(char *a_dwnldTempDir)
 	dwnldTempDir = a_dwnldTempDir;
 }
 
+/*
+ * Name:	quitSetContentsBatch
+ * Description:	set the package to finish the contents file batch with
+ * Arguments:	a_pkginst - pointer to string representing the package instance
+ *			to pass to end_cfbatch(), or NULL once the batch begun
+ *			with begin_cfbatch() has been finished
+ * Returns:	void
+ * NOTE:	If a package is set when quit() is called, end_cfbatch() is
+ *		called to fold the updates journaled by the packages added
+ *		so far into the contents file before quit() calls exit
+ */
+
+void
+quitSetContentsBatch(char *a_pkginst)
+{
+	contentsBatch = a_pkginst;
+}
+
 /*
  * Name:	quit
  * Description:	cleanup and exit
@@ -321,6 +341,13 @@ quit(int a_retcode)
 		echo(MSG_N_PKGS_NOT_PROCESSED, npkgs);
 	}
 
+	/* if set finish the contents file batch */
+
+	if (contentsBatch != (char *)NULL) {
+		(void) end_cfbatch(contentsBatch);
+		contentsBatch = (char *)NULL;
+	}
+
 	/* if a zone list exists, unlock all zones */
 
 	if (zoneList != (zoneList_t)NULL) {
@@ -56,6 +56,7 @@ extern "C" {
 extern sighdlrFunc_t *quitGetTrapHandler(void);
 extern void	quit(int retcode);
 extern void	quitSetCkreturnFunc(ckreturnFunc_t *a_ckreturnFunc);
+extern void	quitSetContentsBatch(char *a_pkginst);
 extern void	quitSetDwnldTmpdir(char *z_dwnldTempDir);
 extern void	quitSetIdsName(char *a_idsName);
 extern void	quitSetZoneName(char *a_zoneName);
@@ -424,8 +424,20 @@ convert_contents_to_sql(struct dstr *pd, const char *pcroot)
 		return (1);
 	}
 
+	if (cfjnlOpen(vfp, 0) < 0) {
+		log_msg(LOG_MSG_ERR, MSG_FILE_ACCESS, path, strerror(errno));
+		(void) vfpClose(&vfp);
+		return (1);
+	}
+
+	/* the pinfo list of each entry is only needed until the next one */
+
+	srchcfileArena(B_TRUE);
+
 	while ((n = srchcfile(&entry, "*", vfp, (VFP_T *)NULL)) > 0) {
 		if (append_contents_sql(pd, &entry)) {
+			srchcfileArena(B_FALSE);
+			cfjnlClose();
 			(void) vfpClose(&vfp);
 			return (1);
 		}
@@ -433,6 +445,9 @@ convert_contents_to_sql(struct dstr *pd, const char *pcroot)
 		total++;
 	}
 
+	srchcfileArena(B_FALSE);
+
+	cfjnlClose();
 	(void) vfpClose(&vfp);
 
 	if (n < 0) {
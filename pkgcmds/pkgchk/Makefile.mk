@@ -14,7 +14,7 @@ OBJ = checkmap.o ckentry.o main.o ../../version/version.o
 all: $(BIN)
 
 $(BIN): $(OBJ)
-	$(CC) $(LDFLAGS) $(OBJ) $(PKGLIBS) $(LIBS) -o $@
+	$(CC) $(LDFLAGS) $(OBJ) $(PKGLIBS) $(LIBS) -lz -lpthread -o $@
 
 install: all
 	mkdir -p $(ROOT)$(SBINDIR)
@@ -54,7 +54,7 @@
 #include "libadm.h"
 #include "libinst.h"
 
-extern int	qflag, lflag, Lflag, pkgcnt;
+extern int	qflag, lflag, Lflag, fflag, pkgcnt, njobs;
 extern short	npaths;
 
 extern char	*basedir, *pathlist[], *ppathlist[], **pkg, **environ;
@@ -68,6 +68,8 @@ extern int	relslock(void);		/* unlock the database. */
 
 /* ckentry.c */
 extern int	ckentry(int envflag, int maptyp, struct cfent *ept, VFP_T *vfp);
+extern int	ckqueue(int envflag, int maptyp, struct cfent *ept, VFP_T *vfp);
+extern int	ckdrain(VFP_T *vfp);
 
 #define	NXTENTRY(P, VFP) \
 		(maptyp ? srchcfile((P), "*", (VFP), (VFP_T *)NULL) : \
@@ -84,7 +86,26 @@ extern int	ckentry(int envflag, int maptyp, struct cfent *ept, VFP_T *vfp);
 
 static struct cfent entry;
 
-static int	shellmatch(char *, char *);
+/*
+ * The path list of -p and -i compiled into a tree with a node for each
+ * distinct prefix of the listed paths; a path is matched by walking down
+ * the tree along its characters.
+ */
+struct pathnode {
+	int	pn_child;	/* first child node, or -1 */
+	int	pn_next;	/* next sibling node, or -1 */
+	int	pn_first;	/* lowest index of a path below this node */
+	int	pn_end;		/* lowest index of a path ending here, or -1 */
+	int	pn_char;	/* character leading to this node */
+};
+
+static struct pathnode	*pathtree;
+static int		npathnodes;
+static int		maxpathnodes;
+
+static int	mkpathtree(void);
+static int	pathchild(int node, int c, int index);
+static int	pathmatch(char *path);
 static int is_partial_path_in_DB(char *, char *);
 
 int	selpath(char *, int);
@@ -111,8 +132,12 @@ checkmap(int maptyp, int uninst, char *mapfile, char *envfile,
 	int		errflg;
 	int		n;
 	int		selected;
+	int		queued;
 	struct pinfo	*pinfo;
 	VFP_T		*vfp = (VFP_T *)NULL;
+	char		**lines = (char **)NULL;
+	size_t		nline = 0;
+	size_t		nlines = 0;
 
 	if (envfile != NULL) {
 		if ((fp = fopen(envfile, "r")) == NULL) {
@@ -162,6 +187,8 @@ checkmap(int maptyp, int uninst, char *mapfile, char *envfile,
 			progerr(gettext(ERR_PKGMAP), "contents");
 			return (-1);
 		}
+		/* pinfo lists are only needed until the next entry is read */
+		srchcfileArena(B_TRUE);
 	} else {
 		if (vfpOpen(&vfp, mapfile, "r", VFP_NONE) != 0) {
 			progerr(gettext(ERR_PKGMAP), mapfile);
@@ -172,9 +199,29 @@ checkmap(int maptyp, int uninst, char *mapfile, char *envfile,
 	if ((cl = getenv("CLASSES")) != NULL)
 		cl_sets(qstrdup(cl));
 
+	/*
+	 * if the listed packages are all named exactly and the package index
+	 * is current, only the lines naming those packages need be read
+	 */
+	if (maptyp && pkginst != NULL) {
+		lines = cfpkxFind(vfp, pkg, pkgcnt, &nlines);
+	}
+
+	/*
+	 * with -j the entries are verified on several threads; listing and
+	 * fixing entries stays serial
+	 */
+	queued = (njobs > 1 && !lflag && !Lflag && !fflag);
+
 	errflg = count = 0;
 
 	do {
+		if (lines != (char **)NULL) {
+			if (nline >= nlines) {
+				break;
+			}
+			vfpGetCurrCharPtr(vfp) = lines[nline++];
+		}
 		if ((n = NXTENTRY(&entry, vfp)) == 0) {
 			break;
 		}
@@ -204,10 +251,15 @@ checkmap(int maptyp, int uninst, char *mapfile, char *envfile,
 
 		if (n < 0) {
 			char	*errstr = getErrstr();
+			char	errpath[PATH_MAX];
+
+			/* the entries queued before this one come first */
+			(void) strlcpy(errpath, (entry.path && *entry.path) ?
+			    entry.path : "Unknown", sizeof (errpath));
+			if (queued)
+				(void) ckdrain(vfp);
 			logerr(gettext("ERROR: garbled entry"));
-			logerr(gettext("pathname: %s"),
-			    (entry.path && *entry.path) ? entry.path :
-			    "Unknown");
+			logerr(gettext("pathname: %s"), errpath);
 			logerr(gettext("problem: %s"),
 			    (errstr && *errstr) ? errstr : "Unknown");
 			exit(99);
@@ -267,14 +319,26 @@ checkmap(int maptyp, int uninst, char *mapfile, char *envfile,
 					continue;
 
 		count++;
-		if (ckentry((envfile ? 1 : 0), maptyp, &entry, vfp))
+		if (queued)
+			errflg += ckqueue((envfile ? 1 : 0), maptyp, &entry,
+			    vfp);
+		else if (ckentry((envfile ? 1 : 0), maptyp, &entry, vfp))
 			errflg++;
 	} while (n != 0);
 
+	if (queued)
+		errflg += ckdrain(vfp);
+
+	if (lines != (char **)NULL) {
+		free(lines);
+	}
+
 	(void) vfpClose(&vfp);
 
-	if (maptyp)
+	if (maptyp) {
+		srchcfileArena(B_FALSE);
 		relslock();
+	}
 
 	if (environ) {
 		/* free up environment resources */
@@ -389,36 +453,145 @@ selpath(char *path, int partial_path)
 	if (!npaths)
 		return (1); /* everything is selectable */
 
-	for (n = 0; n < npaths; n++) {
-		if (path == NULL) {
+	if (path == NULL) {
+		for (n = 0; n < npaths; n++) {
 			if (!used[n])
 				logerr(gettext(WRN_NOPATH),
 					partial_path ? ppathlist[n] :
 					pathlist[n]);
-		} else if (partial_path) {
-			used[n] = 1;
-			return (1);
-		} else if (!shellmatch(pathlist[n], path)) {
-			used[n] = 1;
-			return (1);
 		}
+		return (0);
 	}
-	return (0); /* not selected */
+
+	if (partial_path) {
+		used[0] = 1;
+		return (1);
+	}
+
+	if ((n = pathmatch(path)) < 0)
+		return (0); /* not selected */
+	used[n] = 1;
+	return (1);
 }
 
+/*
+ * Return the index of the first path in pathlist[] that matches path, or -1
+ * if there is none. A listed path matches if it equals path, or if it has
+ * an asterisk where it first differs from path; the asterisk matches the
+ * rest of path, whatever follows it in the listed path.
+ */
 static int
-shellmatch(char *spec, char *path)
+pathmatch(char *path)
 {
-	/* Check if the value is NULL */
-	if (spec == NULL || path == NULL)
-		return (1);
+	int	node;
+	int	star;
+	int	found;
 
-	while (*spec && (*spec == *path)) {
-		spec++, path++;
+	if (pathtree == NULL && mkpathtree() != 0) {
+		progerr(gettext(ERR_NOMEM), errno);
+		exit(99);
 	}
-	if ((*spec == *path) || (*spec == '*'))
-		return (0);
-	return (1);
+
+	found = npaths;
+	node = 0;
+	for (;;) {
+		/* listed paths continuing with an asterisk differ here */
+		if (*path != '*') {
+			for (star = pathtree[node].pn_child; star >= 0;
+			    star = pathtree[star].pn_next) {
+				if (pathtree[star].pn_char == '*')
+					break;
+			}
+			if (star >= 0 && pathtree[star].pn_first < found)
+				found = pathtree[star].pn_first;
+		}
+		if (*path == '\0') {
+			if (pathtree[node].pn_end >= 0 &&
+			    pathtree[node].pn_end < found)
+				found = pathtree[node].pn_end;
+			break;
+		}
+		for (node = pathtree[node].pn_child; node >= 0;
+		    node = pathtree[node].pn_next) {
+			if (pathtree[node].pn_char == (unsigned char)*path)
+				break;
+		}
+		if (node < 0)
+			break;
+		path++;
+	}
+
+	return ((found < npaths) ? found : -1);
+}
+
+/*
+ * Compile pathlist[] into pathtree. Returns 0 on success, -1 if out of
+ * memory.
+ */
+static int
+mkpathtree(void)
+{
+	unsigned char	*p;
+	int		node;
+	int		n;
+
+	if (pathchild(-1, '\0', 0) < 0)
+		return (-1);
+
+	for (n = 0; n < npaths; n++) {
+		if (pathlist[n] == NULL)
+			continue;
+		node = 0;
+		for (p = (unsigned char *)pathlist[n]; *p; p++) {
+			if ((node = pathchild(node, *p, n)) < 0)
+				return (-1);
+		}
+		if (pathtree[node].pn_end < 0)
+			pathtree[node].pn_end = n;
+	}
+	return (0);
+}
+
+/*
+ * Return the child of node that c leads to, adding it for the path with the
+ * given index if there is none; with node -1 the root is added. Returns -1
+ * if out of memory.
+ */
+static int
+pathchild(int node, int c, int index)
+{
+	struct pathnode	*pn;
+	int		child;
+
+	if (node >= 0) {
+		for (child = pathtree[node].pn_child; child >= 0;
+		    child = pathtree[child].pn_next) {
+			if (pathtree[child].pn_char == c)
+				return (child);
+		}
+	}
+
+	if (npathnodes == maxpathnodes) {
+		maxpathnodes = maxpathnodes ? 2 * maxpathnodes : 1024;
+		pn = (struct pathnode *)realloc(pathtree,
+			maxpathnodes * sizeof (struct pathnode));
+		if (pn == NULL)
+			return (-1);
+		pathtree = pn;
+	}
+
+	child = npathnodes++;
+	pn = &pathtree[child];
+	pn->pn_child = -1;
+	pn->pn_next = -1;
+	pn->pn_first = index;
+	pn->pn_end = -1;
+	pn->pn_char = c;
+	if (node >= 0) {
+		pn->pn_next = pathtree[node].pn_child;
+		pathtree[node].pn_child = child;
+	}
+	return (child);
 }
 
 static int
@@ -47,12 +47,15 @@
 #include <libintl.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <errno.h>
+#include <pthread.h>
 #include "pkglib.h"
 #include "install.h"
 #include "libadm.h"
 #include "libinst.h"
 
 extern int	Lflag, lflag, aflag, cflag, fflag, qflag, nflag, xflag, vflag;
+extern int	njobs;
 extern char	*basedir, *device, pkgspool[];
 
 #define	NXTENTRY(P, VFP) \
@@ -63,16 +66,187 @@ extern char	*basedir, *device, pkgspool[];
 #define	MSG_NET_OBJ	"It is remote and may be available from the network."
 #define	ERR_RMHIDDEN	"unable to remove hidden file"
 #define	ERR_HIDDEN	"ERROR: hidden file in exclusive directory"
+#define	ERR_NOMEM	"unable to allocate dynamic memory, errno=%d"
+
+/*
+ * Each verification thread gets CKQ_PERTHREAD slots in the queue of entries;
+ * the queue lets the threads run ahead of an entry that takes long to verify
+ * while the entries before it are reported.
+ */
+
+#define	CKQ_PERTHREAD	64
+
+/*
+ * Result of verifying an entry; filled in by ckverify() and reported by
+ * ckreport()
+ */
+struct ckres {
+	char	*cr_spool;	/* path of spooled object (-d) */
+	int	cr_served;	/* object is a served file */
+	int	cr_aerr;	/* averify() result */
+	char	*cr_amsg;	/* averify() error messages */
+	int	cr_cerr;	/* cverify() result */
+	char	*cr_cmsg;	/* cverify() error messages */
+};
+
+/*
+ * An entry queued for verification on the verification threads (-j)
+ */
+struct ckjob {
+	struct cfent	cj_ent;		/* copy of the entry */
+	struct ckres	cj_res;		/* result of verifying the entry */
+	int		cj_maptyp;	/* entry is from the contents file */
+	SRCHPOS_T	cj_pos;		/* map position after the entry */
+	int		cj_done;	/* entry has been verified */
+};
 
 static char	*findspool(struct cfent *ept);
 static int	xdir(int maptyp, VFP_T *vfp, char *dirname);
+static int	xnamecmp(const void *a, const void *b);
+static void	mapentry(int envflag, int maptyp, struct cfent *ept);
+static void	ckinit(int maptyp, struct cfent *ept, struct ckres *res);
+static void	ckverify(struct cfent *ept, struct ckres *res);
+static int	ckreport(int maptyp, struct cfent *ept, VFP_T *vfp,
+			struct ckres *res);
+static char	*ckmsg(void);
+static void	ckstart(void);
+static int	ckflush(VFP_T *vfp, int all);
+static void	*ckworker(void *arg);
+
+/*
+ * Queue of entries being verified on the verification threads: the entries
+ * from ckqhead to ckqnext have been handed to a thread, the entries from
+ * ckqnext to ckqtail wait for one. The counters only grow; an entry is kept
+ * in slot (counter % ckqsize).
+ */
+static struct ckjob	*ckq;
+static int		ckqsize;
+static unsigned long	ckqhead;
+static unsigned long	ckqnext;
+static unsigned long	ckqtail;
+static int		ckqstop;
+static pthread_t	*ckqtid;
+static int		ckqnthreads;
+static pthread_mutex_t	ckqlock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	ckqwork = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t	ckqdone = PTHREAD_COND_INITIALIZER;
 
 int
 ckentry(int envflag, int maptyp, struct cfent *ept, VFP_T *vfp)
 {
-	int	a_err, c_err,
-		errflg;
-	char	*path;
+	struct ckres	res;
+	int		errflg;
+
+	mapentry(envflag, maptyp, ept);
+
+	if (lflag) {
+		tputcfent(ept, stdout);
+		return (0);
+	} else if (Lflag)
+		return (putcfile(ept, stdout));
+
+	if (device && strchr("dxslcbp", ept->ftype))
+		return (0);
+
+	ckinit(maptyp, ept, &res);
+	ckverify(ept, &res);
+	errflg = ckreport(maptyp, ept, vfp, &res);
+
+	free(res.cr_amsg);
+	free(res.cr_cmsg);
+	return (errflg);
+}
+
+/*
+ * This queues an entry for verification on the verification threads, which
+ * are started on the first call. Entries are reported in the order they
+ * were queued, each once it and all entries before it have been verified,
+ * so the output is the same as that of ckentry() called for each entry.
+ * Returns the number of entries reported that failed verification. Listing
+ * (-l, -L) and fixing (-f) are not supported.
+ */
+int
+ckqueue(int envflag, int maptyp, struct cfent *ept, VFP_T *vfp)
+{
+	struct ckjob	*job;
+
+	mapentry(envflag, maptyp, ept);
+
+	if (device && strchr("dxslcbp", ept->ftype))
+		return (0);
+
+	if (ckq == NULL)
+		ckstart();
+
+	/* a slot is always free here: ckflush() leaves at least one */
+	job = &ckq[ckqtail % ckqsize];
+
+	job->cj_ent = *ept;
+	job->cj_ent.path = qstrdup(ept->path);
+	if (ept->ainfo.local != NULL)
+		job->cj_ent.ainfo.local = qstrdup(ept->ainfo.local);
+	job->cj_ent.pinfo = NULL;
+	ckinit(maptyp, ept, &job->cj_res);
+	if (job->cj_res.cr_spool != NULL)
+		job->cj_res.cr_spool = qstrdup(job->cj_res.cr_spool);
+	job->cj_maptyp = maptyp;
+	srchcfileGetPos(vfp, &job->cj_pos);
+	job->cj_done = 0;
+
+	if (ckqnthreads == 0) {
+		/* no verification threads could be started */
+		ckverify(&job->cj_ent, &job->cj_res);
+		job->cj_done = 1;
+	}
+
+	(void) pthread_mutex_lock(&ckqlock);
+	ckqtail++;
+	(void) pthread_cond_signal(&ckqwork);
+	(void) pthread_mutex_unlock(&ckqlock);
+
+	return (ckflush(vfp, 0));
+}
+
+/*
+ * This reports all entries still queued and stops the verification threads.
+ * Returns the number of entries reported that failed verification.
+ */
+int
+ckdrain(VFP_T *vfp)
+{
+	int	errflg;
+	int	i;
+
+	if (ckq == NULL)
+		return (0);
+
+	errflg = ckflush(vfp, 1);
+
+	(void) pthread_mutex_lock(&ckqlock);
+	ckqstop = 1;
+	(void) pthread_cond_broadcast(&ckqwork);
+	(void) pthread_mutex_unlock(&ckqlock);
+
+	for (i = 0; i < ckqnthreads; i++)
+		(void) pthread_join(ckqtid[i], NULL);
+
+	free(ckqtid);
+	free(ckq);
+	ckq = NULL;
+	ckqtid = NULL;
+	ckqnthreads = 0;
+	ckqhead = ckqnext = ckqtail = 0;
+	ckqstop = 0;
+
+	return (errflg);
+}
+
+/*
+ * Map the path names of an entry to where the object is on this system.
+ */
+static void
+mapentry(int envflag, int maptyp, struct cfent *ept)
+{
 	char	*ir = get_inst_root();
 
 	if (ept->ftype != 'i') {
@@ -100,28 +274,39 @@ ckentry(int envflag, int maptyp, struct cfent *ept, VFP_T *vfp)
 			mapvar(2, ept->ainfo.group);
 		}
 	}
+}
 
-	if (lflag) {
-		tputcfent(ept, stdout);
-		return (0);
-	} else if (Lflag)
-		return (putcfile(ept, stdout));
+/*
+ * Set up the result of verifying an entry. For a spooled package this
+ * locates the spooled object; the path returned is statically allocated.
+ */
+static void
+ckinit(int maptyp, struct cfent *ept, struct ckres *res)
+{
+	(void) memset(res, 0, sizeof (struct ckres));
 
-	errflg = 0;
+	if (device)
+		res->cr_spool = findspool(ept);
+	res->cr_served = (maptyp && ept->pinfo != NULL &&
+	    ept->pinfo->status == SERVED_FILE);
+}
+
+/*
+ * Verify the attributes and contents of an entry as requested. This only
+ * records the results and may therefore run on any thread.
+ */
+static void
+ckverify(struct cfent *ept, struct ckres *res)
+{
 	if (device) {
-		if (strchr("dxslcbp", ept->ftype))
-			return (0);
-		if ((path = findspool(ept)) == NULL) {
-			logerr(gettext(ERR_SPOOLED), ept->path);
-			return (-1);
-		}
+		if (res->cr_spool == NULL)
+			return;
 
 		/*
 		 * If the package file attributes are to be sync'd up with
 		 * the pkgmap, we fix the attributes here.
 		 */
 		if (fflag) {
-			a_err = 0;
 			/* Clear dangerous bits. */
 			ept->ainfo.mode = (ept->ainfo.mode & S_IAMB);
 			/*
@@ -131,44 +316,26 @@ ckentry(int envflag, int maptyp, struct cfent *ept, VFP_T *vfp)
 			ept->ainfo.mode |= 0644;
 			if (!strchr("in", ept->ftype)) {
 				/* Set the safe attributes. */
-				if (a_err = averify(fflag, &ept->ftype,
-				    path, &ept->ainfo)) {
-					errflg++;
-					if (!qflag || (a_err != VE_EXIST)) {
-						logerr(gettext("ERROR: %s"),
-						    ept->path);
-						logerr(getErrbufAddr());
-					}
-					if (a_err == VE_EXIST)
-						return (-1);
+				if ((res->cr_aerr = averify(fflag, &ept->ftype,
+				    res->cr_spool, &ept->ainfo)) != 0) {
+					res->cr_amsg = ckmsg();
+					if (res->cr_aerr == VE_EXIST)
+						return;
 				}
 			}
 		}
 		/* Report invalid modtimes by passing cverify a -1 */
-		c_err = cverify((!fflag ? (-1) : fflag),  &ept->ftype, path,
-			&ept->cinfo, 1);
-		if (c_err) {
-			logerr(gettext("ERROR: %s"), path);
-			logerr(getErrbufAddr());
-			return (-1);
-		}
+		if ((res->cr_cerr = cverify((!fflag ? (-1) : fflag),
+		    &ept->ftype, res->cr_spool, &ept->cinfo, 1)) != 0)
+			res->cr_cmsg = ckmsg();
 	} else {
-		a_err = 0;
 		if (aflag && !strchr("in", ept->ftype)) {
 			/* validate attributes */
-			if (a_err = averify(fflag, &ept->ftype, ept->path,
-			    &ept->ainfo)) {
-				errflg++;
-				if (!qflag || (a_err != VE_EXIST)) {
-					logerr(gettext("ERROR: %s"),
-					    ept->path);
-					logerr(getErrbufAddr());
-					if (maptyp && ept->pinfo->status ==
-					    SERVED_FILE)
-						logerr(gettext(MSG_NET_OBJ));
-				}
-				if (a_err == VE_EXIST)
-					return (-1);
+			if ((res->cr_aerr = averify(fflag, &ept->ftype,
+			    ept->path, &ept->ainfo)) != 0) {
+				res->cr_amsg = ckmsg();
+				if (res->cr_aerr == VE_EXIST)
+					return;
 			}
 		}
 		if (cflag && strchr("fev", ept->ftype) &&
@@ -176,21 +343,68 @@ ckentry(int envflag, int maptyp, struct cfent *ept, VFP_T *vfp)
 		    (!nflag || ept->ftype != 'e')) {
 			/* validate contents */
 			/* Report invalid modtimes by passing cverify a -1 */
-			if (c_err = cverify((!fflag ? (-1) : fflag),
-				&ept->ftype, ept->path, &ept->cinfo, 1)) {
-				errflg++;
-				if (!qflag || (c_err != VE_EXIST)) {
-					if (!a_err)
-						logerr(gettext("ERROR: %s"),
-						    ept->path);
-					logerr(getErrbufAddr());
-					if (maptyp && ept->pinfo->status ==
-					    SERVED_FILE)
-						logerr(gettext(MSG_NET_OBJ));
-				}
-				if (c_err == VE_EXIST)
-					return (-1);
+			if ((res->cr_cerr = cverify((!fflag ? (-1) : fflag),
+				&ept->ftype, ept->path, &ept->cinfo, 1)) != 0)
+				res->cr_cmsg = ckmsg();
+		}
+	}
+}
+
+/*
+ * Report the result of verifying an entry and check exclusive directories
+ * for hidden files. Returns non-zero if the entry failed verification.
+ */
+static int
+ckreport(int maptyp, struct cfent *ept, VFP_T *vfp, struct ckres *res)
+{
+	int	a_err = res->cr_aerr,
+		c_err = res->cr_cerr,
+		errflg;
+	char	*path;
+
+	errflg = 0;
+	if (device) {
+		if (res->cr_spool == NULL) {
+			logerr(gettext(ERR_SPOOLED), ept->path);
+			return (-1);
+		}
+		if (a_err) {
+			errflg++;
+			if (!qflag || (a_err != VE_EXIST)) {
+				logerr(gettext("ERROR: %s"), ept->path);
+				logerr(res->cr_amsg);
+			}
+			if (a_err == VE_EXIST)
+				return (-1);
+		}
+		if (c_err) {
+			logerr(gettext("ERROR: %s"), res->cr_spool);
+			logerr(res->cr_cmsg);
+			return (-1);
+		}
+	} else {
+		if (a_err) {
+			errflg++;
+			if (!qflag || (a_err != VE_EXIST)) {
+				logerr(gettext("ERROR: %s"), ept->path);
+				logerr(res->cr_amsg);
+				if (res->cr_served)
+					logerr(gettext(MSG_NET_OBJ));
+			}
+			if (a_err == VE_EXIST)
+				return (-1);
+		}
+		if (c_err) {
+			errflg++;
+			if (!qflag || (c_err != VE_EXIST)) {
+				if (!a_err)
+					logerr(gettext("ERROR: %s"), ept->path);
+				logerr(res->cr_cmsg);
+				if (res->cr_served)
+					logerr(gettext(MSG_NET_OBJ));
 			}
+			if (c_err == VE_EXIST)
+				return (-1);
 		}
 		if (xflag && (ept->ftype == 'x')) {
 			/* must do verbose here since ept->path will change */
@@ -206,21 +420,154 @@ ckentry(int envflag, int maptyp, struct cfent *ept, VFP_T *vfp)
 	return (errflg);
 }
 
+/*
+ * Return a copy of the error messages of the last averify() or cverify()
+ * on this thread.
+ */
+static char *
+ckmsg(void)
+{
+	char	*msg;
+
+	if ((msg = strdup(getErrbufAddr())) == NULL) {
+		progerr(gettext(ERR_NOMEM), errno);
+		exit(99);
+	}
+	return (msg);
+}
+
+/*
+ * Allocate the queue and start the verification threads. If no thread can
+ * be started, ckqueue() verifies the entries itself.
+ */
+static void
+ckstart(void)
+{
+	int	i;
+
+	ckqsize = njobs * CKQ_PERTHREAD;
+	ckq = (struct ckjob *)calloc(ckqsize, sizeof (struct ckjob));
+	ckqtid = (pthread_t *)calloc(njobs, sizeof (pthread_t));
+	if (ckq == NULL || ckqtid == NULL) {
+		progerr(gettext(ERR_NOMEM), errno);
+		exit(99);
+	}
+
+	for (i = 0; i < njobs; i++) {
+		if (pthread_create(&ckqtid[ckqnthreads], NULL, ckworker,
+		    NULL) == 0)
+			ckqnthreads++;
+	}
+}
+
+/*
+ * Report the verified entries at the head of the queue, waiting for the
+ * oldest one while the queue is full or, if all is set, until the queue is
+ * empty. Returns the number of entries reported that failed verification.
+ */
+static int
+ckflush(VFP_T *vfp, int all)
+{
+	struct ckjob	*job;
+	SRCHPOS_T	pos;
+	int		errflg = 0;
+
+	(void) pthread_mutex_lock(&ckqlock);
+	while (ckqhead != ckqtail) {
+		job = &ckq[ckqhead % ckqsize];
+		if (!job->cj_done) {
+			if (!all && (ckqtail - ckqhead < ckqsize))
+				break;
+			(void) pthread_cond_wait(&ckqdone, &ckqlock);
+			continue;
+		}
+		(void) pthread_mutex_unlock(&ckqlock);
+
+		/* xdir() reads the entries following this one */
+		srchcfileGetPos(vfp, &pos);
+		srchcfileSetPos(vfp, &job->cj_pos);
+		if (ckreport(job->cj_maptyp, &job->cj_ent, vfp,
+		    &job->cj_res))
+			errflg++;
+		srchcfileSetPos(vfp, &pos);
+
+		free(job->cj_ent.path);
+		free(job->cj_ent.ainfo.local);
+		free(job->cj_res.cr_spool);
+		free(job->cj_res.cr_amsg);
+		free(job->cj_res.cr_cmsg);
+
+		(void) pthread_mutex_lock(&ckqlock);
+		ckqhead++;
+	}
+	(void) pthread_mutex_unlock(&ckqlock);
+
+	return (errflg);
+}
+
+/*
+ * Verification thread: verify queued entries until told to stop.
+ */
+/*ARGSUSED*/
+static void *
+ckworker(void *arg)
+{
+	struct ckjob	*job;
+
+	(void) pthread_mutex_lock(&ckqlock);
+	for (;;) {
+		while ((ckqnext == ckqtail) && !ckqstop)
+			(void) pthread_cond_wait(&ckqwork, &ckqlock);
+		if (ckqnext == ckqtail)
+			break;
+		job = &ckq[ckqnext++ % ckqsize];
+		(void) pthread_mutex_unlock(&ckqlock);
+
+		ckverify(&job->cj_ent, &job->cj_res);
+
+		(void) pthread_mutex_lock(&ckqlock);
+		job->cj_done = 1;
+		(void) pthread_cond_signal(&ckqdone);
+	}
+	(void) pthread_mutex_unlock(&ckqlock);
+
+	return (NULL);
+}
+
+/*
+ * Compare two names of the children of a directory, for qsort() and
+ * bsearch().
+ */
+static int
+xnamecmp(const void *a, const void *b)
+{
+	return (strcmp(*(char **)a, *(char **)b));
+}
+
+/*
+ * Report (or with -f remove) the files in the exclusive directory dirname
+ * that are not in the package map. The entries of the map that follow the
+ * current position and lie below dirname are read once, and the names of
+ * the children of dirname among them are kept in a sorted array that each
+ * directory entry is looked up in.
+ */
 static int
 xdir(int maptyp, VFP_T *vfp, char *dirname)
 {
 	DIR		*dirfp;
 	char		badpath[PATH_MAX+1];
-	int		dirfound;
+	char		**names;
+	char		*name;
+	int		nnames;
+	int		maxnames;
 	int		errflg;
 	int		len;
 	int		n;
 	struct cfent	mine;
 	struct dirent	*drp;
-	struct pinfo	*pinfo;
-	void		*pos;
+	SRCHPOS_T	pos;
 
-	pos = vfpGetCurrCharPtr(vfp);	/* get current position in file */
+	srchcfileGetPos(vfp, &pos);	/* get current position in file */
 
 	if ((dirfp = opendir(dirname)) == NULL) {
 		progerr(gettext("unable to open directory <%s>"), dirname);
@@ -228,59 +575,82 @@ xdir(int maptyp, VFP_T *vfp, char *dirname)
 	}
 	len = strlen(dirname);
 
-	errflg = 0;
+	/* collect the names of the children of the directory in the map */
+
+	names = NULL;
+	nnames = maxnames = 0;
 	(void) memset((char *)&mine, '\0', sizeof (struct cfent));
-	while ((drp = readdir(dirfp)) != NULL) {
-		if (strcmp(drp->d_name, ".") == 0 ||
-		    strcmp(drp->d_name, "..") == 0)
+	while ((n = NXTENTRY(&mine, vfp)) != 0) {
+		if (n < 0) {
+			char	*errstr = getErrstr();
+			logerr(gettext("ERROR: garbled entry"));
+			logerr(gettext("pathname: %s"),
+			    (mine.path && *mine.path) ? mine.path :
+			    "Unknown");
+			logerr(gettext("problem: %s"),
+			    (errstr && *errstr) ? errstr : "Unknown");
+			exit(99);
+		}
+		if (strncmp(mine.path, dirname, len) ||
+		(mine.path[len] != '/'))
+			break;
+		name = &mine.path[len+1];
+		if (strchr(name, '/') != NULL)
 			continue;
-		dirfound = 0;
-		while ((n = NXTENTRY(&mine, vfp)) != 0) {
-			if (n < 0) {
-				char	*errstr = getErrstr();
-				logerr(gettext("ERROR: garbled entry"));
-				logerr(gettext("pathname: %s"),
-				    (mine.path && *mine.path) ? mine.path :
-				    "Unknown");
-				logerr(gettext("problem: %s"),
-				    (errstr && *errstr) ? errstr : "Unknown");
+		if (nnames == maxnames) {
+			maxnames = maxnames ? 2 * maxnames : 64;
+			names = (char **)realloc(names,
+				maxnames * sizeof (char *));
+			if (names == NULL) {
+				progerr(gettext(ERR_NOMEM), errno);
 				exit(99);
 			}
-			if (strncmp(mine.path, dirname, len) ||
-			(mine.path[len] != '/'))
-				break;
-			if (strcmp(drp->d_name, &mine.path[len+1]) == 0) {
-				dirfound++;
-				break;
-			}
 		}
+		if ((names[nnames++] = strdup(name)) == NULL) {
+			progerr(gettext(ERR_NOMEM), errno);
+			exit(99);
+		}
+	}
 
-		vfpGetCurrCharPtr(vfp) = pos;
+	srchcfileSetPos(vfp, &pos);
 
-		if (!dirfound) {
-			(void) snprintf(badpath, sizeof (badpath),
-				"%s/%s", dirname, drp->d_name);
-			if (fflag) {
-				if (unlink(badpath)) {
-					errflg++;
-					logerr(gettext("ERROR: %s"), badpath);
-					logerr(gettext(ERR_RMHIDDEN));
-				}
-			} else {
+	/*
+	 * the contents file is scanned with srchcfileArena() enabled, so the
+	 * pinfo lists read into 'mine' are reused by srchcfile() and must not
+	 * be freed here
+	 */
+
+	if (nnames > 1)
+		qsort(names, nnames, sizeof (char *), xnamecmp);
+
+	errflg = 0;
+	while ((drp = readdir(dirfp)) != NULL) {
+		if (strcmp(drp->d_name, ".") == 0 ||
+		    strcmp(drp->d_name, "..") == 0)
+			continue;
+		name = drp->d_name;
+		if (nnames > 0 && bsearch(&name, names, nnames,
+		    sizeof (char *), xnamecmp) != NULL)
+			continue;
+
+		(void) snprintf(badpath, sizeof (badpath),
+			"%s/%s", dirname, drp->d_name);
+		if (fflag) {
+			if (unlink(badpath)) {
 				errflg++;
 				logerr(gettext("ERROR: %s"), badpath);
-				logerr(gettext(ERR_HIDDEN));
+				logerr(gettext(ERR_RMHIDDEN));
 			}
+		} else {
+			errflg++;
+			logerr(gettext("ERROR: %s"), badpath);
+			logerr(gettext(ERR_HIDDEN));
 		}
 	}
 
-	if (maptyp) {
-		/* clear memory we've used */
-		while ((pinfo = mine.pinfo) != NULL) {
-			mine.pinfo = pinfo->next;
-			free((char *)pinfo);
-		}
-	}
+	while (nnames > 0)
+		free(names[--nnames]);
+	free(names);
 
 	(void) closedir(dirfp);
 	return (errflg);
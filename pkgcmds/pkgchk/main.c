@@ -84,7 +84,7 @@
 #define	ERR_PATHS_INVALID "Pathnames in %s are not valid."
 #define	ERR_MKDIR "unable to make directory <%s>"
 #define	ERR_USAGE	"usage:\n" \
-		"\t%s [-l|vqacnxf] [-p path[,...]] " \
+		"\t%s [-l|vqacnxfC] [-j jobs] [-p path[,...]] " \
 		"[-i file] [options]\n" \
 		"\t%s -d device  [-l|v] [-p path[,...]] "\
 		"[-i file] [pkginst [...]]\n" \
@@ -114,6 +114,8 @@ int	xflag = 0;
 int	qflag = 0;
 int	Rflag = 0;
 int	dflag = 0;
+int	njobs = 0;
+int	Cflag = 0;
 char 	*device;
 
 char	*uniTmp;
@@ -154,6 +156,7 @@ main(int argc, char *argv[])
 		*dvalue = NULL;
 	int dbcreate = 0;
 	int pathtype;
+	char	*endptr;
 
 	/* initialize locale mechanism */
 
@@ -177,7 +180,7 @@ main(int argc, char *argv[])
 	if ((uniTmp = getenv("PKG_NO_UNIFIED")) != NULL)
 		map_client = 0;
 
-	while ((c = getopt(argc, argv, "Y:R:e:p:d:nLli:vaV:Mm:cqxfQP:?"))
+	while ((c = getopt(argc, argv, "Y:R:e:p:d:nLli:j:vaV:Mm:cqxfCQP:?"))
 			!= EOF) {
 		switch (c) {
 		case 'p':
@@ -231,6 +234,16 @@ main(int argc, char *argv[])
 			setpathlist(optarg);
 			break;
 
+		case 'C':
+			Cflag++;
+			break;
+
+		case 'j':
+			njobs = strtol(optarg, &endptr, 10);
+			if ((*endptr != '\0') || (njobs < 1))
+				usage();
+			break;
+
 		case 'v':
 			vflag++;
 			break;
@@ -366,6 +379,10 @@ main(int argc, char *argv[])
 		quit(99);
 	}
 
+	/* checksums cached by earlier runs stand in for reading the files */
+	if (Cflag && !device)
+		(void) cksumCacheOpen(get_PKGADM());
+
 	errflg = 0;
 	if (mapfile) {
 		/* check for incompatible options */
@@ -586,6 +603,7 @@ quit(int n)
 		(void) rrmdir(tmpdir);
 		tmpdir = NULL;
 	}
+	(void) cksumCacheClose();
 	(void) pkghead(NULL);
 	exit(n);
 	/*NOTREACHED*/
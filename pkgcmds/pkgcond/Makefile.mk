@@ -18,7 +18,7 @@ install:
 _all: $(BIN)
 
 $(BIN): $(OBJ)
-	$(CC) $(LDFLAGS) $(OBJ) $(PKGLIBS) $(LIBS) -o $@
+	$(CC) $(LDFLAGS) $(OBJ) $(PKGLIBS) $(LIBS) -lpthread -o $@
 
 _install: all
 	mkdir -p $(ROOT)$(BINDIR)
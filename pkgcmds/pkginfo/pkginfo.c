@@ -141,11 +141,17 @@ static struct cfstat {
 static struct pkginfo info;
 
 static struct	cfstat *fpkg(char *pkginst);
+static struct	cfstat *fpkglist(struct cfstat **r_list, char *pkginst);
 static int	iscatg(char *list);
 static int	selectp(char *p);
 static void	usage(void), look_for_installed(void),
 		report(void), rdcontents(void);
 static void	pkgusage(struct cfstat *dp, struct cfent *pentry);
+static int	rdlines(VFP_T *vfp, char **lines, size_t nlines,
+		    struct cfent *pentry);
+static void	*rdstart(void *arg);
+static void	rdentry(void *res, struct cfent *pentry);
+static void	rdreduce(void *res, void *arg);
 static void	getinfo(struct cfstat *dp);
 static void	dumpinfo(struct cfstat *dp, int pkgLngth);
 
@@ -559,10 +565,16 @@ dumpinfo(struct cfstat *dp, int pkgLngth)
 
 static struct cfstat *
 fpkg(char *pkginst)
+{
+	return (fpkglist(&data, pkginst));
+}
+
+static struct cfstat *
+fpkglist(struct cfstat **r_list, char *pkginst)
 {
 	struct cfstat *dp, *last;
 
-	dp = data;
+	dp = *r_list;
 	last = (struct cfstat *)0;
 	while (dp) {
 		if (strcmp(dp->pkginst, pkginst) == 0)
@@ -576,7 +588,7 @@ fpkg(char *pkginst)
 		exit(1);
 	}
 	if (!last)
-		data = dp;
+		*r_list = dp;
 	else
 		last->next = dp; /* link list */
 	(void) strcpy(dp->pkginst, pkginst);
@@ -661,44 +673,50 @@ static void
 rdcontents(void)
 {
 	VFP_T		*vfp;
-	struct cfstat	*dp;
-	struct pinfo	*pinfo;
+	CFSCANOPS_T	ops;
+	char		**lines = (char **)NULL;
 	int		n;
+	size_t		nlines;
 
 	if (vfpOpen(&vfp, contents, "r", VFP_NEEDNOW) != 0) {
 		progerr(gettext("unable to open \"%s\" for reading"), contents);
 		exit(1);
 	}
 
-	/* check the contents file to look for referenced packages */
-	while ((n = srchcfile(&entry, "*", vfp, (VFP_T *)NULL)) > 0) {
-		for (pinfo = entry.pinfo; pinfo; pinfo = pinfo->next) {
-			/* see if entry is used by indicated packaged */
-			if (pkgcnt && (selectp(pinfo->pkg) < 0))
-				continue;
-
-			dp = fpkg(pinfo->pkg);
-			pkgusage(dp, &entry);
-
-			if (entry.npkgs > 1)
-				dp->shared++;
-
-			/*
-			 * Only objects specifically tagged with '!' event
-			 * character are considered "partial", everything
-			 * else is considered "installed" (even server
-			 * objects).
-			 */
-			switch (pinfo->status) {
-			case '!' :
-				dp->partial++;
-				break;
-			default :
-				dp->installed++;
-				break;
-			}
-		}
+	/* attach any journaled updates; srchcfile() merges them in */
+
+	if (cfjnlOpen(vfp, 0) < 0) {
+		progerr(gettext("unable to read journal of \"%s\""), contents);
+		exit(1);
 	}
+
+	/*
+	 * if specific packages are listed and the package index describes
+	 * the contents file, only the lines naming those packages are read
+	 */
+
+	if (pkgcnt && (cfpkxOpen(vfp) == 0)) {
+		lines = cfpkxFind(vfp, pkg, pkgcnt, &nlines);
+		cfpkxClose();
+	}
+
+	if (lines != (char **)NULL) {
+		n = rdlines(vfp, lines, nlines, &entry);
+		free(lines);
+	} else {
+		/*
+		 * check the contents file to look for referenced packages;
+		 * the file is scanned in parallel, each chunk counting into
+		 * its own list
+		 */
+
+		ops.cso_start = rdstart;
+		ops.cso_entry = rdentry;
+		ops.cso_reduce = rdreduce;
+
+		n = cfscan(vfp, 0, &ops, NULL, &entry);
+	}
+
 	if (n < 0) {
 		char	*errstr = getErrstr();
 		progerr(gettext("bad entry read in contents file"));
@@ -709,9 +727,126 @@ rdcontents(void)
 		exit(1);
 	}
 
+	cfjnlClose();
 	(void) vfpClose(&vfp);
 }
 
+/*
+ * count the usage of the packages found on the given lines of the contents
+ * file; returns < 0 if a line cannot be parsed
+ */
+
+static int
+rdlines(VFP_T *vfp, char **lines, size_t nlines, struct cfent *pentry)
+{
+	void	*list;
+	size_t	i;
+	int	n = 0;
+
+	list = rdstart(NULL);
+
+	/* pinfo lists are only needed until the next entry is read */
+	srchcfileArena(B_TRUE);
+
+	for (i = 0; i < nlines; i++) {
+		vfpGetCurrCharPtr(vfp) = lines[i];
+		if ((n = srchcfile(pentry, "*", vfp, (VFP_T *)NULL)) < 0) {
+			break;
+		}
+		if (n > 0) {
+			rdentry(list, pentry);
+		}
+	}
+
+	srchcfileArena(B_FALSE);
+
+	rdreduce(list, NULL);
+
+	return (n < 0 ? n : 0);
+}
+
+/*
+ * cfscan() callbacks for rdcontents(): the usage of the packages found in
+ * a chunk of the contents file is counted in a list private to the chunk;
+ * the lists are added to the package data in file order.
+ */
+
+/*ARGSUSED*/
+static void *
+rdstart(void *arg)
+{
+	struct cfstat	**list;
+
+	list = (struct cfstat **)calloc(1, sizeof (struct cfstat *));
+	if (!list) {
+		progerr(gettext("no memory, malloc() failed"));
+		exit(1);
+	}
+	return (list);
+}
+
+static void
+rdentry(void *res, struct cfent *pentry)
+{
+	struct cfstat	**list = (struct cfstat **)res;
+	struct cfstat	*dp;
+	struct pinfo	*pinfo;
+
+	for (pinfo = pentry->pinfo; pinfo; pinfo = pinfo->next) {
+		/* see if entry is used by indicated packaged */
+		if (pkgcnt && (selectp(pinfo->pkg) < 0))
+			continue;
+
+		dp = fpkglist(list, pinfo->pkg);
+		pkgusage(dp, pentry);
+
+		if (pentry->npkgs > 1)
+			dp->shared++;
+
+		/*
+		 * Only objects specifically tagged with '!' event
+		 * character are considered "partial", everything
+		 * else is considered "installed" (even server
+		 * objects).
+		 */
+		switch (pinfo->status) {
+		case '!' :
+			dp->partial++;
+			break;
+		default :
+			dp->installed++;
+			break;
+		}
+	}
+}
+
+/*ARGSUSED*/
+static void
+rdreduce(void *res, void *arg)
+{
+	struct cfstat	**list = (struct cfstat **)res;
+	struct cfstat	*cp, *dp;
+
+	while ((cp = *list) != NULL) {
+		*list = cp->next;
+
+		dp = fpkg(cp->pkginst);
+		dp->exec += cp->exec;
+		dp->dirs += cp->dirs;
+		dp->link += cp->link;
+		dp->partial += cp->partial;
+		dp->spooled += cp->spooled;
+		dp->installed += cp->installed;
+		dp->info += cp->info;
+		dp->shared += cp->shared;
+		dp->setuid += cp->setuid;
+		dp->tblks += cp->tblks;
+
+		free(cp);
+	}
+	free(list);
+}
+
 static void
 getinfo(struct cfstat *dp)
 {
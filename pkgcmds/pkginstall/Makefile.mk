@@ -16,7 +16,7 @@ OBJ = backup.o check.o cppath.o dockspace.o getinst.o instvol.o main.o \
 all: $(BIN)
 
 $(BIN): $(OBJ)
-	$(CC) $(LDFLAGS) $(OBJ) $(PKGLIBS) $(LIBS) -o $@
+	$(CC) $(LDFLAGS) $(OBJ) $(PKGLIBS) $(LIBS) -lz -lpthread -o $@
 
 install: all
 	mkdir -p $(ROOT)$(SADMDIR)/install/bin
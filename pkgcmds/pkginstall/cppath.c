@@ -72,6 +72,9 @@
  * forward declarations
  */
 
+static int	copy_path(int a_ctrl, int a_srcFd, CPIO_T *a_cpio,
+			struct stat *a_srcStatbuf, char *a_srcPath,
+			char *a_dstPath, mode_t a_mode);
 static int	write_file(char **r_linknam, int a_ctrl, mode_t a_mode,
 			char *a_file);
 static int	create_path(int a_ctrl, char *a_file);
@@ -96,13 +99,9 @@ static int	create_path(int a_ctrl, char *a_file);
 int
 cppath(int a_ctrl, char *a_srcPath, char *a_dstPath, mode_t a_mode)
 {
-	char		*linknam = (char *)NULL;
-	int		dstFd;
-	int		len;
 	int		srcFd;
-	long		status;
+	int		n;
 	struct stat	srcStatbuf;
-	struct utimbuf	times;
 
 	/* entry debugging info */
 
@@ -125,6 +124,74 @@ cppath(int a_ctrl, char *a_srcPath, char *a_dstPath, mode_t a_mode)
 		return (1);
 	}
 
+	n = copy_path(a_ctrl, srcFd, (CPIO_T *)NULL, &srcStatbuf, a_srcPath,
+		a_dstPath, a_mode);
+
+	(void) close(srcFd);
+
+	return (n);
+}
+
+/*
+ * Name:	cpstream
+ * Description:	install a path object straight from a datastream (install
+ *		new file on system without unpacking it first)
+ * Arguments:
+ *    - a_cntrl - determine how the destination file mode is set, as for
+ *	cppath()
+ *    - a_cpio - datastream archive positioned at the data of the file
+ *	(see ds_fetch()); the data is consumed
+ *    - a_srcStatbuf - status of the file in the archive
+ *    - a_srcPath - path the file would have been unpacked to
+ *    - a_dstPath - path to copy source to
+ *    - a_mode - mode to set a_dstpath to (mode controlled by a_ctrl)
+ * Returns:	int
+ *	== 0 - success
+ *	!= 0 - failure
+ */
+
+int
+cpstream(int a_ctrl, CPIO_T *a_cpio, struct stat *a_srcStatbuf,
+	char *a_srcPath, char *a_dstPath, mode_t a_mode)
+{
+	/* entry debugging info */
+
+	echoDebug(DBG_CPPATH_ENTRY, a_ctrl, a_mode, a_srcPath, a_dstPath);
+
+	return (copy_path(a_ctrl, -1, a_cpio, a_srcStatbuf, a_srcPath,
+		a_dstPath, a_mode));
+}
+
+/*
+ * Name:	copy_path
+ * Description:	install a new file on the system from an open source file
+ *		or a datastream archive; an existing file is replaced
+ *		through a temporary file
+ * Arguments:	a_ctrl - determine how the destination file mode is set, as
+ *			for cppath()
+ *		a_srcFd - file descriptor open on the source file; if < 0
+ *			the data is read from a_cpio
+ *		a_cpio - datastream archive positioned at the data of the
+ *			source file, if a_srcFd < 0
+ *		a_srcStatbuf - status of the source file
+ *		a_srcPath - path of the source file
+ *		a_dstPath - path to copy source to
+ *		a_mode - mode to set a_dstpath to (mode controlled by a_ctrl)
+ * Returns:	int
+ *			== 0 - success
+ *			!= 0 - failure
+ */
+
+static int
+copy_path(int a_ctrl, int a_srcFd, CPIO_T *a_cpio, struct stat *a_srcStatbuf,
+	char *a_srcPath, char *a_dstPath, mode_t a_mode)
+{
+	char		*linknam = (char *)NULL;
+	int		dstFd;
+	int		len;
+	long		status;
+	struct utimbuf	times;
+
 	/*
 	 * Determine the permissions mode for the destination:
 	 * - if MODE_SET is specified:
@@ -132,7 +199,7 @@ cppath(int a_ctrl, char *a_srcPath, char *a_dstPath, mode_t a_mode)
 	 * --> If a_mode is unknown (? in the pkgmap), then the file gets
 	 * --> installed with the default 0644 mode
 	 * - if MODE_SRC is specified:
-	 * --> use the mode of the source (srcStatbuf.st_mode) but mask off all
+	 * --> use the mode of the source (a_srcStatbuf) but mask off all
 	 * --> non-access mode bits (remove SET?UID bits)
 	 * - otherwise:
 	 * --> use 0666
@@ -147,7 +214,7 @@ cppath(int a_ctrl, char *a_srcPath, char *a_dstPath, mode_t a_mode)
 			a_mode = usemode;
 		}
 	} else if (a_ctrl & MODE_SRC) {
-		a_mode = (srcStatbuf.st_mode & S_IAMB);
+		a_mode = (a_srcStatbuf->st_mode & S_IAMB);
 	} else {
 		a_mode = 0666;
 	}
@@ -159,7 +226,6 @@ cppath(int a_ctrl, char *a_srcPath, char *a_dstPath, mode_t a_mode)
 
 	dstFd = write_file(&linknam, a_ctrl, a_mode, a_dstPath);
 	if (dstFd < 0) {
-		(void) close(srcFd);
 		return (1);
 	}
 
@@ -167,13 +233,22 @@ cppath(int a_ctrl, char *a_srcPath, char *a_dstPath, mode_t a_mode)
 	 * source and target files are open: copy data
 	 */
 
-	status = copyFile(srcFd, dstFd, a_srcPath, a_dstPath, &srcStatbuf, 0);
+	if (a_srcFd >= 0) {
+		status = copyFile(a_srcFd, dstFd, a_srcPath, a_dstPath,
+			a_srcStatbuf, 0);
+		if (status != 0) {
+			progerr(ERR_INPUT, a_srcPath, errno, strerror(errno));
+		}
+	} else {
+		status = cpioCopy(a_cpio, dstFd, a_dstPath);
+		if (status != 0) {
+			progerr(ERR_INPUT_STREAM, a_srcPath, getErrstr());
+		}
+	}
 
-	(void) close(srcFd);
 	(void) close(dstFd);
 
 	if (status != 0) {
-		progerr(ERR_INPUT, a_srcPath, errno, strerror(errno));
 		if (linknam) {
 			(void) remove(linknam);
 		}
@@ -220,8 +295,8 @@ cppath(int a_ctrl, char *a_srcPath, char *a_dstPath, mode_t a_mode)
 
 	/* set access/modification times for target */
 
-	times.actime = srcStatbuf.st_atime;
-	times.modtime = srcStatbuf.st_mtime;
+	times.actime = a_srcStatbuf->st_atime;
+	times.modtime = a_srcStatbuf->st_mtime;
 
 	if (utime(a_dstPath, &times) != 0) {
 		progerr(ERR_MODTIM, a_dstPath, errno, strerror(errno));
@@ -304,7 +379,8 @@ write_file(char **r_linknam, int a_ctrl, mode_t a_mode, char *a_file)
 {
 	int		len;
 	int		fd = -1;
-	static char	loc_link[PATH_MAX];
+	/* per thread: instvol() may copy several files at once */
+	static __thread char	loc_link[PATH_MAX];
 
 	/* entry debugging */
 
@@ -51,6 +51,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <assert.h>
+#include <pthread.h>
 
 /*
  * libspmi includes
@@ -131,6 +132,56 @@ struct reg_files {
 };
 static struct reg_files *regfiles_head = NULL;
 
+/*
+ * Regular files of a class without a class action script are copied on
+ * copy threads, one for each online processor but at least CPQ_MINTHREADS
+ * since the copies mostly wait for i/o. Each thread gets CPQ_PERTHREAD
+ * slots in the queue of files; the results are taken off the queue in
+ * order, only when it is full or the class is done, so that the output
+ * does not depend on how fast the threads are. While files are queued the
+ * name of each file to install is kept with the file queued before it (see
+ * cpecho()) and anything else is only output after the queue is flushed,
+ * so that the output is in the order of the files whatever the size of
+ * the queue.
+ */
+
+#define	CPQ_MINTHREADS	4
+#define	CPQ_PERTHREAD	16
+
+struct cpjob {
+	struct cfextra	*cj_ext;	/* entry of file to copy */
+	char		*cj_src;	/* copy of source path */
+	char		*cj_dst;	/* copy of destination path */
+	int		cj_status;	/* cppath() result */
+	char		*cj_msg;	/* messages output by cppath() */
+	char		*cj_names;	/* names of files echoed after it */
+	int		cj_done;	/* file has been copied */
+};
+
+/*
+ * The files from cpqhead to cpqnext have been handed to a thread, the
+ * files from cpqnext to cpqtail wait for one. The counters only grow; a
+ * file is kept in slot (counter % cpqsize).
+ */
+static struct cpjob	*cpq;
+static int		cpqsize;
+static unsigned long	cpqhead;
+static unsigned long	cpqnext;
+static unsigned long	cpqtail;
+static int		cpqstop;
+static pthread_t	*cpqtid;
+static int		cpqnthreads;
+static pthread_mutex_t	cpqlock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	cpqwork = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t	cpqdone = PTHREAD_COND_INITIALIZER;
+
+static int	cpqueue(struct cfextra *ext, char *srcp, char *dstp);
+static void	cpdrain(void);
+static void	cpecho(char *dstp);
+static void	cpfinal(struct cfextra *ext, int status);
+static void	cpflush(int all);
+static void	*cpworker(void *arg);
+
 /*
  * This is the function that actually installs one volume (usually that's
  * all there is). Upon entry, the extlist is entirely correct:
@@ -168,6 +219,9 @@ instvol(struct cfextra **extlist, char *srcinst, int part,
 	struct cfextra	*ext;
 	struct mergstat	*mstat;
 	struct reg_files *rfp = NULL;
+	struct stat	srcst;
+	CPIO_T		*cpio;
+	int		direct;
 
 	/*
 	 * r_updated and r_skipped are optional parameters that can be passed in
@@ -214,6 +268,17 @@ instvol(struct cfextra **extlist, char *srcinst, int part,
 			pass_relative = 1;
 		}
 
+		/*
+		 * A class action script may look at anything in the package:
+		 * if the package is installed straight from a datastream,
+		 * unpack the rest of it first.
+		 */
+
+		if (cl_iscript(classidx) && ds_drain()) {
+			progerr(ERR_DSTREAM);
+			quit(99);
+		}
+
 		for (;;) {
 			if (!tcount++) {
 				/* first file to install */
@@ -270,6 +335,23 @@ instvol(struct cfextra **extlist, char *srcinst, int part,
 			ept = &(ext->cf_ent);
 			mstat = &(ext->mstat);
 
+			/*
+			 * If the package is installed straight from a
+			 * datastream (see ds_nextstream()), a regular file
+			 * that is copied as is can be copied from the
+			 * datastream below; the source of any other object
+			 * must be unpacked now.
+			 */
+
+			direct = ((ept->ftype == 'f') && (!is_partial_inst()));
+
+			if ((srcp != (char *)NULL) && !direct &&
+					(ds_fetch(srcp, (CPIO_T **)NULL,
+					(struct stat *)NULL) < 0)) {
+				progerr(ERR_DSTREAM);
+				quit(99);
+			}
+
 			/*
 			 * If not installing from a partially spooled package
 			 * (the "save/pspool" area), and the file contents can
@@ -305,6 +387,7 @@ instvol(struct cfextra **extlist, char *srcinst, int part,
 
 				/* copy, preserve source file mode */
 
+				cpflush(1);
 				if (cppath(MODE_SRC, srcp, scrpt_dst, 0644)) {
 					warnflag++;
 				}
@@ -331,6 +414,7 @@ instvol(struct cfextra **extlist, char *srcinst, int part,
 					((ept->ftype == 'e') ||
 					(ept->ftype == 'n'))) {
 					if (ck_efile(srcp, ept)) {
+						cpflush(1);
 						progerr(ERR_CORRUPT,
 							srcp);
 						logerr(getErrbufAddr());
@@ -436,6 +520,7 @@ instvol(struct cfextra **extlist, char *srcinst, int part,
 
 				/* copy, preserve source file mode */
 
+				cpflush(1);
 				if (cppath(MODE_SRC, srcp, scrpt_dst, 0644)) {
 					warnflag++;
 				}
@@ -469,6 +554,8 @@ instvol(struct cfextra **extlist, char *srcinst, int part,
 				 * at least test it for existence.
 				 */
 
+				cpflush(1);
+
 				if (is_mounted(ept->path, &(ext->fsys_value))) {
 					if (!isfile(NULL, dstp)) {
 						echo(MSG_IS_PRESENT, dstp);
@@ -491,7 +578,7 @@ instvol(struct cfextra **extlist, char *srcinst, int part,
 
 			/* echo output destination name */
 
-			echo("%s", dstp);
+			cpecho(dstp);
 
 			/*
 			 * if no source then no need to copy/verify
@@ -553,6 +640,8 @@ instvol(struct cfextra **extlist, char *srcinst, int part,
 					(strcmp(cl_nam(ept->pkg_class_idx),
 								"none") == 0)) {
 
+					cpflush(1);
+
 					/*
 					 * if the file is in a space inherited
 					 * from the global zone, and if the
@@ -627,17 +716,25 @@ instvol(struct cfextra **extlist, char *srcinst, int part,
 			 */
 
 			if (z_path_is_inherited(dstp, ept->ftype,
-						get_inst_root()) == B_FALSE) {
-				n = cppath(MODE_SET|DIR_DISPLAY, srcp, dstp,
+					get_inst_root()) == B_FALSE) {
+				if (direct && ((n = ds_fetch(srcp, &cpio,
+						&srcst)) != 0)) {
+					if (n < 0) {
+						progerr(ERR_DSTREAM);
+						quit(99);
+					}
+
+					/* keep the results in package order */
+
+					cpflush(1);
+					n = cpstream(MODE_SET|DIR_DISPLAY, cpio,
+						&srcst, srcp, dstp,
 						ept->ainfo.mode);
-				if (n != 0) {
-					warnflag++;
-				} else if (!finalck(ept, 1, 1, B_FALSE)) {
-					/*
-					 * everything checks here
-					 */
-					mstat->attrchg = 0;
-					mstat->contchg = 0;
+					cpfinal(ext, n);
+				} else if (cpqueue(ext, srcp, dstp) != 0) {
+					n = cppath(MODE_SET|DIR_DISPLAY, srcp,
+						dstp, ept->ainfo.mode);
+					cpfinal(ext, n);
 				}
 			}
 
@@ -649,6 +746,10 @@ instvol(struct cfextra **extlist, char *srcinst, int part,
 			}
 		}
 
+		/* wait for the files of this class still being copied */
+
+		cpdrain();
+
 		/*
 		 * We have now completed processing of all pathnames
 		 * associated with this volume and class.
@@ -1766,3 +1867,246 @@ regfiles_free()
 		regfiles_head = NULL;
 	}
 }
+
+/*
+ * Queue a regular file for copying on the copy threads, starting them if
+ * needed. Returns 0 if the file was queued, != 0 if the caller must copy
+ * it itself: no copy thread could be started, or the directory of the file
+ * does not exist yet. Implied directories are only created on this thread, so
+ * that they are created (and displayed) in order; the files queued before
+ * are finished first, but the copy threads are kept for the rest of the
+ * class.
+ */
+static int
+cpqueue(struct cfextra *ext, char *srcp, char *dstp)
+{
+	struct cpjob	*job;
+	char		*pt;
+	int		n;
+
+	pt = strrchr(dstp, '/');
+	if (pt != (char *)NULL && pt != dstp) {
+		*pt = '\0';
+		n = access(dstp, F_OK);
+		*pt = '/';
+		if (n != 0) {
+			cpflush(1);
+			return (1);
+		}
+	}
+
+	if (cpq == (struct cpjob *)NULL) {
+		long	nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+		int	i;
+
+		if (nthreads < CPQ_MINTHREADS) {
+			nthreads = CPQ_MINTHREADS;
+		}
+
+		cpqsize = (int)nthreads * CPQ_PERTHREAD;
+		cpq = (struct cpjob *)calloc(cpqsize, sizeof (struct cpjob));
+		cpqtid = (pthread_t *)calloc(nthreads, sizeof (pthread_t));
+		if ((cpq == (struct cpjob *)NULL) ||
+				(cpqtid == (pthread_t *)NULL)) {
+			progerr(ERR_MEMORY, errno);
+			quit(99);
+		}
+
+		cpqstop = 0;
+		for (i = 0; i < nthreads; i++) {
+			if (pthread_create(&cpqtid[cpqnthreads], NULL,
+					cpworker, NULL) == 0) {
+				cpqnthreads++;
+			}
+		}
+	}
+
+	if (cpqnthreads == 0) {
+		return (1);
+	}
+
+	/* make room in the queue */
+
+	cpflush(0);
+
+	job = &cpq[cpqtail % cpqsize];
+	(void) memset(job, 0, sizeof (struct cpjob));
+	job->cj_ext = ext;
+	job->cj_src = strdup(srcp);
+	job->cj_dst = strdup(dstp);
+	if ((job->cj_src == (char *)NULL) || (job->cj_dst == (char *)NULL)) {
+		progerr(ERR_MEMORY, errno);
+		quit(99);
+	}
+
+	(void) pthread_mutex_lock(&cpqlock);
+	cpqtail++;
+	(void) pthread_cond_signal(&cpqwork);
+	(void) pthread_mutex_unlock(&cpqlock);
+
+	return (0);
+}
+
+/*
+ * Echo the name of a file to install. While files are queued the name is
+ * kept with the file queued last, to be output by cpflush() after the
+ * messages of copying that file.
+ */
+static void
+cpecho(char *dstp)
+{
+	struct cpjob	*job;
+	char		*p;
+	size_t		len;
+	size_t		n;
+
+	if ((cpq == (struct cpjob *)NULL) || (cpqhead == cpqtail) ||
+			(echoGetFlag() == B_FALSE)) {
+		echo("%s", dstp);
+		return;
+	}
+
+	job = &cpq[(cpqtail - 1) % cpqsize];
+	n = (job->cj_names == (char *)NULL) ? 0 : strlen(job->cj_names);
+	len = strlen(dstp);
+
+	p = (char *)realloc(job->cj_names, n + len + 2);
+	if (p == (char *)NULL) {
+		progerr(ERR_MEMORY, errno);
+		quit(99);
+	}
+	(void) memcpy(p + n, dstp, len);
+	p[n + len] = '\n';
+	p[n + len + 1] = '\0';
+	job->cj_names = p;
+}
+
+/*
+ * Finish all queued files and stop the copy threads.
+ */
+static void
+cpdrain(void)
+{
+	int	i;
+
+	if (cpq == (struct cpjob *)NULL) {
+		return;
+	}
+
+	cpflush(1);
+
+	(void) pthread_mutex_lock(&cpqlock);
+	cpqstop = 1;
+	(void) pthread_cond_broadcast(&cpqwork);
+	(void) pthread_mutex_unlock(&cpqlock);
+
+	for (i = 0; i < cpqnthreads; i++) {
+		(void) pthread_join(cpqtid[i], NULL);
+	}
+
+	free(cpq);
+	free(cpqtid);
+	cpq = (struct cpjob *)NULL;
+	cpqtid = (pthread_t *)NULL;
+	cpqnthreads = 0;
+}
+
+/*
+ * Finish the copied files at the head of the queue: the oldest one if the
+ * queue is full or, if all is set, all of them.
+ */
+static void
+cpflush(int all)
+{
+	struct cpjob	*job;
+
+	for (;;) {
+		(void) pthread_mutex_lock(&cpqlock);
+		if ((cpqhead == cpqtail) ||
+				(!all && (cpqtail - cpqhead < cpqsize))) {
+			(void) pthread_mutex_unlock(&cpqlock);
+			break;
+		}
+		job = &cpq[cpqhead % cpqsize];
+		while (!job->cj_done) {
+			(void) pthread_cond_wait(&cpqdone, &cpqlock);
+		}
+		(void) pthread_mutex_unlock(&cpqlock);
+
+		if (job->cj_msg != (char *)NULL) {
+			(void) fputs(job->cj_msg, get_msg_stream());
+			free(job->cj_msg);
+		}
+		cpfinal(job->cj_ext, job->cj_status);
+		if (job->cj_names != (char *)NULL) {
+			(void) fputs(job->cj_names, get_msg_stream());
+			free(job->cj_names);
+		}
+
+		free(job->cj_src);
+		free(job->cj_dst);
+
+		(void) pthread_mutex_lock(&cpqlock);
+		cpqhead++;
+		(void) pthread_mutex_unlock(&cpqlock);
+	}
+}
+
+/*
+ * Check the attributes and contents of a file copied by cppath() and note
+ * the outcome; status is the result of cppath().
+ */
+static void
+cpfinal(struct cfextra *ext, int status)
+{
+	if (status != 0) {
+		warnflag++;
+	} else if (!finalck(&(ext->cf_ent), 1, 1, B_FALSE)) {
+		/*
+		 * everything checks here
+		 */
+		ext->mstat.attrchg = 0;
+		ext->mstat.contchg = 0;
+	}
+}
+
+/*
+ * Copy thread: copy queued files until told to stop. The messages output
+ * while copying a file are kept with it, to be output by cpflush().
+ */
+/*ARGSUSED*/
+static void *
+cpworker(void *arg)
+{
+	struct cpjob	*job;
+	FILE		*fp;
+	size_t		len;
+
+	(void) pthread_mutex_lock(&cpqlock);
+	for (;;) {
+		while ((cpqnext == cpqtail) && !cpqstop) {
+			(void) pthread_cond_wait(&cpqwork, &cpqlock);
+		}
+		if (cpqnext == cpqtail) {
+			break;
+		}
+		job = &cpq[cpqnext++ % cpqsize];
+		(void) pthread_mutex_unlock(&cpqlock);
+
+		fp = open_memstream(&job->cj_msg, &len);
+		(void) set_msg_stream(fp);
+		job->cj_status = cppath(MODE_SET|DIR_DISPLAY, job->cj_src,
+			job->cj_dst, job->cj_ext->cf_ent.ainfo.mode);
+		(void) set_msg_stream((FILE *)NULL);
+		if (fp != (FILE *)NULL) {
+			(void) fclose(fp);
+		}
+
+		(void) pthread_mutex_lock(&cpqlock);
+		job->cj_done = 1;
+		(void) pthread_cond_broadcast(&cpqdone);
+	}
+	(void) pthread_mutex_unlock(&cpqlock);
+
+	return (NULL);
+}
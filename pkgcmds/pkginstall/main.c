@@ -563,6 +563,11 @@ main(int argc, char *argv[])
 		 * --> Do not perform any script locking
 		 * --> Do not install or uninstall any components of any package
 		 * --> Do not output any status or database update messages
+		 * -> contents-batch
+		 * --> This package is one of a batch of packages being added:
+		 * --> if contents file updates are journaled, never fold the
+		 * --> journal into the contents file - pkgadd does that once
+		 * --> all packages of the batch have been added
 		 */
 		case 'O':
 			for (p = strtok(optarg, ","); p != (char *)NULL;
@@ -594,6 +599,13 @@ main(int argc, char *argv[])
 					continue;
 				}
 
+				/* process contents-batch option */
+
+				if (strcmp(p, "contents-batch") == 0) {
+					set_cfbatch();
+					continue;
+				}
+
 				/* process inherited-filesystem= option */
 
 				if (strncmp(p, INHERITFS, INHERITFS_LEN) == 0) {
@@ -1100,10 +1112,13 @@ main(int argc, char *argv[])
 
 		quitSetDstreamTmpdir(pkgdev.dirname);
 
-		/* unpack the package instance from the data stream */
+		/*
+		 * unpack the package instance from the data stream; its
+		 * objects are installed straight from the stream
+		 */
 
 		b = unpack_package_from_stream(idsName, srcinst,
-							pkgdev.dirname);
+						pkgdev.dirname, B_TRUE);
 		if (b == B_FALSE) {
 			progerr(ERR_CANNOT_UNPACK_PKGSTRM,
 				srcinst ? srcinst : "?",
@@ -1113,10 +1128,7 @@ main(int argc, char *argv[])
 			/*NOTREACHED*/
 		}
 
-		/* close the datastream - no longer needed */
-
-		echoDebug(DBG_CLOSING_STREAM, idsName, pkgdev.dirname);
-		(void) ds_close(1);
+		/* the datastream is closed once the package is installed */
 	}
 
 	if (snprintf(instdir, PATH_MAX, "%s/%s", pkgdev.dirname, srcinst)
@@ -2032,6 +2044,17 @@ main(int argc, char *argv[])
 		}
 	}
 
+	/*
+	 * unpack what is left of a package installed straight from the
+	 * datastream, so the postinstall script finds it as usual
+	 */
+
+	if (ds_drain()) {
+		progerr(ERR_DSTREAM);
+		quit(99);
+		/*NOTREACHED*/
+	}
+
 	z_destroyMountTable();
 
 	/*
@@ -2827,7 +2850,9 @@ unpack(void)
 
 	dparts--;
 
-	if (ds_next(pkgdev.cdevice, instdir)) {
+	/* package objects are installed straight from the stream */
+
+	if (ds_nextstream(pkgdev.cdevice, instdir)) {
 		progerr(ERR_DSTREAM);
 		quit(99);
 		/*NOTREACHED*/
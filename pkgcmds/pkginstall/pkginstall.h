@@ -63,6 +63,8 @@ extern "C" {
 #endif /* __STDC__ */
 
 extern int	cppath __P((int ctrl, char *f1, char *f2, mode_t mode));
+extern int	cpstream __P((int ctrl, CPIO_T *cpio, struct stat *st,
+		    char *f1, char *f2, mode_t mode));
 extern void	backup __P((char *path, int mode));
 extern void	pkgvolume __P((struct pkgdev *devp, char *pkg, int part,
 		    int nparts));
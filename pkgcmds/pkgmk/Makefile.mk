@@ -14,7 +14,7 @@ OBJ = main.o mkpkgmap.o quit.o splpkgmap.o ../../version/version.o
 all: $(BIN)
 
 $(BIN): $(OBJ)
-	$(CC) $(LDFLAGS) $(OBJ) $(PKGLIBS) $(LIBS) -o $@
+	$(CC) $(LDFLAGS) $(OBJ) $(PKGLIBS) $(LIBS) -lz -lpthread -o $@
 
 install: all
 	mkdir -p $(ROOT)$(BINDIR)
@@ -14,7 +14,7 @@ OBJ = pkgname.o ../../version/version.o
 all: $(BIN)
 
 $(BIN): $(OBJ)
-	$(CC) $(LDFLAGS) $(OBJ) $(PKGLIBS) $(LIBS) -o $@
+	$(CC) $(LDFLAGS) $(OBJ) $(PKGLIBS) $(LIBS) -lpthread -o $@
 
 install: all
 	mkdir -p $(ROOT)$(SADMDIR)/install/bin
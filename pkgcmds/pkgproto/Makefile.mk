@@ -13,7 +13,7 @@ OBJ = main.o ../../version/version.o
 all: $(BIN)
 
 $(BIN): $(OBJ)
-	$(CC) $(LDFLAGS) $(OBJ) $(PKGLIBS) $(LIBS) -o $@
+	$(CC) $(LDFLAGS) $(OBJ) $(PKGLIBS) $(LIBS) -lpthread -o $@
 
 install: all
 	mkdir -p $(ROOT)$(BINDIR)
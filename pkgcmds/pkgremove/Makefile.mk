@@ -9,12 +9,12 @@ PKGLIBS = -L../../libinst -linst -L../../libpkg -lpkgu -L../../libgendb -lgendb
 	-L$(CCSDIR)/lib -ll
 
 BIN = pkgremove
-OBJ = check.o delmap.o main.o quit.o ../../version/version.o
+OBJ = check.o delmap.o main.o quit.o rmpaths.o ../../version/version.o
 
 all: $(BIN)
 
 $(BIN): $(OBJ)
-	$(CC) $(LDFLAGS) $(OBJ) $(PKGLIBS) $(LIBS) -o $@
+	$(CC) $(LDFLAGS) $(OBJ) $(PKGLIBS) $(LIBS) -lz -lpthread -o $@
 
 install: all
 	mkdir -p $(ROOT)$(SADMDIR)/install/bin
@@ -46,10 +46,17 @@ main.o: main.c ../../hdrs/pkgstrct.h ../../hdrs/pkginfo.h \
   ../../hdrs/pkgdev.h ../../libpkg/pkgerr.h ../../libpkg/keystore.h \
   ../../libpkg/cfext.h ../../hdrs/install.h ../../hdrs/libinst.h \
   ../../hdrs/install.h ../../hdrs/libadm.h ../ \
-  ../../hdrs/sys/dklabel.h ../../hdrs/valtools.h ../../hdrs/messages.h
+  ../../hdrs/sys/dklabel.h ../../hdrs/valtools.h ../../hdrs/messages.h \
+  pkgremove.h
 quit.o: quit.c ../../libpkg/pkglib.h ../../hdrs/pkgdev.h \
   ../../hdrs/pkgstrct.h ../../libpkg/pkgerr.h ../../libpkg/keystore.h \
   ../../libpkg/cfext.h ../../hdrs/install.h ../../hdrs/libadm.h \
   ../ ../../hdrs/sys/dklabel.h ../../hdrs/pkginfo.h \
   ../../hdrs/valtools.h ../../hdrs/install.h ../../hdrs/libinst.h \
   ../../libpkg/cfext.h ../../hdrs/messages.h
+rmpaths.o: rmpaths.c ../../hdrs/pkgstrct.h ../../libpkg/pkglib.h \
+  ../../hdrs/pkgdev.h ../../libpkg/pkgerr.h ../../libpkg/keystore.h \
+  ../../libpkg/cfext.h ../../hdrs/libadm.h ../ \
+  ../../hdrs/sys/dklabel.h ../../hdrs/pkginfo.h ../../hdrs/valtools.h \
+  ../../hdrs/install.h ../../hdrs/libinst.h ../../hdrs/messages.h \
+  pkgremove.h
@@ -69,6 +69,10 @@ delmap(int flag, char *pkginst)
 	VFP_T		*vfpo;
 	int		n;
 	char		*unknown = "Unknown";
+	char		**lines;
+	char		*p;
+	size_t		nline;
+	size_t		nlines;
 
 
 	if (!ocfile(&vfp, &vfpo, 0L)) {
@@ -94,8 +98,32 @@ delmap(int flag, char *pkginst)
 		quit(99);
 	}
 
+	/*
+	 * if the package index is current only the lines naming the package
+	 * are parsed; all other lines are copied to the new contents file
+	 * unchanged
+	 */
+
+	lines = cfpkxFind(vfp, &pkginst, 1, &nlines);
+	nline = 0;
+
 	eptnum = 0;
-	while (n = srchcfile(ept, "*", vfp, (VFP_T *)NULL)) {
+	for (;;) {
+		if (lines != (char **)NULL) {
+			p = (nline < nlines) ? lines[nline] :
+				vfpGetLastCharPtr(vfp) + 1;
+			if (p > vfpGetCurrCharPtr(vfp)) {
+				vfpPutBytes(vfpo, vfpGetCurrCharPtr(vfp),
+					vfpGetCurrPtrDelta(vfp, p));
+			}
+			if (nline++ >= nlines) {
+				break;
+			}
+			vfpGetCurrCharPtr(vfp) = p;
+		}
+		if ((n = srchcfile(ept, "*", vfp, (VFP_T *)NULL)) == 0) {
+			break;
+		}
 		if (n < 0) {
 			char	*errstr = getErrstr();
 			progerr(gettext("bad read of contents file"));
@@ -153,6 +181,10 @@ delmap(int flag, char *pkginst)
 
 	eptlist[eptnum] = (struct cfent *)NULL;
 
+	if (lines != (char **)NULL) {
+		free(lines);
+	}
+
 	n = swapcfile(&vfp, &vfpo, pkginst, dbchg);
 	if (n == RESULT_WRN) {
 		warnflag++;
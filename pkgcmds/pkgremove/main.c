@@ -58,6 +58,7 @@
 #include <libinst.h>
 #include <libadm.h>
 #include <messages.h>
+#include "pkgremove.h"
 
 #undef	P_tmpdir
 #define	P_tmpdir	"/var/tmp/"
@@ -133,9 +134,25 @@ static char	pkgbin[PATH_MAX],
 		*admnfile, 		/* file to use for installation admin */
 		*tmpdir; 		/* location to place temporary files */
 
+/*
+ * The entries of eptlist grouped by class, in the order each class first
+ * appears in eptlist; built by rmbucket() so rmclass() does not have to
+ * search all of eptlist for each class.
+ */
+struct rmclass {
+	char	rc_class[CLSSIZ+1];
+	int	*rc_ept;	/* indexes into eptlist, ascending */
+	int	rc_n;
+	int	rc_max;
+};
+
+static struct rmclass	*rmclasses;
+static int		nrmclasses = -1;	/* < 0 until built */
+
 static boolean_t	path_valid(char *path);
 static void		ckreturn(int retcode, char *msg);
 static void		rmclass(char *aclass, int rm_remote, char *a_zoneName);
+static struct rmclass	*rmbucket(char *aclass);
 static void		usage(void);
 
 /*
@@ -1081,9 +1098,13 @@ rmclass(char *aclass, int rm_remote, char *a_zoneName)
 	char	tmpfile[PATH_MAX];
 	char	script[PATH_MAX];
 	int	i;
-	char	*tmp_path;
-	char	*save_path = NULL;
 	struct stat st;
+	struct rmclass	*rc;
+	struct rmpath	*rps;
+	struct rmpath	*rp;
+	int	j;
+	int	n;
+	int	keep;
 
 	if (aclass == NULL) {
 		for (i = 0; i < eptnum; i++) {
@@ -1092,9 +1113,17 @@ rmclass(char *aclass, int rm_remote, char *a_zoneName)
 					rm_remote, a_zoneName);
 			}
 		}
+		for (j = 0; j < nrmclasses; j++) {
+			free(rmclasses[j].rc_ept);
+		}
+		free(rmclasses);
+		rmclasses = NULL;
+		nrmclasses = -1;
 		return;
 	}
 
+	rc = rmbucket(aclass);
+
 	/* locate class action script to execute */
 	(void) snprintf(script, sizeof (script), "%s/r.%s", pkgbin, aclass);
 	if (access(script, F_OK) != 0) {
@@ -1125,20 +1154,30 @@ rmclass(char *aclass, int rm_remote, char *a_zoneName)
 		echo(MSG_PKGREMOVE_REMPATHCLASS_LZ, aclass, a_zoneName);
 	}
 
-	/* process paths in reverse order */
-	i = eptnum;
-	while (--i >= 0) {
+	/* list paths in reverse order */
+	j = (rc != NULL) ? rc->rc_n : 0;
+	rps = (struct rmpath *)calloc(j + 1, sizeof (struct rmpath));
+	if (rps == (struct rmpath *)NULL) {
+		progerr(ERR_MEMORY, errno);
+		quit(99);
+	}
+	n = 0;
+	while (--j >= 0) {
+		i = rc->rc_ept[j];
 		ept = eptlist[i];
 
-		if ((ept == NULL) || strcmp(aclass, ept->pkg_class)) {
+		if (ept == NULL) {
 			continue;
 		}
-
-		/* save the path, and prepend the ir */
-		if (is_an_inst_root()) {
-			save_path = ept->path;
-			tmp_path = fixpath(ept->path);
-			ept->path = tmp_path;
+		keep = 0;
+
+		/* prepend the ir */
+		rp = &rps[n++];
+		rp->rp_path = is_an_inst_root() ? fixpath(ept->path) :
+		    strdup(ept->path);
+		if (rp->rp_path == NULL) {
+			progerr(ERR_MEMORY, errno);
+			quit(99);
 		}
 
 		if (!ept->ftype || (ept->ftype == '^' && !script[0])) {
@@ -1151,50 +1190,38 @@ rmclass(char *aclass, int rm_remote, char *a_zoneName)
 			 * no class action script is present. It is the CAS's
 			 * responsibility to not remove the editable object.
 			 */
-			echo(MSG_SHARED, ept->path);
+			rp->rp_msg = MSG_SHARED;
 		} else if (ept->pinfo->status == SERVED_FILE && !rm_remote) {
 			/*
 			 * If the path is provided to the client from a
 			 * server, don't remove anything unless explicitly
 			 * requested through the "-f" option.
 			 */
-			echo(MSG_SERVER, ept->path);
-		} else if (z_path_is_inherited(ept->path, ept->ftype,
+			rp->rp_msg = MSG_SERVER;
+		} else if (z_path_is_inherited(rp->rp_path, ept->ftype,
 		    get_inst_root())) {
 			/*
 			 * object is in an area inherited from the global zone,
 			 * and the object cannot be removed - output a message
 			 * indicating the object cannot be removed and continue.
 			 */
-			echo(MSG_NOTREMOVED_INHERITED, ept->path);
+			rp->rp_msg = MSG_NOTREMOVED_INHERITED;
 		} else if (script[0]) {
 			/*
 			 * If there's a class action script, just put the
 			 * path name into the list.
 			 */
-			(void) fprintf(fp, "%s\n", ept->path);
-		} else if (strchr("dx", ept->ftype) != NULL ||
-		    (lstat(ept->path, &st) == 0 && S_ISDIR(st.st_mode))) {
-			/* Directories are rmdir()'d. */
-
-			if (rmdir(ept->path)) {
-				if (errno == EBUSY) {
-					echo(MSG_DIRBUSY, ept->path);
-				} else if (errno == EEXIST) {
-					echo(MSG_NOTEMPTY, ept->path);
-				} else if (errno != ENOENT) {
-					progerr(ERR_RMDIR, ept->path);
-					warnflag++;
-				}
-			} else {
-				if (ept->pinfo->status == SERVED_FILE) {
-					echo(MSG_RMSRVR, ept->path);
-				} else {
-					echo("%s", ept->path);
-				}
-			}
-
+			(void) fprintf(fp, "%s\n", rp->rp_path);
 		} else {
+			/*
+			 * Directories are rmdir()'d, regular files are
+			 * unlink()'d by rmpaths(), which also finds the
+			 * files that are directories now.
+			 */
+			rp->rp_remove = 1;
+			rp->rp_isdir = (strchr("dx", ept->ftype) != NULL);
+			rp->rp_served = (ept->pinfo->status == SERVED_FILE);
+
 			/*
 			 * Before removing this object one more
 			 * check should be done to assure that a
@@ -1205,43 +1232,65 @@ rmclass(char *aclass, int rm_remote, char *a_zoneName)
 			 * This handles pathologcal cases that
 			 * weren't handled above.
 			 */
-			if (ept->npkgs > 1) {
-				echo(MSG_SHARED, ept->path);
-				continue;
-			}
-
-			/* Regular files are unlink()'d. */
-
-			if (unlink(ept->path)) {
-				if (errno != ENOENT) {
-					progerr(ERR_RMPATH, ept->path);
-					warnflag++;
-				}
-			} else {
-				if (ept->pinfo->status == SERVED_FILE) {
-					echo(MSG_RMSRVR, ept->path);
+			if (!rp->rp_isdir && ept->npkgs > 1) {
+				if (lstat(rp->rp_path, &st) == 0 &&
+				    S_ISDIR(st.st_mode)) {
+					rp->rp_isdir = 1;
 				} else {
-					echo("%s", ept->path);
+					/* left in eptlist; rmclass(NULL) sees it again */
+					rp->rp_msg = MSG_SHARED;
+					rp->rp_remove = 0;
+					keep = 1;
 				}
 			}
 		}
 
-		/* restore the original path */
-
-		if (is_an_inst_root()) {
-			ept->path = save_path;
-		}
-
 		/*
 		 * free memory allocated for this entry memory used for
 		 * pathnames will be freed later by a call to pathdup()
 		 */
 
-		if (eptlist[i]) {
+		if (!keep) {
 			free(eptlist[i]);
+			eptlist[i] = NULL;
+		}
+	}
+
+	rmpaths(rps, n);
+
+	/* report the paths in the order they were listed */
+
+	for (j = 0; j < n; j++) {
+		rp = &rps[j];
+
+		if (rp->rp_msg != NULL) {
+			echo(rp->rp_msg, rp->rp_path);
+		} else if (!rp->rp_remove) {
+			/* listed for the class action script */
+		} else if (rp->rp_errno == 0) {
+			if (rp->rp_served) {
+				echo(MSG_RMSRVR, rp->rp_path);
+			} else {
+				echo("%s", rp->rp_path);
+			}
+		} else if (!rp->rp_isdir) {
+			if (rp->rp_errno != ENOENT) {
+				progerr(ERR_RMPATH, rp->rp_path);
+				warnflag++;
+			}
+		} else if (rp->rp_errno == EBUSY) {
+			echo(MSG_DIRBUSY, rp->rp_path);
+		} else if (rp->rp_errno == EEXIST) {
+			echo(MSG_NOTEMPTY, rp->rp_path);
+		} else if (rp->rp_errno != ENOENT) {
+			progerr(ERR_RMDIR, rp->rp_path);
+			warnflag++;
 		}
-		eptlist[i] = NULL;
+
+		free(rp->rp_path);
 	}
+	free(rps);
+
 	if (script[0]) {
 		(void) fclose(fp);
 		set_ulimit(script, ERR_CASFAIL);
@@ -1261,6 +1310,79 @@ rmclass(char *aclass, int rm_remote, char *a_zoneName)
 	}
 }
 
+/*
+ * Name:	rmbucket
+ * Description:	Group the entries of eptlist by class in one pass over
+ *		eptlist, the first time it is called, and look up a class
+ * Arguments:	aclass - (char *) - [RO, *RO]
+ *			Class to look up; may be NULL
+ * Returns:	struct rmclass *
+ *			The entries of aclass, or NULL if it has none
+ */
+
+static struct rmclass *
+rmbucket(char *aclass)
+{
+	struct rmclass	*rc = NULL;
+	int		i;
+	int		j;
+
+	if (nrmclasses < 0) {
+		nrmclasses = 0;
+		for (i = 0; i < eptnum; i++) {
+			if (eptlist[i] == NULL) {
+				continue;
+			}
+
+			/* runs of one class are the common case */
+			if ((rc == NULL) || strcmp(rc->rc_class,
+			    eptlist[i]->pkg_class)) {
+				for (j = 0; j < nrmclasses; j++) {
+					if (strcmp(rmclasses[j].rc_class,
+					    eptlist[i]->pkg_class) == 0) {
+						break;
+					}
+				}
+				if (j == nrmclasses) {
+					rmclasses = realloc(rmclasses,
+					    (nrmclasses + 1) *
+					    sizeof (struct rmclass));
+					if (rmclasses == NULL) {
+						progerr(ERR_MEMORY, errno);
+						quit(99);
+					}
+					(void) memset(&rmclasses[j], 0,
+					    sizeof (struct rmclass));
+					(void) strlcpy(rmclasses[j].rc_class,
+					    eptlist[i]->pkg_class,
+					    sizeof (rmclasses[j].rc_class));
+					nrmclasses++;
+				}
+				rc = &rmclasses[j];
+			}
+
+			if (rc->rc_n == rc->rc_max) {
+				rc->rc_max = rc->rc_max ? 2 * rc->rc_max : 16;
+				rc->rc_ept = realloc(rc->rc_ept,
+				    rc->rc_max * sizeof (int));
+				if (rc->rc_ept == NULL) {
+					progerr(ERR_MEMORY, errno);
+					quit(99);
+				}
+			}
+			rc->rc_ept[rc->rc_n++] = i;
+		}
+	}
+
+	for (j = 0; (aclass != NULL) && (j < nrmclasses); j++) {
+		if (strcmp(rmclasses[j].rc_class, aclass) == 0) {
+			return (&rmclasses[j]);
+		}
+	}
+
+	return (NULL);
+}
+
 static void
 ckreturn(int retcode, char *msg)
 {
@@ -0,0 +1,50 @@
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at src/OPENSOLARIS.LICENSE
+ * or http://www.opensolaris.org/os/licensing.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+#ifndef __PKG_PKGREMOVE_H__
+#define	__PKG_PKGREMOVE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A path of a class being removed, in the order rmclass() reports them.
+ * rmpaths() removes the paths with rp_remove set and records the outcome
+ * in rp_errno; rmclass() then reports all of them in order.
+ */
+struct rmpath {
+	char	*rp_path;	/* path, with the install root */
+	char	*rp_msg;	/* if != NULL, output instead of removing */
+	int	rp_remove;	/* != 0 if to be removed by rmpaths() */
+	int	rp_isdir;	/* != 0 if a directory, removed with rmdir() */
+	int	rp_served;	/* != 0 if provided by a server */
+	int	rp_errno;	/* 0 if removed, else errno of the failure */
+};
+
+/* rmpaths.c */
+extern void	rmpaths(struct rmpath *a_paths, int a_n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __PKG_PKGREMOVE_H__ */
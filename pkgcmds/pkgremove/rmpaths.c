@@ -0,0 +1,348 @@
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at src/OPENSOLARIS.LICENSE
+ * or http://www.opensolaris.org/os/licensing.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+/*
+ * Removal of the paths of a class that has no class action script.
+ *
+ * The paths are grouped by the directory they are in. Each directory is
+ * opened once, and the paths in it are removed relative to it with
+ * unlinkat(), so the directory is not looked up again for every path.
+ * The groups are removed on a pool of threads, one for each online
+ * processor but at least RM_MINTHREADS since the removals mostly wait
+ * for the file system.
+ *
+ * All files are removed first. Then the directories are removed, the
+ * deepest first: a directory is only removed once all directories below
+ * it are done, and the directories of one depth are removed in parallel.
+ *
+ * Nothing is output here; the outcome of each path is recorded for
+ * rmclass() to report in order, so the output does not depend on thread
+ * timing.
+ */
+
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <pkgstrct.h>
+#include <locale.h>
+#include <libintl.h>
+#include <pkglib.h>
+#include <libadm.h>
+#include <libinst.h>
+#include <messages.h>
+#include "pkgremove.h"
+
+#define	RM_MINTHREADS	4
+
+/* a path to remove, see rmsort() for the order */
+
+struct rmref {
+	struct rmpath	*rr_path;
+	size_t		rr_dirlen;	/* length of the directory part */
+	int		rr_depth;	/* number of slashes */
+	int		rr_order;	/* index in the caller's list */
+};
+
+/* paths removed by a pool of threads, one directory at a time */
+
+struct rmwork {
+	struct rmref	*rw_refs;
+	int		*rw_groups;	/* first path of each directory */
+	int		rw_ngroups;
+	int		rw_next;	/* next directory to take */
+	int		rw_isdir;	/* != 0 if removing directories */
+	pthread_mutex_t	rw_lock;
+};
+
+static int	rmsort(const void *a_ref1, const void *a_ref2);
+static void	rmrun(struct rmref *a_refs, int a_n, int a_isdir);
+static void	*rmworker(void *a_work);
+static void	rmgroup(struct rmwork *a_work, struct rmref *a_refs, int a_n);
+
+/*
+ * Name:	rmpaths
+ * Description:	Remove the paths of a list that have rp_remove set; a path
+ *		with rp_isdir set is removed with rmdir(), any other path
+ *		with unlink() unless it turns out to be a directory
+ * Arguments:	a_paths - (struct rmpath *) - [RO, *RW]
+ *			Paths to remove; rp_errno is set for each path
+ *			removed, and rp_isdir for each path found to be a
+ *			directory
+ *		a_n - (int) - [RO]
+ *			Number of paths in a_paths
+ * Returns:	void
+ */
+
+void
+rmpaths(struct rmpath *a_paths, int a_n)
+{
+	struct rmref	*refs;
+	char		*p;
+	int		i;
+	int		j;
+	int		n;
+
+	refs = (struct rmref *)calloc(a_n + 1, sizeof (struct rmref));
+	if (refs == (struct rmref *)NULL) {
+		progerr(ERR_MEMORY, errno);
+		quit(99);
+	}
+
+	/* files first, all at once */
+
+	for (n = 0, i = 0; i < a_n; i++) {
+		if (a_paths[i].rp_remove && !a_paths[i].rp_isdir) {
+			refs[n++].rr_order = i;
+		}
+	}
+	for (i = 0; i < n; i++) {
+		refs[i].rr_path = &a_paths[refs[i].rr_order];
+	}
+	rmrun(refs, n, 0);
+
+	/* then directories, including files found to be directories */
+
+	for (n = 0, i = 0; i < a_n; i++) {
+		if (a_paths[i].rp_remove && a_paths[i].rp_isdir) {
+			refs[n].rr_path = &a_paths[i];
+			refs[n].rr_order = i;
+			refs[n].rr_depth = 0;
+			for (p = a_paths[i].rp_path; *p != '\0'; p++) {
+				refs[n].rr_depth += (*p == '/');
+			}
+			n++;
+		}
+	}
+
+	/* rmrun() sorts each depth by directory */
+
+	for (i = 0; i < n; i++) {
+		refs[i].rr_dirlen = 0;
+	}
+	qsort(refs, n, sizeof (struct rmref), rmsort);
+
+	for (i = 0; i < n; i = j) {
+		for (j = i + 1; (j < n) &&
+		    (refs[j].rr_depth == refs[i].rr_depth); j++)
+			;
+		rmrun(&refs[i], j - i, 1);
+	}
+
+	free(refs);
+}
+
+/*
+ * order paths by decreasing depth, then by directory, then as listed;
+ * rr_dirlen is 0 for all paths when sorting by depth only
+ */
+
+static int
+rmsort(const void *a_ref1, const void *a_ref2)
+{
+	const struct rmref	*r1 = (const struct rmref *)a_ref1;
+	const struct rmref	*r2 = (const struct rmref *)a_ref2;
+	size_t			len;
+	int			n;
+
+	if (r1->rr_depth != r2->rr_depth) {
+		return (r2->rr_depth - r1->rr_depth);
+	}
+
+	len = (r1->rr_dirlen < r2->rr_dirlen) ? r1->rr_dirlen : r2->rr_dirlen;
+	if ((n = memcmp(r1->rr_path->rp_path, r2->rr_path->rp_path,
+	    len)) != 0) {
+		return (n);
+	}
+	if (r1->rr_dirlen != r2->rr_dirlen) {
+		return ((r1->rr_dirlen < r2->rr_dirlen) ? -1 : 1);
+	}
+
+	return (r1->rr_order - r2->rr_order);
+}
+
+/*
+ * remove a list of paths, grouped by directory, on a pool of threads;
+ * the first group is taken by this thread as well
+ */
+
+static void
+rmrun(struct rmref *a_refs, int a_n, int a_isdir)
+{
+	struct rmwork	work;
+	pthread_t	*tids;
+	long		ncpu;
+	int		nthreads;
+	char		*p;
+	int		ntids = 0;
+	int		i;
+
+	if (a_n <= 0) {
+		return;
+	}
+
+	for (i = 0; i < a_n; i++) {
+		p = strrchr(a_refs[i].rr_path->rp_path, '/');
+		a_refs[i].rr_dirlen = (p == (char *)NULL) ? 0 :
+		    (size_t)(p - a_refs[i].rr_path->rp_path);
+	}
+	qsort(a_refs, a_n, sizeof (struct rmref), rmsort);
+
+	(void) memset(&work, 0, sizeof (work));
+	work.rw_refs = a_refs;
+	work.rw_isdir = a_isdir;
+	work.rw_groups = (int *)calloc(a_n + 1, sizeof (int));
+	if (work.rw_groups == (int *)NULL) {
+		progerr(ERR_MEMORY, errno);
+		quit(99);
+	}
+
+	for (i = 0; i < a_n; i++) {
+		if ((i == 0) ||
+		    (a_refs[i].rr_dirlen != a_refs[i-1].rr_dirlen) ||
+		    (memcmp(a_refs[i].rr_path->rp_path,
+		    a_refs[i-1].rr_path->rp_path, a_refs[i].rr_dirlen) != 0)) {
+			work.rw_groups[work.rw_ngroups++] = i;
+		}
+	}
+	work.rw_groups[work.rw_ngroups] = a_n;
+	(void) pthread_mutex_init(&work.rw_lock, NULL);
+
+	ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	if (ncpu < RM_MINTHREADS) {
+		ncpu = RM_MINTHREADS;
+	}
+	if (ncpu > work.rw_ngroups) {
+		ncpu = work.rw_ngroups;
+	}
+	nthreads = (int)ncpu;
+
+	tids = (pthread_t *)calloc(nthreads, sizeof (pthread_t));
+	if (tids == (pthread_t *)NULL) {
+		progerr(ERR_MEMORY, errno);
+		quit(99);
+	}
+
+	for (i = 1; i < nthreads; i++) {
+		if (pthread_create(&tids[ntids], NULL, rmworker,
+		    &work) == 0) {
+			ntids++;
+		}
+	}
+
+	(void) rmworker(&work);
+
+	for (i = 0; i < ntids; i++) {
+		(void) pthread_join(tids[i], NULL);
+	}
+
+	(void) pthread_mutex_destroy(&work.rw_lock);
+	free(tids);
+	free(work.rw_groups);
+}
+
+/* take directories off a work list until it is empty */
+
+static void *
+rmworker(void *a_work)
+{
+	struct rmwork	*work = (struct rmwork *)a_work;
+	int		g;
+
+	for (;;) {
+		(void) pthread_mutex_lock(&work->rw_lock);
+		g = work->rw_next++;
+		(void) pthread_mutex_unlock(&work->rw_lock);
+
+		if (g >= work->rw_ngroups) {
+			break;
+		}
+
+		rmgroup(work, &work->rw_refs[work->rw_groups[g]],
+		    work->rw_groups[g+1] - work->rw_groups[g]);
+	}
+
+	return (NULL);
+}
+
+/*
+ * remove the paths of one directory, relative to the directory; if the
+ * directory cannot be opened, the paths are removed by their full names
+ */
+
+static void
+rmgroup(struct rmwork *a_work, struct rmref *a_refs, int a_n)
+{
+	struct rmpath	*rp;
+	struct stat	st;
+	char		dir[PATH_MAX];
+	char		*name;
+	size_t		len = a_refs[0].rr_dirlen;
+	int		dfd = -1;
+	int		i;
+	int		r;
+
+	if (len < sizeof (dir)) {
+		(void) memcpy(dir, a_refs[0].rr_path->rp_path, len);
+		dir[len] = '\0';
+		dfd = open((len == 0) ? "/" : dir, O_RDONLY);
+	}
+
+	for (i = 0; i < a_n; i++) {
+		rp = a_refs[i].rr_path;
+		name = rp->rp_path + len + 1;
+
+		if ((dfd < 0) || (rp->rp_path[len] != '/') ||
+		    (*name == '\0')) {
+			if (a_work->rw_isdir) {
+				r = rmdir(rp->rp_path);
+			} else if ((lstat(rp->rp_path, &st) == 0) &&
+			    S_ISDIR(st.st_mode)) {
+				/* left for the directory pass */
+				rp->rp_isdir = 1;
+				continue;
+			} else {
+				r = unlink(rp->rp_path);
+			}
+		} else if (a_work->rw_isdir) {
+			r = unlinkat(dfd, name, AT_REMOVEDIR);
+		} else if ((fstatat(dfd, name, &st,
+		    AT_SYMLINK_NOFOLLOW) == 0) && S_ISDIR(st.st_mode)) {
+			/* left for the directory pass */
+			rp->rp_isdir = 1;
+			continue;
+		} else {
+			r = unlinkat(dfd, name, 0);
+		}
+
+		rp->rp_errno = (r == 0) ? 0 : errno;
+	}
+
+	if (dfd >= 0) {
+		(void) close(dfd);
+	}
+}
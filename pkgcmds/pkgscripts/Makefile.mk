@@ -21,7 +21,7 @@ PLAIN = i.CompCpio i.awk i.build i.sed r.awk r.build r.sed default
 all: $(BIN) $(PLAIN)
 
 $(BIN): $(OBJ)
-	$(CC) $(LDFLAGS) $(OBJ) $(PKGLIBS) $(LIBS) -o $@
+	$(CC) $(LDFLAGS) $(OBJ) $(PKGLIBS) $(LIBS) -lpthread -o $@
 
 install: all
 	mkdir -p $(ROOT)$(SADMDIR)/install/scripts
@@ -70,6 +70,9 @@ main(int argc, char *argv[])
 	char		*homedir = NULL;
 	PKG_ERR		*err = NULL;
 	int		ret, len, homelen;
+	int		level = 0;
+	int		njobs = 1;
+	char		*endptr;
 
 #if !defined(TEXT_DOMAIN)	/* Should be defined by cc -D */
 #define	TEXT_DOMAIN "SYS_TEST"
@@ -78,7 +81,7 @@ main(int argc, char *argv[])
 
 	(void) set_prog_name(argv[0]);
 
-	while ((c = getopt(argc, argv, "ga:k:snio?")) != EOF) {
+	while ((c = getopt(argc, argv, "ga:j:k:snioz:?")) != EOF) {
 		switch (c) {
 		    case 'n':
 			options |= PT_RENAME;
@@ -109,6 +112,36 @@ main(int argc, char *argv[])
 			keystore_alias = optarg;
 			break;
 
+		    case 'j':
+			njobs = strtol(optarg, &endptr, 10);
+			if ((*endptr != '\0') || (njobs < 0)) {
+				usage();
+				return (1);
+			}
+			break;
+
+		    case 'z':
+			/* method[:level] */
+			len = strcspn(optarg, ":");
+			options &= ~(PT_GZIP|PT_ZSTD);
+			if (len == 4 && strncmp(optarg, "gzip", 4) == 0) {
+				options |= PT_GZIP;
+			} else if (len == 4 &&
+			    strncmp(optarg, "zstd", 4) == 0) {
+				options |= PT_ZSTD;
+			} else {
+				usage();
+				return (1);
+			}
+			if (optarg[len] == ':') {
+				level = strtol(optarg + len + 1, &endptr, 10);
+				if ((*endptr != '\0') || (level < 1)) {
+					usage();
+					return (1);
+				}
+			}
+			break;
+
 		    default:
 			usage();
 			return (1);
@@ -130,6 +163,8 @@ main(int argc, char *argv[])
 	/* no signature, so don't use a keystore */
 	keystore = NULL;
 
+	cpioSetCompression(level, njobs);
+
 	ret = pkgtrans(flex_device(argv[optind], 1),
 	    flex_device(argv[optind+1], 1), &argv[optind+2], options,
 	    keystore, keystore_alias);
@@ -184,6 +219,7 @@ static void
 usage(void)
 {
 	(void) fprintf(stderr,
-		gettext("usage: %s [-cinos] srcdev dstdev [pkg [pkg...]]\n"),
+		gettext("usage: %s [-cinos] [-z gzip|zstd[:level]] [-j jobs] "
+		"srcdev dstdev [pkg [pkg...]]\n"),
 		get_prog_name());
 }